@@ -3,6 +3,7 @@ package main
 import (
 	"context"
 	_ "embed"
+	"errors"
 	"fmt"
 	"os"
 	"strings"
@@ -14,6 +15,7 @@ import (
 	"github.com/platformlabs-co/personal-assist/logger"
 	"github.com/platformlabs-co/personal-assist/models"
 	"github.com/platformlabs-co/personal-assist/services"
+	"github.com/platformlabs-co/personal-assist/services/memory"
 	"github.com/platformlabs-co/personal-assist/storage"
 	"github.com/platformlabs-co/personal-assist/views"
 )
@@ -30,6 +32,11 @@ type App struct {
 	activityService      *services.ActivityService
 	audioService         *services.AudioService
 	transcriptionService *services.TranscriptionService
+	transcriptRefiner    *services.TranscriptRefiner
+	garbageCollector     *services.GarbageCollector
+	retentionService     *services.RetentionService
+	backupManager        *database.BackupManager
+	maintenance          *database.MaintenanceScheduler
 	fileManager          *storage.FileManager
 	currentUser          *models.User
 	mainView             *views.MainView
@@ -67,6 +74,27 @@ func (a *App) startup(ctx context.Context) {
 	}
 }
 
+// shutdown is called when the app is closing and stops background workers
+func (a *App) shutdown(ctx context.Context) {
+	logger.Info("Application shutting down")
+
+	if a.garbageCollector != nil {
+		a.garbageCollector.Stop()
+	}
+	if a.retentionService != nil {
+		a.retentionService.Stop()
+	}
+	if a.backupManager != nil {
+		a.backupManager.Stop()
+	}
+	if a.maintenance != nil {
+		a.maintenance.Stop()
+	}
+	if a.transcriptRefiner != nil {
+		a.transcriptRefiner.Stop()
+	}
+}
+
 // initializeLogging initializes the logging system
 func (a *App) initializeLogging() error {
 	config := logger.DefaultLogConfig()
@@ -107,6 +135,13 @@ func (a *App) initializeApp() error {
 		return fmt.Errorf("failed to initialize schema: %w", err)
 	}
 
+	// Apply schema migrations
+	logger.Info("Running database migrations")
+	if err := migrator.RunMigrations(database.SchemaMigrations()); err != nil {
+		logger.WithError(err).Error("Failed to run migrations")
+		return fmt.Errorf("failed to run migrations: %w", err)
+	}
+
 	// Validate schema
 	logger.Info("Validating database schema")
 	if err := migrator.Validate(); err != nil {
@@ -130,6 +165,35 @@ func (a *App) initializeApp() error {
 	modelsPath := a.fileManager.GetModelsDir()
 	a.transcriptionService = services.NewTranscriptionService(sqliteStorage, config.DataDir, modelsPath, logger.GetLogger())
 
+	// Start background purging of deleted activities
+	a.garbageCollector = services.NewGarbageCollector(sqliteStorage, a.fileManager, services.DefaultGarbageCollectorConfig())
+	a.garbageCollector.Start()
+
+	// Start the retention engine; the policy is applied once the user is loaded
+	a.retentionService = services.NewRetentionService(sqliteStorage, a.fileManager, services.DefaultRetentionConfig())
+	a.retentionService.SetClaimFunc(a.transcriptionService.ClaimForPurge)
+	a.retentionService.Start()
+
+	// Start periodic database snapshots
+	a.backupManager = database.NewBackupManager(db, database.DefaultBackupConfig(config.DataDir))
+	a.backupManager.Start()
+
+	// Start database maintenance; heavy work only runs while nothing is recording or transcribing
+	a.maintenance = database.NewMaintenanceScheduler(db, database.DefaultMaintenanceConfig())
+	a.maintenance.SetIdleFunc(a.isIdle)
+	a.maintenance.Start()
+
+	// Replace draft transcripts with the larger model while nothing else runs
+	a.transcriptRefiner = services.NewTranscriptRefiner(a.transcriptionService, sqliteStorage, services.DefaultTranscriptRefinerConfig())
+	a.transcriptRefiner.SetIdleFunc(a.isIdle)
+	a.transcriptRefiner.SetRefinedFunc(func(activityID, recordingID string) {
+		runtime.EventsEmit(a.ctx, "transcription:refined", map[string]interface{}{
+			"activity_id":  activityID,
+			"recording_id": recordingID,
+		})
+	})
+	a.transcriptRefiner.Start()
+
 	// Initialize views
 	logger.Info("Initializing views")
 	a.mainView = views.NewMainView(a.activityService, a.audioService)
@@ -140,11 +204,32 @@ func (a *App) initializeApp() error {
 		logger.WithError(err).Error("Failed to initialize user")
 		return fmt.Errorf("failed to initialize user: %w", err)
 	}
+	a.retentionService.SetPolicy(a.currentUser.Settings.Retention)
+	a.applyMemoryBudget(a.currentUser.Settings)
 
 	logger.Info("Application initialization completed successfully")
 	return nil
 }
 
+// applyMemoryBudget sets the budget models, caches, audio buffers and
+// transcription jobs share; 0 leaves it to the memory governor's default
+func (a *App) applyMemoryBudget(settings models.UserSettings) {
+	config := memory.DefaultConfig()
+	config.Budget = settings.MemoryBudgetMB * memory.MB
+	memory.Default().Configure(config)
+}
+
+// isIdle reports whether no recording or transcription is in progress
+func (a *App) isIdle() bool {
+	if a.audioService != nil && len(a.audioService.AudioRecorder.GetActiveRecordings()) > 0 {
+		return false
+	}
+	if a.transcriptionService != nil && a.transcriptionService.HasActiveJobs() {
+		return false
+	}
+	return true
+}
+
 // initializeUser creates or retrieves the current user
 func (a *App) initializeUser(storage *storage.SQLiteStorage) error {
 	// Try to get existing user
@@ -335,6 +420,23 @@ func (a *App) GetSystemInfo() map[string]interface{} {
 		}
 	}
 
+	if a.garbageCollector != nil {
+		info["garbage_collector"] = a.garbageCollector.GetStats()
+	}
+	if a.retentionService != nil {
+		info["retention"] = a.retentionService.GetStats()
+	}
+	if a.backupManager != nil {
+		info["backup"] = a.backupManager.GetStats()
+	}
+	if a.maintenance != nil {
+		info["database_maintenance"] = a.maintenance.GetStats()
+	}
+	if a.transcriptRefiner != nil {
+		info["transcript_refiner"] = a.transcriptRefiner.GetStats()
+	}
+	info["memory"] = memory.Default().Stats()
+
 	return info
 }
 
@@ -551,6 +653,24 @@ func (a *App) DeleteActivity(activityID string) error {
 	return nil
 }
 
+// RestoreActivity restores a deleted activity that has not been purged yet
+func (a *App) RestoreActivity(activityID string) error {
+	logger.WithField("activity_id", activityID).Info("Restore activity requested")
+
+	if a.currentUser == nil || a.activityService == nil {
+		return fmt.Errorf("services not initialized")
+	}
+
+	if err := a.activityService.RestoreActivity(a.currentUser.ID, activityID); err != nil {
+		logger.WithError(err).WithField("activity_id", activityID).Error("Failed to restore activity")
+		return fmt.Errorf("failed to restore activity: %w", err)
+	}
+
+	// Emit event for frontend to refresh UI
+	runtime.EventsEmit(a.ctx, "activity:restored", activityID)
+	return nil
+}
+
 // ==================== RECORDING MANAGEMENT ====================
 
 // StartRecordingButtonAction handles the simple "Start Recording" button action
@@ -600,6 +720,19 @@ func (a *App) StopRecordingButtonAction(recordingID string) error {
 
 	// Emit event for frontend
 	runtime.EventsEmit(a.ctx, "recording:stopped", recordingID)
+
+	// Draft a transcript right away; the refiner improves it later
+	if a.transcriptionService != nil {
+		activityID, err := a.transcriptionService.DraftRecording(a.currentUser.ID, recordingID)
+		if errors.Is(err, services.ErrAlreadyTranscribing) {
+			logger.WithField("recording_id", recordingID).Info("Recording already being transcribed, skipping draft")
+		} else if err != nil {
+			logger.WithError(err).WithField("recording_id", recordingID).Warn("Failed to start draft transcription")
+		} else {
+			runtime.EventsEmit(a.ctx, "transcription:started", activityID)
+			go a.monitorTranscription(activityID)
+		}
+	}
 	return nil
 }
 
@@ -819,6 +952,44 @@ func (a *App) GetAppStatusDetailed() map[string]interface{} {
 	return status
 }
 
+// CreateBackup schedules a database snapshot in the background
+func (a *App) CreateBackup() error {
+	if a.backupManager == nil {
+		return fmt.Errorf("backup manager not initialized")
+	}
+
+	a.backupManager.RequestSnapshot()
+	return nil
+}
+
+// ListBackups returns the database snapshots in the backup directory
+func (a *App) ListBackups() ([]map[string]interface{}, error) {
+	if a.backupManager == nil {
+		return nil, fmt.Errorf("backup manager not initialized")
+	}
+
+	snapshots, err := a.backupManager.ListSnapshots()
+	if err != nil {
+		logger.WithError(err).Error("Failed to list backups")
+		return nil, err
+	}
+
+	backups := make([]map[string]interface{}, 0, len(snapshots))
+	for _, snapshot := range snapshots {
+		backups = append(backups, map[string]interface{}{
+			"sequence":      snapshot.Sequence,
+			"kind":          snapshot.Kind,
+			"file":          snapshot.File,
+			"page_count":    snapshot.PageCount,
+			"pages_written": snapshot.Pages,
+			"bytes":         snapshot.Bytes,
+			"created_at":    snapshot.CreatedAt,
+		})
+	}
+
+	return backups, nil
+}
+
 // ==================== RECORDING MODE CONFIGURATION ====================
 
 // GetRecordingModes returns available recording modes with system capability awareness
@@ -908,12 +1079,16 @@ func (a *App) GetUserSettings() (map[string]interface{}, error) {
 	}
 
 	settings := map[string]interface{}{
-		"preferred_audio_device": a.currentUser.Settings.PreferredAudioDevice,
-		"whisper_model":          a.currentUser.Settings.WhisperModel,
-		"auto_start_recording":   a.currentUser.Settings.AutoStartRecording,
-		"transcription_language": a.currentUser.Settings.TranscriptionLanguage,
-		"audio_quality":          a.currentUser.Settings.AudioQuality,
-		"storage_location":       a.currentUser.Settings.StorageLocation,
+		"preferred_audio_device":    a.currentUser.Settings.PreferredAudioDevice,
+		"whisper_model":             a.currentUser.Settings.WhisperModel,
+		"auto_start_recording":      a.currentUser.Settings.AutoStartRecording,
+		"transcription_language":    a.currentUser.Settings.TranscriptionLanguage,
+		"audio_quality":             a.currentUser.Settings.AudioQuality,
+		"storage_location":          a.currentUser.Settings.StorageLocation,
+		"audio_retention_days":      a.currentUser.Settings.Retention.AudioRetentionDays,
+		"audio_storage_cap_mb":      a.currentUser.Settings.Retention.AudioStorageCapMB,
+		"transcript_retention_days": a.currentUser.Settings.Retention.TranscriptRetentionDays,
+		"memory_budget_mb":          a.currentUser.Settings.MemoryBudgetMB,
 	}
 
 	return settings, nil
@@ -946,9 +1121,26 @@ func (a *App) UpdateUserSettings(settingsJSON map[string]interface{}) error {
 	if val, ok := settingsJSON["storage_location"].(string); ok {
 		newSettings.StorageLocation = val
 	}
+	// JSON numbers arrive as float64
+	if val, ok := settingsJSON["audio_retention_days"].(float64); ok {
+		newSettings.Retention.AudioRetentionDays = int(val)
+	}
+	if val, ok := settingsJSON["audio_storage_cap_mb"].(float64); ok {
+		newSettings.Retention.AudioStorageCapMB = int64(val)
+	}
+	if val, ok := settingsJSON["transcript_retention_days"].(float64); ok {
+		newSettings.Retention.TranscriptRetentionDays = int(val)
+	}
+	if val, ok := settingsJSON["memory_budget_mb"].(float64); ok {
+		newSettings.MemoryBudgetMB = int64(val)
+	}
 
 	// Update the user's settings
 	a.currentUser.UpdateSettings(newSettings)
+	if a.retentionService != nil {
+		a.retentionService.SetPolicy(newSettings.Retention)
+	}
+	a.applyMemoryBudget(newSettings)
 
 	// Save to database
 	if a.db != nil {
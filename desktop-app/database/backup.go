@@ -0,0 +1,836 @@
+package database
+
+import (
+	"bufio"
+	"context"
+	"database/sql"
+	"encoding/binary"
+	"encoding/json"
+	"fmt"
+	"hash/crc32"
+	"io"
+	"os"
+	"path/filepath"
+	"sort"
+	"sync"
+	"time"
+
+	"github.com/mattn/go-sqlite3"
+	"github.com/platformlabs-co/personal-assist/logger"
+)
+
+// Snapshot kinds
+const (
+	BackupKindFull  = "full"
+	BackupKindDelta = "delta"
+)
+
+const (
+	backupManifestName = "manifest.json"
+	deltaMagic         = "PABKDLT1"
+
+	// maxBackupRestarts bounds how often a paced backup may be restarted by
+	// concurrent writers before the remaining pages are copied in one step
+	maxBackupRestarts = 3
+
+	// maxDeltaCheckpoints bounds the checkpoints a delta snapshot tries
+	// before giving up on readers holding frames in the WAL
+	maxDeltaCheckpoints = 10
+)
+
+// BackupConfig controls snapshot pacing and retention
+type BackupConfig struct {
+	TargetDir      string        // Directory receiving snapshots
+	PagesPerStep   int           // Pages copied per online backup step
+	StepInterval   time.Duration // Pause between backup steps
+	InitialDelay   time.Duration // Delay before the first scheduled snapshot
+	Interval       time.Duration // Time between scheduled snapshots
+	MaxChainLength int           // Deltas written before starting a new full snapshot
+	KeepChains     int           // Full snapshots (with their deltas) to keep
+}
+
+// DefaultBackupConfig returns the default backup configuration for a data directory
+func DefaultBackupConfig(dataDir string) BackupConfig {
+	return BackupConfig{
+		TargetDir:      filepath.Join(dataDir, "backups"),
+		PagesPerStep:   256,
+		StepInterval:   20 * time.Millisecond,
+		InitialDelay:   10 * time.Minute,
+		Interval:       6 * time.Hour,
+		MaxChainLength: 30,
+		KeepChains:     2,
+	}
+}
+
+// BackupSnapshot describes one snapshot in the target directory
+type BackupSnapshot struct {
+	Sequence  int       `json:"sequence"`
+	Kind      string    `json:"kind"`
+	File      string    `json:"file"`
+	PageCount int       `json:"page_count"`    // Database size in pages after this snapshot
+	Pages     int       `json:"pages_written"` // Pages stored in this snapshot
+	Bytes     int64     `json:"bytes"`
+	CreatedAt time.Time `json:"created_at"`
+}
+
+// backupManifest lists the snapshots of a target directory in sequence order
+type backupManifest struct {
+	PageSize  int              `json:"page_size"`
+	Snapshots []BackupSnapshot `json:"snapshots"`
+}
+
+// BackupStats reports the state of the backup manager
+type BackupStats struct {
+	LastSnapshot *BackupSnapshot `json:"last_snapshot,omitempty"`
+	LastRun      time.Time       `json:"last_run"`
+	LastError    string          `json:"last_error,omitempty"`
+	Running      bool            `json:"running"`
+}
+
+// BackupManager writes snapshots of the live database in the background.
+// A delta snapshot holds the pages the DB's page journal lists as changed
+// since the previous snapshot, read from the live database file, so its cost
+// follows the pages written rather than the size of the database. A full
+// snapshot is copied through SQLite's online backup API in paced steps, so
+// the app keeps working while it runs; one is written when the journal does
+// not cover the previous snapshot or the delta chain gets long.
+type BackupManager struct {
+	db     *DB
+	config BackupConfig
+
+	snapshotMutex sync.Mutex
+	trigger       chan struct{}
+
+	ctx    context.Context
+	cancel context.CancelFunc
+	done   chan struct{}
+
+	statsMutex sync.RWMutex
+	stats      BackupStats
+}
+
+// NewBackupManager creates a new backup manager
+func NewBackupManager(db *DB, config BackupConfig) *BackupManager {
+	return &BackupManager{
+		db:      db,
+		config:  config,
+		trigger: make(chan struct{}, 1),
+	}
+}
+
+// Start launches the background snapshot loop
+func (bm *BackupManager) Start() {
+	if bm.cancel != nil {
+		return
+	}
+
+	bm.ctx, bm.cancel = context.WithCancel(context.Background())
+	bm.done = make(chan struct{})
+	go bm.run()
+
+	logger.WithFields(map[string]interface{}{
+		"target_dir": bm.config.TargetDir,
+		"interval":   bm.config.Interval.String(),
+	}).Info("Backup manager started")
+}
+
+// Stop cancels any snapshot in progress and waits for the loop to exit
+func (bm *BackupManager) Stop() {
+	if bm.cancel == nil {
+		return
+	}
+
+	bm.cancel()
+	<-bm.done
+	bm.cancel = nil
+
+	logger.Info("Backup manager stopped")
+}
+
+// RequestSnapshot asks the background loop to take a snapshot as soon as possible
+func (bm *BackupManager) RequestSnapshot() {
+	select {
+	case bm.trigger <- struct{}{}:
+	default: // A snapshot is already pending
+	}
+}
+
+// GetStats returns the backup manager state
+func (bm *BackupManager) GetStats() BackupStats {
+	bm.statsMutex.RLock()
+	defer bm.statsMutex.RUnlock()
+	return bm.stats
+}
+
+// ListSnapshots returns the snapshots present in the target directory
+func (bm *BackupManager) ListSnapshots() ([]BackupSnapshot, error) {
+	manifest, err := loadBackupManifest(bm.config.TargetDir)
+	if err != nil {
+		return nil, err
+	}
+	return manifest.Snapshots, nil
+}
+
+// run is the background loop
+func (bm *BackupManager) run() {
+	defer close(bm.done)
+
+	timer := time.NewTimer(bm.config.InitialDelay)
+	defer timer.Stop()
+
+	for {
+		select {
+		case <-timer.C:
+			bm.runScheduled()
+			timer.Reset(bm.config.Interval)
+		case <-bm.trigger:
+			bm.runScheduled()
+		case <-bm.ctx.Done():
+			return
+		}
+	}
+}
+
+// runScheduled takes a snapshot and records the outcome
+func (bm *BackupManager) runScheduled() {
+	bm.statsMutex.Lock()
+	bm.stats.Running = true
+	bm.statsMutex.Unlock()
+
+	snapshot, err := bm.Snapshot(bm.ctx)
+
+	bm.statsMutex.Lock()
+	bm.stats.Running = false
+	bm.stats.LastRun = time.Now()
+	bm.stats.LastError = ""
+	if err != nil {
+		bm.stats.LastError = err.Error()
+	} else if snapshot != nil {
+		bm.stats.LastSnapshot = snapshot
+	}
+	bm.statsMutex.Unlock()
+
+	if err != nil && bm.ctx.Err() == nil {
+		logger.WithError(err).Warn("Database backup failed")
+	}
+}
+
+// Snapshot writes a new snapshot to the target directory. It returns nil
+// without writing anything if no page changed since the previous snapshot.
+func (bm *BackupManager) Snapshot(ctx context.Context) (*BackupSnapshot, error) {
+	bm.snapshotMutex.Lock()
+	defer bm.snapshotMutex.Unlock()
+
+	if err := os.MkdirAll(bm.config.TargetDir, 0755); err != nil {
+		return nil, fmt.Errorf("failed to create backup directory: %w", err)
+	}
+
+	manifest, err := loadBackupManifest(bm.config.TargetDir)
+	if err != nil {
+		return nil, err
+	}
+
+	sequence := 1
+	if n := len(manifest.Snapshots); n > 0 {
+		sequence = manifest.Snapshots[n-1].Sequence + 1
+	}
+
+	var snapshot *BackupSnapshot
+	written := false
+	if len(manifest.Snapshots) > 0 && bm.chainLength(manifest) < bm.config.MaxChainLength {
+		snapshot, written, err = bm.writeDeltaSnapshot(ctx, manifest, sequence)
+		if err != nil {
+			return nil, err
+		}
+		if written && snapshot == nil {
+			logger.Debug("Database unchanged since last backup, skipping snapshot")
+			return nil, nil
+		}
+	}
+	if !written {
+		if snapshot, err = bm.writeFullSnapshot(ctx, manifest, sequence); err != nil {
+			return nil, err
+		}
+	}
+
+	logger.WithFields(map[string]interface{}{
+		"sequence": snapshot.Sequence,
+		"kind":     snapshot.Kind,
+		"pages":    snapshot.Pages,
+		"bytes":    snapshot.Bytes,
+	}).Info("Database snapshot written")
+
+	return snapshot, nil
+}
+
+// commitSnapshot adds a written snapshot to the manifest
+func (bm *BackupManager) commitSnapshot(manifest *backupManifest, pageSize int, snapshot *BackupSnapshot) error {
+	manifest.PageSize = pageSize
+	manifest.Snapshots = append(manifest.Snapshots, *snapshot)
+	manifest.Snapshots = bm.pruneSnapshots(manifest.Snapshots)
+	return saveBackupManifest(bm.config.TargetDir, manifest)
+}
+
+// chainLength returns the number of deltas since the last full snapshot
+func (bm *BackupManager) chainLength(manifest *backupManifest) int {
+	length := 0
+	for i := len(manifest.Snapshots) - 1; i >= 0; i-- {
+		if manifest.Snapshots[i].Kind == BackupKindFull {
+			break
+		}
+		length++
+	}
+	return length
+}
+
+// writeFullSnapshot copies the live database into the target directory. The
+// page journal restarts relative to the new snapshot before the copy starts:
+// pages changed while it runs are listed for the next delta even if the copy
+// already holds them.
+func (bm *BackupManager) writeFullSnapshot(ctx context.Context, manifest *backupManifest, sequence int) (*BackupSnapshot, error) {
+	bm.db.checkpointMutex.Lock()
+	err := bm.db.pages.reset(sequence)
+	bm.db.checkpointMutex.Unlock()
+	if err != nil {
+		return nil, err
+	}
+
+	name := fmt.Sprintf("full-%06d.db", sequence)
+	path := filepath.Join(bm.config.TargetDir, name)
+	tmpPath := path + ".tmp"
+	defer os.Remove(tmpPath)
+
+	if err := bm.db.BackupTo(ctx, tmpPath, bm.config.PagesPerStep, bm.config.StepInterval); err != nil {
+		return nil, fmt.Errorf("failed to write full snapshot: %w", err)
+	}
+
+	file, err := os.Open(tmpPath)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open full snapshot: %w", err)
+	}
+	pageSize, err := readPageSize(file)
+	if err == nil {
+		err = file.Sync()
+	}
+	file.Close()
+	if err != nil {
+		return nil, err
+	}
+
+	info, err := os.Stat(tmpPath)
+	if err != nil {
+		return nil, err
+	}
+	if err := os.Rename(tmpPath, path); err != nil {
+		return nil, fmt.Errorf("failed to write full snapshot: %w", err)
+	}
+
+	pageCount := int(info.Size() / int64(pageSize))
+	snapshot := &BackupSnapshot{
+		Sequence:  sequence,
+		Kind:      BackupKindFull,
+		File:      name,
+		PageCount: pageCount,
+		Pages:     pageCount,
+		Bytes:     info.Size(),
+		CreatedAt: time.Now(),
+	}
+	if err := bm.commitSnapshot(manifest, pageSize, snapshot); err != nil {
+		return nil, err
+	}
+	return snapshot, nil
+}
+
+// writeDeltaSnapshot writes the pages changed since the previous snapshot,
+// reading them from the live database file. Checkpoints are held off until
+// the snapshot is committed; the WAL is first checkpointed completely so the
+// file holds every page committed as of the checkpoint's reader snapshot,
+// and the page count is read in that snapshot. It reports written false when the page journal does not cover
+// the previous snapshot, and a nil snapshot when no page changed.
+func (bm *BackupManager) writeDeltaSnapshot(ctx context.Context, manifest *backupManifest, sequence int) (*BackupSnapshot, bool, error) {
+	db := bm.db
+	db.checkpointMutex.Lock()
+	defer db.checkpointMutex.Unlock()
+
+	var pageSize, pageCount int
+	readSize := func(conn *sql.Conn) error {
+		if err := conn.QueryRowContext(ctx, "PRAGMA page_size").Scan(&pageSize); err != nil {
+			return fmt.Errorf("failed to read page size: %w", err)
+		}
+		if err := conn.QueryRowContext(ctx, "PRAGMA page_count").Scan(&pageCount); err != nil {
+			return fmt.Errorf("failed to read page count: %w", err)
+		}
+		return nil
+	}
+
+	for attempt := 1; ; attempt++ {
+		result, err := db.checkpointLocked(ctx, readSize)
+		if err != nil {
+			return nil, false, err
+		}
+		if result.Complete() {
+			break
+		}
+		if attempt == maxDeltaCheckpoints {
+			return nil, false, fmt.Errorf("readers kept %d of %d WAL frames from the database file", result.LogFrames-result.Checkpointed, result.LogFrames)
+		}
+		select {
+		case <-time.After(time.Second):
+		case <-ctx.Done():
+			return nil, false, ctx.Err()
+		}
+	}
+
+	previous := manifest.Snapshots[len(manifest.Snapshots)-1]
+	pages, ok := db.pages.changed(previous.Sequence)
+	if !ok || pageSize != manifest.PageSize {
+		logger.Info("Page journal does not cover the last backup, writing a full snapshot")
+		return nil, false, nil
+	}
+
+	// Pages past the end were released by a vacuum; the delta truncates them
+	n := 0
+	for _, pgno := range pages {
+		if int(pgno) <= pageCount {
+			pages[n] = pgno
+			n++
+		}
+	}
+	pages = pages[:n]
+	if len(pages) == 0 && pageCount == previous.PageCount {
+		return nil, true, nil
+	}
+
+	name := fmt.Sprintf("delta-%06d.pages", sequence)
+	written, err := writeDeltaFile(db.path, filepath.Join(bm.config.TargetDir, name), pageSize, pageCount, pages)
+	if err != nil {
+		return nil, false, fmt.Errorf("failed to write delta snapshot: %w", err)
+	}
+
+	snapshot := &BackupSnapshot{
+		Sequence:  sequence,
+		Kind:      BackupKindDelta,
+		File:      name,
+		PageCount: pageCount,
+		Pages:     len(pages),
+		Bytes:     written,
+		CreatedAt: time.Now(),
+	}
+	if err := bm.commitSnapshot(manifest, pageSize, snapshot); err != nil {
+		return nil, false, err
+	}
+	if err := db.pages.reset(sequence); err != nil {
+		return nil, false, err
+	}
+	return snapshot, true, nil
+}
+
+// pruneSnapshots keeps the newest KeepChains full snapshots and their deltas,
+// deleting the files of older ones
+func (bm *BackupManager) pruneSnapshots(snapshots []BackupSnapshot) []BackupSnapshot {
+	fulls := 0
+	cut := 0
+	for i := len(snapshots) - 1; i >= 0; i-- {
+		if snapshots[i].Kind == BackupKindFull {
+			fulls++
+			if fulls == bm.config.KeepChains {
+				cut = i
+				break
+			}
+		}
+	}
+
+	for _, snapshot := range snapshots[:cut] {
+		if err := os.Remove(filepath.Join(bm.config.TargetDir, snapshot.File)); err != nil && !os.IsNotExist(err) {
+			logger.WithError(err).WithField("file", snapshot.File).Warn("Failed to remove old snapshot")
+		}
+	}
+
+	return append([]BackupSnapshot(nil), snapshots[cut:]...)
+}
+
+// BackupTo copies the live database to destPath with SQLite's online backup
+// API, copying pagesPerStep pages at a time and sleeping stepInterval between
+// steps. Writes from other connections restart the copy; after a few restarts
+// the remaining pages are copied in a single step so the backup finishes.
+func (db *DB) BackupTo(ctx context.Context, destPath string, pagesPerStep int, stepInterval time.Duration) error {
+	destDB, err := sql.Open(DriverName, destPath)
+	if err != nil {
+		return fmt.Errorf("failed to open backup destination: %w", err)
+	}
+	defer destDB.Close()
+
+	destConn, err := destDB.Conn(ctx)
+	if err != nil {
+		return fmt.Errorf("failed to connect to backup destination: %w", err)
+	}
+	defer destConn.Close()
+
+	srcConn, err := db.Conn(ctx)
+	if err != nil {
+		return fmt.Errorf("failed to get source connection: %w", err)
+	}
+	defer srcConn.Close()
+
+	return destConn.Raw(func(destDriverConn interface{}) error {
+		return srcConn.Raw(func(srcDriverConn interface{}) error {
+			dest, ok := destDriverConn.(*sqlite3.SQLiteConn)
+			if !ok {
+				return fmt.Errorf("unexpected destination driver connection %T", destDriverConn)
+			}
+			src, ok := srcDriverConn.(*sqlite3.SQLiteConn)
+			if !ok {
+				return fmt.Errorf("unexpected source driver connection %T", srcDriverConn)
+			}
+
+			backup, err := dest.Backup("main", src, "main")
+			if err != nil {
+				return fmt.Errorf("failed to start backup: %w", err)
+			}
+
+			if err := stepBackup(ctx, backup, pagesPerStep, stepInterval); err != nil {
+				backup.Close()
+				return err
+			}
+
+			if err := backup.Finish(); err != nil {
+				return fmt.Errorf("failed to finish backup: %w", err)
+			}
+			return nil
+		})
+	})
+}
+
+// stepBackup drives a backup to completion in paced steps
+func stepBackup(ctx context.Context, backup *sqlite3.SQLiteBackup, pagesPerStep int, stepInterval time.Duration) error {
+	restarts := 0
+	lastRemaining := -1
+
+	for {
+		step := pagesPerStep
+		if restarts >= maxBackupRestarts {
+			step = -1 // Copy everything that is left in one go
+		}
+
+		done, err := backup.Step(step)
+		if err != nil {
+			return fmt.Errorf("backup step failed: %w", err)
+		}
+		if done {
+			return nil
+		}
+
+		remaining := backup.Remaining()
+		if lastRemaining >= 0 && remaining > lastRemaining {
+			restarts++
+		}
+		lastRemaining = remaining
+
+		select {
+		case <-time.After(stepInterval):
+		case <-ctx.Done():
+			return ctx.Err()
+		}
+	}
+}
+
+// RestoreBackupSnapshot rebuilds the database as of the given snapshot
+// sequence into destPath, starting from the closest full snapshot and
+// applying the deltas that follow it, then checks the result with
+// CheckIntegrity
+func RestoreBackupSnapshot(targetDir string, sequence int, destPath string) error {
+	manifest, err := loadBackupManifest(targetDir)
+	if err != nil {
+		return err
+	}
+
+	base := -1
+	for i, snapshot := range manifest.Snapshots {
+		if snapshot.Sequence > sequence {
+			break
+		}
+		if snapshot.Kind == BackupKindFull {
+			base = i
+		}
+	}
+	if base < 0 {
+		return fmt.Errorf("no full snapshot found for sequence %d", sequence)
+	}
+
+	if _, err := copyFileSynced(filepath.Join(targetDir, manifest.Snapshots[base].File), destPath); err != nil {
+		return fmt.Errorf("failed to restore full snapshot: %w", err)
+	}
+
+	for _, snapshot := range manifest.Snapshots[base+1:] {
+		if snapshot.Sequence > sequence {
+			break
+		}
+		if err := applyDeltaFile(filepath.Join(targetDir, snapshot.File), destPath); err != nil {
+			return fmt.Errorf("failed to apply snapshot %d: %w", snapshot.Sequence, err)
+		}
+	}
+
+	return CheckIntegrity(destPath)
+}
+
+// CheckIntegrity runs SQLite's integrity check and the full-text index's on
+// a database file. The index check reads every chunk's text through
+// transcript_text(), so the file is opened through DriverName.
+func CheckIntegrity(path string) error {
+	db, err := sql.Open(DriverName, fmt.Sprintf("file:%s?_foreign_keys=on", path))
+	if err != nil {
+		return fmt.Errorf("failed to open database: %w", err)
+	}
+	defer db.Close()
+
+	rows, err := db.Query("PRAGMA integrity_check")
+	if err != nil {
+		return fmt.Errorf("failed to run integrity check: %w", err)
+	}
+	defer rows.Close()
+
+	var problems []string
+	for rows.Next() {
+		var problem string
+		if err := rows.Scan(&problem); err != nil {
+			return fmt.Errorf("failed to read integrity check: %w", err)
+		}
+		if problem != "ok" {
+			problems = append(problems, problem)
+		}
+	}
+	if err := rows.Err(); err != nil {
+		return fmt.Errorf("failed to run integrity check: %w", err)
+	}
+	if len(problems) > 0 {
+		return fmt.Errorf("integrity check failed: %v", problems)
+	}
+
+	// Snapshots taken before migration 6 have no index
+	var indexed int
+	if err := db.QueryRow("SELECT COUNT(*) FROM sqlite_master WHERE name = 'transcript_fts'").Scan(&indexed); err != nil {
+		return fmt.Errorf("failed to read schema: %w", err)
+	}
+	if indexed == 0 {
+		return nil
+	}
+	if _, err := db.Exec("INSERT INTO transcript_fts(transcript_fts) VALUES('integrity-check')"); err != nil {
+		return fmt.Errorf("transcript index integrity check failed: %w", err)
+	}
+	return nil
+}
+
+// readPageSize reads the page size from a database file header
+func readPageSize(file *os.File) (int, error) {
+	header := make([]byte, 100)
+	if _, err := file.ReadAt(header, 0); err != nil {
+		return 0, fmt.Errorf("failed to read database header: %w", err)
+	}
+	if string(header[:16]) != "SQLite format 3\x00" {
+		return 0, fmt.Errorf("not a SQLite database")
+	}
+
+	pageSize := int(binary.BigEndian.Uint16(header[16:18]))
+	if pageSize == 1 {
+		pageSize = 65536
+	}
+	return pageSize, nil
+}
+
+// writeDeltaFile writes the given pages of srcPath to a delta file:
+// magic, page size, page count, entry count, then (page number, page data)
+// entries and a trailing CRC32 of everything before it
+func writeDeltaFile(srcPath, deltaPath string, pageSize, pageCount int, pages []uint32) (int64, error) {
+	src, err := os.Open(srcPath)
+	if err != nil {
+		return 0, err
+	}
+	defer src.Close()
+
+	tmpPath := deltaPath + ".tmp"
+	out, err := os.Create(tmpPath)
+	if err != nil {
+		return 0, err
+	}
+	defer os.Remove(tmpPath)
+	defer out.Close()
+
+	crc := crc32.NewIEEE()
+	writer := bufio.NewWriterSize(io.MultiWriter(out, crc), 1024*1024)
+
+	header := make([]byte, 0, 20)
+	header = append(header, deltaMagic...)
+	header = binary.BigEndian.AppendUint32(header, uint32(pageSize))
+	header = binary.BigEndian.AppendUint32(header, uint32(pageCount))
+	header = binary.BigEndian.AppendUint32(header, uint32(len(pages)))
+	if _, err := writer.Write(header); err != nil {
+		return 0, err
+	}
+
+	page := make([]byte, pageSize)
+	var number [4]byte
+	for _, pgno := range pages {
+		if _, err := src.ReadAt(page, int64(pgno-1)*int64(pageSize)); err != nil {
+			return 0, fmt.Errorf("failed to read page %d: %w", pgno, err)
+		}
+		binary.BigEndian.PutUint32(number[:], pgno)
+		if _, err := writer.Write(number[:]); err != nil {
+			return 0, err
+		}
+		if _, err := writer.Write(page); err != nil {
+			return 0, err
+		}
+	}
+
+	if err := writer.Flush(); err != nil {
+		return 0, err
+	}
+	if err := binary.Write(out, binary.BigEndian, crc.Sum32()); err != nil {
+		return 0, err
+	}
+	if err := out.Sync(); err != nil {
+		return 0, err
+	}
+	if err := out.Close(); err != nil {
+		return 0, err
+	}
+
+	info, err := os.Stat(tmpPath)
+	if err != nil {
+		return 0, err
+	}
+	if err := os.Rename(tmpPath, deltaPath); err != nil {
+		return 0, err
+	}
+	return info.Size(), nil
+}
+
+// applyDeltaFile writes the pages of a delta file into a database file and
+// truncates it to the page count recorded in the delta
+func applyDeltaFile(deltaPath, dbPath string) error {
+	data, err := os.ReadFile(deltaPath)
+	if err != nil {
+		return err
+	}
+	if len(data) < 24 || string(data[:8]) != deltaMagic {
+		return fmt.Errorf("invalid delta file %s", filepath.Base(deltaPath))
+	}
+
+	body := data[:len(data)-4]
+	if crc32.ChecksumIEEE(body) != binary.BigEndian.Uint32(data[len(data)-4:]) {
+		return fmt.Errorf("checksum mismatch in delta file %s", filepath.Base(deltaPath))
+	}
+
+	pageSize := int(binary.BigEndian.Uint32(body[8:12]))
+	pageCount := int64(binary.BigEndian.Uint32(body[12:16]))
+	entries := int(binary.BigEndian.Uint32(body[16:20]))
+	if len(body) != 20+entries*(4+pageSize) {
+		return fmt.Errorf("truncated delta file %s", filepath.Base(deltaPath))
+	}
+
+	db, err := os.OpenFile(dbPath, os.O_RDWR, 0644)
+	if err != nil {
+		return err
+	}
+	defer db.Close()
+
+	offset := 20
+	for i := 0; i < entries; i++ {
+		pgno := int64(binary.BigEndian.Uint32(body[offset : offset+4]))
+		offset += 4
+		if _, err := db.WriteAt(body[offset:offset+pageSize], (pgno-1)*int64(pageSize)); err != nil {
+			return err
+		}
+		offset += pageSize
+	}
+
+	if err := db.Truncate(pageCount * int64(pageSize)); err != nil {
+		return err
+	}
+	return db.Sync()
+}
+
+// loadBackupManifest reads the manifest of a target directory
+func loadBackupManifest(targetDir string) (*backupManifest, error) {
+	data, err := os.ReadFile(filepath.Join(targetDir, backupManifestName))
+	if err != nil {
+		if os.IsNotExist(err) {
+			return &backupManifest{}, nil
+		}
+		return nil, fmt.Errorf("failed to read backup manifest: %w", err)
+	}
+
+	var manifest backupManifest
+	if err := json.Unmarshal(data, &manifest); err != nil {
+		return nil, fmt.Errorf("failed to parse backup manifest: %w", err)
+	}
+	sort.Slice(manifest.Snapshots, func(i, j int) bool {
+		return manifest.Snapshots[i].Sequence < manifest.Snapshots[j].Sequence
+	})
+	return &manifest, nil
+}
+
+// saveBackupManifest writes the manifest of a target directory
+func saveBackupManifest(targetDir string, manifest *backupManifest) error {
+	data, err := json.MarshalIndent(manifest, "", "  ")
+	if err != nil {
+		return fmt.Errorf("failed to serialize backup manifest: %w", err)
+	}
+	return writeFileAtomic(filepath.Join(targetDir, backupManifestName), data)
+}
+
+// writeFileAtomic writes data to a temporary file and renames it into place
+func writeFileAtomic(path string, data []byte) error {
+	tmpPath := path + ".tmp"
+	file, err := os.Create(tmpPath)
+	if err != nil {
+		return err
+	}
+
+	if _, err := file.Write(data); err != nil {
+		file.Close()
+		os.Remove(tmpPath)
+		return err
+	}
+	if err := file.Sync(); err != nil {
+		file.Close()
+		os.Remove(tmpPath)
+		return err
+	}
+	if err := file.Close(); err != nil {
+		os.Remove(tmpPath)
+		return err
+	}
+
+	return os.Rename(tmpPath, path)
+}
+
+// copyFileSynced copies src to dst through a temporary file and returns the bytes written
+func copyFileSynced(src, dst string) (int64, error) {
+	in, err := os.Open(src)
+	if err != nil {
+		return 0, err
+	}
+	defer in.Close()
+
+	tmpPath := dst + ".tmp"
+	out, err := os.Create(tmpPath)
+	if err != nil {
+		return 0, err
+	}
+	defer os.Remove(tmpPath)
+	defer out.Close()
+
+	written, err := io.Copy(out, in)
+	if err != nil {
+		return 0, err
+	}
+	if err := out.Sync(); err != nil {
+		return 0, err
+	}
+	if err := out.Close(); err != nil {
+		return 0, err
+	}
+
+	return written, os.Rename(tmpPath, dst)
+}
@@ -1,24 +1,42 @@
 package database
 
 import (
+	"context"
 	"database/sql"
 	"fmt"
 	"os"
 	"path/filepath"
+	"sync"
 
-	_ "github.com/mattn/go-sqlite3" // SQLite driver
+	"github.com/mattn/go-sqlite3"
+	"github.com/platformlabs-co/personal-assist/logger"
 )
 
 // DB holds the database connection
 type DB struct {
 	*sql.DB
-	path string
+	path       string
+	transcript *TranscriptCodec
+
+	// Checkpoints run one at a time and record their pages in the journal
+	checkpointMutex sync.Mutex
+	pages           *pageJournal
+	wal             *walScanner
+	stopCheckpoints chan struct{}
+	checkpointsDone chan struct{}
 }
 
 // Config holds database configuration
 type Config struct {
 	DataDir string // App data directory
 	DBName  string // Database filename
+
+	// DriverName overrides the registered database/sql driver, DriverName when empty
+	DriverName string
+
+	// ConvertAutoVacuumMaxBytes is the largest database switched to
+	// incremental auto_vacuum when opened, 0 to never switch
+	ConvertAutoVacuumMaxBytes int64
 }
 
 // NewDB creates a new database connection
@@ -31,10 +49,22 @@ func NewDB(config Config) (*DB, error) {
 	// Full path to database file
 	dbPath := filepath.Join(config.DataDir, config.DBName)
 
-	// Open database with SQLite-specific options
-	dsn := fmt.Sprintf("file:%s?_foreign_keys=on&_journal_mode=WAL&_synchronous=NORMAL&_cache_size=1000&_temp_store=memory", dbPath)
+	// Open database with SQLite-specific options. Writers wait up to the
+	// busy timeout for the write lock rather than failing with SQLITE_BUSY.
+	dsn := fmt.Sprintf("file:%s?_foreign_keys=on&_journal_mode=WAL&_synchronous=NORMAL&_busy_timeout=5000&_auto_vacuum=incremental&_cache_size=1000&_temp_store=memory", dbPath)
 	
-	sqlDB, err := sql.Open("sqlite3", dsn)
+	driverName := config.DriverName
+	if driverName == "" {
+		driverName = DriverName
+	}
+
+	if config.ConvertAutoVacuumMaxBytes > 0 {
+		if err := convertAutoVacuum(driverName, dsn, dbPath, config.ConvertAutoVacuumMaxBytes); err != nil {
+			logger.WithError(err).Warn("Failed to convert database to incremental auto_vacuum")
+		}
+	}
+
+	sqlDB, err := sql.Open(driverName, dsn)
 	if err != nil {
 		return nil, fmt.Errorf("failed to open database: %w", err)
 	}
@@ -45,8 +75,9 @@ func NewDB(config Config) (*DB, error) {
 	sqlDB.SetConnMaxLifetime(0) // No maximum lifetime
 
 	db := &DB{
-		DB:   sqlDB,
-		path: dbPath,
+		DB:         sqlDB,
+		path:       dbPath,
+		transcript: newTranscriptCodec(sqlDB),
 	}
 
 	// Test connection
@@ -55,16 +86,58 @@ func NewDB(config Config) (*DB, error) {
 		return nil, fmt.Errorf("failed to ping database: %w", err)
 	}
 
+	pages, err := openPageJournal(dbPath)
+	if err != nil {
+		sqlDB.Close()
+		return nil, err
+	}
+	db.pages = pages
+	db.wal = &walScanner{path: dbPath + "-wal"}
+	db.stopCheckpoints = make(chan struct{})
+	db.checkpointsDone = make(chan struct{})
+	go db.runCheckpoints()
+
 	return db, nil
 }
 
+// prepareConnection registers the app's SQL functions on a new connection
+// and hands WAL checkpoints to the app, see runCheckpoints
+func prepareConnection(conn *sqlite3.SQLiteConn) error {
+	if err := registerFunctions(conn); err != nil {
+		return err
+	}
+	for _, pragma := range []string{"PRAGMA wal_autocheckpoint = 0", "PRAGMA journal_size_limit = 0"} {
+		if _, err := conn.Exec(pragma, nil); err != nil {
+			return fmt.Errorf("failed to run %s: %w", pragma, err)
+		}
+	}
+	return nil
+}
+
 // Path returns the database file path
 func (db *DB) Path() string {
 	return db.path
 }
 
-// Close closes the database connection
+// TranscriptCodec returns the codec compressing the database's transcript text
+func (db *DB) TranscriptCodec() *TranscriptCodec {
+	return db.transcript
+}
+
+// Close checkpoints the WAL and closes the database connection. SQLite
+// checkpoints again when the last connection closes, without the page
+// journal; after a complete checkpoint that copies nothing.
 func (db *DB) Close() error {
+	if db.stopCheckpoints != nil {
+		close(db.stopCheckpoints)
+		<-db.checkpointsDone
+		db.stopCheckpoints = nil
+
+		if _, err := db.Checkpoint(context.Background()); err != nil {
+			logger.WithError(err).Warn("Final WAL checkpoint failed")
+		}
+		db.pages.close()
+	}
 	if db.DB != nil {
 		return db.DB.Close()
 	}
@@ -77,8 +150,9 @@ func DefaultConfig() Config {
 	dataDir := filepath.Join(homeDir, "Library", "Application Support", "personal-assist")
 	
 	return Config{
-		DataDir: dataDir,
-		DBName:  "personal-assist.db",
+		DataDir:                   dataDir,
+		DBName:                    "personal-assist.db",
+		ConvertAutoVacuumMaxBytes: 256 * 1024 * 1024,
 	}
 }
 
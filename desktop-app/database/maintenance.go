@@ -0,0 +1,491 @@
+package database
+
+import (
+	"context"
+	"database/sql"
+	"fmt"
+	"os"
+	"sync"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/logger"
+)
+
+// MaintenanceConfig controls the database maintenance scheduler
+type MaintenanceConfig struct {
+	CheckInterval        time.Duration // Time between maintenance ticks
+	VacuumThresholdPages int64         // Free pages needed before incremental vacuum runs
+	VacuumBatchPages     int           // Pages released per incremental vacuum batch
+	VacuumMaxPages       int           // Pages released per tick at most
+	VacuumBatchPause     time.Duration // Pause between vacuum batches
+	AnalyzeInterval      time.Duration // Time between ANALYZE runs
+	AnalysisLimit        int           // Rows sampled per index by ANALYZE, 0 for no limit
+
+	TranscriptCompression TranscriptCompressionConfig // Dictionary training and backlog compression
+}
+
+// DefaultMaintenanceConfig returns the default maintenance configuration
+func DefaultMaintenanceConfig() MaintenanceConfig {
+	return MaintenanceConfig{
+		CheckInterval:        time.Minute,
+		VacuumThresholdPages: 256,
+		VacuumBatchPages:     128,
+		VacuumMaxPages:       4096,
+		VacuumBatchPause:     50 * time.Millisecond,
+		AnalyzeInterval:      24 * time.Hour,
+		AnalysisLimit:        1000,
+
+		TranscriptCompression: DefaultTranscriptCompressionConfig(),
+	}
+}
+
+// MaintenanceStats reports database health metrics and maintenance work
+type MaintenanceStats struct {
+	WALSizeBytes       int64     `json:"wal_size_bytes"`
+	FreelistPages      int64     `json:"freelist_pages"`
+	PageCount          int64     `json:"page_count"`
+	PageSize           int64     `json:"page_size"`
+	AutoVacuum         string    `json:"auto_vacuum"`
+	LastCheckpoint     time.Time `json:"last_checkpoint"`
+	LastCheckpointMode string    `json:"last_checkpoint_mode,omitempty"`
+	CheckpointBusy     bool      `json:"checkpoint_busy"`
+	PagesVacuumed      int64     `json:"pages_vacuumed"`
+	LastAnalyze        time.Time `json:"last_analyze"`
+	TranscriptDict     int64     `json:"transcript_dictionary"`
+	ChunksCompressed   int64     `json:"chunks_compressed"`
+	LastRun            time.Time `json:"last_run"`
+	LastError          string    `json:"last_error,omitempty"`
+}
+
+// autoVacuumModes maps PRAGMA auto_vacuum values to names
+var autoVacuumModes = map[int]string{0: "none", 1: "full", 2: "incremental"}
+
+// MaintenanceScheduler keeps the database file healthy in the background.
+// Heavy work (checkpoints, incremental vacuum, ANALYZE) only runs while the
+// app is idle; while busy the DB's own checkpoints keep the WAL in check.
+type MaintenanceScheduler struct {
+	db     *DB
+	config MaintenanceConfig
+
+	idleMutex sync.RWMutex
+	isIdle    func() bool
+
+	ctx    context.Context
+	cancel context.CancelFunc
+	done   chan struct{}
+
+	statsMutex sync.RWMutex
+	stats      MaintenanceStats
+}
+
+// NewMaintenanceScheduler creates a new maintenance scheduler
+func NewMaintenanceScheduler(db *DB, config MaintenanceConfig) *MaintenanceScheduler {
+	return &MaintenanceScheduler{
+		db:     db,
+		config: config,
+	}
+}
+
+// SetIdleFunc sets the function reporting whether the app is idle. Without
+// one the database is never considered idle.
+func (ms *MaintenanceScheduler) SetIdleFunc(isIdle func() bool) {
+	ms.idleMutex.Lock()
+	defer ms.idleMutex.Unlock()
+	ms.isIdle = isIdle
+}
+
+// Start launches the background maintenance loop
+func (ms *MaintenanceScheduler) Start() {
+	if ms.cancel != nil {
+		return
+	}
+
+	ms.ctx, ms.cancel = context.WithCancel(context.Background())
+	ms.done = make(chan struct{})
+	go ms.run()
+
+	logger.WithField("interval", ms.config.CheckInterval.String()).Info("Database maintenance scheduler started")
+}
+
+// Stop cancels any maintenance in progress and waits for the loop to exit
+func (ms *MaintenanceScheduler) Stop() {
+	if ms.cancel == nil {
+		return
+	}
+
+	ms.cancel()
+	<-ms.done
+	ms.cancel = nil
+
+	logger.Info("Database maintenance scheduler stopped")
+}
+
+// GetStats returns the latest metrics
+func (ms *MaintenanceScheduler) GetStats() MaintenanceStats {
+	ms.statsMutex.RLock()
+	defer ms.statsMutex.RUnlock()
+	return ms.stats
+}
+
+// run is the background loop
+func (ms *MaintenanceScheduler) run() {
+	defer close(ms.done)
+
+	ticker := time.NewTicker(ms.config.CheckInterval)
+	defer ticker.Stop()
+
+	for {
+		select {
+		case <-ticker.C:
+			if err := ms.RunOnce(ms.ctx); err != nil && ms.ctx.Err() == nil {
+				logger.WithError(err).Warn("Database maintenance failed")
+			}
+		case <-ms.ctx.Done():
+			return
+		}
+	}
+}
+
+// RunOnce refreshes the metrics and runs whatever maintenance is due
+func (ms *MaintenanceScheduler) RunOnce(ctx context.Context) error {
+	err := ms.maintain(ctx)
+
+	ms.statsMutex.Lock()
+	ms.stats.LastRun = time.Now()
+	ms.stats.LastError = ""
+	if err != nil {
+		ms.stats.LastError = err.Error()
+	}
+	ms.statsMutex.Unlock()
+
+	return err
+}
+
+// maintain runs one maintenance tick
+func (ms *MaintenanceScheduler) maintain(ctx context.Context) error {
+	if err := ms.refreshMetrics(ctx); err != nil {
+		return err
+	}
+	stats := ms.GetStats()
+
+	if !ms.idle() {
+		return nil
+	}
+
+	if stats.WALSizeBytes > 0 {
+		if err := ms.checkpoint(ctx); err != nil {
+			return err
+		}
+	}
+
+	if stats.AutoVacuum == "incremental" && stats.FreelistPages >= ms.config.VacuumThresholdPages {
+		if err := ms.incrementalVacuum(ctx); err != nil {
+			return err
+		}
+	}
+
+	if time.Since(stats.LastAnalyze) >= ms.config.AnalyzeInterval && ms.idle() {
+		if err := ms.analyze(ctx); err != nil {
+			return err
+		}
+	}
+
+	if ms.idle() {
+		if err := ms.compressTranscripts(ctx); err != nil {
+			return err
+		}
+	}
+
+	return ms.refreshMetrics(ctx)
+}
+
+// idle reports whether heavy maintenance may run
+func (ms *MaintenanceScheduler) idle() bool {
+	ms.idleMutex.RLock()
+	defer ms.idleMutex.RUnlock()
+	return ms.isIdle != nil && ms.isIdle()
+}
+
+// refreshMetrics reads WAL size, freelist and page counts
+func (ms *MaintenanceScheduler) refreshMetrics(ctx context.Context) error {
+	var freelist, pageCount, pageSize int64
+	var autoVacuum int
+	pragmas := []struct {
+		name string
+		dest interface{}
+	}{
+		{"freelist_count", &freelist},
+		{"page_count", &pageCount},
+		{"page_size", &pageSize},
+		{"auto_vacuum", &autoVacuum},
+	}
+	for _, pragma := range pragmas {
+		if err := ms.db.QueryRowContext(ctx, "PRAGMA "+pragma.name).Scan(pragma.dest); err != nil {
+			return fmt.Errorf("failed to read %s: %w", pragma.name, err)
+		}
+	}
+
+	var walSize int64
+	if info, err := os.Stat(ms.db.Path() + "-wal"); err == nil {
+		walSize = info.Size()
+	}
+
+	ms.statsMutex.Lock()
+	ms.stats.WALSizeBytes = walSize
+	ms.stats.FreelistPages = freelist
+	ms.stats.PageCount = pageCount
+	ms.stats.PageSize = pageSize
+	ms.stats.AutoVacuum = autoVacuumModes[autoVacuum]
+	ms.statsMutex.Unlock()
+
+	return nil
+}
+
+// checkpoint runs a WAL checkpoint through the DB, which records its pages
+// for backups. Checkpoints are always PASSIVE: a TRUNCATE checkpoint would
+// need writers held off until readers finish. The WAL file is truncated
+// instead when the next write restarts it, see prepareConnection.
+func (ms *MaintenanceScheduler) checkpoint(ctx context.Context) error {
+	result, err := ms.db.Checkpoint(ctx)
+	if err != nil {
+		return err
+	}
+
+	ms.statsMutex.Lock()
+	ms.stats.LastCheckpoint = time.Now()
+	ms.stats.LastCheckpointMode = "PASSIVE"
+	ms.stats.CheckpointBusy = !result.Complete()
+	ms.statsMutex.Unlock()
+
+	logger.WithFields(map[string]interface{}{
+		"mode":         "PASSIVE",
+		"busy":         !result.Complete(),
+		"log_frames":   result.LogFrames,
+		"checkpointed": result.Checkpointed,
+	}).Debug("WAL checkpoint completed")
+
+	return nil
+}
+
+// incrementalVacuum releases free pages in bounded batches, stopping early
+// when the app becomes busy
+func (ms *MaintenanceScheduler) incrementalVacuum(ctx context.Context) error {
+	released := 0
+	for released < ms.config.VacuumMaxPages {
+		n, err := ms.incrementalVacuumBatch(ctx, ms.config.VacuumBatchPages)
+		if err != nil {
+			return err
+		}
+		released += n
+
+		ms.statsMutex.Lock()
+		ms.stats.PagesVacuumed += int64(n)
+		ms.statsMutex.Unlock()
+
+		if n < ms.config.VacuumBatchPages || !ms.idle() {
+			break
+		}
+
+		select {
+		case <-time.After(ms.config.VacuumBatchPause):
+		case <-ctx.Done():
+			return ctx.Err()
+		}
+	}
+
+	if released > 0 {
+		logger.WithField("pages", released).Info("Incremental vacuum released free pages")
+	}
+	return nil
+}
+
+// incrementalVacuumBatch runs PRAGMA incremental_vacuum(n). The pragma frees
+// one page per result row, so the rows have to be drained; a plain Exec would
+// only step it once.
+func (ms *MaintenanceScheduler) incrementalVacuumBatch(ctx context.Context, pages int) (int, error) {
+	rows, err := ms.db.QueryContext(ctx, fmt.Sprintf("PRAGMA incremental_vacuum(%d)", pages))
+	if err != nil {
+		return 0, fmt.Errorf("failed to run incremental vacuum: %w", err)
+	}
+	defer rows.Close()
+
+	released := 0
+	for rows.Next() {
+		released++
+	}
+	if err := rows.Err(); err != nil {
+		return released, fmt.Errorf("failed to run incremental vacuum: %w", err)
+	}
+	return released, nil
+}
+
+// analyze refreshes the query planner statistics
+func (ms *MaintenanceScheduler) analyze(ctx context.Context) error {
+	// analysis_limit is per connection, so pin one for both statements
+	return ms.withConn(ctx, func(conn *sql.Conn) error {
+		if _, err := conn.ExecContext(ctx, fmt.Sprintf("PRAGMA analysis_limit = %d", ms.config.AnalysisLimit)); err != nil {
+			return fmt.Errorf("failed to set analysis limit: %w", err)
+		}
+
+		start := time.Now()
+		if _, err := conn.ExecContext(ctx, "ANALYZE"); err != nil {
+			return fmt.Errorf("failed to analyze database: %w", err)
+		}
+
+		ms.statsMutex.Lock()
+		ms.stats.LastAnalyze = time.Now()
+		ms.statsMutex.Unlock()
+
+		logger.WithField("duration_ms", time.Since(start).Milliseconds()).Info("Database statistics refreshed")
+		return nil
+	})
+}
+
+// compressTranscripts trains a transcript dictionary when there is none or
+// it has aged, then compresses one batch of chunks written before it
+func (ms *MaintenanceScheduler) compressTranscripts(ctx context.Context) error {
+	config := ms.config.TranscriptCompression
+	codec := ms.db.TranscriptCodec()
+
+	trained, err := codec.LastTrained()
+	if err != nil {
+		return err
+	}
+	if time.Since(trained) >= config.RetrainInterval {
+		start := time.Now()
+		id, err := codec.TrainDictionary(ctx, config)
+		if err != nil {
+			return err
+		}
+		if id != 0 {
+			logger.WithFields(map[string]interface{}{
+				"dictionary":  id,
+				"duration_ms": time.Since(start).Milliseconds(),
+			}).Info("Transcript dictionary trained")
+		}
+	}
+
+	compressed, err := codec.CompressBatch(ctx, config.BatchRows)
+	if err != nil {
+		return err
+	}
+	id, err := codec.CurrentDictionaryID()
+	if err != nil {
+		return err
+	}
+
+	ms.statsMutex.Lock()
+	ms.stats.TranscriptDict = id
+	ms.stats.ChunksCompressed += int64(compressed)
+	ms.statsMutex.Unlock()
+
+	if compressed > 0 {
+		logger.WithFields(map[string]interface{}{
+			"chunks":     compressed,
+			"dictionary": id,
+		}).Debug("Transcript chunks compressed")
+	}
+	return nil
+}
+
+// convertAutoVacuum switches a database created without auto_vacuum to
+// incremental mode. The mode only takes effect when the file is rewritten,
+// so the database is vacuumed into a new file that replaces it. NewDB runs
+// this before opening its pool, while nothing else uses the database, and
+// only for files up to maxBytes; larger ones keep their free pages rather
+// than hold up startup. VACUUM may renumber the rowids the full-text index
+// refers to, so the index is rebuilt in the new file before the swap. The
+// page journal no longer matches the file, so the next backup is full.
+func convertAutoVacuum(driverName, dsn, path string, maxBytes int64) error {
+	info, err := os.Stat(path)
+	if err != nil {
+		if os.IsNotExist(err) {
+			return nil // Created in incremental mode
+		}
+		return fmt.Errorf("failed to stat database: %w", err)
+	}
+
+	db, err := sql.Open(driverName, dsn)
+	if err != nil {
+		return fmt.Errorf("failed to open database: %w", err)
+	}
+	defer db.Close()
+	db.SetMaxOpenConns(1)
+
+	var mode int
+	if err := db.QueryRow("PRAGMA auto_vacuum").Scan(&mode); err != nil {
+		return fmt.Errorf("failed to read auto_vacuum: %w", err)
+	}
+	if mode != 0 {
+		return nil
+	}
+	if info.Size() > maxBytes {
+		logger.WithField("size", info.Size()).Info("Database too large to convert to incremental auto_vacuum at startup")
+		return nil
+	}
+
+	start := time.Now()
+	tmpPath := path + ".vacuum"
+	os.Remove(tmpPath)
+	defer os.Remove(tmpPath)
+	if _, err := db.Exec("PRAGMA auto_vacuum = INCREMENTAL"); err != nil {
+		return fmt.Errorf("failed to set auto_vacuum: %w", err)
+	}
+	if _, err := db.Exec("VACUUM INTO ?", tmpPath); err != nil {
+		return fmt.Errorf("failed to vacuum database: %w", err)
+	}
+	if err := rebuildTranscriptIndex(driverName, tmpPath); err != nil {
+		return err
+	}
+
+	// Closing the last connection checkpoints the WAL and removes it. A WAL
+	// left behind would be replayed onto the new file, so the swap only
+	// goes ahead without one.
+	if err := db.Close(); err != nil {
+		return fmt.Errorf("failed to close database: %w", err)
+	}
+	if info, err := os.Stat(path + "-wal"); err == nil && info.Size() > 0 {
+		return fmt.Errorf("database WAL still in use")
+	}
+	os.Remove(path + "-wal")
+	os.Remove(path + "-shm")
+	if err := os.Rename(tmpPath, path); err != nil {
+		return fmt.Errorf("failed to replace database: %w", err)
+	}
+
+	logger.WithField("duration_ms", time.Since(start).Milliseconds()).Info("Database converted to incremental auto_vacuum")
+	return nil
+}
+
+// rebuildTranscriptIndex rebuilds the full-text index of a database file
+// that has one
+func rebuildTranscriptIndex(driverName, path string) error {
+	db, err := sql.Open(driverName, "file:"+path+"?_foreign_keys=on")
+	if err != nil {
+		return fmt.Errorf("failed to open database: %w", err)
+	}
+	defer db.Close()
+
+	var tables int
+	if err := db.QueryRow(`SELECT count(*) FROM sqlite_master WHERE name = 'transcript_fts'`).Scan(&tables); err != nil {
+		return fmt.Errorf("failed to look up transcript index: %w", err)
+	}
+	if tables == 0 {
+		return nil // Built by its migration
+	}
+	if _, err := db.Exec("INSERT INTO transcript_fts(transcript_fts) VALUES('rebuild')"); err != nil {
+		return fmt.Errorf("failed to rebuild transcript index: %w", err)
+	}
+	return db.Close()
+}
+
+// withConn runs fn on a dedicated connection
+func (ms *MaintenanceScheduler) withConn(ctx context.Context, fn func(conn *sql.Conn) error) error {
+	conn, err := ms.db.Conn(ctx)
+	if err != nil {
+		return fmt.Errorf("failed to get connection: %w", err)
+	}
+	defer conn.Close()
+
+	return fn(conn)
+}
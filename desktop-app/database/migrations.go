@@ -233,7 +233,7 @@ func (m *Migrator) tableExists(tableName string) (bool, error) {
 
 // splitSQL splits SQL text into individual statements
 func splitSQL(sql string) []string {
-	// Simple SQL statement splitter - splits on semicolons not in quotes
+	// Simple SQL statement splitter - splits on semicolons not in quotes or trigger bodies
 	var statements []string
 	var current strings.Builder
 	inQuotes := false
@@ -246,7 +246,7 @@ func splitSQL(sql string) []string {
 			if char == '\'' || char == '"' {
 				inQuotes = true
 				quoteChar = char
-			} else if char == ';' {
+			} else if char == ';' && !inTriggerBody(current.String()) {
 				stmt := strings.TrimSpace(current.String())
 				if stmt != "" {
 					statements = append(statements, stmt)
@@ -277,6 +277,18 @@ func splitSQL(sql string) []string {
 	return statements
 }
 
+// inTriggerBody reports whether a partial statement is a CREATE TRIGGER whose
+// BEGIN ... END body is still open, so its semicolons do not end it
+func inTriggerBody(stmt string) bool {
+	fields := strings.Fields(strings.ToUpper(stmt))
+	if len(fields) < 2 || fields[0] != "CREATE" {
+		return false
+	}
+	trigger := fields[1] == "TRIGGER" ||
+		(len(fields) > 2 && (fields[1] == "TEMP" || fields[1] == "TEMPORARY") && fields[2] == "TRIGGER")
+	return trigger && fields[len(fields)-1] != "END"
+}
+
 // CreateMigration creates a new migration with the given SQL
 func CreateMigration(version int, sql string) Migration {
 	return Migration{
@@ -0,0 +1,521 @@
+package database
+
+import (
+	"bytes"
+	"context"
+	"database/sql"
+	"encoding/binary"
+	"fmt"
+	"hash/crc32"
+	"io"
+	"os"
+	"sort"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/logger"
+)
+
+const (
+	pageJournalMagic = "PAPGJNL1"
+
+	// Page journal record types
+	journalPagesRecord = 'P' // Pages about to be checkpointed into the database file
+	journalStateRecord = 'S' // Size and modification time of the file after a checkpoint
+
+	walHeaderSize      = 32
+	walFrameHeaderSize = 24
+
+	// The WAL is checkpointed by the app rather than by SQLite, once it grows
+	// past autoCheckpointBytes, so every page written to the database file
+	// goes through the page journal
+	autoCheckpointBytes    = 4 * 1024 * 1024
+	autoCheckpointInterval = 2 * time.Second
+)
+
+// CheckpointResult is the outcome of a WAL checkpoint
+type CheckpointResult struct {
+	LogFrames    int // Frames committed to the WAL when the checkpoint started
+	Checkpointed int // Of those, frames copied into the database file
+}
+
+// Complete reports whether every frame committed when the checkpoint started
+// reached the database file
+func (r CheckpointResult) Complete() bool {
+	return r.LogFrames <= 0 || r.Checkpointed == r.LogFrames
+}
+
+// journalFileState identifies the database file as a checkpoint left it
+type journalFileState struct {
+	Size    int64
+	ModTime int64
+}
+
+// pageJournal records the pages every checkpoint copies from the WAL into the
+// database file since the last backup snapshot. Checkpoints are the only way
+// committed pages reach the file, so the journal lists every page that can
+// differ from the snapshot, without reading the database. It is a superset:
+// pages written and rolled back, or written twice, are listed once each.
+//
+// The journal is a file next to the database: a header naming the snapshot
+// sequence it is relative to, then appended records. The pages of a
+// checkpoint are synced before the checkpoint runs and the state of the file
+// is appended after it. A file that no longer matches the last state was
+// written without the journal, by another process or by SQLite itself, and
+// the journal no longer covers it.
+type pageJournal struct {
+	path     string
+	dbPath   string
+	file     *os.File
+	sequence int
+	pages    map[uint32]struct{}
+	state    journalFileState
+	lost     bool
+}
+
+// openPageJournal loads the page journal of a database, starting an empty
+// one relative to no snapshot if there is none
+func openPageJournal(dbPath string) (*pageJournal, error) {
+	j := &pageJournal{
+		path:   dbPath + "-pages",
+		dbPath: dbPath,
+		pages:  make(map[uint32]struct{}),
+	}
+
+	data, err := os.ReadFile(j.path)
+	if err != nil && !os.IsNotExist(err) {
+		return nil, fmt.Errorf("failed to read page journal: %w", err)
+	}
+	if len(data) < len(pageJournalMagic)+8 || string(data[:len(pageJournalMagic)]) != pageJournalMagic {
+		return j, j.reset(0)
+	}
+
+	j.sequence = int(binary.BigEndian.Uint64(data[len(pageJournalMagic):]))
+	offset, lastPages := j.readRecords(data, len(pageJournalMagic)+8)
+
+	current, err := j.fileState()
+	if err != nil {
+		return nil, err
+	}
+	if lastPages {
+		// Interrupted between recording pages and their checkpoint
+		j.state = current
+	} else if current != j.state {
+		j.lost = true
+	}
+
+	if j.file, err = os.OpenFile(j.path, os.O_RDWR, 0644); err != nil {
+		return nil, fmt.Errorf("failed to open page journal: %w", err)
+	}
+	// Drop a record torn by a crash so appends follow the last whole one
+	if err := j.file.Truncate(int64(offset)); err != nil {
+		return nil, fmt.Errorf("failed to truncate page journal: %w", err)
+	}
+	if _, err := j.file.Seek(int64(offset), io.SeekStart); err != nil {
+		return nil, fmt.Errorf("failed to seek page journal: %w", err)
+	}
+	if lastPages {
+		if _, err := j.file.Write(stateRecord(j.state)); err != nil {
+			return nil, fmt.Errorf("failed to write page journal: %w", err)
+		}
+	}
+	return j, nil
+}
+
+// readRecords applies the journal records from offset on, stopping at the
+// first incomplete or corrupt one. It returns the offset after the last
+// whole record and whether that record listed pages.
+func (j *pageJournal) readRecords(data []byte, offset int) (int, bool) {
+	lastPages := false
+	for offset < len(data) {
+		var body int
+		switch data[offset] {
+		case journalPagesRecord:
+			if offset+5 > len(data) {
+				return offset, lastPages
+			}
+			body = 5 + 4*int(binary.BigEndian.Uint32(data[offset+1:]))
+		case journalStateRecord:
+			body = 17
+		default:
+			return offset, lastPages
+		}
+		if offset+body+4 > len(data) || crc32.ChecksumIEEE(data[offset:offset+body]) != binary.BigEndian.Uint32(data[offset+body:]) {
+			return offset, lastPages
+		}
+
+		record := data[offset : offset+body]
+		if record[0] == journalPagesRecord {
+			for i := 5; i < len(record); i += 4 {
+				j.pages[binary.BigEndian.Uint32(record[i:])] = struct{}{}
+			}
+			lastPages = true
+		} else {
+			j.state = journalFileState{
+				Size:    int64(binary.BigEndian.Uint64(record[1:])),
+				ModTime: int64(binary.BigEndian.Uint64(record[9:])),
+			}
+			lastPages = false
+		}
+		offset += body + 4
+	}
+	return offset, lastPages
+}
+
+// fileState returns the current state of the database file
+func (j *pageJournal) fileState() (journalFileState, error) {
+	info, err := os.Stat(j.dbPath)
+	if err != nil {
+		if os.IsNotExist(err) {
+			return journalFileState{}, nil
+		}
+		return journalFileState{}, fmt.Errorf("failed to stat database: %w", err)
+	}
+	return journalFileState{Size: info.Size(), ModTime: info.ModTime().UnixNano()}, nil
+}
+
+// verify marks the journal lost if the database file changed since the last
+// checkpoint recorded in it
+func (j *pageJournal) verify() error {
+	current, err := j.fileState()
+	if err != nil {
+		return err
+	}
+	if current != j.state && !j.lost {
+		logger.WithFields(map[string]interface{}{
+			"size":          current.Size,
+			"recorded_size": j.state.Size,
+		}).Warn("Database file changed outside checkpoints, next backup will be a full snapshot")
+		j.lost = true
+	}
+	return nil
+}
+
+// record durably adds the pages of a checkpoint about to run
+func (j *pageJournal) record(pages []uint32) error {
+	var added []uint32
+	for _, pgno := range pages {
+		if _, ok := j.pages[pgno]; !ok {
+			added = append(added, pgno)
+		}
+	}
+	if len(added) == 0 {
+		return nil
+	}
+
+	record := make([]byte, 0, 9+4*len(added))
+	record = append(record, journalPagesRecord)
+	record = binary.BigEndian.AppendUint32(record, uint32(len(added)))
+	for _, pgno := range added {
+		record = binary.BigEndian.AppendUint32(record, pgno)
+	}
+	record = binary.BigEndian.AppendUint32(record, crc32.ChecksumIEEE(record))
+
+	if _, err := j.file.Write(record); err != nil {
+		j.lost = true // Later records would follow a torn one
+		return fmt.Errorf("failed to write page journal: %w", err)
+	}
+	if err := j.file.Sync(); err != nil {
+		return fmt.Errorf("failed to sync page journal: %w", err)
+	}
+	for _, pgno := range added {
+		j.pages[pgno] = struct{}{}
+	}
+	return nil
+}
+
+// checkpointed records the state of the database file after a checkpoint.
+// It is not synced: if it is lost, the state check sends the next backup to
+// a full snapshot instead of a delta.
+func (j *pageJournal) checkpointed() error {
+	state, err := j.fileState()
+	if err != nil {
+		return err
+	}
+	if state == j.state {
+		return nil // Nothing was copied
+	}
+	if _, err := j.file.Write(stateRecord(state)); err != nil {
+		j.lost = true // Later records would follow a torn one
+		return fmt.Errorf("failed to write page journal: %w", err)
+	}
+	j.state = state
+	return nil
+}
+
+// changed returns the sorted pages that may differ from the given snapshot,
+// and false if the journal does not cover it
+func (j *pageJournal) changed(sequence int) ([]uint32, bool) {
+	if j.lost || sequence == 0 || sequence != j.sequence {
+		return nil, false
+	}
+	pages := make([]uint32, 0, len(j.pages))
+	for pgno := range j.pages {
+		pages = append(pages, pgno)
+	}
+	sort.Slice(pages, func(a, b int) bool { return pages[a] < pages[b] })
+	return pages, true
+}
+
+// reset restarts the journal relative to a snapshot of the database file as
+// it is now
+func (j *pageJournal) reset(sequence int) error {
+	state, err := j.fileState()
+	if err != nil {
+		return err
+	}
+
+	data := make([]byte, 0, len(pageJournalMagic)+8+21)
+	data = append(data, pageJournalMagic...)
+	data = binary.BigEndian.AppendUint64(data, uint64(sequence))
+	data = append(data, stateRecord(state)...)
+
+	if j.file != nil {
+		j.file.Close()
+		j.file = nil
+	}
+	if err := writeFileAtomic(j.path, data); err != nil {
+		return fmt.Errorf("failed to write page journal: %w", err)
+	}
+	if j.file, err = os.OpenFile(j.path, os.O_RDWR|os.O_APPEND, 0644); err != nil {
+		return fmt.Errorf("failed to open page journal: %w", err)
+	}
+
+	j.sequence = sequence
+	j.pages = make(map[uint32]struct{})
+	j.state = state
+	j.lost = false
+	return nil
+}
+
+// close closes the journal file
+func (j *pageJournal) close() error {
+	if j.file == nil {
+		return nil
+	}
+	err := j.file.Close()
+	j.file = nil
+	return err
+}
+
+// stateRecord encodes a state record
+func stateRecord(state journalFileState) []byte {
+	record := make([]byte, 0, 21)
+	record = append(record, journalStateRecord)
+	record = binary.BigEndian.AppendUint64(record, uint64(state.Size))
+	record = binary.BigEndian.AppendUint64(record, uint64(state.ModTime))
+	return binary.BigEndian.AppendUint32(record, crc32.ChecksumIEEE(record))
+}
+
+// walScanner lists the pages of the committed frames in the current
+// generation of a WAL file, reading only the frames appended since its last
+// scan. Frames after the last commit frame belong to a transaction still
+// being written, or to one rolled back whose frames the next overwrites, so
+// they are read again by the next scan. Frames of an earlier generation,
+// after the current ones, carry another salt and end the scan.
+type walScanner struct {
+	path       string
+	salt       []byte
+	pageSize   int
+	frames     int // Frames scanned, up to the last commit frame
+	backfilled int // Frames a checkpoint copied into the database file
+}
+
+// scan returns the pages of the frames committed since the last scan
+func (s *walScanner) scan() ([]uint32, error) {
+	file, err := os.Open(s.path)
+	if err != nil {
+		if os.IsNotExist(err) {
+			s.reset(nil, 0)
+			return nil, nil
+		}
+		return nil, fmt.Errorf("failed to open WAL: %w", err)
+	}
+	defer file.Close()
+
+	header := make([]byte, walHeaderSize)
+	if _, err := file.ReadAt(header, 0); err != nil {
+		if err == io.EOF {
+			s.reset(nil, 0) // Empty or truncated WAL
+			return nil, nil
+		}
+		return nil, fmt.Errorf("failed to read WAL header: %w", err)
+	}
+	if binary.BigEndian.Uint32(header[0:4])&^1 != 0x377f0682 {
+		return nil, fmt.Errorf("invalid WAL header")
+	}
+	pageSize := int(binary.BigEndian.Uint32(header[8:12]))
+	if salt := header[16:24]; !bytes.Equal(salt, s.salt) || pageSize != s.pageSize {
+		s.reset(salt, pageSize) // Restarted since the last scan
+	}
+
+	// Only frame headers are read; the pages themselves are skipped
+	frameSize := int64(walFrameHeaderSize + s.pageSize)
+	offset := walHeaderSize + int64(s.frames)*frameSize
+	seen := make(map[uint32]struct{})
+	var pages, pending []uint32
+	frame := make([]byte, walFrameHeaderSize)
+	for n := s.frames + 1; ; n++ {
+		if _, err := file.ReadAt(frame, offset); err != nil {
+			if err == io.EOF {
+				break
+			}
+			return nil, fmt.Errorf("failed to read WAL frame: %w", err)
+		}
+		if !bytes.Equal(frame[8:16], s.salt) {
+			break
+		}
+		pending = append(pending, binary.BigEndian.Uint32(frame[0:4]))
+		if binary.BigEndian.Uint32(frame[4:8]) != 0 { // Commit frame
+			for _, pgno := range pending {
+				if _, ok := seen[pgno]; !ok {
+					seen[pgno] = struct{}{}
+					pages = append(pages, pgno)
+				}
+			}
+			pending = pending[:0]
+			s.frames = n
+		}
+		offset += frameSize
+	}
+	return pages, nil
+}
+
+// reset starts scanning a new generation of the WAL
+func (s *walScanner) reset(salt []byte, pageSize int) {
+	s.salt = append(s.salt[:0], salt...)
+	s.pageSize = pageSize
+	s.frames = 0
+	s.backfilled = 0
+}
+
+// Checkpoint copies the WAL into the database file, recording the pages it
+// copies in the page journal first. Writers are held off only while the
+// frames committed since the last scan are read and a reader snapshot is
+// taken. The snapshot bounds the checkpoint to the frames it saw, so the
+// copying itself runs alongside writers and the journal still lists
+// exactly what reached the file. The checkpoint is PASSIVE: readers still
+// using old frames are not waited for, and their frames stay in the WAL.
+func (db *DB) Checkpoint(ctx context.Context) (CheckpointResult, error) {
+	db.checkpointMutex.Lock()
+	defer db.checkpointMutex.Unlock()
+	return db.checkpointLocked(ctx, nil)
+}
+
+// checkpointLocked runs a checkpoint with checkpointMutex held. inTx, when
+// set, is called once the checkpoint is done on the connection holding the
+// snapshot it was bounded to, to read the database as the checkpoint left
+// it when the checkpoint is complete.
+func (db *DB) checkpointLocked(ctx context.Context, inTx func(conn *sql.Conn) error) (CheckpointResult, error) {
+	result := CheckpointResult{LogFrames: -1, Checkpointed: -1}
+
+	if err := db.pages.verify(); err != nil {
+		return result, err
+	}
+	// Most of the WAL is read before writers are held off
+	pages, err := db.wal.scan()
+	if err != nil {
+		return result, err
+	}
+	if err := db.pages.record(pages); err != nil {
+		return result, err
+	}
+
+	snapshot, err := db.Conn(ctx)
+	if err != nil {
+		return result, fmt.Errorf("failed to get connection: %w", err)
+	}
+	defer snapshot.Close()
+	if pages, err = db.snapshotWAL(ctx, snapshot); err != nil {
+		return result, err
+	}
+	defer snapshot.ExecContext(context.Background(), "ROLLBACK")
+	if err := db.pages.record(pages); err != nil {
+		return result, err
+	}
+
+	// A PASSIVE checkpoint copies no frame past the oldest reader's
+	// snapshot, so frames committed since the snapshot stay in the WAL.
+	// Frames already copied are not checkpointed again: with every frame
+	// copied the snapshot reads the database file alone, which does not
+	// hold the checkpoint back.
+	result.LogFrames = db.wal.frames
+	result.Checkpointed = db.wal.backfilled
+	if db.wal.frames > db.wal.backfilled {
+		var busy, logFrames int
+		if err := db.QueryRowContext(ctx, "PRAGMA wal_checkpoint(PASSIVE)").Scan(&busy, &logFrames, &result.Checkpointed); err != nil {
+			return result, fmt.Errorf("failed to checkpoint: %w", err)
+		}
+		if err := db.pages.checkpointed(); err != nil {
+			return result, err
+		}
+		if result.Checkpointed > db.wal.frames {
+			result.Checkpointed = db.wal.frames
+		}
+		db.wal.backfilled = result.Checkpointed
+	}
+
+	if inTx != nil {
+		if err := inTx(snapshot); err != nil {
+			return result, err
+		}
+	}
+	return result, nil
+}
+
+// snapshotWAL holds writers off while it reads the frames committed since
+// the last scan and starts a read transaction on the snapshot connection, so
+// the snapshot holds exactly the frames scanned. It returns the pages of the
+// frames read.
+func (db *DB) snapshotWAL(ctx context.Context, snapshot *sql.Conn) ([]uint32, error) {
+	writer, err := db.Conn(ctx)
+	if err != nil {
+		return nil, fmt.Errorf("failed to get connection: %w", err)
+	}
+	defer writer.Close()
+
+	if _, err := writer.ExecContext(ctx, "BEGIN IMMEDIATE"); err != nil {
+		return nil, fmt.Errorf("failed to hold off writers: %w", err)
+	}
+	defer writer.ExecContext(context.Background(), "ROLLBACK")
+
+	if _, err := snapshot.ExecContext(ctx, "BEGIN"); err != nil {
+		return nil, fmt.Errorf("failed to begin snapshot: %w", err)
+	}
+	var tables int
+	if err := snapshot.QueryRowContext(ctx, "SELECT count(*) FROM sqlite_master").Scan(&tables); err != nil {
+		snapshot.ExecContext(context.Background(), "ROLLBACK")
+		return nil, fmt.Errorf("failed to begin snapshot: %w", err)
+	}
+	pages, err := db.wal.scan()
+	if err != nil {
+		snapshot.ExecContext(context.Background(), "ROLLBACK")
+		return nil, err
+	}
+	return pages, nil
+}
+
+// runCheckpoints checkpoints the WAL whenever it grows past
+// autoCheckpointBytes, in place of SQLite's automatic checkpoints. With
+// journal_size_limit at zero the WAL is truncated when it restarts, so its
+// size follows the frames it holds.
+func (db *DB) runCheckpoints() {
+	defer close(db.checkpointsDone)
+
+	ticker := time.NewTicker(autoCheckpointInterval)
+	defer ticker.Stop()
+
+	for {
+		select {
+		case <-ticker.C:
+			info, err := os.Stat(db.path + "-wal")
+			if err != nil || info.Size() < autoCheckpointBytes {
+				continue
+			}
+			if _, err := db.Checkpoint(context.Background()); err != nil {
+				logger.WithError(err).Warn("WAL checkpoint failed")
+			}
+		case <-db.stopCheckpoints:
+			return
+		}
+	}
+}
@@ -88,8 +88,8 @@ CREATE TABLE schema_migrations (
     applied_at INTEGER NOT NULL        -- Unix timestamp
 );
 
--- Note: FTS5 not available in this SQLite build, using LIKE for text search instead
--- Full-text search can be implemented at application level
+-- Note: FTS5 not available in this SQLite build; full-text search uses the
+-- FTS4 index over transcript_chunks added by migration 6
 
 -- Insert initial schema version
 INSERT INTO schema_migrations (version, applied_at) VALUES (1, strftime('%s', 'now'));
\ No newline at end of file
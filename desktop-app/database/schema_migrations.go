@@ -0,0 +1,144 @@
+package database
+
+// SchemaMigrations returns the migrations applied on top of schema.sql.
+// schema.sql is version 1; new versions are appended here and never edited
+// once released. Statements must not start with a comment line because the
+// migrator skips statements beginning with "--".
+func SchemaMigrations() []Migration {
+	return []Migration{
+		// Tombstone support for the background garbage collector. The partial
+		// index keeps the purge scan proportional to the number of deleted
+		// activities instead of the whole table.
+		CreateMigration(2, `
+ALTER TABLE activities ADD COLUMN purge_started_at INTEGER;
+CREATE INDEX IF NOT EXISTS idx_activities_deleted_at ON activities(deleted_at) WHERE deleted_at IS NOT NULL;
+`),
+		// Retention support. Audio files removed by the retention engine are
+		// tracked per recording so transcripts can outlive their audio; the
+		// partial index covers the age and size queries over audio still on disk.
+		CreateMigration(3, `
+ALTER TABLE audio_recordings ADD COLUMN audio_purged_at INTEGER;
+CREATE INDEX IF NOT EXISTS idx_audio_recordings_retention ON audio_recordings(created_at, file_size) WHERE audio_purged_at IS NULL;
+CREATE INDEX IF NOT EXISTS idx_transcript_chunks_created_at ON transcript_chunks(created_at);
+`),
+		// Transcript and recording fetches filter on the parent id and sort by
+		// time; with single-column indexes every fetch sorted its rows in a
+		// temporary b-tree. The composite indexes return rows in order and
+		// replace the single-column ones, which are their prefixes.
+		CreateMigration(4, `
+CREATE INDEX IF NOT EXISTS idx_transcript_chunks_activity_start ON transcript_chunks(activity_id, start_time);
+DROP INDEX IF EXISTS idx_transcript_chunks_activity_id;
+CREATE INDEX IF NOT EXISTS idx_transcript_chunks_recording_start ON transcript_chunks(audio_recording_id, start_time);
+DROP INDEX IF EXISTS idx_transcript_chunks_audio_recording_id;
+CREATE INDEX IF NOT EXISTS idx_audio_recordings_activity_created ON audio_recordings(activity_id, created_at);
+DROP INDEX IF EXISTS idx_audio_recordings_activity_id;
+`),
+		// Two-tier transcription. A recording's transcript is a fast draft
+		// until the refinement pass replaces it; the partial index keeps the
+		// refinement queue scan proportional to the drafts still pending.
+		CreateMigration(5, `
+ALTER TABLE audio_recordings ADD COLUMN transcript_tier TEXT;
+ALTER TABLE audio_recordings ADD COLUMN transcript_model TEXT;
+CREATE INDEX IF NOT EXISTS idx_audio_recordings_draft ON audio_recordings(created_at) WHERE transcript_tier = 'draft';
+`),
+		// Compressed transcript text. Chunks move their text to text_z,
+		// DEFLATE with the trained dictionary text_dict; text_dict stays NULL
+		// until a chunk has been considered, which the partial index finds.
+		// Search goes through an FTS4 index whose external content is a view
+		// of the plain text, so the index never stores the text again and
+		// FTS4 reads old values through the view when it deletes. Rewriting
+		// a chunk in its other form leaves the text and the index as they were.
+		CreateMigration(6, `
+ALTER TABLE transcript_chunks ADD COLUMN text_z BLOB;
+ALTER TABLE transcript_chunks ADD COLUMN text_dict INTEGER;
+CREATE TABLE IF NOT EXISTS transcript_dictionaries (
+    id INTEGER PRIMARY KEY,
+    data BLOB NOT NULL,
+    sample_chunks INTEGER NOT NULL,
+    created_at INTEGER NOT NULL
+);
+CREATE INDEX IF NOT EXISTS idx_transcript_chunks_uncompressed ON transcript_chunks(created_at) WHERE text_dict IS NULL;
+CREATE VIEW IF NOT EXISTS transcript_chunk_text AS
+    SELECT rowid AS rowid,
+        CASE WHEN text_z IS NULL THEN text
+        ELSE transcript_text(text, text_z, (SELECT data FROM transcript_dictionaries WHERE id = text_dict)) END AS text
+    FROM transcript_chunks;
+CREATE VIRTUAL TABLE IF NOT EXISTS transcript_fts USING fts4(content="transcript_chunk_text", text, tokenize=unicode61);
+INSERT INTO transcript_fts(transcript_fts) VALUES('rebuild');
+CREATE TRIGGER IF NOT EXISTS transcript_chunks_fts_insert AFTER INSERT ON transcript_chunks BEGIN
+    INSERT INTO transcript_fts(docid, text) SELECT rowid, text FROM transcript_chunk_text WHERE rowid = new.rowid;
+END;
+CREATE TRIGGER IF NOT EXISTS transcript_chunks_fts_delete BEFORE DELETE ON transcript_chunks BEGIN
+    DELETE FROM transcript_fts WHERE docid = old.rowid;
+END;
+CREATE TRIGGER IF NOT EXISTS transcript_chunks_fts_before_update BEFORE UPDATE OF text, text_z, text_dict ON transcript_chunks
+WHEN (CASE WHEN old.text_z IS NULL THEN old.text ELSE transcript_text(old.text, old.text_z, (SELECT data FROM transcript_dictionaries WHERE id = old.text_dict)) END)
+    IS NOT (CASE WHEN new.text_z IS NULL THEN new.text ELSE transcript_text(new.text, new.text_z, (SELECT data FROM transcript_dictionaries WHERE id = new.text_dict)) END)
+BEGIN
+    DELETE FROM transcript_fts WHERE docid = old.rowid;
+END;
+CREATE TRIGGER IF NOT EXISTS transcript_chunks_fts_after_update AFTER UPDATE OF text, text_z, text_dict ON transcript_chunks
+WHEN (CASE WHEN old.text_z IS NULL THEN old.text ELSE transcript_text(old.text, old.text_z, (SELECT data FROM transcript_dictionaries WHERE id = old.text_dict)) END)
+    IS NOT (CASE WHEN new.text_z IS NULL THEN new.text ELSE transcript_text(new.text, new.text_z, (SELECT data FROM transcript_dictionaries WHERE id = new.text_dict)) END)
+BEGIN
+    INSERT INTO transcript_fts(docid, text) SELECT rowid, text FROM transcript_chunk_text WHERE rowid = new.rowid;
+END;
+`),
+		// Materialized activity transcripts, one blob of every chunk per
+		// activity (see storage/activity_transcript.go). Storage updates a
+		// blob in the transaction that changes its chunks; the triggers drop
+		// it on any other change, and the next read rebuilds it.
+		CreateMigration(7, `
+CREATE TABLE IF NOT EXISTS activity_transcripts (
+    activity_id TEXT PRIMARY KEY,
+    data BLOB NOT NULL,
+    updated_at INTEGER NOT NULL,
+    FOREIGN KEY (activity_id) REFERENCES activities(id) ON DELETE CASCADE
+);
+CREATE TRIGGER IF NOT EXISTS transcript_chunks_materialized_insert AFTER INSERT ON transcript_chunks BEGIN
+    DELETE FROM activity_transcripts WHERE activity_id = new.activity_id;
+END;
+CREATE TRIGGER IF NOT EXISTS transcript_chunks_materialized_delete AFTER DELETE ON transcript_chunks BEGIN
+    DELETE FROM activity_transcripts WHERE activity_id = old.activity_id;
+END;
+CREATE TRIGGER IF NOT EXISTS transcript_chunks_materialized_update AFTER UPDATE ON transcript_chunks
+WHEN old.id IS NOT new.id OR old.user_id IS NOT new.user_id OR old.activity_id IS NOT new.activity_id
+    OR old.audio_recording_id IS NOT new.audio_recording_id OR old.start_time IS NOT new.start_time OR old.end_time IS NOT new.end_time
+    OR old.speaker IS NOT new.speaker OR old.confidence IS NOT new.confidence OR old.language IS NOT new.language
+    OR old.created_at IS NOT new.created_at
+    OR (CASE WHEN old.text_z IS NULL THEN old.text ELSE transcript_text(old.text, old.text_z, (SELECT data FROM transcript_dictionaries WHERE id = old.text_dict)) END)
+        IS NOT (CASE WHEN new.text_z IS NULL THEN new.text ELSE transcript_text(new.text, new.text_z, (SELECT data FROM transcript_dictionaries WHERE id = new.text_dict)) END)
+BEGIN
+    DELETE FROM activity_transcripts WHERE activity_id IN (old.activity_id, new.activity_id);
+END;
+`),
+		// Regions of each recording as last transcribed, with a fingerprint
+		// of the decoder input and the chunk each produced, so transcribing
+		// a recording again decodes only the regions that changed
+		CreateMigration(8, `
+CREATE TABLE IF NOT EXISTS transcript_regions (
+    audio_recording_id TEXT NOT NULL,
+    start_sample INTEGER NOT NULL,
+    end_sample INTEGER NOT NULL,
+    fingerprint BLOB NOT NULL,
+    chunk_id TEXT,
+    PRIMARY KEY (audio_recording_id, start_sample),
+    FOREIGN KEY (audio_recording_id) REFERENCES audio_recordings(id) ON DELETE CASCADE
+) WITHOUT ROWID;
+`),
+		// Audio files retention failed to delete. The retention queries back
+		// off from a recording after each failure instead of retrying it
+		// first on every pass.
+		CreateMigration(9, `
+ALTER TABLE audio_recordings ADD COLUMN purge_attempts INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE audio_recordings ADD COLUMN purge_failed_at INTEGER;
+`),
+		// Drafts the refiner failed to refine. The draft query leaves out
+		// those that failed too often until a retry delay has passed, so
+		// they do not fill every batch ahead of newer drafts.
+		CreateMigration(10, `
+ALTER TABLE audio_recordings ADD COLUMN refine_attempts INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE audio_recordings ADD COLUMN refine_failed_at INTEGER;
+`),
+	}
+}
@@ -0,0 +1,519 @@
+package database
+
+import (
+	"bytes"
+	"compress/flate"
+	"context"
+	"database/sql"
+	"fmt"
+	"io"
+	"sort"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/mattn/go-sqlite3"
+)
+
+// DriverName is the database/sql driver databases are opened with: SQLite
+// with the functions called by the schema registered on every connection.
+//
+// Every connection to the app's database must go through it, tools and
+// restored backups included. The transcript_chunk_text view, the FTS index
+// whose external content it is, and the transcript_chunks triggers of
+// migrations 6 and 7 call transcript_text(); on a connection without it,
+// inserting, updating or deleting chunks, rebuilding or checking the index
+// and reading the view all fail with "no such function". The plain
+// "sqlite3" driver is only fit for copying pages, as BackupTo does.
+const DriverName = "sqlite3_personal_assist"
+
+func init() {
+	sql.Register(DriverName, NewSQLiteDriver())
+}
+
+// NewSQLiteDriver returns a SQLite driver preparing each connection with
+// prepareConnection. Tools wrapping the driver must start from this one, or
+// writes to transcript_chunks fail in the full-text triggers.
+func NewSQLiteDriver() *sqlite3.SQLiteDriver {
+	return &sqlite3.SQLiteDriver{ConnectHook: prepareConnection}
+}
+
+// registerFunctions registers the app's SQL functions on a connection
+func registerFunctions(conn *sqlite3.SQLiteConn) error {
+	if err := conn.RegisterFunc("transcript_text", transcriptTextSQL, true); err != nil {
+		return fmt.Errorf("failed to register transcript_text: %w", err)
+	}
+	return nil
+}
+
+// transcriptTextSQL implements transcript_text(text, text_z, dictionary),
+// the plain text of a chunk stored either way, for the full-text triggers
+func transcriptTextSQL(text, compressed, dictionary interface{}) (string, error) {
+	data, _ := compressed.([]byte)
+	if data == nil {
+		plain, _ := text.(string)
+		return plain, nil
+	}
+	dict, _ := dictionary.([]byte)
+	if dict == nil {
+		return "", fmt.Errorf("transcript dictionary missing")
+	}
+	return inflateText(data, dict)
+}
+
+// TranscriptCodec compresses transcript text with DEFLATE primed by a preset
+// dictionary trained on the database's own transcripts. A chunk is a few
+// hundred bytes of conversation, too short for repeats within it to pay
+// off; the dictionary supplies the phrases chunks share instead. Each row
+// records the dictionary it was written with, so retraining never
+// invalidates existing rows.
+type TranscriptCodec struct {
+	db *sql.DB
+
+	mutex        sync.RWMutex
+	dictionaries map[int64]*transcriptDictionary
+	current      *transcriptDictionary
+	loaded       bool                  // Whether current was looked up
+	plain        *transcriptDictionary // Empty, for blobs compressed before there was a dictionary
+}
+
+// transcriptDictionary is a trained dictionary with its primed coders
+type transcriptDictionary struct {
+	id        int64
+	data      []byte
+	createdAt time.Time
+	writers   sync.Pool // *flate.Writer
+	readers   sync.Pool // io.ReadCloser implementing flate.Resetter
+}
+
+// TranscriptCompressionConfig controls dictionary training and the
+// compression of chunks written before a dictionary existed
+type TranscriptCompressionConfig struct {
+	DictionarySize      int           // Bytes of a dictionary, at most the 32KB DEFLATE window
+	DictionarySamples   int           // Most recent chunks a dictionary is trained on
+	DictionaryMinChunks int           // Chunks needed before the first dictionary
+	RetrainInterval     time.Duration // Age at which the dictionary is retrained
+	BatchRows           int           // Chunks compressed per batch
+}
+
+// DefaultTranscriptCompressionConfig returns the default configuration
+func DefaultTranscriptCompressionConfig() TranscriptCompressionConfig {
+	return TranscriptCompressionConfig{
+		DictionarySize:      32 * 1024,
+		DictionarySamples:   5000,
+		DictionaryMinChunks: 200,
+		RetrainInterval:     7 * 24 * time.Hour,
+		BatchRows:           2000,
+	}
+}
+
+// newTranscriptCodec creates the codec of a database
+func newTranscriptCodec(db *sql.DB) *TranscriptCodec {
+	return &TranscriptCodec{
+		db:           db,
+		dictionaries: make(map[int64]*transcriptDictionary),
+		plain:        &transcriptDictionary{},
+	}
+}
+
+// Compress returns text compressed with the current dictionary and the
+// dictionary's ID. Without a dictionary the ID is 0 and text stays plain;
+// when compression would not make it smaller the data is nil but the ID is
+// set, so the chunk is not considered again.
+func (c *TranscriptCodec) Compress(text string) ([]byte, int64, error) {
+	dict, err := c.currentDictionary()
+	if err != nil || dict == nil {
+		return nil, 0, err
+	}
+
+	compressed, err := dict.deflate([]byte(text))
+	if err != nil {
+		return nil, 0, fmt.Errorf("failed to compress transcript text: %w", err)
+	}
+	if len(compressed) >= len(text) {
+		return nil, dict.id, nil
+	}
+	return compressed, dict.id, nil
+}
+
+// Decompress returns the text of a chunk compressed with a dictionary
+func (c *TranscriptCodec) Decompress(data []byte, dictionaryID int64) (string, error) {
+	dict, err := c.dictionary(dictionaryID)
+	if err != nil {
+		return "", err
+	}
+
+	var text strings.Builder
+	text.Grow(4 * len(data))
+	if err := dict.inflate(&text, data); err != nil {
+		return "", fmt.Errorf("failed to decompress transcript text: %w", err)
+	}
+	return text.String(), nil
+}
+
+// CompressBlob returns data holding transcript text, such as an activity's
+// materialized transcript, compressed with the current dictionary and the
+// dictionary's ID. Before there is a dictionary the data is compressed
+// without one and the ID is 0. Unlike Compress, the result is never nil.
+func (c *TranscriptCodec) CompressBlob(data []byte) ([]byte, int64, error) {
+	dict, err := c.currentDictionary()
+	if err != nil {
+		return nil, 0, err
+	}
+	if dict == nil {
+		dict = c.plain
+	}
+
+	compressed, err := dict.deflate(data)
+	if err != nil {
+		return nil, 0, fmt.Errorf("failed to compress transcript blob: %w", err)
+	}
+	return compressed, dict.id, nil
+}
+
+// DecompressBlob returns data compressed by CompressBlob
+func (c *TranscriptCodec) DecompressBlob(data []byte, dictionaryID int64) ([]byte, error) {
+	dict := c.plain
+	if dictionaryID != 0 {
+		var err error
+		if dict, err = c.dictionary(dictionaryID); err != nil {
+			return nil, err
+		}
+	}
+
+	var blob bytes.Buffer
+	blob.Grow(4 * len(data))
+	if err := dict.inflate(&blob, data); err != nil {
+		return nil, fmt.Errorf("failed to decompress transcript blob: %w", err)
+	}
+	return blob.Bytes(), nil
+}
+
+// deflate compresses data primed with the dictionary
+func (d *transcriptDictionary) deflate(data []byte) ([]byte, error) {
+	var buffer bytes.Buffer
+	writer, _ := d.writers.Get().(*flate.Writer)
+	if writer == nil {
+		var err error
+		if writer, err = flate.NewWriterDict(&buffer, flate.BestCompression, d.data); err != nil {
+			return nil, fmt.Errorf("failed to create compressor: %w", err)
+		}
+	} else {
+		writer.Reset(&buffer)
+	}
+	defer d.writers.Put(writer)
+
+	if _, err := writer.Write(data); err != nil {
+		return nil, err
+	}
+	if err := writer.Close(); err != nil {
+		return nil, err
+	}
+	return buffer.Bytes(), nil
+}
+
+// inflate decompresses data primed with the dictionary into dst
+func (d *transcriptDictionary) inflate(dst io.Writer, data []byte) error {
+	source := bytes.NewReader(data)
+	reader, _ := d.readers.Get().(io.ReadCloser)
+	if reader == nil {
+		reader = flate.NewReader(source)
+	}
+	defer d.readers.Put(reader)
+	if err := reader.(flate.Resetter).Reset(source, d.data); err != nil {
+		return fmt.Errorf("failed to reset decompressor: %w", err)
+	}
+	_, err := io.Copy(dst, reader)
+	return err
+}
+
+// LastTrained returns when the current dictionary was trained, zero when
+// there is none yet
+func (c *TranscriptCodec) LastTrained() (time.Time, error) {
+	dict, err := c.currentDictionary()
+	if err != nil || dict == nil {
+		return time.Time{}, err
+	}
+	return dict.createdAt, nil
+}
+
+// CurrentDictionaryID returns the ID of the dictionary new text is
+// compressed with, 0 when there is none yet
+func (c *TranscriptCodec) CurrentDictionaryID() (int64, error) {
+	dict, err := c.currentDictionary()
+	if err != nil || dict == nil {
+		return 0, err
+	}
+	return dict.id, nil
+}
+
+// TrainDictionary trains a dictionary on the most recent chunks and makes
+// it the one new text is compressed with. It returns 0 without training
+// when there are fewer than the configured minimum of chunks.
+func (c *TranscriptCodec) TrainDictionary(ctx context.Context, config TranscriptCompressionConfig) (int64, error) {
+	rows, err := c.db.QueryContext(ctx, `
+		SELECT text, text_z, text_dict FROM transcript_chunks
+		ORDER BY created_at DESC
+		LIMIT ?`, config.DictionarySamples)
+	if err != nil {
+		return 0, fmt.Errorf("failed to sample transcript chunks: %w", err)
+	}
+	var samples []string
+	for rows.Next() {
+		var text string
+		var compressed []byte
+		var dictionaryID sql.NullInt64
+		if err := rows.Scan(&text, &compressed, &dictionaryID); err != nil {
+			rows.Close()
+			return 0, fmt.Errorf("failed to scan transcript sample: %w", err)
+		}
+		if compressed != nil {
+			if text, err = c.Decompress(compressed, dictionaryID.Int64); err != nil {
+				rows.Close()
+				return 0, err
+			}
+		}
+		samples = append(samples, text)
+	}
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return 0, fmt.Errorf("error iterating transcript samples: %w", err)
+	}
+	if len(samples) < config.DictionaryMinChunks {
+		return 0, nil
+	}
+
+	data := TrainTranscriptDictionary(samples, config.DictionarySize)
+	createdAt := time.Now()
+	result, err := c.db.ExecContext(ctx,
+		`INSERT INTO transcript_dictionaries (data, sample_chunks, created_at) VALUES (?, ?, ?)`,
+		data, len(samples), createdAt.Unix())
+	if err != nil {
+		return 0, fmt.Errorf("failed to store transcript dictionary: %w", err)
+	}
+	id, err := result.LastInsertId()
+	if err != nil {
+		return 0, fmt.Errorf("failed to get transcript dictionary id: %w", err)
+	}
+
+	dict := &transcriptDictionary{id: id, data: data, createdAt: time.Unix(createdAt.Unix(), 0)}
+	c.mutex.Lock()
+	c.dictionaries[id] = dict
+	c.current = dict
+	c.loaded = true
+	c.mutex.Unlock()
+	return id, nil
+}
+
+// CompressBatch compresses up to limit chunks written before there was a
+// dictionary, oldest first, and returns how many it rewrote
+func (c *TranscriptCodec) CompressBatch(ctx context.Context, limit int) (int, error) {
+	dict, err := c.currentDictionary()
+	if err != nil || dict == nil {
+		return 0, err
+	}
+
+	type pending struct {
+		rowid int64
+		text  string
+	}
+	rows, err := c.db.QueryContext(ctx, `
+		SELECT rowid, text FROM transcript_chunks
+		WHERE text_dict IS NULL
+		ORDER BY created_at
+		LIMIT ?`, limit)
+	if err != nil {
+		return 0, fmt.Errorf("failed to query uncompressed transcript chunks: %w", err)
+	}
+	var batch []pending
+	for rows.Next() {
+		var p pending
+		if err := rows.Scan(&p.rowid, &p.text); err != nil {
+			rows.Close()
+			return 0, fmt.Errorf("failed to scan transcript chunk: %w", err)
+		}
+		batch = append(batch, p)
+	}
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return 0, fmt.Errorf("error iterating transcript chunks: %w", err)
+	}
+	if len(batch) == 0 {
+		return 0, nil
+	}
+
+	tx, err := c.db.BeginTx(ctx, nil)
+	if err != nil {
+		return 0, fmt.Errorf("failed to begin transaction: %w", err)
+	}
+	defer tx.Rollback()
+
+	stmt, err := tx.PrepareContext(ctx, `UPDATE transcript_chunks SET text = ?, text_z = ?, text_dict = ? WHERE rowid = ?`)
+	if err != nil {
+		return 0, fmt.Errorf("failed to prepare transcript update: %w", err)
+	}
+	defer stmt.Close()
+
+	for _, p := range batch {
+		compressed, id, err := c.Compress(p.text)
+		if err != nil {
+			return 0, err
+		}
+		text := p.text
+		if compressed != nil {
+			text = ""
+		}
+		if _, err := stmt.ExecContext(ctx, text, compressed, id, p.rowid); err != nil {
+			return 0, fmt.Errorf("failed to compress transcript chunk: %w", err)
+		}
+	}
+
+	if err := tx.Commit(); err != nil {
+		return 0, fmt.Errorf("failed to commit transcript compression: %w", err)
+	}
+	return len(batch), nil
+}
+
+// currentDictionary returns the newest dictionary, nil when none exists
+func (c *TranscriptCodec) currentDictionary() (*transcriptDictionary, error) {
+	c.mutex.RLock()
+	dict, loaded := c.current, c.loaded
+	c.mutex.RUnlock()
+	if loaded {
+		return dict, nil
+	}
+
+	var id, createdAt int64
+	var data []byte
+	err := c.db.QueryRow(`SELECT id, data, created_at FROM transcript_dictionaries ORDER BY id DESC LIMIT 1`).
+		Scan(&id, &data, &createdAt)
+	if err != nil && err != sql.ErrNoRows {
+		return nil, fmt.Errorf("failed to get transcript dictionary: %w", err)
+	}
+
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	if !c.loaded {
+		if err == nil {
+			c.current = c.cache(id, data, createdAt)
+		}
+		c.loaded = true
+	}
+	return c.current, nil
+}
+
+// dictionary returns a dictionary by ID, loading it on first use
+func (c *TranscriptCodec) dictionary(id int64) (*transcriptDictionary, error) {
+	c.mutex.RLock()
+	dict := c.dictionaries[id]
+	c.mutex.RUnlock()
+	if dict != nil {
+		return dict, nil
+	}
+
+	var data []byte
+	var createdAt int64
+	err := c.db.QueryRow(`SELECT data, created_at FROM transcript_dictionaries WHERE id = ?`, id).Scan(&data, &createdAt)
+	if err != nil {
+		return nil, fmt.Errorf("failed to get transcript dictionary %d: %w", id, err)
+	}
+
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	return c.cache(id, data, createdAt), nil
+}
+
+// cache keeps a loaded dictionary, returning the one already kept if any.
+// The caller holds the write lock.
+func (c *TranscriptCodec) cache(id int64, data []byte, createdAt int64) *transcriptDictionary {
+	if dict := c.dictionaries[id]; dict != nil {
+		return dict
+	}
+	dict := &transcriptDictionary{id: id, data: data, createdAt: time.Unix(createdAt, 0)}
+	c.dictionaries[id] = dict
+	return dict
+}
+
+// inflateText decompresses text with a dictionary, without pooling, for the
+// SQL function
+func inflateText(data, dict []byte) (string, error) {
+	reader := flate.NewReaderDict(bytes.NewReader(data), dict)
+	defer reader.Close()
+	var text strings.Builder
+	if _, err := io.Copy(&text, reader); err != nil {
+		return "", fmt.Errorf("failed to decompress transcript text: %w", err)
+	}
+	return text.String(), nil
+}
+
+// dictionaryMaxWords is the longest phrase the trainer considers
+const dictionaryMaxWords = 6
+
+// TrainTranscriptDictionary builds a DEFLATE preset dictionary of at most
+// size bytes from sample texts. Every phrase of one to six words is scored
+// by the bytes a match against it would save over all samples, occurrences
+// times length beyond a match's own cost, and the best phrases not already
+// contained in a better one are packed in. The best go last: DEFLATE codes
+// nearer matches in fewer bits.
+func TrainTranscriptDictionary(samples []string, size int) []byte {
+	size = min(size, 32*1024)
+	counts := make(map[string]int)
+	for _, sample := range samples {
+		words := strings.Fields(sample)
+		seen := make(map[string]bool)
+		for i := range words {
+			phrase := ""
+			for n := 0; n < dictionaryMaxWords && i+n < len(words); n++ {
+				phrase += " " + words[i+n]
+				// Count a phrase once per sample, so one long repetitive
+				// chunk does not decide the dictionary
+				if !seen[phrase] {
+					seen[phrase] = true
+					counts[phrase]++
+				}
+			}
+		}
+	}
+
+	type candidate struct {
+		phrase string
+		score  int
+	}
+	candidates := make([]candidate, 0, len(counts))
+	for phrase, count := range counts {
+		// A match costs about three bytes, and a phrase seen once saves nothing
+		if score := (count - 1) * (len(phrase) - 3); count > 1 && score > 0 {
+			candidates = append(candidates, candidate{phrase, score})
+		}
+	}
+	sort.Slice(candidates, func(i, j int) bool {
+		if candidates[i].score != candidates[j].score {
+			return candidates[i].score > candidates[j].score
+		}
+		return candidates[i].phrase < candidates[j].phrase
+	})
+
+	var chosen []string
+	var packed strings.Builder
+	used := 0
+	for _, c := range candidates {
+		if size-used < 4 {
+			break
+		}
+		if used+len(c.phrase) > size {
+			continue
+		}
+		if strings.Contains(packed.String(), c.phrase) {
+			continue
+		}
+		chosen = append(chosen, c.phrase)
+		packed.WriteString(c.phrase)
+		used += len(c.phrase)
+	}
+
+	dict := make([]byte, 0, used)
+	for i := len(chosen) - 1; i >= 0; i-- {
+		dict = append(dict, chosen[i]...)
+	}
+	return dict
+}
@@ -5,6 +5,8 @@ import {views} from '../models';
 
 export function CreateActivity(arg1:string,arg2:string):Promise<models.Activity>;
 
+export function CreateBackup():Promise<void>;
+
 export function CreateRecordingWithMode(arg1:string,arg2:string):Promise<views.RecordingSession>;
 
 export function CreateTestActivity():Promise<Record<string, any>>;
@@ -55,12 +57,16 @@ export function HideWindow():Promise<void>;
 
 export function ListActivities():Promise<Record<string, any>>;
 
+export function ListBackups():Promise<Array<{[key: string]: any}>>;
+
 export function ProcessActivityTranscription(arg1:string):Promise<void>;
 
 export function ProcessRecordingTranscription(arg1:string,arg2:string):Promise<void>;
 
 export function QuitApp():Promise<void>;
 
+export function RestoreActivity(arg1:string):Promise<void>;
+
 export function SearchActivityTranscripts(arg1:string):Promise<Array<models.TranscriptChunk>>;
 
 export function SearchTranscripts(arg1:string):Promise<Array<models.TranscriptChunk>>;
@@ -6,6 +6,10 @@ export function CreateActivity(arg1, arg2) {
   return window['go']['main']['App']['CreateActivity'](arg1, arg2);
 }
 
+export function CreateBackup() {
+  return window['go']['main']['App']['CreateBackup']();
+}
+
 export function CreateRecordingWithMode(arg1, arg2) {
   return window['go']['main']['App']['CreateRecordingWithMode'](arg1, arg2);
 }
@@ -106,6 +110,10 @@ export function ListActivities() {
   return window['go']['main']['App']['ListActivities']();
 }
 
+export function ListBackups() {
+  return window['go']['main']['App']['ListBackups']();
+}
+
 export function ProcessActivityTranscription(arg1) {
   return window['go']['main']['App']['ProcessActivityTranscription'](arg1);
 }
@@ -118,6 +126,10 @@ export function QuitApp() {
   return window['go']['main']['App']['QuitApp']();
 }
 
+export function RestoreActivity(arg1) {
+  return window['go']['main']['App']['RestoreActivity'](arg1);
+}
+
 export function SearchActivityTranscripts(arg1) {
   return window['go']['main']['App']['SearchActivityTranscripts'](arg1);
 }
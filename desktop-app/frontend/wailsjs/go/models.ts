@@ -119,6 +119,8 @@ export namespace models {
 	    created_at: any;
 	    // Go type: time
 	    updated_at: any;
+	    // Go type: time
+	    audio_purged_at?: any;
 	
 	    static createFrom(source: any = {}) {
 	        return new AudioRecording(source);
@@ -137,6 +139,7 @@ export namespace models {
 	        this.config = this.convertValues(source["config"], RecordingConfig);
 	        this.created_at = this.convertValues(source["created_at"], null);
 	        this.updated_at = this.convertValues(source["updated_at"], null);
+	        this.audio_purged_at = this.convertValues(source["audio_purged_at"], null);
 	    }
 	
 		convertValues(a: any, classs: any, asMap: boolean = false): any {
@@ -209,6 +212,42 @@ export namespace models {
 		    return a;
 		}
 	}
+	export class TranscriptionReport {
+	    segments: number;
+	    low_confidence: number;
+	    redecoded: number;
+	    improved: number;
+	    first_pass_confidence: number;
+	    confidence: number;
+	    audio_seconds: number;
+	    redecoded_seconds: number;
+	    decode_time: number;
+	    redecode_time: number;
+	    redecode_method?: string;
+	    language_checks: number;
+	    language_switches: number;
+	
+	    static createFrom(source: any = {}) {
+	        return new TranscriptionReport(source);
+	    }
+	
+	    constructor(source: any = {}) {
+	        if ('string' === typeof source) source = JSON.parse(source);
+	        this.segments = source["segments"];
+	        this.low_confidence = source["low_confidence"];
+	        this.redecoded = source["redecoded"];
+	        this.improved = source["improved"];
+	        this.first_pass_confidence = source["first_pass_confidence"];
+	        this.confidence = source["confidence"];
+	        this.audio_seconds = source["audio_seconds"];
+	        this.redecoded_seconds = source["redecoded_seconds"];
+	        this.decode_time = source["decode_time"];
+	        this.redecode_time = source["redecode_time"];
+	        this.redecode_method = source["redecode_method"];
+	        this.language_checks = source["language_checks"];
+	        this.language_switches = source["language_switches"];
+	    }
+	}
 	export class TranscriptionStatus {
 	    stage: string;
 	    progress: number;
@@ -219,6 +258,7 @@ export namespace models {
 	    // Go type: time
 	    started_at: any;
 	    last_error?: string;
+	    report?: TranscriptionReport;
 	
 	    static createFrom(source: any = {}) {
 	        return new TranscriptionStatus(source);
@@ -234,6 +274,7 @@ export namespace models {
 	        this.estimated_time = source["estimated_time"];
 	        this.started_at = this.convertValues(source["started_at"], null);
 	        this.last_error = source["last_error"];
+	        this.report = this.convertValues(source["report"], TranscriptionReport);
 	    }
 	
 		convertValues(a: any, classs: any, asMap: boolean = false): any {
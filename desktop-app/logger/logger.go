@@ -146,6 +146,12 @@ func GetLogger() *logrus.Logger {
 	return Logger
 }
 
+// DebugEnabled reports whether debug messages are logged, so hot paths can
+// skip building their fields
+func DebugEnabled() bool {
+	return GetLogger().IsLevelEnabled(logrus.DebugLevel)
+}
+
 // WithField creates a new logger entry with a single field
 func WithField(key string, value interface{}) *logrus.Entry {
 	return GetLogger().WithField(key, value)
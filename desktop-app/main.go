@@ -84,6 +84,9 @@ func main() {
 		OnStartup: func(ctx context.Context) {
 			app.startup(ctx)
 		},
+		OnShutdown: func(ctx context.Context) {
+			app.shutdown(ctx)
+		},
 		Bind: []interface{}{
 			app,
 		},
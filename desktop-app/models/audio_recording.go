@@ -29,6 +29,7 @@ type AudioRecording struct {
 	Config         RecordingConfig      `json:"config" db:"config"`
 	CreatedAt      time.Time            `json:"created_at" db:"created_at"`
 	UpdatedAt      time.Time            `json:"updated_at" db:"updated_at"`
+	AudioPurgedAt  *time.Time           `json:"audio_purged_at,omitempty" db:"audio_purged_at"` // Set when retention removed the audio file
 }
 
 // AudioDeviceInfo contains information about the recording device
@@ -110,6 +111,11 @@ func (ar *AudioRecording) IsCompleted() bool {
 	return ar.Status == AudioRecordingStatusCompleted
 }
 
+// HasAudio returns false once retention has removed the audio file
+func (ar *AudioRecording) HasAudio() bool {
+	return ar.AudioPurgedAt == nil
+}
+
 // DeviceInfoToJSON converts device info to JSON string for database storage
 func (ar *AudioRecording) DeviceInfoToJSON() (string, error) {
 	data, err := json.Marshal(ar.DeviceInfo)
@@ -0,0 +1,40 @@
+package models
+
+import "time"
+
+// RetentionPolicy controls how long recorded data is kept. Zero values mean
+// keep forever, so the zero policy never deletes anything.
+type RetentionPolicy struct {
+	AudioRetentionDays      int   `json:"audio_retention_days,omitempty"`      // Remove audio files older than this
+	AudioStorageCapMB       int64 `json:"audio_storage_cap_mb,omitempty"`      // Remove oldest audio above this total
+	TranscriptRetentionDays int   `json:"transcript_retention_days,omitempty"` // Remove transcript chunks older than this
+}
+
+// IsEmpty returns true if the policy keeps everything
+func (p RetentionPolicy) IsEmpty() bool {
+	return p.AudioRetentionDays <= 0 && p.AudioStorageCapMB <= 0 && p.TranscriptRetentionDays <= 0
+}
+
+// AudioMaxAge returns the maximum audio age, or 0 to keep audio forever
+func (p RetentionPolicy) AudioMaxAge() time.Duration {
+	if p.AudioRetentionDays <= 0 {
+		return 0
+	}
+	return time.Duration(p.AudioRetentionDays) * 24 * time.Hour
+}
+
+// AudioStorageCapBytes returns the audio storage cap in bytes, or 0 for no cap
+func (p RetentionPolicy) AudioStorageCapBytes() int64 {
+	if p.AudioStorageCapMB <= 0 {
+		return 0
+	}
+	return p.AudioStorageCapMB * 1024 * 1024
+}
+
+// TranscriptMaxAge returns the maximum transcript age, or 0 to keep transcripts forever
+func (p RetentionPolicy) TranscriptMaxAge() time.Duration {
+	if p.TranscriptRetentionDays <= 0 {
+		return 0
+	}
+	return time.Duration(p.TranscriptRetentionDays) * 24 * time.Hour
+}
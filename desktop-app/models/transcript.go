@@ -7,6 +7,13 @@ import (
 	"github.com/google/uuid"
 )
 
+// Transcript tiers of a recording. A draft comes from a fast model right
+// after recording and is replaced by a final transcript from a larger model.
+const (
+	TranscriptTierDraft = "draft"
+	TranscriptTierFinal = "final"
+)
+
 // TranscriptChunk represents a segment of transcribed audio
 type TranscriptChunk struct {
 	ID                string    `json:"id" db:"id"`
@@ -22,6 +29,16 @@ type TranscriptChunk struct {
 	CreatedAt         time.Time `json:"created_at" db:"created_at"`
 }
 
+// TranscriptRegion is a span of a recording as last transcribed: its
+// samples in the 16kHz audio, a fingerprint of the decoder input and the
+// chunk it produced, empty when it produced none
+type TranscriptRegion struct {
+	StartSample int    `json:"start_sample" db:"start_sample"`
+	EndSample   int    `json:"end_sample" db:"end_sample"`
+	Fingerprint []byte `json:"fingerprint" db:"fingerprint"`
+	ChunkID     string `json:"chunk_id,omitempty" db:"chunk_id"`
+}
+
 // NewTranscriptChunk creates a new transcript chunk
 func NewTranscriptChunk(userID, activityID, audioRecordingID, text string, startTime, endTime float64) *TranscriptChunk {
 	return &TranscriptChunk{
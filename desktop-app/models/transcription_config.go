@@ -13,6 +13,18 @@ type TranscriptionConfig struct {
 	OverlapDuration    int      `json:"overlap_duration"`               // seconds
 	NoSpeechThreshold  float64  `json:"no_speech_threshold"`
 	CustomVocabulary   []string `json:"custom_vocabulary,omitempty"`
+	BeamSize           int      `json:"beam_size"`                      // 0 or 1 decodes greedily
+	Streams            int      `json:"streams"`                        // Chunks decoded concurrently from mel input
+	LanguageWindows    int      `json:"language_windows"`               // Speech windows sampled to lock an "auto" language per recording, 0 detects per chunk
+	NoiseSuppression   bool     `json:"noise_suppression"`              // Suppress stationary background noise before Whisper
+
+	// Segments whose confidence is below RedecodeThreshold are decoded again,
+	// with RedecodeModel when set and otherwise with beam search on the same
+	// model. A threshold of 0, the default, disables re-decoding; callers opt
+	// in by setting one.
+	RedecodeThreshold float64 `json:"redecode_threshold"`
+	RedecodeModel     string  `json:"redecode_model,omitempty"`
+	RedecodeBeamSize  int     `json:"redecode_beam_size"`
 }
 
 // DefaultTranscriptionConfig returns a sensible default configuration
@@ -27,6 +39,13 @@ func DefaultTranscriptionConfig() TranscriptionConfig {
 		OverlapDuration:   5,
 		NoSpeechThreshold: 0.6,
 		CustomVocabulary:  make([]string, 0),
+		BeamSize:          1,
+		Streams:           2,
+		LanguageWindows:   3,
+		NoiseSuppression:  true,
+		RedecodeThreshold: 0,
+		RedecodeModel:     "",
+		RedecodeBeamSize:  5,
 	}
 }
 
@@ -40,6 +59,64 @@ type TranscriptionStatus struct {
 	EstimatedTime   time.Duration `json:"estimated_time"`
 	StartedAt       time.Time     `json:"started_at"`
 	LastError       string        `json:"last_error,omitempty"`
+	Report          *TranscriptionReport `json:"report,omitempty"`
+}
+
+// TranscriptionReport shows what confidence-targeted re-decoding cost and
+// what it gained over a transcription job. Confidences are the geometric
+// mean probability of a segment's text tokens, averaged over segments
+// weighted by their duration.
+type TranscriptionReport struct {
+	Segments            int           `json:"segments"`
+	LowConfidence       int           `json:"low_confidence"` // Segments below the re-decoding threshold
+	Redecoded           int           `json:"redecoded"`
+	Improved            int           `json:"improved"` // Re-decoded segments whose new text was kept
+	FirstPassConfidence float64       `json:"first_pass_confidence"`
+	Confidence          float64       `json:"confidence"` // After re-decoding
+	AudioSeconds        float64       `json:"audio_seconds"`
+	RedecodedSeconds    float64       `json:"redecoded_seconds"`
+	DecodeTime          time.Duration `json:"decode_time"`
+	RedecodeTime        time.Duration `json:"redecode_time"`
+	RedecodeMethod      string        `json:"redecode_method,omitempty"` // Model ID or "beam_search"
+	LanguageChecks      int           `json:"language_checks"`           // Chunks whose language was detected again
+	LanguageSwitches    int           `json:"language_switches"`         // Chunks decoded in another language than the recording's
+	ChunksDecoded       int           `json:"chunks_decoded"`
+	ChunksReused        int           `json:"chunks_reused"` // Chunks whose audio was unchanged since the last transcription
+}
+
+// AddSegment records one decoded segment and its confidence before and after re-decoding
+func (r *TranscriptionReport) AddSegment(duration, firstPass, final float64) {
+	if duration <= 0 {
+		duration = 0.01
+	}
+	total := r.AudioSeconds + duration
+	r.FirstPassConfidence = (r.FirstPassConfidence*r.AudioSeconds + firstPass*duration) / total
+	r.Confidence = (r.Confidence*r.AudioSeconds + final*duration) / total
+	r.AudioSeconds = total
+	r.Segments++
+}
+
+// Merge adds the counts and times of another report
+func (r *TranscriptionReport) Merge(other TranscriptionReport) {
+	if total := r.AudioSeconds + other.AudioSeconds; total > 0 {
+		r.FirstPassConfidence = (r.FirstPassConfidence*r.AudioSeconds + other.FirstPassConfidence*other.AudioSeconds) / total
+		r.Confidence = (r.Confidence*r.AudioSeconds + other.Confidence*other.AudioSeconds) / total
+		r.AudioSeconds = total
+	}
+	r.Segments += other.Segments
+	r.LowConfidence += other.LowConfidence
+	r.Redecoded += other.Redecoded
+	r.Improved += other.Improved
+	r.RedecodedSeconds += other.RedecodedSeconds
+	r.DecodeTime += other.DecodeTime
+	r.RedecodeTime += other.RedecodeTime
+	r.LanguageChecks += other.LanguageChecks
+	r.LanguageSwitches += other.LanguageSwitches
+	r.ChunksDecoded += other.ChunksDecoded
+	r.ChunksReused += other.ChunksReused
+	if other.RedecodeMethod != "" {
+		r.RedecodeMethod = other.RedecodeMethod
+	}
 }
 
 // NewTranscriptionStatus creates a new transcription status
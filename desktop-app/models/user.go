@@ -24,6 +24,8 @@ type UserSettings struct {
 	TranscriptionLanguage string `json:"transcription_language,omitempty"`
 	AudioQuality        string  `json:"audio_quality,omitempty"`
 	StorageLocation     string  `json:"storage_location,omitempty"`
+	Retention           RetentionPolicy `json:"retention"`
+	MemoryBudgetMB      int64   `json:"memory_budget_mb,omitempty"` // Memory for models, caches and jobs; 0 is half the RAM
 }
 
 // NewUser creates a new user with default settings
@@ -10,6 +10,8 @@ type WhisperModel struct {
 	Languages    []string `json:"languages"`     // Supported languages
 	Accuracy     string   `json:"accuracy"`      // "good", "better", "best"
 	Speed        string   `json:"speed"`         // "fast", "medium", "slow"
+	Memory       int64    `json:"memory"`        // Memory needed to run it, weights and one decoder state
+	Quantizes    string   `json:"quantizes,omitempty"` // ID of the full-precision model this is a quantized copy of
 }
 
 // AvailableWhisperModels returns the list of available Whisper models
@@ -24,6 +26,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"multilingual"},
 			Accuracy:     "good",
 			Speed:        "fast",
+			Memory:       273*1024*1024,
 		},
 		{
 			ID:           "tiny.en",
@@ -34,6 +37,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"en"},
 			Accuracy:     "good",
 			Speed:        "fast",
+			Memory:       273*1024*1024,
 		},
 		{
 			ID:           "small",
@@ -44,6 +48,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"multilingual"},
 			Accuracy:     "better",
 			Speed:        "medium",
+			Memory:       852*1024*1024,
 		},
 		{
 			ID:           "small.en",
@@ -54,6 +59,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"en"},
 			Accuracy:     "better",
 			Speed:        "medium",
+			Memory:       852*1024*1024,
 		},
 		{
 			ID:           "medium",
@@ -64,6 +70,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"multilingual"},
 			Accuracy:     "better",
 			Speed:        "medium",
+			Memory:       2100*1024*1024,
 		},
 		{
 			ID:           "medium.en",
@@ -74,6 +81,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"en"},
 			Accuracy:     "better",
 			Speed:        "medium",
+			Memory:       2100*1024*1024,
 		},
 		{
 			ID:           "large",
@@ -84,6 +92,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"multilingual"},
 			Accuracy:     "best",
 			Speed:        "slow",
+			Memory:       3900*1024*1024,
 		},
 		{
 			ID:           "large-v1",
@@ -94,6 +103,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"multilingual"},
 			Accuracy:     "best",
 			Speed:        "slow",
+			Memory:       3900*1024*1024,
 		},
 		{
 			ID:           "large-v2",
@@ -104,6 +114,7 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"multilingual"},
 			Accuracy:     "best",
 			Speed:        "slow",
+			Memory:       3900*1024*1024,
 		},
 		{
 			ID:           "large-v3",
@@ -114,6 +125,57 @@ func AvailableWhisperModels() []WhisperModel {
 			Languages:    []string{"multilingual"},
 			Accuracy:     "best",
 			Speed:        "slow",
+			Memory:       3900*1024*1024,
+		},
+		// Quantized copies: whisper.cpp decodes them at close to the
+		// accuracy of the originals with about half the memory
+		{
+			ID:           "tiny-q5_1",
+			Name:         "Tiny Quantized (31 MB)",
+			Size:         31*1024*1024,
+			IsDownloaded: false,
+			IsActive:     false,
+			Languages:    []string{"multilingual"},
+			Accuracy:     "good",
+			Speed:        "fast",
+			Memory:       250*1024*1024,
+			Quantizes:    "tiny",
+		},
+		{
+			ID:           "small-q5_1",
+			Name:         "Small Quantized (181 MB)",
+			Size:         181*1024*1024,
+			IsDownloaded: false,
+			IsActive:     false,
+			Languages:    []string{"multilingual"},
+			Accuracy:     "better",
+			Speed:        "medium",
+			Memory:       560*1024*1024,
+			Quantizes:    "small",
+		},
+		{
+			ID:           "medium-q5_0",
+			Name:         "Medium Quantized (514 MB)",
+			Size:         514*1024*1024,
+			IsDownloaded: false,
+			IsActive:     false,
+			Languages:    []string{"multilingual"},
+			Accuracy:     "better",
+			Speed:        "medium",
+			Memory:       1100*1024*1024,
+			Quantizes:    "medium",
+		},
+		{
+			ID:           "large-v3-q5_0",
+			Name:         "Large v3 Quantized (1031 MB)",
+			Size:         1031*1024*1024,
+			IsDownloaded: false,
+			IsActive:     false,
+			Languages:    []string{"multilingual"},
+			Accuracy:     "best",
+			Speed:        "slow",
+			Memory:       1900*1024*1024,
+			Quantizes:    "large-v3",
 		},
 	}
 }
@@ -129,6 +191,26 @@ func GetModelByID(id string) (*WhisperModel, bool) {
 	return nil, false
 }
 
+// GetQuantizedVariant returns the quantized copy of a model, if there is one
+func GetQuantizedVariant(id string) (*WhisperModel, bool) {
+	models := AvailableWhisperModels()
+	for i, model := range models {
+		if model.Quantizes == id {
+			return &models[i], true
+		}
+	}
+	return nil, false
+}
+
+// StateMemory returns the memory of one decoder state, the part of Memory
+// that every concurrent transcription needs again
+func (wm *WhisperModel) StateMemory() int64 {
+	if wm.Memory <= wm.Size {
+		return 0
+	}
+	return wm.Memory - wm.Size
+}
+
 // GetSizeMB returns the model size in megabytes
 func (wm *WhisperModel) GetSizeMB() float64 {
 	return float64(wm.Size) / (1024 * 1024)
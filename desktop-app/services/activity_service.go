@@ -167,7 +167,8 @@ func (s *ActivityService) SetActivityMetadata(userID, id, key string, value inte
 	return activity, nil
 }
 
-// DeleteActivity soft deletes an activity (keeps in database but marks as deleted)
+// DeleteActivity soft deletes an activity (keeps in database but marks as deleted).
+// Files and rows are purged later by the GarbageCollector once the grace period ends.
 func (s *ActivityService) DeleteActivity(userID, id string) error {
 	logger.WithField("activity_id", id).Info("ActivityService DeleteActivity called (soft delete)")
 
@@ -231,11 +232,8 @@ func (s *ActivityService) RestoreActivity(userID, id string) error {
 		"title":       activity.Title,
 	}).Info("Restoring soft-deleted activity")
 
-	// Restore the activity
-	activity.Restore()
-
-	// Update in database
-	if err := s.storage.UpdateActivity(activity); err != nil {
+	// Clear the tombstone; this fails once the garbage collector has claimed it
+	if err := s.storage.RestoreActivity(userID, id); err != nil {
 		logger.WithError(err).WithField("activity_id", id).Error("Failed to restore activity in database")
 		return fmt.Errorf("failed to restore activity: %w", err)
 	}
@@ -19,6 +19,7 @@ import (
 type AudioRecorder struct {
 	activeRecordings map[string]*RecordingProcess
 	mutex           sync.RWMutex
+	replaySource    string // Audio file captured instead of the devices, for load testing
 }
 
 // RecordingProcess represents an active recording process
@@ -34,6 +35,13 @@ type RecordingProcess struct {
 	UseCoreAudioTap bool // Whether using Core Audio Taps instead of ffmpeg
 }
 
+// RecordingStats describes a stopped recording
+type RecordingStats struct {
+	Duration time.Duration // Wall time from start to stop
+	CPUTime  time.Duration // CPU used by ffmpeg, 0 with Core Audio Taps
+	FileSize int64
+}
+
 // NewAudioRecorder creates a new audio recorder
 func NewAudioRecorder() *AudioRecorder {
 	return &AudioRecorder{
@@ -41,6 +49,16 @@ func NewAudioRecorder() *AudioRecorder {
 	}
 }
 
+// SetReplaySource makes recordings read an audio file in real time, looped,
+// in place of every capture device, so many concurrent recordings can be
+// load tested on machines without audio hardware. An empty path restores
+// device capture. Recordings already running are not affected.
+func (r *AudioRecorder) SetReplaySource(filePath string) {
+	r.mutex.Lock()
+	defer r.mutex.Unlock()
+	r.replaySource = filePath
+}
+
 // ListAudioDevices lists available audio input devices using ffmpeg
 func (r *AudioRecorder) ListAudioDevices() ([]models.AudioDeviceInfo, error) {
 	logger.Info("Listing available audio input devices")
@@ -207,14 +225,32 @@ func (r *AudioRecorder) StartRecording(recordingID, filePath string, device mode
 		"sample_rate":  config.SampleRate,
 	}).Info("Starting audio recording")
 
+	// Reserve the ID, then start the capture without holding the lock, so
+	// one slow process start does not hold up every other recording
 	r.mutex.Lock()
-	defer r.mutex.Unlock()
-
-	// Check if recording is already active
 	if _, exists := r.activeRecordings[recordingID]; exists {
+		r.mutex.Unlock()
 		logger.WithField("recording_id", recordingID).Warn("Recording already active")
 		return fmt.Errorf("recording %s is already active", recordingID)
 	}
+	recording := &RecordingProcess{
+		ID:       recordingID,
+		FilePath: filePath,
+		Config:   config,
+		Device:   device,
+	}
+	r.activeRecordings[recordingID] = recording
+	replaySource := r.replaySource
+	r.mutex.Unlock()
+
+	started := false
+	defer func() {
+		if !started {
+			r.mutex.Lock()
+			delete(r.activeRecordings, recordingID)
+			r.mutex.Unlock()
+		}
+	}()
 
 	// Create directory for the file if it doesn't exist
 	dir := ""
@@ -237,7 +273,7 @@ func (r *AudioRecorder) StartRecording(recordingID, filePath string, device mode
 	useCoreAudioTap := false
 	macVersion := coreaudio.GetMacOSVersion()
 
-	if config.RecordingMode == "mixed" && macVersion.SupportsCoreAudioTaps() {
+	if config.RecordingMode == "mixed" && replaySource == "" && macVersion.SupportsCoreAudioTaps() {
 		logger.WithFields(map[string]interface{}{
 			"recording_id":  recordingID,
 			"macos_version": macVersion.String(),
@@ -279,14 +315,14 @@ func (r *AudioRecorder) StartRecording(recordingID, filePath string, device mode
 		// Use traditional ffmpeg approach
 		switch config.RecordingMode {
 		case "microphone":
-			cmd = r.createMicrophoneOnlyCommand(filePath, device, config)
+			cmd = r.createMicrophoneOnlyCommand(filePath, device, config, replaySource)
 		case "system":
-			cmd = r.createSystemAudioCommand(filePath, device, config)
+			cmd = r.createSystemAudioCommand(filePath, device, config, replaySource)
 		case "mixed":
-			cmd = r.createMixedAudioCommand(filePath, device, config)
+			cmd = r.createMixedAudioCommand(filePath, device, config, replaySource)
 		default:
 			// Default to microphone only for backwards compatibility
-			cmd = r.createMicrophoneOnlyCommand(filePath, device, config)
+			cmd = r.createMicrophoneOnlyCommand(filePath, device, config, replaySource)
 		}
 
 		logger.WithFields(map[string]interface{}{
@@ -301,24 +337,22 @@ func (r *AudioRecorder) StartRecording(recordingID, filePath string, device mode
 		}
 	}
 
-	// Store the recording process
-	r.activeRecordings[recordingID] = &RecordingProcess{
-		ID:              recordingID,
-		FilePath:        filePath,
-		Config:          config,
-		Device:          device,
-		Process:         cmd,
-		CoreAudioTapRec: coreAudioRec,
-		StartTime:       time.Now(),
-		IsActive:        true,
-		UseCoreAudioTap: useCoreAudioTap,
-	}
+	// Complete the reserved recording
+	r.mutex.Lock()
+	recording.Process = cmd
+	recording.CoreAudioTapRec = coreAudioRec
+	recording.StartTime = time.Now()
+	recording.IsActive = true
+	recording.UseCoreAudioTap = useCoreAudioTap
+	r.mutex.Unlock()
+	started = true
 
 	logger.WithFields(map[string]interface{}{
 		"recording_id":       recordingID,
 		"file_path":          filePath,
 		"use_core_audio_tap": useCoreAudioTap,
 		"macos_version":      macVersion.String(),
+		"replay_source":      replaySource,
 	}).Info("Audio recording started successfully")
 
 	return nil
@@ -326,17 +360,31 @@ func (r *AudioRecorder) StartRecording(recordingID, filePath string, device mode
 
 // StopRecording stops the recording process
 func (r *AudioRecorder) StopRecording(recordingID string) error {
+	_, err := r.StopRecordingWithStats(recordingID)
+	return err
+}
+
+// StopRecordingWithStats stops the recording process and returns how long
+// it ran and what it cost
+func (r *AudioRecorder) StopRecordingWithStats(recordingID string) (*RecordingStats, error) {
 	logger.WithField("recording_id", recordingID).Info("Stopping audio recording")
 
+	// Take the recording out of the active set, then stop it without holding
+	// the lock: ffmpeg may take seconds to finish the file
 	r.mutex.Lock()
-	defer r.mutex.Unlock()
-
-	// Get the recording process
 	recording, exists := r.activeRecordings[recordingID]
 	if !exists {
+		r.mutex.Unlock()
 		logger.WithField("recording_id", recordingID).Warn("Recording not found or already stopped")
-		return fmt.Errorf("recording %s not found", recordingID)
+		return nil, fmt.Errorf("recording %s not found", recordingID)
+	}
+	if !recording.IsActive {
+		r.mutex.Unlock()
+		return nil, fmt.Errorf("recording %s is still starting", recordingID)
 	}
+	delete(r.activeRecordings, recordingID)
+	r.mutex.Unlock()
+	stats := &RecordingStats{Duration: time.Since(recording.StartTime)}
 
 	// Stop Core Audio Taps recorder if used
 	if recording.UseCoreAudioTap && recording.CoreAudioTapRec != nil {
@@ -379,31 +427,34 @@ func (r *AudioRecorder) StopRecording(recordingID string) error {
 		case <-time.After(5 * time.Second):
 			logger.WithField("recording_id", recordingID).Warn("ffmpeg process did not finish within timeout, force killing")
 			recording.Process.Process.Kill()
+			<-done
 		}
 
+		if state := recording.Process.ProcessState; state != nil {
+			stats.CPUTime = state.UserTime() + state.SystemTime()
+		}
 		recording.IsActive = false
 	}
 
-	// Remove from active recordings
-	delete(r.activeRecordings, recordingID)
-
 	// Check if file was created and has content
 	if fileInfo, err := os.Stat(recording.FilePath); err == nil {
+		stats.FileSize = fileInfo.Size()
 		logger.WithFields(map[string]interface{}{
 			"recording_id": recordingID,
 			"file_path":    recording.FilePath,
 			"file_size":    fileInfo.Size(),
-			"duration":     time.Since(recording.StartTime).Seconds(),
+			"duration":     stats.Duration.Seconds(),
+			"cpu_time":     stats.CPUTime.Seconds(),
 		}).Info("Audio recording stopped successfully")
 	} else {
 		logger.WithError(err).WithFields(map[string]interface{}{
 			"recording_id": recordingID,
 			"file_path":    recording.FilePath,
 		}).Error("Audio file was not created or is not accessible")
-		return fmt.Errorf("audio file not found after recording: %w", err)
+		return nil, fmt.Errorf("audio file not found after recording: %w", err)
 	}
 
-	return nil
+	return stats, nil
 }
 
 // IsRecording checks if a recording is currently active
@@ -467,7 +518,7 @@ func (r *AudioRecorder) StopAllRecordings() error {
 }
 
 // createMicrophoneOnlyCommand creates an ffmpeg command for microphone-only recording
-func (r *AudioRecorder) createMicrophoneOnlyCommand(filePath string, device models.AudioDeviceInfo, config models.RecordingConfig) *exec.Cmd {
+func (r *AudioRecorder) createMicrophoneOnlyCommand(filePath string, device models.AudioDeviceInfo, config models.RecordingConfig, replaySource string) *exec.Cmd {
 	var audioInput string
 
 	// Parse device ID to get the actual index
@@ -481,33 +532,33 @@ func (r *AudioRecorder) createMicrophoneOnlyCommand(filePath string, device mode
 		audioInput = fmt.Sprintf(":%s", device.DeviceID)
 	}
 
-	return exec.Command("ffmpeg",
-		"-f", "avfoundation",                        // macOS audio framework
-		"-i", audioInput,                            // Audio input device (microphone)
+	args := captureInput(audioInput, replaySource) // Audio input device (microphone)
+	args = append(args,
 		"-ar", fmt.Sprintf("%d", config.SampleRate), // Sample rate
 		"-ac", "2",                                  // Stereo output
 		"-y",                                        // Overwrite output file
 		filePath,
 	)
+	return exec.Command("ffmpeg", args...)
 }
 
 // createSystemAudioCommand creates an ffmpeg command for system audio recording
-func (r *AudioRecorder) createSystemAudioCommand(filePath string, device models.AudioDeviceInfo, config models.RecordingConfig) *exec.Cmd {
+func (r *AudioRecorder) createSystemAudioCommand(filePath string, device models.AudioDeviceInfo, config models.RecordingConfig, replaySource string) *exec.Cmd {
 	// For system audio, we need to use the output device as input
 	// This requires special macOS permissions and setup
 
-	return exec.Command("ffmpeg",
-		"-f", "avfoundation",                        // macOS audio framework
-		"-i", ":1",                                  // System audio (typically index 1)
+	args := captureInput(":1", replaySource) // System audio (typically index 1)
+	args = append(args,
 		"-ar", fmt.Sprintf("%d", config.SampleRate), // Sample rate
 		"-ac", "2",                                  // Stereo output
 		"-y",                                        // Overwrite output file
 		filePath,
 	)
+	return exec.Command("ffmpeg", args...)
 }
 
 // createMixedAudioCommand creates an ffmpeg command for mixed microphone + system audio recording
-func (r *AudioRecorder) createMixedAudioCommand(filePath string, device models.AudioDeviceInfo, config models.RecordingConfig) *exec.Cmd {
+func (r *AudioRecorder) createMixedAudioCommand(filePath string, device models.AudioDeviceInfo, config models.RecordingConfig, replaySource string) *exec.Cmd {
 	var micInput string
 
 	// Parse device ID to get the actual microphone index
@@ -523,15 +574,27 @@ func (r *AudioRecorder) createMixedAudioCommand(filePath string, device models.A
 
 	// Create ffmpeg command to capture both microphone and system audio
 	// and mix them together
-	return exec.Command("ffmpeg",
-		"-f", "avfoundation",                        // macOS audio framework
-		"-i", micInput,                              // Microphone input
-		"-f", "avfoundation",                        // macOS audio framework
-		"-i", ":1",                                  // System audio input
+	args := captureInput(micInput, replaySource)             // Microphone input
+	args = append(args, captureInput(":1", replaySource)...) // System audio input
+	args = append(args,
 		"-filter_complex", "[0:a][1:a]amix=inputs=2:duration=longest", // Mix the two audio streams
 		"-ar", fmt.Sprintf("%d", config.SampleRate), // Sample rate
 		"-ac", "2",                                  // Stereo output
 		"-y",                                        // Overwrite output file
 		filePath,
 	)
+	return exec.Command("ffmpeg", args...)
+}
+
+// captureInput returns the ffmpeg arguments for one capture input: the
+// avfoundation device, or with a replay source the file read at its native
+// rate and looped, so it arrives as a device would deliver it
+func captureInput(device, replaySource string) []string {
+	if replaySource != "" {
+		return []string{"-re", "-stream_loop", "-1", "-i", replaySource}
+	}
+	return []string{
+		"-f", "avfoundation", // macOS audio framework
+		"-i", device,
+	}
 }
\ No newline at end of file
@@ -10,11 +10,12 @@
 
 #else
 
+#include "tap_layout.h"
+
 // Stub declarations for non-Apple platforms
 typedef void* AudioTapHandle;
-typedef void (*AudioTapCallback)(void* userData, const void* audioData, size_t dataSize, int channels, double sampleRate);
 
-static inline AudioTapHandle AudioTap_Create(AudioTapCallback callback, void* userData) { return NULL; }
+static inline AudioTapHandle AudioTap_Create(AudioTapCallback callback, uintptr_t userData) { return NULL; }
 static inline int AudioTap_Start(AudioTapHandle handle) { return -1; }
 static inline void AudioTap_Stop(AudioTapHandle handle) {}
 static inline void AudioTap_Destroy(AudioTapHandle handle) {}
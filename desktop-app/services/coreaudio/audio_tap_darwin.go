@@ -13,8 +13,8 @@ import "C"
 import (
 	"fmt"
 	"runtime"
+	"runtime/cgo"
 	"sync"
-	"unsafe"
 
 	"github.com/platformlabs-co/personal-assist/logger"
 )
@@ -22,22 +22,12 @@ import (
 // SystemAudioTap represents a Core Audio tap for capturing system audio
 type SystemAudioTap struct {
 	handle   C.AudioTapHandle
-	callback AudioCallback
-	userData interface{}
+	sink     tapSink
+	id       cgo.Handle // Passed to C as user data to find the sink in callbacks
 	mutex    sync.Mutex
 	isActive bool
 }
 
-// AudioCallback is called when audio data is available
-type AudioCallback func(audioData []byte, channels int, sampleRate float64)
-
-// Global registry to map C pointers to Go callbacks
-var (
-	callbackRegistry = make(map[uintptr]*SystemAudioTap)
-	registryMutex    sync.RWMutex
-	nextID           uintptr = 1
-)
-
 // IsAvailable checks if Core Audio Taps are available (macOS 14.2+)
 func IsAvailable() bool {
 	available := C.AudioTap_IsAvailable()
@@ -55,30 +45,22 @@ func NewSystemAudioTap(callback AudioCallback) (*SystemAudioTap, error) {
 	}
 
 	tap := &SystemAudioTap{
-		callback: callback,
+		sink:     newTapSink(callback),
 		isActive: false,
 	}
-
-	// Register the tap in the global registry
-	registryMutex.Lock()
-	id := nextID
-	nextID++
-	callbackRegistry[id] = tap
-	tap.userData = id
-	registryMutex.Unlock()
+	tap.id = cgo.NewHandle(&tap.sink)
+	id := uintptr(tap.id)
 
 	logger.WithField("tap_id", id).Info("Creating Core Audio Tap")
 
 	// Create the C audio tap with our C callback wrapper
 	handle := C.AudioTap_Create(
 		C.AudioTapCallback(C.coreaudio_callback_wrapper),
-		unsafe.Pointer(id),
+		C.uintptr_t(tap.id),
 	)
 
 	if handle == nil {
-		registryMutex.Lock()
-		delete(callbackRegistry, id)
-		registryMutex.Unlock()
+		tap.id.Delete()
 
 		errorMsg := C.GoString(C.AudioTap_GetLastError())
 		logger.WithError(fmt.Errorf(errorMsg)).Error("Failed to create Core Audio Tap")
@@ -165,38 +147,8 @@ func (t *SystemAudioTap) destroy() {
 	C.AudioTap_Destroy(t.handle)
 	t.handle = nil
 
-	// Remove from registry
-	if id, ok := t.userData.(uintptr); ok {
-		registryMutex.Lock()
-		delete(callbackRegistry, id)
-		registryMutex.Unlock()
-	}
+	// No callbacks arrive once the IO proc is destroyed
+	t.id.Delete()
 
 	logger.Info("Core Audio Tap destroyed")
 }
-
-//export audioTapGoCallback
-func audioTapGoCallback(userData unsafe.Pointer, audioData unsafe.Pointer, dataSize C.size_t, channels C.int, sampleRate C.double) {
-	// Get the tap from the registry
-	id := uintptr(userData)
-
-	registryMutex.RLock()
-	tap, ok := callbackRegistry[id]
-	registryMutex.RUnlock()
-
-	if !ok || tap == nil || tap.callback == nil {
-		return
-	}
-
-	// Convert C data to Go slice
-	size := int(dataSize)
-	if size <= 0 {
-		return
-	}
-
-	// Create a copy of the audio data
-	goData := C.GoBytes(audioData, C.int(dataSize))
-
-	// Call the Go callback
-	tap.callback(goData, int(channels), float64(sampleRate))
-}
@@ -7,15 +7,12 @@
 #import <CoreAudio/CoreAudio.h>
 #import <AudioToolbox/AudioToolbox.h>
 #include <os/log.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <Block.h>
+#include <dispatch/dispatch.h>
 
-// Callback function type for audio data
-typedef void (*AudioTapCallback)(void* userData, const void* audioData, size_t dataSize, int channels, double sampleRate);
-
-// Forward declaration of Go callback - implemented in Go via //export
-extern void audioTapGoCallback(void* userData, void* audioData, size_t dataSize, int channels, double sampleRate);
-
-// Forward declaration of wrapper - defined in callbacks_darwin.go CGo preamble
-extern void coreaudio_callback_wrapper(void* userData, const void* audioData, size_t dataSize, int channels, double sampleRate);
+#include "tap_layout.h"
 
 // Audio tap handle
 typedef void* AudioTapHandle;
@@ -23,15 +20,26 @@ typedef void* AudioTapHandle;
 // Audio tap context structure
 typedef struct {
     AudioTapCallback callback;
-    void* userData;
-    AudioDeviceID deviceID;
+    uintptr_t userData;
+    AudioDeviceID deviceID;     // kAudioDeviceUnknown while no output device is bound
     AudioDeviceIOProcID procID;
     CFTypeRef tap;
-    int isRunning;
-    int channels;
-    double sampleRate;
+    int isRunning;              // Capture was started; survives rebinding to another device
+    AudioTapLayout format;      // Device stream format; channels and frames are set per block
+    void* scratch;              // Interleave buffer for cycles of more than one buffer
+    size_t scratchBytes;
+    pthread_mutex_t lock;       // Serializes start, stop and rebinding
+    dispatch_queue_t listenerQueue;
+    AudioObjectPropertyListenerBlock listener;
 } AudioTapContext;
 
+// Property address of the default output device
+static const AudioObjectPropertyAddress audioTapDefaultOutputAddress = {
+    kAudioHardwarePropertyDefaultOutputDevice,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
 // Storage for the last error message
 static char audioTapLastError[256] = "";
 
@@ -95,6 +103,37 @@ static inline OSStatus AudioTap_GetDeviceStreamFormat(AudioDeviceID deviceID, Au
     );
 }
 
+// Get the buffers an IO cycle of the output device carries, one per stream
+// of an interleaved format or one per channel of a non-interleaved one, and
+// their channels in total
+static inline OSStatus AudioTap_GetDeviceStreamConfiguration(AudioDeviceID deviceID, UInt32* buffers, UInt32* channels) {
+    AudioObjectPropertyAddress propertyAddress = {
+        kAudioDevicePropertyStreamConfiguration,
+        kAudioDevicePropertyScopeOutput,
+        kAudioObjectPropertyElementMain
+    };
+
+    UInt32 size = 0;
+    OSStatus status = AudioObjectGetPropertyDataSize(deviceID, &propertyAddress, 0, NULL, &size);
+    if (status != noErr) {
+        return status;
+    }
+    AudioBufferList* list = (AudioBufferList*)malloc(size);
+    if (list == NULL) {
+        return kAudioHardwareUnspecifiedError;
+    }
+    status = AudioObjectGetPropertyData(deviceID, &propertyAddress, 0, NULL, &size, list);
+    if (status == noErr) {
+        *buffers = list->mNumberBuffers;
+        *channels = 0;
+        for (UInt32 i = 0; i < list->mNumberBuffers; i++) {
+            *channels += list->mBuffers[i].mNumberChannels;
+        }
+    }
+    free(list);
+    return status;
+}
+
 // Audio tap callback - called when audio data is available
 static OSStatus AudioTap_IOProc(
     AudioObjectID inObjectID,
@@ -111,25 +150,153 @@ static OSStatus AudioTap_IOProc(
         return noErr;
     }
 
-    // Process each buffer in the buffer list
-    for (UInt32 i = 0; i < inInputData->mNumberBuffers; i++) {
-        AudioBuffer buffer = inInputData->mBuffers[i];
+    // Non-interleaved formats deliver a buffer per channel, and devices with
+    // several streams a buffer per stream; they are interleaved into one
+    // block so the callback sees whole frames
+    UInt32 count = inInputData->mNumberBuffers;
+    if (count > TAP_MAX_CHANNELS) {
+        count = TAP_MAX_CHANNELS;
+    }
+    AudioTapBuffer buffers[TAP_MAX_CHANNELS];
+    for (UInt32 i = 0; i < count; i++) {
+        buffers[i].data = inInputData->mBuffers[i].mData;
+        buffers[i].bytes = inInputData->mBuffers[i].mDataByteSize;
+        buffers[i].channels = inInputData->mBuffers[i].mNumberChannels;
+    }
 
-        // Call the Go callback with the audio data
-        context->callback(
-            context->userData,
-            buffer.mData,
-            buffer.mDataByteSize,
-            buffer.mNumberChannels,
-            context->sampleRate
-        );
+    // Host time lets Go fill the gap of a device switch with silence
+    AudioTapLayout format = context->format;
+    format.hostTimeNs = 0;
+    if (inInputTime != NULL && (inInputTime->mFlags & kAudioTimeStampHostTimeValid)) {
+        format.hostTimeNs = AudioConvertHostTimeToNanos(inInputTime->mHostTime);
     }
 
+    AudioTap_Deliver(
+        buffers,
+        count,
+        format,
+        context->scratch,
+        context->scratchBytes,
+        context->callback,
+        context->userData
+    );
+
     return noErr;
 }
 
+// Bind the tap to an output device: read its stream format and create the
+// IO proc. Callers hold the lock; the tap is unbound.
+static inline int AudioTap_Bind(AudioTapContext* context, AudioDeviceID deviceID) {
+    AudioStreamBasicDescription format;
+    OSStatus status = AudioTap_GetDeviceStreamFormat(deviceID, &format);
+    if (status != noErr) {
+        AudioTap_SetLastError("Failed to get device stream format");
+        return -1;
+    }
+
+    context->format.channels = format.mChannelsPerFrame;
+    context->format.sampleRate = format.mSampleRate;
+    context->format.bytesPerSample = format.mBitsPerChannel / 8;
+    context->format.isFloat = (format.mFormatFlags & kAudioFormatFlagIsFloat) != 0;
+    context->format.planar = (format.mFormatFlags & kAudioFormatFlagIsNonInterleaved) != 0;
+
+    // The stream format describes the first stream only. A device whose
+    // configuration cannot be read is sized for the most channels a cycle
+    // may carry, so a cycle of several buffers is never dropped.
+    UInt32 buffers = 0;
+    UInt32 channels = 0;
+    if (AudioTap_GetDeviceStreamConfiguration(deviceID, &buffers, &channels) != noErr) {
+        buffers = TAP_MAX_CHANNELS;
+        channels = TAP_MAX_CHANNELS;
+    }
+    if (channels < format.mChannelsPerFrame) {
+        channels = format.mChannelsPerFrame;
+    }
+    if (channels > TAP_MAX_CHANNELS) {
+        channels = TAP_MAX_CHANNELS;
+    }
+
+    // Allocated here because the IO proc runs on the real-time thread
+    if (context->format.planar || buffers > 1) {
+        size_t scratchBytes = (size_t)TAP_MAX_BLOCK_FRAMES * channels * context->format.bytesPerSample;
+        if (scratchBytes > context->scratchBytes) {
+            free(context->scratch);
+            context->scratch = malloc(scratchBytes);
+            context->scratchBytes = context->scratch != NULL ? scratchBytes : 0;
+        }
+        if (context->scratch == NULL) {
+            AudioTap_SetLastError("Failed to allocate interleave buffer");
+            return -1;
+        }
+    }
+
+    // Create the IO proc
+    status = AudioDeviceCreateIOProcID(
+        deviceID,
+        AudioTap_IOProc,
+        context,
+        &context->procID
+    );
+
+    if (status != noErr) {
+        char errorMsg[256];
+        snprintf(errorMsg, sizeof(errorMsg), "Failed to create audio IO proc: %d", status);
+        AudioTap_SetLastError(errorMsg);
+        context->procID = NULL;
+        return -1;
+    }
+
+    context->deviceID = deviceID;
+    context->format.generation++;
+    return 0;
+}
+
+// Stop and destroy the IO proc of the bound device. Callers hold the lock.
+static inline void AudioTap_Unbind(AudioTapContext* context) {
+    if (context->procID != NULL) {
+        if (context->isRunning) {
+            AudioDeviceStop(context->deviceID, context->procID);
+        }
+        AudioDeviceDestroyIOProcID(context->deviceID, context->procID);
+        context->procID = NULL;
+    }
+    context->deviceID = kAudioDeviceUnknown;
+}
+
+// Move the tap to the new default output device, keeping it running if it
+// was. Runs on the listener queue when the user switches outputs; the gap
+// shows up in the host times of the blocks that follow.
+static inline void AudioTap_Rebind(AudioTapContext* context) {
+    pthread_mutex_lock(&context->lock);
+
+    AudioDeviceID deviceID = AudioTap_GetDefaultOutputDevice();
+    if (deviceID == kAudioDeviceUnknown || deviceID == context->deviceID) {
+        pthread_mutex_unlock(&context->lock);
+        return;
+    }
+
+    AudioTap_Unbind(context);
+    if (AudioTap_Bind(context, deviceID) != 0) {
+        // Stays unbound; the next device change tries again
+        os_log_error(OS_LOG_DEFAULT, "Core Audio Tap failed to rebind: %{public}s", audioTapLastError);
+        pthread_mutex_unlock(&context->lock);
+        return;
+    }
+
+    if (context->isRunning) {
+        OSStatus status = AudioDeviceStart(context->deviceID, context->procID);
+        if (status != noErr) {
+            os_log_error(OS_LOG_DEFAULT, "Core Audio Tap failed to start on new device: %d", status);
+        }
+    }
+
+    os_log(OS_LOG_DEFAULT, "Core Audio Tap moved to output device %u (%.0f Hz, %d channels)",
+        (unsigned)deviceID, context->format.sampleRate, context->format.channels);
+    pthread_mutex_unlock(&context->lock);
+}
+
 // Create an audio tap for system audio capture
-static inline AudioTapHandle AudioTap_Create(AudioTapCallback callback, void* userData) {
+static inline AudioTapHandle AudioTap_Create(AudioTapCallback callback, uintptr_t userData) {
     if (!AudioTap_IsAvailable()) {
         AudioTap_SetLastError("Core Audio Taps API not available (requires macOS 14.2+)");
         return NULL;
@@ -150,40 +317,31 @@ static inline AudioTapHandle AudioTap_Create(AudioTapCallback callback, void* us
         context->callback = callback;
         context->userData = userData;
         context->isRunning = 0;
+        context->deviceID = kAudioDeviceUnknown;
+        pthread_mutex_init(&context->lock, NULL);
 
         // Get the default output device
-        context->deviceID = AudioTap_GetDefaultOutputDevice();
-        if (context->deviceID == kAudioDeviceUnknown) {
-            free(context);
-            return NULL;
-        }
-
-        // Get the device stream format
-        AudioStreamBasicDescription format;
-        OSStatus status = AudioTap_GetDeviceStreamFormat(context->deviceID, &format);
-        if (status != noErr) {
-            AudioTap_SetLastError("Failed to get device stream format");
+        AudioDeviceID deviceID = AudioTap_GetDefaultOutputDevice();
+        if (deviceID == kAudioDeviceUnknown || AudioTap_Bind(context, deviceID) != 0) {
+            pthread_mutex_destroy(&context->lock);
+            free(context->scratch);
             free(context);
             return NULL;
         }
 
-        context->channels = format.mChannelsPerFrame;
-        context->sampleRate = format.mSampleRate;
-
-        // Create the IO proc
-        status = AudioDeviceCreateIOProcID(
-            context->deviceID,
-            AudioTap_IOProc,
-            context,
-            &context->procID
+        // Follow the default output device, e.g. when headphones are plugged in
+        context->listenerQueue = dispatch_queue_create("personal-assist.audiotap.device", DISPATCH_QUEUE_SERIAL);
+        context->listener = Block_copy(^(UInt32 inNumberAddresses, const AudioObjectPropertyAddress* inAddresses) {
+            AudioTap_Rebind(context);
+        });
+        OSStatus status = AudioObjectAddPropertyListenerBlock(
+            kAudioObjectSystemObject,
+            &audioTapDefaultOutputAddress,
+            context->listenerQueue,
+            context->listener
         );
-
         if (status != noErr) {
-            char errorMsg[256];
-            snprintf(errorMsg, sizeof(errorMsg), "Failed to create audio IO proc: %d", status);
-            AudioTap_SetLastError(errorMsg);
-            free(context);
-            return NULL;
+            os_log_error(OS_LOG_DEFAULT, "Core Audio Tap cannot follow output device changes: %d", status);
         }
 
         context->tap = NULL;
@@ -200,14 +358,23 @@ static inline int AudioTap_Start(AudioTapHandle handle) {
     }
 
     AudioTapContext* context = (AudioTapContext*)handle;
+    pthread_mutex_lock(&context->lock);
 
     if (context->isRunning) {
+        pthread_mutex_unlock(&context->lock);
         AudioTap_SetLastError("Audio tap already running");
         return -1;
     }
 
+    if (context->procID == NULL) {
+        pthread_mutex_unlock(&context->lock);
+        AudioTap_SetLastError("No output device to capture");
+        return -1;
+    }
+
     OSStatus status = AudioDeviceStart(context->deviceID, context->procID);
     if (status != noErr) {
+        pthread_mutex_unlock(&context->lock);
         char errorMsg[256];
         snprintf(errorMsg, sizeof(errorMsg), "Failed to start audio device: %d", status);
         AudioTap_SetLastError(errorMsg);
@@ -215,6 +382,7 @@ static inline int AudioTap_Start(AudioTapHandle handle) {
     }
 
     context->isRunning = 1;
+    pthread_mutex_unlock(&context->lock);
     os_log(OS_LOG_DEFAULT, "Core Audio Tap started");
     return 0;
 }
@@ -226,13 +394,18 @@ static inline void AudioTap_Stop(AudioTapHandle handle) {
     }
 
     AudioTapContext* context = (AudioTapContext*)handle;
+    pthread_mutex_lock(&context->lock);
 
     if (!context->isRunning) {
+        pthread_mutex_unlock(&context->lock);
         return;
     }
 
-    AudioDeviceStop(context->deviceID, context->procID);
+    if (context->procID != NULL) {
+        AudioDeviceStop(context->deviceID, context->procID);
+    }
     context->isRunning = 0;
+    pthread_mutex_unlock(&context->lock);
 
     os_log(OS_LOG_DEFAULT, "Core Audio Tap stopped");
 }
@@ -245,21 +418,32 @@ static inline void AudioTap_Destroy(AudioTapHandle handle) {
 
     AudioTapContext* context = (AudioTapContext*)handle;
 
-    // Stop if running
-    if (context->isRunning) {
-        AudioTap_Stop(handle);
+    // Stop following the output device, and wait out a rebind in progress
+    if (context->listener != NULL) {
+        AudioObjectRemovePropertyListenerBlock(
+            kAudioObjectSystemObject,
+            &audioTapDefaultOutputAddress,
+            context->listenerQueue,
+            context->listener
+        );
+        dispatch_sync(context->listenerQueue, ^{});
+        Block_release(context->listener);
+        dispatch_release(context->listenerQueue);
     }
 
-    // Destroy the IO proc
-    if (context->procID != NULL) {
-        AudioDeviceDestroyIOProcID(context->deviceID, context->procID);
-    }
+    // Stop if running, and destroy the IO proc
+    pthread_mutex_lock(&context->lock);
+    AudioTap_Unbind(context);
+    context->isRunning = 0;
+    pthread_mutex_unlock(&context->lock);
 
     // Release the tap if it exists
     if (context->tap != NULL) {
         CFRelease(context->tap);
     }
 
+    pthread_mutex_destroy(&context->lock);
+    free(context->scratch);
     free(context);
     os_log(OS_LOG_DEFAULT, "Core Audio Tap destroyed");
 }
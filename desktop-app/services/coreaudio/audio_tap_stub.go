@@ -8,9 +8,6 @@ import "fmt"
 // SystemAudioTap stub for non-macOS platforms
 type SystemAudioTap struct{}
 
-// AudioCallback is called when audio data is available
-type AudioCallback func(audioData []byte, channels int, sampleRate float64)
-
 // IsAvailable always returns false on non-macOS platforms
 func IsAvailable() bool {
 	return false
@@ -0,0 +1,18 @@
+// go:build cgo
+// +build cgo
+
+package coreaudio
+
+/*
+#include "tap_layout.h"
+
+// C callback wrapper - defined ONLY in this file to avoid duplicates
+void coreaudio_callback_wrapper(uintptr_t userData, const void* audioData, size_t dataSize, const AudioTapLayout* layout) {
+    audioTapGoCallback(userData, (void*)audioData, dataSize, (AudioTapLayout*)layout);
+}
+*/
+import "C"
+
+// This file exists solely to define the C callback wrapper in a single compilation unit
+// to avoid duplicate symbol errors during linking. It is shared by the Core Audio tap
+// and the replay backend.
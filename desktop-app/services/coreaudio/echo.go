@@ -0,0 +1,422 @@
+package coreaudio
+
+import (
+	"errors"
+	"fmt"
+	"math"
+	"os"
+	"sort"
+	"time"
+
+	"github.com/go-audio/audio"
+	"github.com/go-audio/wav"
+	"github.com/platformlabs-co/personal-assist/services/dsp"
+)
+
+// Echo cancellation runs on finished recordings, so it builds on plain WAV
+// files and the dsp package and compiles on every platform; the synthetic
+// echo paths in tools/aecbench exercise it on Linux.
+
+const (
+	// The streams are aligned on mono copies at echoAnalysisRate: a window of
+	// echoWindowLength every echoWindowEvery, searched for lags up to echoMaxLag
+	echoAnalysisRate = 8000
+	echoWindowEvery  = 20 * time.Second
+	echoWindowLength = 6 * time.Second
+	echoMaxLag       = 2 * time.Second
+
+	// echoMinConfidence is the GCC-PHAT peak ratio a window needs to count,
+	// and echoMinLevel the RMS both streams need in it (-50dBFS)
+	echoMinConfidence = 12
+	echoMinLevel      = 0.003
+
+	// echoMargin starts the reference this much early so the filter also
+	// covers an alignment that is slightly late
+	echoMargin = 20 * time.Millisecond
+
+	// echoMaxDrift bounds the clock drift fit; a steeper fit is treated as
+	// a bad measurement and the median delay is used instead
+	echoMaxDrift = 1e-3
+
+	echoBlockFrames = 4096
+)
+
+// ErrNoEcho is returned when the system audio cannot be found in the
+// microphone track, either because nothing was played or the speakers were
+// not audible to the microphone (headphones)
+var ErrNoEcho = errors.New("no echo of the system audio found in the microphone track")
+
+// EchoReport describes the echo cancellation of a mixed recording
+type EchoReport struct {
+	Delay       time.Duration // Lag of the echo behind the system audio at the start
+	DriftPPM    float64       // Clock drift of the microphone against the system audio
+	Windows     int           // Windows the alignment was measured in
+	Attenuation float64       // dB removed from the microphone track
+}
+
+// CancelEcho removes the system audio that the microphone picked up from
+// the speakers. The microphone track at micPath is written to outputPath as
+// a mono 16-bit WAV file at its own sample rate, with the system audio at
+// systemPath as the echo reference. The two files start at different times
+// and run on different clocks, so the echo delay is measured by
+// cross-correlation across the recording and fitted with a linear drift
+// before the reference is resampled onto the microphone's timeline.
+func CancelEcho(micPath, systemPath, outputPath string) (EchoReport, error) {
+	var report EchoReport
+
+	micWindows, micRate, err := echoAnalysisWindows(micPath, true)
+	if err != nil {
+		return report, err
+	}
+	systemWindows, systemRate, err := echoAnalysisWindows(systemPath, false)
+	if err != nil {
+		return report, err
+	}
+
+	delay, drift, windows, err := fitEchoDelay(systemWindows, micWindows)
+	if err != nil {
+		return report, err
+	}
+	report.Delay = time.Duration(delay * float64(time.Second))
+	report.DriftPPM = drift * 1e6
+	report.Windows = windows
+
+	mic, err := openWAVReader(micPath, true)
+	if err != nil {
+		return report, err
+	}
+	defer mic.Close()
+	system, err := openWAVReader(systemPath, false)
+	if err != nil {
+		return report, err
+	}
+	defer system.Close()
+
+	// System sample for microphone frame n: ((n/micRate)(1-drift) - delay + margin) * systemRate
+	reference := &alignedReference{
+		reader: system,
+		offset: (echoMargin.Seconds() - delay) * float64(systemRate),
+		step:   (1 - drift) * float64(systemRate) / float64(micRate),
+	}
+
+	canceller, err := dsp.NewEchoCanceller(dsp.DefaultEchoCancellerConfig(micRate))
+	if err != nil {
+		return report, err
+	}
+
+	file, err := os.Create(outputPath)
+	if err != nil {
+		return report, fmt.Errorf("failed to create echo cancelled file: %w", err)
+	}
+	defer file.Close()
+	encoder := wav.NewEncoder(file, micRate, 16, 1, 1)
+
+	captured := make([]float32, echoBlockFrames)
+	played := make([]float32, echoBlockFrames)
+	var cleaned []float32
+	for {
+		n, err := mic.Read(captured)
+		if err != nil {
+			return report, err
+		}
+		if n == 0 {
+			break
+		}
+		if err := reference.Read(played[:n]); err != nil {
+			return report, err
+		}
+		cleaned = canceller.Process(captured[:n], played[:n], cleaned[:0])
+		if err := writePCM16(encoder, cleaned, micRate); err != nil {
+			return report, err
+		}
+	}
+	if err := writePCM16(encoder, canceller.Flush(cleaned[:0]), micRate); err != nil {
+		return report, err
+	}
+	report.Attenuation = canceller.Attenuation()
+
+	if err := encoder.Close(); err != nil {
+		return report, fmt.Errorf("failed to finish echo cancelled file: %w", err)
+	}
+	return report, nil
+}
+
+// fitEchoDelay measures the echo delay in every window both streams have
+// and fits delay(t) = delay + drift*t, in seconds on the microphone's timeline
+func fitEchoDelay(systemWindows, micWindows map[int][]float32) (float64, float64, int, error) {
+	maxLag := int(echoMaxLag.Seconds() * echoAnalysisRate)
+	var times, delays []float64
+	for index, captured := range micWindows {
+		played, ok := systemWindows[index]
+		if !ok || rms(played) < echoMinLevel || rms(captured) < echoMinLevel {
+			continue
+		}
+		lag, confidence, err := dsp.EstimateDelay(played, captured, maxLag)
+		if err != nil {
+			return 0, 0, 0, err
+		}
+		if confidence < echoMinConfidence {
+			continue
+		}
+		start := float64(index) * echoWindowEvery.Seconds()
+		times = append(times, start+echoWindowLength.Seconds()/2)
+		delays = append(delays, float64(lag)/echoAnalysisRate)
+	}
+	if len(delays) == 0 {
+		return 0, 0, 0, ErrNoEcho
+	}
+
+	// Least squares line through the measurements
+	var meanT, meanD float64
+	for i := range times {
+		meanT += times[i]
+		meanD += delays[i]
+	}
+	meanT /= float64(len(times))
+	meanD /= float64(len(times))
+	var covariance, variance float64
+	for i := range times {
+		covariance += (times[i] - meanT) * (delays[i] - meanD)
+		variance += (times[i] - meanT) * (times[i] - meanT)
+	}
+	if variance == 0 {
+		return meanD, 0, len(delays), nil
+	}
+	drift := covariance / variance
+	if math.Abs(drift) > echoMaxDrift {
+		sort.Float64s(delays)
+		return delays[len(delays)/2], 0, len(delays), nil
+	}
+	return meanD - drift*meanT, drift, len(delays), nil
+}
+
+// echoAnalysisWindows reads a WAV file as mono at echoAnalysisRate, keeping
+// only the analysis windows, and returns them by index with the file's rate
+func echoAnalysisWindows(path string, adaptive bool) (map[int][]float32, int, error) {
+	reader, err := openWAVReader(path, adaptive)
+	if err != nil {
+		return nil, 0, err
+	}
+	defer reader.Close()
+
+	every := int64(echoWindowEvery.Seconds() * echoAnalysisRate)
+	length := int64(echoWindowLength.Seconds() * echoAnalysisRate)
+	windows := make(map[int][]float32)
+
+	// Box filter each source sample into its analysis sample
+	var source, current int64
+	var sum float64
+	var count int
+	finish := func() {
+		if count == 0 {
+			return
+		}
+		if offset := current % every; offset < length {
+			index := int(current / every)
+			window, ok := windows[index]
+			if !ok {
+				window = make([]float32, length)
+				windows[index] = window
+			}
+			window[offset] = float32(sum / float64(count))
+		}
+		sum, count = 0, 0
+	}
+
+	buffer := make([]float32, echoBlockFrames)
+	for {
+		n, err := reader.Read(buffer)
+		if err != nil {
+			return nil, 0, err
+		}
+		if n == 0 {
+			break
+		}
+		for _, sample := range buffer[:n] {
+			if target := source * echoAnalysisRate / int64(reader.rate); target != current {
+				finish()
+				current = target
+			}
+			sum += float64(sample)
+			count++
+			source++
+		}
+	}
+	finish()
+	return windows, reader.rate, nil
+}
+
+// frameReader reads mono frames, returning 0 at the end of the stream
+type frameReader interface {
+	Read(mono []float32) (int, error)
+}
+
+// wavReader streams a WAV file as mono float32 samples
+type wavReader struct {
+	file      *os.File
+	decoder   *wav.Decoder
+	buffer    *audio.IntBuffer
+	downmixer *dsp.Downmixer
+	channels  int
+	rate      int
+}
+
+// openWAVReader opens a PCM WAV file for streaming. An adaptive reader
+// weighs the channels by what they carry, which suits the microphone; the
+// system track is averaged so the echo path the canceller learns does not
+// change with the mix.
+func openWAVReader(path string, adaptive bool) (*wavReader, error) {
+	file, err := os.Open(path)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open audio file: %w", err)
+	}
+
+	decoder := wav.NewDecoder(file)
+	if !decoder.IsValidFile() {
+		file.Close()
+		return nil, fmt.Errorf("invalid WAV file: %s", path)
+	}
+	format := decoder.Format()
+	if format.NumChannels < 1 || format.SampleRate < 1 || decoder.BitDepth == 0 {
+		file.Close()
+		return nil, fmt.Errorf("unsupported WAV format in %s", path)
+	}
+
+	config := dsp.DefaultDownmixConfig(format.NumChannels, int(decoder.BitDepth), format.SampleRate)
+	if !adaptive {
+		config.Window = 0
+	}
+	downmixer, err := dsp.NewDownmixer(config)
+	if err != nil {
+		file.Close()
+		return nil, err
+	}
+
+	return &wavReader{
+		file:      file,
+		decoder:   decoder,
+		buffer:    &audio.IntBuffer{Format: format, Data: make([]int, echoBlockFrames*format.NumChannels)},
+		downmixer: downmixer,
+		channels:  format.NumChannels,
+		rate:      format.SampleRate,
+	}, nil
+}
+
+// Read fills mono with up to len(mono) frames mixed down from the channels
+// and returns how many it read, 0 at the end of the file
+func (r *wavReader) Read(mono []float32) (int, error) {
+	if need := len(mono) * r.channels; len(r.buffer.Data) < need {
+		r.buffer.Data = make([]int, need)
+	}
+	r.buffer.Data = r.buffer.Data[:len(mono)*r.channels]
+
+	n, err := r.decoder.PCMBuffer(r.buffer)
+	if err != nil {
+		return 0, fmt.Errorf("failed to read audio data: %w", err)
+	}
+
+	frames := n / r.channels
+	r.downmixer.Process(r.buffer.Data[:frames*r.channels], mono[:0])
+	return frames, nil
+}
+
+// Close closes the file
+func (r *wavReader) Close() error {
+	return r.file.Close()
+}
+
+// alignedReference resamples a stream onto another timeline: output sample
+// n is the input at offset + step*n, linearly interpolated, and silence
+// outside the input
+type alignedReference struct {
+	reader frameReader
+	offset float64
+	step   float64
+
+	buffer []float32 // Input samples from base on
+	base   int64
+	next   int64 // Output samples produced
+	ended  bool
+}
+
+// Read fills out with the next output samples
+func (a *alignedReference) Read(out []float32) error {
+	for i := range out {
+		position := a.offset + a.step*float64(a.next)
+		a.next++
+		if position < 0 {
+			out[i] = 0
+			continue
+		}
+
+		index := int64(position)
+		for !a.ended && index+1-a.base >= int64(len(a.buffer)) {
+			if err := a.fill(index); err != nil {
+				return err
+			}
+		}
+		at := index - a.base
+		if at+1 >= int64(len(a.buffer)) {
+			out[i] = 0
+			continue
+		}
+		frac := float32(position - float64(index))
+		out[i] = a.buffer[at]*(1-frac) + a.buffer[at+1]*frac
+	}
+	return nil
+}
+
+// fill drops the input before index and reads another block
+func (a *alignedReference) fill(index int64) error {
+	if drop := index - a.base; drop > 0 {
+		if drop > int64(len(a.buffer)) {
+			drop = int64(len(a.buffer)) // Skipped input is read and dropped below
+		}
+		a.buffer = a.buffer[:copy(a.buffer, a.buffer[drop:])]
+		a.base += drop
+	}
+
+	start := len(a.buffer)
+	a.buffer = append(a.buffer, make([]float32, echoBlockFrames)...)
+	n, err := a.reader.Read(a.buffer[start:])
+	if err != nil {
+		return err
+	}
+	a.buffer = a.buffer[:start+n]
+	if n == 0 {
+		a.ended = true
+	}
+	return nil
+}
+
+// writePCM16 appends mono samples to a 16-bit WAV encoder
+func writePCM16(encoder *wav.Encoder, samples []float32, sampleRate int) error {
+	if len(samples) == 0 {
+		return nil
+	}
+	data := make([]int, len(samples))
+	for i, sample := range samples {
+		data[i] = int(math.Max(-32768, math.Min(32767, math.Round(float64(sample)*32768))))
+	}
+	buffer := &audio.IntBuffer{
+		Format:         &audio.Format{NumChannels: 1, SampleRate: sampleRate},
+		Data:           data,
+		SourceBitDepth: 16,
+	}
+	if err := encoder.Write(buffer); err != nil {
+		return fmt.Errorf("failed to write echo cancelled audio: %w", err)
+	}
+	return nil
+}
+
+// rms returns the root mean square of samples
+func rms(samples []float32) float64 {
+	if len(samples) == 0 {
+		return 0
+	}
+	var sum float64
+	for _, sample := range samples {
+		sum += float64(sample) * float64(sample)
+	}
+	return math.Sqrt(sum / float64(len(samples)))
+}
@@ -0,0 +1,110 @@
+package coreaudio
+
+import "sync/atomic"
+
+const (
+	// tapFrameBytes is the capacity of a pooled tap frame. Core Audio hands
+	// over a few hundred float32 frames per IO cycle, 4KB for 512 stereo
+	// frames, so one pooled frame holds a cycle; larger buffers are split.
+	tapFrameBytes = 16 * 1024
+
+	// tapFramePoolSize is the number of frames a tap keeps for reuse
+	tapFramePoolSize = 64
+)
+
+// AudioLayout describes the audio in a frame. Frames are always
+// interleaved; Planar records that the device delivered one buffer per
+// channel and the tap interleaved them.
+type AudioLayout struct {
+	Channels       int     `json:"channels"`
+	SampleRate     float64 `json:"sample_rate"`
+	BytesPerSample int     `json:"bytes_per_sample"`
+	Float          bool    `json:"float"`
+	Planar         bool    `json:"planar"`
+}
+
+// FrameBytes returns the size of one frame of all channels
+func (l AudioLayout) FrameBytes() int {
+	return l.Channels * l.BytesPerSample
+}
+
+// AudioCallback is called when audio data is available. It owns the frame
+// and must Release it once the data is written or copied.
+type AudioCallback func(frame *AudioFrame)
+
+// AudioFrame is a buffer of tap audio owned by whoever holds it. The
+// callback that receives a frame owns it and must Release it once the data
+// is written or copied; the frame must not be used afterwards.
+type AudioFrame struct {
+	Data   []byte
+	Layout AudioLayout
+	pool   *FramePool
+}
+
+// Release returns the frame to its pool
+func (f *AudioFrame) Release() {
+	if f.pool != nil {
+		f.pool.put(f)
+	}
+}
+
+// FramePool recycles fixed-size audio frames through a bounded free list,
+// so delivering audio from the real-time thread allocates nothing once the
+// pool is filled. When every frame is held, Get allocates rather than making
+// the audio thread wait, and the extra frames join the free list on release
+// while there is room.
+type FramePool struct {
+	free      chan *AudioFrame
+	frameSize int
+	allocated atomic.Int64
+}
+
+// NewFramePool creates a pool of frames holding frameSize bytes each, filled
+// with the given number of frames
+func NewFramePool(frames, frameSize int) *FramePool {
+	p := &FramePool{
+		free:      make(chan *AudioFrame, frames),
+		frameSize: frameSize,
+	}
+	for i := 0; i < frames; i++ {
+		p.free <- p.newFrame()
+	}
+	return p
+}
+
+// Get returns an empty frame
+func (p *FramePool) Get() *AudioFrame {
+	select {
+	case f := <-p.free:
+		return f
+	default:
+		return p.newFrame()
+	}
+}
+
+// FrameSize returns the capacity of a frame in bytes
+func (p *FramePool) FrameSize() int {
+	return p.frameSize
+}
+
+// Allocated returns the number of frames created, which stays constant
+// while consumers keep up with the audio
+func (p *FramePool) Allocated() int64 {
+	return p.allocated.Load()
+}
+
+// newFrame allocates a frame belonging to the pool
+func (p *FramePool) newFrame() *AudioFrame {
+	p.allocated.Add(1)
+	return &AudioFrame{Data: make([]byte, 0, p.frameSize), pool: p}
+}
+
+// put keeps a released frame, or drops it when the free list is full
+func (p *FramePool) put(f *AudioFrame) {
+	f.Data = f.Data[:0]
+	f.Layout = AudioLayout{}
+	select {
+	case p.free <- f:
+	default:
+	}
+}
@@ -7,12 +7,14 @@ import (
 	"bytes"
 	"encoding/binary"
 	"fmt"
+	"math"
 	"os"
 	"os/exec"
 	"sync"
 	"time"
 
 	"github.com/platformlabs-co/personal-assist/logger"
+	"github.com/platformlabs-co/personal-assist/services/memory"
 )
 
 // MixedAudioRecorder records both system audio and microphone audio
@@ -36,15 +38,30 @@ type MixedAudioRecorder struct {
 type AudioBuffer struct {
 	data      []byte
 	mutex     sync.Mutex
-	sampleRate float64
-	channels   int
+	layout    AudioLayout
+	reserved  int64 // Capacity recorded with the memory governor
+}
+
+var (
+	audioBufferMemory     *memory.Consumer
+	audioBufferMemoryOnce sync.Once
+)
+
+// bufferMemory returns the memory governor account shared by audio buffers
+func bufferMemory() *memory.Consumer {
+	audioBufferMemoryOnce.Do(func() {
+		audioBufferMemory = memory.Default().Register("system audio buffers", memory.Heap, nil)
+	})
+	return audioBufferMemory
 }
 
 // NewAudioBuffer creates a new audio buffer
 func NewAudioBuffer() *AudioBuffer {
-	return &AudioBuffer{
+	b := &AudioBuffer{
 		data: make([]byte, 0, 1024*1024), // 1MB initial capacity
 	}
+	b.account()
+	return b
 }
 
 // Append adds audio data to the buffer
@@ -52,6 +69,36 @@ func (b *AudioBuffer) Append(data []byte) {
 	b.mutex.Lock()
 	defer b.mutex.Unlock()
 	b.data = append(b.data, data...)
+	b.account()
+}
+
+// account records capacity growth with the memory governor. Audio arriving
+// from the tap cannot wait, so growth is recorded rather than reserved.
+// Callers hold the mutex, except during construction.
+func (b *AudioBuffer) account() {
+	if grown := int64(cap(b.data)) - b.reserved; grown > 0 {
+		bufferMemory().Add(grown)
+		b.reserved += grown
+	}
+}
+
+// Take returns the buffered data without copying it and empties the
+// buffer. The memory stays reserved until Free.
+func (b *AudioBuffer) Take() []byte {
+	b.mutex.Lock()
+	defer b.mutex.Unlock()
+	data := b.data
+	b.data = nil
+	return data
+}
+
+// Free drops the buffered data and returns its memory to the budget
+func (b *AudioBuffer) Free() {
+	b.mutex.Lock()
+	defer b.mutex.Unlock()
+	b.data = nil
+	bufferMemory().Release(b.reserved)
+	b.reserved = 0
 }
 
 // GetData returns a copy of the buffer data
@@ -71,11 +118,10 @@ func (b *AudioBuffer) Clear() {
 }
 
 // SetFormat sets the audio format
-func (b *AudioBuffer) SetFormat(sampleRate float64, channels int) {
+func (b *AudioBuffer) SetFormat(layout AudioLayout) {
 	b.mutex.Lock()
 	defer b.mutex.Unlock()
-	b.sampleRate = sampleRate
-	b.channels = channels
+	b.layout = layout
 }
 
 // NewMixedAudioRecorder creates a new mixed audio recorder
@@ -146,7 +192,9 @@ func (r *MixedAudioRecorder) startSystemAudioCapture() error {
 	}
 
 	// Create the audio tap with callback
-	tap, err := NewSystemAudioTap(func(audioData []byte, channels int, sampleRate float64) {
+	tap, err := NewSystemAudioTap(func(frame *AudioFrame) {
+		defer frame.Release()
+
 		// Track callback activity
 		r.mutex.Lock()
 		r.callbackCount++
@@ -155,25 +203,29 @@ func (r *MixedAudioRecorder) startSystemAudioCapture() error {
 		r.mutex.Unlock()
 
 		// Store audio format on first callback
-		if r.systemBuffer.sampleRate == 0 {
-			r.systemBuffer.SetFormat(sampleRate, channels)
+		if r.systemBuffer.layout.SampleRate == 0 {
+			r.systemBuffer.SetFormat(frame.Layout)
 			logger.WithFields(map[string]interface{}{
-				"sample_rate": sampleRate,
-				"channels":    channels,
+				"sample_rate":      frame.Layout.SampleRate,
+				"channels":         frame.Layout.Channels,
+				"bytes_per_sample": frame.Layout.BytesPerSample,
+				"float":            frame.Layout.Float,
+				"planar":           frame.Layout.Planar,
 			}).Info("System audio format detected")
 		}
 
-		// Log periodically (every 100 callbacks)
-		if count%100 == 1 {
+		// Log periodically (every 100 callbacks), skipping the fields when
+		// debug logging is off so steady capture allocates nothing
+		if count%100 == 1 && logger.DebugEnabled() {
 			logger.WithFields(map[string]interface{}{
 				"callback_count": count,
-				"data_size":      len(audioData),
+				"data_size":      len(frame.Data),
 				"buffer_size":    len(r.systemBuffer.data),
 			}).Debug("System audio callback progress")
 		}
 
 		// Append audio data to buffer
-		r.systemBuffer.Append(audioData)
+		r.systemBuffer.Append(frame.Data)
 	})
 
 	if err != nil {
@@ -277,6 +329,10 @@ func (r *MixedAudioRecorder) Stop() error {
 		return r.fallbackToMicrophoneFile()
 	}
 
+	// Remove the system audio the microphone picked up from the speakers,
+	// so remote speech is not transcribed twice
+	r.cancelEcho()
+
 	// Mix the two audio streams
 	if err := r.mixAudioStreams(); err != nil {
 		logger.WithError(err).Error("Failed to mix audio streams")
@@ -333,7 +389,10 @@ func (r *MixedAudioRecorder) saveSystemAudioToWAV() error {
 		"buffer_size":    len(r.systemBuffer.data),
 	}).Info("Saving system audio to WAV file")
 
-	data := r.systemBuffer.GetData()
+	// The tap has stopped, so the buffer is written out without a copy and
+	// its memory returned once the file is saved
+	data := r.systemBuffer.Take()
+	defer r.systemBuffer.Free()
 	if len(data) == 0 {
 		logger.WithFields(map[string]interface{}{
 			"callback_count":      r.callbackCount,
@@ -354,10 +413,17 @@ func (r *MixedAudioRecorder) saveSystemAudioToWAV() error {
 	}
 	defer file.Close()
 
-	// Write WAV header
-	sampleRate := int(r.systemBuffer.sampleRate)
-	channels := r.systemBuffer.channels
+	// Write WAV header. Float samples are converted to 16-bit PCM, which is
+	// what the header and the readers of the file expect.
+	layout := r.systemBuffer.layout
+	sampleRate := int(layout.SampleRate)
+	channels := layout.Channels
 	bitsPerSample := 16
+	if layout.Float && layout.BytesPerSample == 4 {
+		data = float32ToPCM16(data)
+	} else if layout.BytesPerSample > 0 {
+		bitsPerSample = layout.BytesPerSample * 8
+	}
 
 	if err := writeWAVHeader(file, len(data), sampleRate, channels, bitsPerSample); err != nil {
 		return fmt.Errorf("failed to write WAV header: %w", err)
@@ -378,6 +444,36 @@ func (r *MixedAudioRecorder) saveSystemAudioToWAV() error {
 	return nil
 }
 
+// cancelEcho replaces the microphone track with an echo cancelled copy that
+// uses the system audio as the reference. The recording is mixed from the
+// original microphone track when that fails.
+func (r *MixedAudioRecorder) cancelEcho() {
+	cleanedFile := fmt.Sprintf("%s.aec.wav", r.finalFile)
+	report, err := CancelEcho(r.tempMicFile, r.tempSystemFile, cleanedFile)
+	if err != nil {
+		os.Remove(cleanedFile)
+		if err == ErrNoEcho {
+			logger.Info("No speaker echo found in microphone audio")
+		} else {
+			logger.WithError(err).Warn("Echo cancellation failed, mixing microphone audio as recorded")
+		}
+		return
+	}
+
+	if err := os.Rename(cleanedFile, r.tempMicFile); err != nil {
+		os.Remove(cleanedFile)
+		logger.WithError(err).Warn("Failed to replace microphone audio with echo cancelled copy")
+		return
+	}
+
+	logger.WithFields(map[string]interface{}{
+		"delay_ms":       report.Delay.Milliseconds(),
+		"drift_ppm":      report.DriftPPM,
+		"windows":        report.Windows,
+		"attenuation_db": report.Attenuation,
+	}).Info("Cancelled speaker echo in microphone audio")
+}
+
 // mixAudioStreams mixes the system and microphone audio streams using ffmpeg
 func (r *MixedAudioRecorder) mixAudioStreams() error {
 	logger.WithFields(map[string]interface{}{
@@ -449,6 +545,18 @@ func (r *MixedAudioRecorder) IsRecording() bool {
 	return r.isRecording
 }
 
+// float32ToPCM16 converts little-endian float32 samples to 16-bit PCM in
+// place and returns the converted bytes
+func float32ToPCM16(data []byte) []byte {
+	n := len(data) / 4
+	for i := 0; i < n; i++ {
+		v := math.Float32frombits(binary.LittleEndian.Uint32(data[4*i:]))
+		v = max(-1, min(1, v))
+		binary.LittleEndian.PutUint16(data[2*i:], uint16(int16(v*32767)))
+	}
+	return data[:2*n]
+}
+
 // writeWAVHeader writes a WAV file header
 func writeWAVHeader(w *os.File, dataSize int, sampleRate int, channels int, bitsPerSample int) error {
 	var buf bytes.Buffer
@@ -0,0 +1,168 @@
+// go:build cgo
+// +build cgo
+
+package coreaudio
+
+/*
+#include <stdlib.h>
+#include "tap_layout.h"
+*/
+import "C"
+import (
+	"fmt"
+	"runtime/cgo"
+	"time"
+	"unsafe"
+)
+
+// ReplayTap feeds recorded audio through the native delivery path of the
+// tap one simulated IO cycle at a time, laid out as a device with the given
+// format delivers it: one interleaved buffer, or one buffer per channel when
+// the layout is planar. Cycles are stamped with a simulated host clock, and
+// SwitchDevice stands in for the user changing the output device. It needs
+// no audio hardware, so the tap can be exercised on any platform.
+type ReplayTap struct {
+	sink         tapSink
+	id           cgo.Handle
+	layout       AudioLayout
+	cycleFrames  int
+	buffers      *C.AudioTapBuffer // Buffer list of a cycle, in C memory
+	count        int
+	device       unsafe.Pointer // Device memory the buffers point into
+	scratch      unsafe.Pointer // Interleave buffer for planar layouts
+	scratchBytes int
+	hostTimeNs   uint64
+	generation   int
+}
+
+// NewReplayTap creates a replay backend delivering cycleFrames frames per IO
+// cycle to callback
+func NewReplayTap(callback AudioCallback, layout AudioLayout, cycleFrames int) (*ReplayTap, error) {
+	if callback == nil {
+		return nil, fmt.Errorf("callback cannot be nil")
+	}
+	if layout.Channels <= 0 || layout.Channels > C.TAP_MAX_CHANNELS || layout.BytesPerSample <= 0 || cycleFrames <= 0 {
+		return nil, fmt.Errorf("invalid replay layout: %d channels of %d bytes, %d frames per cycle",
+			layout.Channels, layout.BytesPerSample, cycleFrames)
+	}
+
+	t := &ReplayTap{
+		sink:        newTapSink(callback),
+		cycleFrames: cycleFrames,
+		hostTimeNs:  uint64(time.Second),
+	}
+	t.bind(layout)
+	t.id = cgo.NewHandle(&t.sink)
+	return t, nil
+}
+
+// bind allocates the device memory of a layout, as binding the IO proc of a
+// device does
+func (t *ReplayTap) bind(layout AudioLayout) {
+	t.layout = layout
+	t.count = 1
+	t.scratch, t.scratchBytes = nil, 0
+	if layout.Planar {
+		t.count = layout.Channels
+		t.scratchBytes = C.TAP_MAX_BLOCK_FRAMES * layout.FrameBytes()
+		t.scratch = C.malloc(C.size_t(t.scratchBytes))
+	}
+	t.buffers = (*C.AudioTapBuffer)(C.calloc(C.size_t(t.count), C.sizeof_AudioTapBuffer))
+	t.device = C.malloc(C.size_t(t.cycleFrames * layout.FrameBytes()))
+	t.generation++
+}
+
+// unbind frees the device memory
+func (t *ReplayTap) unbind() {
+	C.free(unsafe.Pointer(t.buffers))
+	C.free(t.device)
+	C.free(t.scratch)
+	t.buffers = nil
+}
+
+// SwitchDevice moves the replay to a device with another layout after the
+// given gap without audio, as the native tap rebinds when the default
+// output device changes
+func (t *ReplayTap) SwitchDevice(layout AudioLayout, gap time.Duration) error {
+	if layout.Channels <= 0 || layout.Channels > C.TAP_MAX_CHANNELS || layout.BytesPerSample <= 0 {
+		return fmt.Errorf("invalid replay layout: %d channels of %d bytes", layout.Channels, layout.BytesPerSample)
+	}
+	t.unbind()
+	t.bind(layout)
+	t.hostTimeNs += uint64(gap)
+	return nil
+}
+
+// Write replays interleaved audio of whole frames, in IO cycles of the
+// replay's length
+func (t *ReplayTap) Write(data []byte) error {
+	frameBytes := t.layout.FrameBytes()
+	if len(data)%frameBytes != 0 {
+		return fmt.Errorf("replay data is not whole frames: %d bytes of %d byte frames", len(data), frameBytes)
+	}
+
+	buffers := unsafe.Slice(t.buffers, t.count)
+	device := unsafe.Slice((*byte)(t.device), t.cycleFrames*frameBytes)
+	format := C.AudioTapLayout{
+		channels:       C.int(t.layout.Channels),
+		sampleRate:     C.double(t.layout.SampleRate),
+		bytesPerSample: C.int(t.layout.BytesPerSample),
+		generation:     C.int(t.generation),
+	}
+	if t.layout.Float {
+		format.isFloat = 1
+	}
+	if t.layout.Planar {
+		format.planar = 1
+	}
+
+	for len(data) > 0 {
+		n := min(t.cycleFrames, len(data)/frameBytes)
+		cycle := data[:n*frameBytes]
+		data = data[n*frameBytes:]
+
+		if t.layout.Planar {
+			// One buffer per channel, as a non-interleaved device delivers them
+			size := t.layout.BytesPerSample
+			for c := range buffers {
+				plane := device[c*t.cycleFrames*size:][:n*size]
+				for f := 0; f < n; f++ {
+					copy(plane[f*size:(f+1)*size], cycle[f*frameBytes+c*size:])
+				}
+				buffers[c] = C.AudioTapBuffer{data: unsafe.Pointer(&plane[0]), bytes: C.uint32_t(len(plane)), channels: 1}
+			}
+		} else {
+			copy(device, cycle)
+			buffers[0] = C.AudioTapBuffer{data: t.device, bytes: C.uint32_t(len(cycle)), channels: C.uint32_t(t.layout.Channels)}
+		}
+
+		format.hostTimeNs = C.uint64_t(t.hostTimeNs)
+		t.hostTimeNs += uint64(float64(n) * 1e9 / t.layout.SampleRate)
+
+		C.AudioTap_Deliver(
+			t.buffers,
+			C.uint32_t(t.count),
+			format,
+			t.scratch,
+			C.size_t(t.scratchBytes),
+			C.AudioTapCallback(C.coreaudio_callback_wrapper),
+			C.uintptr_t(t.id),
+		)
+	}
+	return nil
+}
+
+// Frames returns the frame pool of the replay, to check its allocations
+func (t *ReplayTap) Frames() *FramePool {
+	return t.sink.frames
+}
+
+// Close releases the native buffers of the replay
+func (t *ReplayTap) Close() error {
+	if t.buffers == nil {
+		return nil
+	}
+	t.id.Delete()
+	t.unbind()
+	return nil
+}
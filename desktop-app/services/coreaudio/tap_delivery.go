@@ -0,0 +1,72 @@
+// go:build cgo
+// +build cgo
+
+package coreaudio
+
+/*
+#include "tap_layout.h"
+*/
+import "C"
+import (
+	"runtime/cgo"
+	"unsafe"
+)
+
+// tapSink delivers the interleaved blocks of the native tap to an
+// AudioCallback in pooled frames, in the layout of the first block whatever
+// output device the tap moves to. A cgo.Handle to the sink is the user data
+// of the native callback.
+type tapSink struct {
+	callback AudioCallback
+	frames   *FramePool
+	stream   tapStream
+}
+
+// newTapSink creates a sink with its own frame pool
+func newTapSink(callback AudioCallback) tapSink {
+	return tapSink{
+		callback: callback,
+		frames:   NewFramePool(tapFramePoolSize, tapFrameBytes),
+	}
+}
+
+// deliver copies a block into frames, splitting blocks larger than a frame
+// on whole sample frames
+func (s *tapSink) deliver(data []byte, layout AudioLayout, hostTimeNs uint64, generation int) {
+	data = s.stream.conform(data, layout, hostTimeNs, generation)
+	layout = s.stream.output
+
+	step := s.frames.FrameSize()
+	if frameBytes := layout.FrameBytes(); frameBytes > 0 && step > frameBytes {
+		step -= step % frameBytes
+	}
+	for len(data) > 0 {
+		n := min(step, len(data))
+		frame := s.frames.Get()
+		frame.Data = append(frame.Data, data[:n]...)
+		frame.Layout = layout
+		data = data[n:]
+		s.callback(frame)
+	}
+}
+
+//export audioTapGoCallback
+func audioTapGoCallback(userData C.uintptr_t, audioData unsafe.Pointer, dataSize C.size_t, layout *C.AudioTapLayout) {
+	sink, ok := cgo.Handle(userData).Value().(*tapSink)
+	if !ok || sink.callback == nil {
+		return
+	}
+
+	size := int(dataSize)
+	if size <= 0 || audioData == nil || layout == nil {
+		return
+	}
+
+	sink.deliver(unsafe.Slice((*byte)(audioData), size), AudioLayout{
+		Channels:       int(layout.channels),
+		SampleRate:     float64(layout.sampleRate),
+		BytesPerSample: int(layout.bytesPerSample),
+		Float:          layout.isFloat != 0,
+		Planar:         layout.planar != 0,
+	}, uint64(layout.hostTimeNs), int(layout.generation))
+}
@@ -0,0 +1,193 @@
+#ifndef TAP_LAYOUT_H
+#define TAP_LAYOUT_H
+
+// Portable part of the audio tap: describes the audio of an IO cycle and
+// turns the buffers a device delivers into one interleaved block. Free of
+// Apple headers so the replay backend runs the same code on every platform.
+//
+// Devices with a non-interleaved stream format deliver one AudioBuffer per
+// channel, and devices with several interleaved streams one per stream.
+// Those are interleaved here, with SSE2/NEON for the common case of mono
+// planes of 32-bit samples, so Go only ever sees interleaved frames.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TAP_SIMD_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TAP_SIMD_NEON 1
+#endif
+
+// Most channels and buffers an IO cycle may carry
+#define TAP_MAX_CHANNELS 64
+
+// Frames of the interleave scratch; longer IO cycles are delivered in blocks
+#define TAP_MAX_BLOCK_FRAMES 4096
+
+// Layout of a block of audio handed to the callback. Blocks are always
+// interleaved; planar records that the device delivered one buffer per
+// channel and the block was interleaved natively. hostTimeNs is the host
+// time of the first frame, 0 when the device gave none, and generation
+// counts the output devices the tap has been bound to.
+typedef struct {
+    int channels;
+    double sampleRate;
+    int bytesPerSample;
+    int isFloat;
+    int planar;
+    size_t frames;
+    uint64_t hostTimeNs;
+    int generation;
+} AudioTapLayout;
+
+// One buffer of an IO cycle, holding channels interleaved channels
+typedef struct {
+    const void* data;
+    uint32_t bytes;
+    uint32_t channels;
+} AudioTapBuffer;
+
+// Callback function type for audio data. userData is the Go handle of the tap.
+typedef void (*AudioTapCallback)(uintptr_t userData, const void* audioData, size_t dataSize, const AudioTapLayout* layout);
+
+// Forward declaration of Go callback - implemented in Go via //export
+extern void audioTapGoCallback(uintptr_t userData, void* audioData, size_t dataSize, AudioTapLayout* layout);
+
+// Forward declaration of wrapper - defined in callbacks.go CGo preamble
+extern void coreaudio_callback_wrapper(uintptr_t userData, const void* audioData, size_t dataSize, const AudioTapLayout* layout);
+
+// Interleaves two mono planes of 32-bit samples. Samples are moved as
+// integers so float payloads, NaNs included, are copied bit for bit.
+static inline void AudioTap_InterleaveStereo32(const uint32_t* left, const uint32_t* right, size_t frames, uint32_t* out) {
+    size_t f = 0;
+#if TAP_SIMD_SSE
+    for (; f + 4 <= frames; f += 4) {
+        __m128i l = _mm_loadu_si128((const __m128i*)(left + f));
+        __m128i r = _mm_loadu_si128((const __m128i*)(right + f));
+        _mm_storeu_si128((__m128i*)(out + 2 * f), _mm_unpacklo_epi32(l, r));
+        _mm_storeu_si128((__m128i*)(out + 2 * f + 4), _mm_unpackhi_epi32(l, r));
+    }
+#elif TAP_SIMD_NEON
+    for (; f + 4 <= frames; f += 4) {
+        uint32x4x2_t lr = { { vld1q_u32(left + f), vld1q_u32(right + f) } };
+        vst2q_u32(out + 2 * f, lr);
+    }
+#endif
+    for (; f < frames; f++) {
+        out[2 * f] = left[f];
+        out[2 * f + 1] = right[f];
+    }
+}
+
+// Interleaves mono planes of 32-bit samples, one channel at a time
+static inline void AudioTap_InterleavePlanes32(const uint32_t* const* planes, int channels, size_t frames, uint32_t* out) {
+    if (channels == 2) {
+        AudioTap_InterleaveStereo32(planes[0], planes[1], frames, out);
+        return;
+    }
+    for (int c = 0; c < channels; c++) {
+        const uint32_t* plane = planes[c];
+        uint32_t* dst = out + c;
+        for (size_t f = 0; f < frames; f++) {
+            dst[f * channels] = plane[f];
+        }
+    }
+}
+
+// Interleaves buffers of any channel count and sample size, starting at
+// frame offset of each, into frames of out
+static inline void AudioTap_Interleave(const AudioTapBuffer* buffers, uint32_t count, int bytesPerSample, size_t offset, size_t frames, void* out) {
+    int mono32 = bytesPerSample == 4;
+    for (uint32_t b = 0; b < count && mono32; b++) {
+        mono32 = buffers[b].channels == 1;
+    }
+    if (mono32) {
+        const uint32_t* planes[TAP_MAX_CHANNELS];
+        for (uint32_t b = 0; b < count; b++) {
+            planes[b] = (const uint32_t*)buffers[b].data + offset;
+        }
+        AudioTap_InterleavePlanes32(planes, (int)count, frames, (uint32_t*)out);
+        return;
+    }
+
+    size_t frameBytes = 0;
+    for (uint32_t b = 0; b < count; b++) {
+        frameBytes += (size_t)buffers[b].channels * bytesPerSample;
+    }
+    size_t at = 0;
+    for (uint32_t b = 0; b < count; b++) {
+        size_t bytes = (size_t)buffers[b].channels * bytesPerSample;
+        const uint8_t* src = (const uint8_t*)buffers[b].data + offset * bytes;
+        uint8_t* dst = (uint8_t*)out + at;
+        for (size_t f = 0; f < frames; f++) {
+            memcpy(dst + f * frameBytes, src + f * bytes, bytes);
+        }
+        at += bytes;
+    }
+}
+
+// Hands one IO cycle to the callback as interleaved blocks. A single buffer
+// is interleaved already and goes through without a copy; several buffers
+// are interleaved into scratch, TAP_MAX_BLOCK_FRAMES frames at a time.
+// format supplies the sample rate and sample format of the device and the
+// host time of the cycle.
+static inline void AudioTap_Deliver(
+    const AudioTapBuffer* buffers,
+    uint32_t count,
+    AudioTapLayout format,
+    void* scratch,
+    size_t scratchBytes,
+    AudioTapCallback callback,
+    uintptr_t userData)
+{
+    if (count == 0 || count > TAP_MAX_CHANNELS || format.bytesPerSample <= 0) {
+        return;
+    }
+
+    // Channels of the cycle, and frames present in every buffer
+    int channels = 0;
+    size_t frames = SIZE_MAX;
+    for (uint32_t b = 0; b < count; b++) {
+        if (buffers[b].data == NULL || buffers[b].channels == 0) {
+            return;
+        }
+        channels += buffers[b].channels;
+        size_t bufferFrames = buffers[b].bytes / ((size_t)buffers[b].channels * format.bytesPerSample);
+        if (bufferFrames < frames) {
+            frames = bufferFrames;
+        }
+    }
+    if (frames == 0 || channels > TAP_MAX_CHANNELS) {
+        return;
+    }
+
+    AudioTapLayout layout = format;
+    layout.channels = channels;
+    size_t frameBytes = (size_t)channels * format.bytesPerSample;
+
+    if (count == 1) {
+        layout.frames = frames;
+        callback(userData, buffers[0].data, frames * frameBytes, &layout);
+        return;
+    }
+
+    size_t blockFrames = scratch != NULL ? scratchBytes / frameBytes : 0;
+    if (blockFrames == 0) {
+        return;
+    }
+    for (size_t offset = 0; offset < frames; offset += blockFrames) {
+        size_t n = frames - offset < blockFrames ? frames - offset : blockFrames;
+        AudioTap_Interleave(buffers, count, format.bytesPerSample, offset, n, scratch);
+        layout.frames = n;
+        if (format.hostTimeNs != 0) {
+            layout.hostTimeNs = format.hostTimeNs + (uint64_t)((double)offset * 1e9 / format.sampleRate);
+        }
+        callback(userData, scratch, n * frameBytes, &layout);
+    }
+}
+
+#endif // TAP_LAYOUT_H
@@ -0,0 +1,190 @@
+package coreaudio
+
+import (
+	"encoding/binary"
+	"math"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/logger"
+	"github.com/platformlabs-co/personal-assist/services/dsp"
+)
+
+const (
+	// tapGapTolerance is how late a block may start, against the end of
+	// the one before, before the difference is filled with silence
+	tapGapTolerance = 10 * time.Millisecond
+
+	// tapMaxGap bounds the silence inserted for one gap, against host clock
+	// jumps such as waking from sleep
+	tapMaxGap = time.Minute
+)
+
+// tapStream keeps the audio of a tap in one format while the output device
+// changes under it. The first block fixes the layout of the stream; blocks
+// in another layout, from a device switched to mid-recording, are converted
+// to it with a streaming resampler when the rate differs. A block starting
+// later than the previous one ended, by host time, is preceded by silence
+// for the gap, so the stream stays aligned with the microphone track.
+//
+// Blocks already in the stream layout pass through without a copy.
+type tapStream struct {
+	output     AudioLayout
+	input      AudioLayout // Layout of the previous block
+	started    bool
+	nextNs     uint64 // Host time the next block is expected at
+	generation int
+
+	resampler *dsp.Resampler
+	decoded   []float32
+	resampled []float32
+	encoded   []byte
+}
+
+// conform returns a block in the stream layout, preceded by silence for any
+// gap before it. The result is valid until the next call.
+func (s *tapStream) conform(data []byte, layout AudioLayout, hostTimeNs uint64, generation int) []byte {
+	frames := 0
+	if frameBytes := layout.FrameBytes(); frameBytes > 0 {
+		frames = len(data) / frameBytes
+	}
+	if !s.started {
+		s.output, s.input, s.started = layout, layout, true
+		s.generation = generation
+		s.nextNs = blockEnd(hostTimeNs, frames, layout.SampleRate)
+		return data
+	}
+
+	// Output frames the resampler held back for the previous device come
+	// first, then silence for the gap, then the block
+	s.encoded = s.encoded[:0]
+	if generation != s.generation || !sameFormat(layout, s.input) {
+		if s.resampler != nil {
+			s.resampled = s.resampler.Flush(s.resampled[:0])
+			s.encoded = encodeSamples(s.resampled, s.output, s.encoded)
+			s.resampler = nil
+		}
+		logger.WithFields(map[string]interface{}{
+			"from_sample_rate": s.input.SampleRate,
+			"from_channels":    s.input.Channels,
+			"to_sample_rate":   layout.SampleRate,
+			"to_channels":      layout.Channels,
+		}).Info("System audio output device changed")
+		s.generation = generation
+		s.input = layout
+	}
+
+	if hostTimeNs != 0 && s.nextNs != 0 && hostTimeNs > s.nextNs+uint64(tapGapTolerance) {
+		late := min(time.Duration(hostTimeNs-s.nextNs), tapMaxGap)
+		gap := int(late.Seconds()*s.output.SampleRate + 0.5)
+		s.encoded = append(s.encoded, make([]byte, gap*s.output.FrameBytes())...)
+	}
+	if hostTimeNs != 0 {
+		s.nextNs = blockEnd(hostTimeNs, frames, layout.SampleRate)
+	} else if s.nextNs != 0 {
+		s.nextNs = blockEnd(s.nextNs, frames, layout.SampleRate)
+	}
+
+	if sameFormat(layout, s.output) {
+		if len(s.encoded) == 0 {
+			return data
+		}
+		return append(s.encoded, data...)
+	}
+
+	// Decode to the stream's channels, then match its rate and sample format
+	s.decoded = decodeFrames(data, layout, s.output.Channels, s.decoded[:0])
+	samples := s.decoded
+	if layout.SampleRate != s.output.SampleRate {
+		if s.resampler == nil {
+			resampler, err := dsp.NewResampler(layout.SampleRate, s.output.SampleRate, s.output.Channels)
+			if err != nil {
+				return s.encoded
+			}
+			s.resampler = resampler
+		}
+		s.resampled = s.resampler.Process(samples, s.resampled[:0])
+		samples = s.resampled
+	}
+	s.encoded = encodeSamples(samples, s.output, s.encoded)
+	return s.encoded
+}
+
+// blockEnd returns the host time after frames at the given rate
+func blockEnd(hostTimeNs uint64, frames int, sampleRate float64) uint64 {
+	if hostTimeNs == 0 || sampleRate <= 0 {
+		return 0
+	}
+	return hostTimeNs + uint64(float64(frames)*1e9/sampleRate)
+}
+
+// sameFormat reports whether two layouts have identical frames
+func sameFormat(a, b AudioLayout) bool {
+	return a.Channels == b.Channels && a.SampleRate == b.SampleRate &&
+		a.BytesPerSample == b.BytesPerSample && a.Float == b.Float
+}
+
+// decodeFrames converts interleaved samples to float32 with the given
+// number of channels and appends them to out. A mono output averages the
+// input channels; otherwise missing channels repeat the input's and extra
+// input channels are dropped.
+func decodeFrames(data []byte, layout AudioLayout, channels int, out []float32) []float32 {
+	size := layout.BytesPerSample
+	frameBytes := layout.FrameBytes()
+	if frameBytes <= 0 {
+		return out
+	}
+	for at := 0; at+frameBytes <= len(data); at += frameBytes {
+		frame := data[at : at+frameBytes]
+		if channels == 1 {
+			var sum float32
+			for c := 0; c < layout.Channels; c++ {
+				sum += decodeSample(frame[c*size:], layout)
+			}
+			out = append(out, sum/float32(layout.Channels))
+			continue
+		}
+		for c := 0; c < channels; c++ {
+			out = append(out, decodeSample(frame[(c%layout.Channels)*size:], layout))
+		}
+	}
+	return out
+}
+
+// decodeSample reads a little-endian sample as a float in [-1, 1]
+func decodeSample(b []byte, layout AudioLayout) float32 {
+	switch {
+	case layout.Float && layout.BytesPerSample == 4:
+		return math.Float32frombits(binary.LittleEndian.Uint32(b))
+	case layout.Float && layout.BytesPerSample == 8:
+		return float32(math.Float64frombits(binary.LittleEndian.Uint64(b)))
+	}
+	// Signed integer PCM of 1 to 4 bytes
+	size := layout.BytesPerSample
+	var v int32
+	for i := 0; i < size; i++ {
+		v |= int32(b[i]) << (8 * i)
+	}
+	v = v << (32 - 8*size) >> (32 - 8*size)
+	return float32(v) / float32(int64(1)<<(8*size-1))
+}
+
+// encodeSamples writes float samples in the layout's sample format and
+// appends them to out
+func encodeSamples(samples []float32, layout AudioLayout, out []byte) []byte {
+	size := layout.BytesPerSample
+	for _, v := range samples {
+		switch {
+		case layout.Float && size == 4:
+			out = binary.LittleEndian.AppendUint32(out, math.Float32bits(v))
+		case layout.Float && size == 8:
+			out = binary.LittleEndian.AppendUint64(out, math.Float64bits(float64(v)))
+		default:
+			scale := float64(int64(1)<<(8*size-1)) - 1
+			q := int64(math.Round(float64(max(-1, min(1, v))) * scale))
+			for i := 0; i < size; i++ {
+				out = append(out, byte(q>>(8*i)))
+			}
+		}
+	}
+	return out
+}
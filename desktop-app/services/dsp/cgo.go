@@ -0,0 +1,9 @@
+package dsp
+
+// #cgo CFLAGS: -O3
+// #cgo LDFLAGS: -lm
+import "C"
+
+// This file sets up CGo compilation for the dsp package. The kernels in
+// fft_impl.h use SSE2 on amd64 and NEON on arm64, both baseline for those
+// architectures, so no target-specific flags are needed.
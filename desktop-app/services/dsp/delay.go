@@ -0,0 +1,80 @@
+package dsp
+
+import (
+	"fmt"
+	"math"
+)
+
+// EstimateDelay returns the lag, in samples, at which capture best matches
+// reference (capture[n] ≈ reference[n-lag]), searching lags in
+// [-maxLag, maxLag]. The cross spectrum is whitened (GCC-PHAT) so the peak
+// stays sharp for speech and music alike. The confidence is the peak over
+// the mean magnitude of the searched correlation; uncorrelated signals score
+// a few units, a clear echo path tens or more.
+func EstimateDelay(reference, capture []float32, maxLag int) (int, float64, error) {
+	if len(reference) == 0 || len(capture) == 0 {
+		return 0, 0, fmt.Errorf("delay estimation needs both signals")
+	}
+	if maxLag < 0 {
+		return 0, 0, fmt.Errorf("invalid maximum lag: %d", maxLag)
+	}
+
+	// Pad past both signals and the largest lag so the correlation does not wrap
+	size := 2
+	for size < len(reference)+len(capture)+maxLag {
+		size *= 2
+	}
+	fft, err := NewRealFFT(size)
+	if err != nil {
+		return 0, 0, err
+	}
+
+	frame := make([]float32, size)
+	copy(frame, reference)
+	referenceSpectrum := make([]complex64, fft.Bins())
+	if err := fft.Forward(frame, referenceSpectrum); err != nil {
+		return 0, 0, err
+	}
+
+	for i := range frame {
+		frame[i] = 0
+	}
+	copy(frame, capture)
+	cross := make([]complex64, fft.Bins())
+	if err := fft.Forward(frame, cross); err != nil {
+		return 0, 0, err
+	}
+
+	for k, c := range cross {
+		r := referenceSpectrum[k]
+		product := c * complex(real(r), -imag(r))
+		magnitude := float32(math.Hypot(float64(real(product)), float64(imag(product))))
+		if magnitude < 1e-20 {
+			cross[k] = 0
+			continue
+		}
+		cross[k] = product / complex(magnitude, 0)
+	}
+	if err := fft.Inverse(cross, frame); err != nil {
+		return 0, 0, err
+	}
+
+	best, peak, sum := 0, float32(-1), 0.0
+	for lag := -maxLag; lag <= maxLag; lag++ {
+		index := lag
+		if lag < 0 {
+			index += size
+		}
+		value := frame[index]
+		sum += math.Abs(float64(value))
+		if value > peak {
+			best, peak = lag, value
+		}
+	}
+
+	mean := sum / float64(2*maxLag+1)
+	if mean == 0 {
+		return 0, 0, nil
+	}
+	return best, float64(peak) / mean, nil
+}
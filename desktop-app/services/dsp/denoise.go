@@ -0,0 +1,302 @@
+package dsp
+
+import (
+	"fmt"
+	"math"
+)
+
+const (
+	// noiseSubwindows splits the noise window so its minimum can be updated
+	// one subwindow at a time instead of keeping every frame
+	noiseSubwindows = 4
+
+	// noiseMinimumBias corrects the minimum of a smoothed power, which
+	// underestimates the mean power of the noise it is taken over
+	noiseMinimumBias = 1.5
+)
+
+// NoiseSuppressorConfig tunes a NoiseSuppressor
+type NoiseSuppressorConfig struct {
+	SampleRate     int     // Input sample rate
+	FrameSize      int     // Analysis frame in samples; frames overlap by half
+	FloorDB        float64 // Strongest attenuation of a bin, in dB below unity
+	NoiseWindow    float64 // Seconds over which the noise floor is the minimum power
+	Smoothing      float32 // Weight of the previous frame in the smoothed bin power
+	PriorSmoothing float32 // Weight of the previous frame in the a priori SNR
+}
+
+// DefaultNoiseSuppressorConfig returns settings for speech: 32ms frames, at
+// most 20dB of attenuation and a noise floor that follows a fan speeding up
+// within two seconds but is found again in the gaps between words
+func DefaultNoiseSuppressorConfig(sampleRate int) NoiseSuppressorConfig {
+	frameSize := 2
+	for frameSize < sampleRate/32 {
+		frameSize *= 2
+	}
+	return NoiseSuppressorConfig{
+		SampleRate:     sampleRate,
+		FrameSize:      frameSize,
+		FloorDB:        20,
+		NoiseWindow:    1.6,
+		Smoothing:      0.7,
+		PriorSmoothing: 0.98,
+	}
+}
+
+// NoiseSuppressor is a streaming spectral noise suppressor. Each bin's
+// noise floor is the minimum of its smoothed power over the last
+// NoiseWindow seconds (minimum statistics), so stationary noise (fans, hum,
+// air handling) is learned in the pauses of speech without a voice detector. Bins are scaled by a
+// decision-directed Wiener gain, floored so the residual noise stays natural
+// and Whisper is not fed musical artifacts.
+//
+// Frames are Hann windowed with 50% overlap, which sums to one, so the
+// suppressor reconstructs its input exactly where it applies no gain. Output
+// lags input by one hop; Flush emits the rest, so the output has exactly as
+// many samples as the input. A NoiseSuppressor is not safe for concurrent use.
+type NoiseSuppressor struct {
+	config NoiseSuppressorConfig
+	stft   *STFT
+	fft    *RealFFT
+	hop    int
+
+	floor    float32 // Minimum gain
+	started  bool
+	smoothed []float32 // Smoothed power per bin
+	noise    []float32 // Noise floor per bin
+	minimum  []float32 // Minimum smoothed power of the current subwindow
+	history  [noiseSubwindows][]float32
+	frames   int       // Frames in the current subwindow
+	window   int       // Frames per subwindow
+	prior    []float32 // |gain*X|^2/noise of the previous frame per bin
+
+	spectrum []complex64
+	frame    []float32
+	overlap  []float32 // Overlap-add accumulator, FrameSize samples
+	silence  []float32 // One hop of zeros for priming and flushing
+
+	output  []float32 // Destination of the current Process or Flush call
+	skip    int       // Leading samples still to drop (the priming hop)
+	pushed  int64     // Samples pushed since the last reset
+	emitted int64     // Samples emitted since the last reset
+}
+
+// NewNoiseSuppressor creates a suppressor for a mono stream
+func NewNoiseSuppressor(config NoiseSuppressorConfig) (*NoiseSuppressor, error) {
+	if config.SampleRate < 1 {
+		return nil, fmt.Errorf("invalid sample rate: %d", config.SampleRate)
+	}
+	if config.FrameSize < 4 || config.FrameSize%4 != 0 {
+		return nil, fmt.Errorf("noise suppressor frame size must be a multiple of 4, got %d", config.FrameSize)
+	}
+	if config.FloorDB < 0 || config.NoiseWindow <= 0 {
+		return nil, fmt.Errorf("invalid noise suppressor floor %.1fdB or window %.1fs", config.FloorDB, config.NoiseWindow)
+	}
+	if config.Smoothing < 0 || config.Smoothing >= 1 || config.PriorSmoothing < 0 || config.PriorSmoothing >= 1 {
+		return nil, fmt.Errorf("noise suppressor smoothing must be in [0, 1)")
+	}
+
+	hop := config.FrameSize / 2
+	subwindow := config.NoiseWindow / noiseSubwindows * float64(config.SampleRate) / float64(hop)
+	n := &NoiseSuppressor{
+		config: config,
+		hop:    hop,
+		floor:  float32(math.Pow(10, -config.FloorDB/20)),
+		window: int(math.Max(1, math.Round(subwindow))),
+	}
+
+	stft, err := NewSTFT(STFTConfig{
+		FFTSize:    config.FrameSize,
+		WindowSize: config.FrameSize,
+		HopSize:    hop,
+		Window:     WindowHann,
+		SampleRate: config.SampleRate,
+	}, n)
+	if err != nil {
+		return nil, err
+	}
+	n.stft = stft
+	n.fft = stft.fft
+
+	bins := n.fft.Bins()
+	n.smoothed = make([]float32, bins)
+	n.noise = make([]float32, bins)
+	n.prior = make([]float32, bins)
+	n.minimum = make([]float32, bins)
+	for i := range n.history {
+		n.history[i] = make([]float32, bins)
+	}
+	n.spectrum = make([]complex64, bins)
+	n.frame = make([]float32, config.FrameSize)
+	n.overlap = make([]float32, config.FrameSize)
+	n.silence = make([]float32, hop)
+	n.Reset()
+	return n, nil
+}
+
+// Latency returns how many samples output lags input
+func (n *NoiseSuppressor) Latency() int {
+	return n.hop
+}
+
+// Process suppresses noise in a block of samples and appends the samples
+// that are complete to output, returning the extended slice
+func (n *NoiseSuppressor) Process(samples []float32, output []float32) []float32 {
+	n.output = output
+	n.pushed += int64(len(samples))
+	n.stft.Push(samples)
+	output, n.output = n.output, nil
+	return output
+}
+
+// Flush appends the samples still held back to output and resets the
+// suppressor for a new stream, noise estimates included
+func (n *NoiseSuppressor) Flush(output []float32) []float32 {
+	n.output = output
+	// One more hop of silence gives the last samples their second frame
+	n.stft.Push(n.silence)
+	n.stft.Flush()
+	output, n.output = n.output, nil
+	n.Reset()
+	return output
+}
+
+// Reset discards buffered samples and the noise estimates
+func (n *NoiseSuppressor) Reset() {
+	n.stft.Reset()
+	n.started = false
+	for i := range n.overlap {
+		n.overlap[i] = 0
+	}
+	n.skip = n.hop
+	n.pushed = 0
+	n.emitted = 0
+
+	// Prime the stream so the first frame already overlaps the first sample
+	n.stft.Push(n.silence)
+}
+
+// ConsumeFrame applies the suppression gains to one frame and overlap-adds it
+func (n *NoiseSuppressor) ConsumeFrame(frame *Frame) {
+	n.updateNoise(frame.Power)
+
+	for k, x := range frame.Spectrum {
+		n.spectrum[k] = x * complex(n.gain(k, frame.Power[k]), 0)
+	}
+	if err := n.fft.Inverse(n.spectrum, n.frame); err != nil {
+		return // Sizes are fixed at construction
+	}
+
+	for i, sample := range n.frame {
+		n.overlap[i] += sample
+	}
+	n.emit(n.overlap[:n.hop])
+
+	copy(n.overlap, n.overlap[n.hop:])
+	for i := n.config.FrameSize - n.hop; i < n.config.FrameSize; i++ {
+		n.overlap[i] = 0
+	}
+}
+
+// updateNoise advances the smoothed power and the noise floor of every bin
+func (n *NoiseSuppressor) updateNoise(power []float32) {
+	if !n.started {
+		copy(n.smoothed, power)
+		copy(n.minimum, power)
+		for i := range n.history {
+			copy(n.history[i], power)
+		}
+		for k := range n.prior {
+			n.prior[k] = 1
+		}
+		n.frames = 0
+		n.started = true
+	}
+
+	a := n.config.Smoothing
+	for k, p := range power {
+		s := a*n.smoothed[k] + (1-a)*p
+		n.smoothed[k] = s
+		if s < n.minimum[k] {
+			n.minimum[k] = s
+		}
+
+		floor := n.minimum[k]
+		for i := range n.history {
+			if n.history[i][k] < floor {
+				floor = n.history[i][k]
+			}
+		}
+		n.noise[k] = floor * noiseMinimumBias
+	}
+
+	// Retire the oldest subwindow so the floor can rise again
+	n.frames++
+	if n.frames == n.window {
+		oldest := n.history[0]
+		copy(n.history[:], n.history[1:])
+		copy(oldest, n.minimum)
+		n.history[noiseSubwindows-1] = oldest
+		copy(n.minimum, n.smoothed)
+		n.frames = 0
+	}
+}
+
+// gain returns the decision-directed Wiener gain of bin k for power p and
+// remembers the cleaned SNR for the next frame
+func (n *NoiseSuppressor) gain(k int, p float32) float32 {
+	noise := n.noise[k]
+	if noise < 1e-12 {
+		noise = 1e-12
+	}
+
+	posterior := p / noise
+	instant := posterior - 1
+	if instant < 0 {
+		instant = 0
+	}
+	a := n.config.PriorSmoothing
+	prior := a*n.prior[k] + (1-a)*instant
+
+	g := prior / (1 + prior)
+	if g < n.floor {
+		g = n.floor
+	}
+	n.prior[k] = g * g * posterior
+	return g
+}
+
+// emit appends finished samples to the output, dropping the priming hop and
+// the padding beyond the last pushed sample
+func (n *NoiseSuppressor) emit(samples []float32) {
+	if n.skip > 0 {
+		drop := n.skip
+		if drop > len(samples) {
+			drop = len(samples)
+		}
+		samples = samples[drop:]
+		n.skip -= drop
+	}
+	if remaining := n.pushed - n.emitted; int64(len(samples)) > remaining {
+		samples = samples[:remaining]
+	}
+	n.output = append(n.output, samples...)
+	n.emitted += int64(len(samples))
+}
+
+// SuppressNoise runs a fresh suppressor over a whole recording and returns
+// the cleaned samples, as many as were given
+func SuppressNoise(samples []float32, config NoiseSuppressorConfig) ([]float32, error) {
+	return SuppressNoiseTo(samples, make([]float32, 0, len(samples)), config)
+}
+
+// SuppressNoiseTo is SuppressNoise appending to output, for callers that
+// bring their own buffer
+func SuppressNoiseTo(samples, output []float32, config NoiseSuppressorConfig) ([]float32, error) {
+	suppressor, err := NewNoiseSuppressor(config)
+	if err != nil {
+		return nil, err
+	}
+	output = suppressor.Process(samples, output)
+	return suppressor.Flush(output), nil
+}
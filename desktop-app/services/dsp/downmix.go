@@ -0,0 +1,286 @@
+package dsp
+
+/*
+#include "fft_impl.h"
+*/
+import "C"
+import (
+	"fmt"
+	"math"
+	"strconv"
+	"unsafe"
+)
+
+const (
+	// downmixDeadLevel is the energy, relative to the loudest channel, below
+	// which a channel carries nothing worth mixing in (-30dB)
+	downmixDeadLevel = 1e-3
+
+	// downmixSilence is the mean square below which a window is silence and
+	// leaves the weights alone (-80dBFS)
+	downmixSilence = 1e-8
+
+	// downmixPolarity is the correlation with the loudest channel below which
+	// a channel is taken to be wired out of phase and inverted
+	downmixPolarity = -0.3
+
+	// downmixMemory weighs the earlier windows in the channel statistics, so
+	// a single window of one-sided sound does not swing the mix
+	downmixMemory = 0.5
+)
+
+// DownmixConfig tunes a Downmixer
+type DownmixConfig struct {
+	Channels   int
+	BitDepth   int // Bits per PCM sample; 8, 16, 24 or 32
+	SampleRate int
+	Window     float64 // Seconds per analysis window; 0 averages the channels
+}
+
+// DefaultDownmixConfig returns settings for recordings: the channel weights
+// are revisited every quarter second and move smoothly to their new values
+// over the next quarter second
+func DefaultDownmixConfig(channels, bitDepth, sampleRate int) DownmixConfig {
+	return DownmixConfig{
+		Channels:   channels,
+		BitDepth:   bitDepth,
+		SampleRate: sampleRate,
+		Window:     0.25,
+	}
+}
+
+// Downmixer converts interleaved integer PCM to mono float32 samples in
+// [-1, 1]. Averaging channels halves the level when one of them is dead and
+// cancels it when one is out of phase, both common with USB headsets and
+// system audio taps, so the downmixer measures each channel's energy and
+// its correlation with the loudest channel over windows: dead channels are
+// dropped, inverted ones are flipped, and the rest are weighted by their
+// level. New weights ramp in over one window so the mix never clicks.
+//
+// Conversion, mixing and the statistics run as one native pass. A
+// Downmixer is not safe for concurrent use.
+type Downmixer struct {
+	config   DownmixConfig
+	scale    float32
+	window   int // Frames per window, 0 for fixed weights
+	channels int
+
+	weights []float32 // Weights at the next frame
+	ramp    []float32 // Change of weight per frame
+	target  []float32 // Weights decided on at the last window
+	ref     int       // Channel the correlations are taken against
+
+	energy   []float64 // Statistics of the current window
+	cross    []float64
+	measured int       // Frames in the statistics
+	frames   int       // Frames of the current window mixed
+	history  []float64 // Smoothed energy and cross statistics, 2*channels
+	started  bool
+}
+
+// NewDownmixer creates a downmixer for interleaved PCM of the given layout
+func NewDownmixer(config DownmixConfig) (*Downmixer, error) {
+	if strconv.IntSize != 64 {
+		return nil, fmt.Errorf("downmixing needs 64-bit ints")
+	}
+	if config.Channels < 1 {
+		return nil, fmt.Errorf("invalid channel count: %d", config.Channels)
+	}
+	if config.SampleRate < 1 {
+		return nil, fmt.Errorf("invalid sample rate: %d", config.SampleRate)
+	}
+	if config.Window < 0 {
+		return nil, fmt.Errorf("invalid downmix window: %.3fs", config.Window)
+	}
+
+	d := &Downmixer{
+		config:   config,
+		scale:    pcmScale(config.BitDepth),
+		window:   int(config.Window * float64(config.SampleRate)),
+		channels: config.Channels,
+		weights:  make([]float32, config.Channels),
+		ramp:     make([]float32, config.Channels),
+		target:   make([]float32, config.Channels),
+		energy:   make([]float64, config.Channels),
+		cross:    make([]float64, config.Channels),
+		history:  make([]float64, 2*config.Channels),
+	}
+	d.Reset()
+	return d, nil
+}
+
+// pcmScale returns the factor mapping samples of a bit depth to [-1, 1],
+// assuming 16-bit for depths WAV files do not use
+func pcmScale(bitDepth int) float32 {
+	switch bitDepth {
+	case 8, 16, 24, 32:
+		return float32(1 / math.Exp2(float64(bitDepth-1)))
+	default:
+		return 1.0 / 32768
+	}
+}
+
+// Reset returns to equal weights and forgets the channel statistics
+func (d *Downmixer) Reset() {
+	for c := range d.weights {
+		d.weights[c] = 1 / float32(d.channels)
+		d.ramp[c] = 0
+	}
+	for i := range d.history {
+		d.history[i] = 0
+	}
+	d.clearStatistics()
+	d.ref = 0
+	d.frames = 0
+	d.started = false
+}
+
+// Weights returns the current weight of each channel
+func (d *Downmixer) Weights() []float32 {
+	return append([]float32(nil), d.weights...)
+}
+
+// Process mixes samples, whole interleaved frames, and appends the mono
+// samples to output, returning the extended slice
+func (d *Downmixer) Process(samples []int, output []float32) []float32 {
+	frames := len(samples) / d.channels
+	start := len(output)
+	if cap(output)-start < frames {
+		grown := make([]float32, start, start+frames)
+		copy(grown, output)
+		output = grown
+	}
+	output = output[:start+frames]
+
+	for done := 0; done < frames; {
+		n := frames - done
+		if d.window > 0 {
+			n = min(n, d.window-d.frames)
+		}
+		in := samples[done*d.channels : (done+n)*d.channels]
+		out := output[start+done : start+done+n]
+
+		d.mix(in, out, n)
+		if !d.started && d.window > 0 {
+			// Decide on the first samples before any of them are emitted
+			d.started = true
+			if d.decide() {
+				copy(d.weights, d.target)
+				d.mix(in, out, n)
+				d.clearStatistics()
+			}
+		}
+		for c := range d.weights {
+			d.weights[c] += d.ramp[c] * float32(n)
+		}
+
+		d.frames += n
+		done += n
+		if d.window > 0 && d.frames == d.window {
+			d.frames = 0
+			decided := d.decide()
+			for c := range d.ramp {
+				d.ramp[c] = 0
+				if decided {
+					d.ramp[c] = (d.target[c] - d.weights[c]) / float32(d.window)
+				}
+			}
+		}
+	}
+	return output
+}
+
+// mix runs the native pass over n frames
+func (d *Downmixer) mix(in []int, out []float32, n int) {
+	if n == 0 {
+		return
+	}
+	d.measured += n
+	C.DSP_Downmix(
+		(*C.int64_t)(unsafe.Pointer(&in[0])),
+		C.int(n), C.int(d.channels), C.float(d.scale),
+		(*C.float)(unsafe.Pointer(&d.weights[0])),
+		(*C.float)(unsafe.Pointer(&d.ramp[0])),
+		C.int(d.ref),
+		(*C.float)(unsafe.Pointer(&out[0])),
+		(*C.double)(unsafe.Pointer(&d.energy[0])),
+		(*C.double)(unsafe.Pointer(&d.cross[0])))
+}
+
+// clearStatistics starts a new window's statistics
+func (d *Downmixer) clearStatistics() {
+	for c := range d.energy {
+		d.energy[c], d.cross[c] = 0, 0
+	}
+	d.measured = 0
+}
+
+// decide folds the window's statistics into the history and sets target to
+// the weights the mix should move to. It reports false, keeping the current
+// weights, when the window was silence.
+func (d *Downmixer) decide() bool {
+	var total float64
+	for _, e := range d.energy {
+		total += e
+	}
+	silent := total < downmixSilence*float64(d.measured*d.channels)
+	energy, cross := d.history[:d.channels], d.history[d.channels:]
+	if !silent {
+		for c := range energy {
+			energy[c] = downmixMemory*energy[c] + d.energy[c]
+			cross[c] = downmixMemory*cross[c] + d.cross[c]
+		}
+	}
+	d.clearStatistics()
+	if silent {
+		return false
+	}
+
+	// Polarity relative to the reference channel, then the loudest channel
+	// is kept upright so the mix does not flip when the reference changes
+	loudest := 0
+	for c, e := range energy {
+		if e > energy[loudest] {
+			loudest = c
+		}
+	}
+	var sum float64
+	for c, e := range energy {
+		d.target[c] = 0
+		if e < downmixDeadLevel*energy[loudest] {
+			continue
+		}
+		level := math.Sqrt(e)
+		if cross[c]/math.Sqrt(e*energy[d.ref]+1e-30) < downmixPolarity {
+			level = -level
+		}
+		d.target[c] = float32(level)
+		sum += math.Abs(level)
+	}
+	scale := float32(1 / sum)
+	if d.target[loudest] < 0 {
+		scale = -scale
+	}
+	for c := range d.target {
+		d.target[c] *= scale
+	}
+
+	// Correlations of the next windows are taken against the loudest
+	// channel; the history is against the old reference, so it restarts
+	if loudest != d.ref {
+		d.ref = loudest
+		for c := range cross {
+			cross[c] = 0
+		}
+	}
+	return true
+}
+
+// Downmix converts a whole recording of interleaved PCM to mono
+func Downmix(samples []int, config DownmixConfig) ([]float32, error) {
+	downmixer, err := NewDownmixer(config)
+	if err != nil {
+		return nil, err
+	}
+	return downmixer.Process(samples, make([]float32, 0, len(samples)/config.Channels)), nil
+}
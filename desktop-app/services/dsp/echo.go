@@ -0,0 +1,350 @@
+package dsp
+
+/*
+#include "fft_impl.h"
+*/
+import "C"
+import (
+	"fmt"
+	"math"
+	"unsafe"
+)
+
+// EchoCancellerConfig tunes an EchoCanceller
+type EchoCancellerConfig struct {
+	SampleRate   int
+	BlockSize    int     // Samples per adaptation step, a power of two
+	FilterLength float64 // Seconds of echo path the filter models
+	StepSize     float32 // NLMS step in (0, 1]
+}
+
+// DefaultEchoCancellerConfig returns settings for a laptop or desk setup:
+// blocks of about 10ms and a 250ms echo tail, enough for the speaker to
+// microphone path of a room once the streams are aligned
+func DefaultEchoCancellerConfig(sampleRate int) EchoCancellerConfig {
+	blockSize := 2
+	for blockSize < sampleRate/100 {
+		blockSize *= 2
+	}
+	return EchoCancellerConfig{
+		SampleRate:   sampleRate,
+		BlockSize:    blockSize,
+		FilterLength: 0.25,
+		StepSize:     0.5,
+	}
+}
+
+const (
+	// echoActiveLevel is the mean square below which a reference block is
+	// silence (-70dBFS): the filters are not compared on it, and it floors
+	// the NLMS normalization so bins the reference barely reaches are not
+	// adapted to microphone noise
+	echoActiveLevel = 1e-7
+
+	// echoRecent weighs the previous blocks in the error energies the two
+	// filters are compared on, about a quarter second at the default block
+	// size, so a single block of double talk does not decide
+	echoRecent = 0.95
+
+	// echoAdopt is how much lower the adapting filter's recent error must be
+	// for the output filter to take over its weights
+	echoAdopt = 0.7
+
+	// echoRevert is how much higher the adapting filter's recent error may
+	// get before it is reset to the output filter's weights, as happens when
+	// it adapts to near-end speech
+	echoRevert = 4
+
+	// echoDivergence is how much louder than the capture a block's output may
+	// get before the capture is passed through instead
+	echoDivergence = 2
+)
+
+// EchoCanceller removes a reference signal (what the speakers played) from
+// a capture signal (what the microphone heard) with a partitioned-block
+// frequency-domain adaptive filter (MDF). Each block the filter estimates
+// the echo from the recent reference spectra, subtracts it and adapts with
+// a per-bin NLMS step. One partition's weights are constrained back to a
+// linear convolution per block, in rotation, as in the alternating-update
+// MDF.
+//
+// Near-end speech over the echo (double talk) would pull an always-adapting
+// filter off the echo path, so the output comes from a second, fixed copy
+// of the weights. The copy takes over the adapting filter's weights when
+// its error has been clearly lower for a while, which is how it follows a
+// changed echo path, and the adapting filter falls back to the copy when
+// its error has been clearly higher, which is what double talk does to it.
+//
+// Output lags input by less than one block; Flush emits the rest, so the
+// output has exactly as many samples as the capture. An EchoCanceller is
+// not safe for concurrent use.
+type EchoCanceller struct {
+	config     EchoCancellerConfig
+	fft        *RealFFT
+	block      int
+	bins       int
+	partitions int
+
+	spectra    []complex64 // Ring of reference spectra, partitions*bins
+	power      []float32   // Power of each ring entry, partitions*bins
+	powerSum   []float32   // Sum of power over the ring, per bin
+	weights    []complex64 // Adapting filter, partitions*bins
+	foreground []complex64 // Output filter, partitions*bins
+	head       int         // Ring entry of the newest spectrum
+	rotation   int         // Next partition to constrain
+
+	recentError      float64 // Decaying sums of block error energies
+	recentForeground float64
+
+	previous []float32 // Reference samples of the previous block
+	frame    []float32 // 2*block samples
+	residual []float32 // Output filter's error, block samples
+	echo     []complex64
+	errors   []complex64
+	gradient []complex64
+
+	capture   []float32 // Samples waiting for a full block
+	reference []float32
+	output    []float32
+	pushed    int64
+	emitted   int64
+
+	captureEnergy float64
+	outputEnergy  float64
+}
+
+// NewEchoCanceller creates a canceller for mono capture and reference streams
+func NewEchoCanceller(config EchoCancellerConfig) (*EchoCanceller, error) {
+	if config.SampleRate < 1 {
+		return nil, fmt.Errorf("invalid sample rate: %d", config.SampleRate)
+	}
+	if config.BlockSize < 2 || config.BlockSize&(config.BlockSize-1) != 0 {
+		return nil, fmt.Errorf("echo canceller block size must be a power of two, got %d", config.BlockSize)
+	}
+	if config.FilterLength <= 0 {
+		return nil, fmt.Errorf("invalid echo filter length: %.3fs", config.FilterLength)
+	}
+	if config.StepSize <= 0 || config.StepSize > 1 {
+		return nil, fmt.Errorf("invalid echo canceller step: %.2f", config.StepSize)
+	}
+
+	fft, err := NewRealFFT(2 * config.BlockSize)
+	if err != nil {
+		return nil, err
+	}
+
+	taps := int(math.Ceil(config.FilterLength * float64(config.SampleRate)))
+	partitions := (taps + config.BlockSize - 1) / config.BlockSize
+	bins := fft.Bins()
+	e := &EchoCanceller{
+		config:     config,
+		fft:        fft,
+		block:      config.BlockSize,
+		bins:       bins,
+		partitions: partitions,
+		spectra:    make([]complex64, partitions*bins),
+		power:      make([]float32, partitions*bins),
+		powerSum:   make([]float32, bins),
+		weights:    make([]complex64, partitions*bins),
+		foreground: make([]complex64, partitions*bins),
+		previous:   make([]float32, config.BlockSize),
+		frame:      make([]float32, 2*config.BlockSize),
+		residual:   make([]float32, config.BlockSize),
+		echo:       make([]complex64, bins),
+		errors:     make([]complex64, bins),
+		gradient:   make([]complex64, bins),
+	}
+	return e, nil
+}
+
+// Process cancels the echo of reference in capture and appends the finished
+// samples to output, returning the extended slice. reference should hold as
+// many samples as capture; missing reference samples count as silence.
+func (e *EchoCanceller) Process(capture, reference []float32, output []float32) []float32 {
+	e.output = output
+	e.pushed += int64(len(capture))
+	e.capture = append(e.capture, capture...)
+	if len(reference) > len(capture) {
+		reference = reference[:len(capture)]
+	}
+	e.reference = append(e.reference, reference...)
+	for len(e.reference) < len(e.capture) {
+		e.reference = append(e.reference, 0)
+	}
+
+	offset := 0
+	for len(e.capture)-offset >= e.block {
+		e.processBlock(e.capture[offset:offset+e.block], e.reference[offset:offset+e.block])
+		offset += e.block
+	}
+	remaining := copy(e.capture, e.capture[offset:])
+	e.capture = e.capture[:remaining]
+	copy(e.reference, e.reference[offset:])
+	e.reference = e.reference[:remaining]
+
+	output, e.output = e.output, nil
+	return output
+}
+
+// Flush appends the samples still held back to output and resets the
+// canceller, adapted weights included
+func (e *EchoCanceller) Flush(output []float32) []float32 {
+	if len(e.capture) > 0 {
+		e.output = output
+		padding := make([]float32, e.block-len(e.capture))
+		e.processBlock(append(e.capture, padding...), append(e.reference, padding...))
+		output, e.output = e.output, nil
+	}
+	e.Reset()
+	return output
+}
+
+// Reset discards buffered samples and the adapted echo path
+func (e *EchoCanceller) Reset() {
+	for i := range e.spectra {
+		e.spectra[i] = 0
+		e.power[i] = 0
+		e.weights[i] = 0
+		e.foreground[i] = 0
+	}
+	for i := range e.powerSum {
+		e.powerSum[i] = 0
+	}
+	for i := range e.previous {
+		e.previous[i] = 0
+	}
+	e.head = 0
+	e.rotation = 0
+	e.recentError = 0
+	e.recentForeground = 0
+	e.capture = e.capture[:0]
+	e.reference = e.reference[:0]
+	e.pushed = 0
+	e.emitted = 0
+}
+
+// Attenuation returns how much quieter the output was than the capture,
+// in dB, over everything processed since the canceller was created
+func (e *EchoCanceller) Attenuation() float64 {
+	if e.outputEnergy == 0 || e.captureEnergy == 0 {
+		return 0
+	}
+	return 10 * math.Log10(e.captureEnergy/e.outputEnergy)
+}
+
+// processBlock cancels the echo in one block of capture samples
+func (e *EchoCanceller) processBlock(capture, reference []float32) {
+	n, bins := e.block, e.bins
+
+	// Newest reference spectrum over the last two blocks replaces the oldest
+	e.head = (e.head + e.partitions - 1) % e.partitions
+	spectrum := e.spectra[e.head*bins : (e.head+1)*bins]
+	power := e.power[e.head*bins : (e.head+1)*bins]
+	copy(e.frame, e.previous)
+	copy(e.frame[n:], reference)
+	copy(e.previous, reference)
+	e.fft.Forward(e.frame, spectrum)
+	for k, x := range spectrum {
+		p := real(x)*real(x) + imag(x)*imag(x)
+		// Clamp the running sum against float drift
+		e.powerSum[k] = float32(math.Max(float64(e.powerSum[k]+p-power[k]), 0))
+		power[k] = p
+	}
+
+	var level, captureEnergy, foregroundEnergy, errorEnergy float64
+	for i, x := range reference {
+		level += float64(x) * float64(x)
+		captureEnergy += float64(capture[i]) * float64(capture[i])
+	}
+
+	// Output filter's error
+	e.filter(e.foreground)
+	for i := 0; i < n; i++ {
+		residual := capture[i] - e.frame[n+i]
+		foregroundEnergy += float64(residual) * float64(residual)
+		e.residual[i] = residual
+	}
+
+	// Adapting filter's error, zero padded for the gradient
+	e.filter(e.weights)
+	for i := 0; i < n; i++ {
+		residual := capture[i] - e.frame[n+i]
+		errorEnergy += float64(residual) * float64(residual)
+		e.frame[n+i] = residual
+		e.frame[i] = 0
+	}
+	e.fft.Forward(e.frame, e.errors)
+
+	// Compare the filters while the reference is audible; in silence both
+	// errors are just the near end
+	if level/float64(n) > echoActiveLevel {
+		e.recentError = echoRecent*e.recentError + errorEnergy
+		e.recentForeground = echoRecent*e.recentForeground + foregroundEnergy
+		switch {
+		case e.recentError < echoAdopt*e.recentForeground:
+			copy(e.foreground, e.weights)
+			copy(e.residual, e.frame[n:])
+			foregroundEnergy = errorEnergy
+			e.recentForeground = e.recentError
+		case e.recentError > echoRevert*e.recentForeground:
+			copy(e.weights, e.foreground)
+			e.recentError = e.recentForeground
+		}
+	}
+
+	// Never emit a block made louder by a wrong estimate
+	if foregroundEnergy > echoDivergence*captureEnergy {
+		e.emit(capture)
+		e.outputEnergy += captureEnergy
+	} else {
+		e.emit(e.residual)
+		e.outputEnergy += foregroundEnergy
+	}
+	e.captureEnergy += captureEnergy
+
+	// Per-bin NLMS step of the adapting filter. A reference at
+	// echoActiveLevel gives each bin 2n times its mean square per partition.
+	var total float32
+	for _, p := range e.powerSum {
+		total += p
+	}
+	regularization := total/float32(bins)*1e-3 + float32(2*n*e.partitions)*echoActiveLevel
+	for k, err := range e.errors {
+		e.gradient[k] = err * complex(e.config.StepSize/(e.powerSum[k]+regularization), 0)
+	}
+	C.DSP_PartitionUpdate(
+		(*C.DSPComplex)(unsafe.Pointer(&e.spectra[0])),
+		(*C.DSPComplex)(unsafe.Pointer(&e.weights[0])),
+		C.int(e.partitions), C.int(e.head), C.int(bins),
+		(*C.DSPComplex)(unsafe.Pointer(&e.gradient[0])))
+
+	// Constrain one partition back to n taps
+	weights := e.weights[e.rotation*bins : (e.rotation+1)*bins]
+	e.fft.Inverse(weights, e.frame)
+	for i := n; i < 2*n; i++ {
+		e.frame[i] = 0
+	}
+	e.fft.Forward(e.frame, weights)
+	e.rotation = (e.rotation + 1) % e.partitions
+}
+
+// filter estimates the echo of the reference ring through weights, leaving
+// it in the second half of frame
+func (e *EchoCanceller) filter(weights []complex64) {
+	C.DSP_PartitionFilter(
+		(*C.DSPComplex)(unsafe.Pointer(&e.spectra[0])),
+		(*C.DSPComplex)(unsafe.Pointer(&weights[0])),
+		C.int(e.partitions), C.int(e.head), C.int(e.bins),
+		(*C.DSPComplex)(unsafe.Pointer(&e.echo[0])))
+	e.fft.Inverse(e.echo, e.frame)
+}
+
+// emit appends finished samples to the output, dropping the padding beyond
+// the last pushed sample
+func (e *EchoCanceller) emit(samples []float32) {
+	if remaining := e.pushed - e.emitted; int64(len(samples)) > remaining {
+		samples = samples[:remaining]
+	}
+	e.output = append(e.output, samples...)
+	e.emitted += int64(len(samples))
+}
@@ -0,0 +1,128 @@
+package dsp
+
+/*
+#include "fft_impl.h"
+*/
+import "C"
+import (
+	"fmt"
+	"sync"
+	"unsafe"
+)
+
+// RealFFT is a cached plan for forward and inverse transforms of real input.
+// Plans are immutable and shared; each transform brings its own scratch space.
+type RealFFT struct {
+	size int
+	plan *C.DSPRealPlan
+	pool sync.Pool // *fftScratch for Forward and Inverse
+}
+
+// fftScratch holds the per-call buffers of a transform
+type fftScratch struct {
+	frame []float32
+	work  []complex64
+}
+
+var (
+	planCache = make(map[int]*RealFFT)
+	planMutex sync.Mutex
+)
+
+// NewRealFFT returns the plan for transforms of the given even size, creating
+// and caching it on first use. Twiddle tables are computed once per size.
+func NewRealFFT(size int) (*RealFFT, error) {
+	planMutex.Lock()
+	defer planMutex.Unlock()
+
+	if plan, ok := planCache[size]; ok {
+		return plan, nil
+	}
+
+	if size < 2 || size%2 != 0 {
+		return nil, fmt.Errorf("FFT size must be even and at least 2, got %d", size)
+	}
+
+	plan := C.DSP_RealPlanCreate(C.int(size))
+	if plan == nil {
+		return nil, fmt.Errorf("failed to create FFT plan for size %d", size)
+	}
+
+	// Plans live for the rest of the process, like the window cache
+	fft := &RealFFT{size: size, plan: plan}
+	fft.pool.New = func() interface{} {
+		return &fftScratch{
+			frame: make([]float32, size),
+			work:  make([]complex64, C.DSP_RealScratchSize(plan)),
+		}
+	}
+	planCache[size] = fft
+	return fft, nil
+}
+
+// Size returns the transform length
+func (f *RealFFT) Size() int {
+	return f.size
+}
+
+// Bins returns the number of frequency bins a transform produces
+func (f *RealFFT) Bins() int {
+	return f.size/2 + 1
+}
+
+// Forward transforms input (Size samples) into output (Bins values)
+func (f *RealFFT) Forward(input []float32, output []complex64) error {
+	if len(input) != f.size {
+		return fmt.Errorf("FFT input has %d samples, expected %d", len(input), f.size)
+	}
+	if len(output) < f.Bins() {
+		return fmt.Errorf("FFT output holds %d bins, expected %d", len(output), f.Bins())
+	}
+
+	scratch := f.pool.Get().(*fftScratch)
+	defer f.pool.Put(scratch)
+
+	C.DSP_RealForward(f.plan,
+		(*C.float)(unsafe.Pointer(&input[0])),
+		(*C.DSPComplex)(unsafe.Pointer(&output[0])),
+		(*C.DSPComplex)(unsafe.Pointer(&scratch.work[0])))
+	return nil
+}
+
+// Inverse transforms input (Bins values) back into output (Size samples),
+// undoing Forward including its scaling
+func (f *RealFFT) Inverse(input []complex64, output []float32) error {
+	if len(input) < f.Bins() {
+		return fmt.Errorf("inverse FFT input holds %d bins, expected %d", len(input), f.Bins())
+	}
+	if len(output) != f.size {
+		return fmt.Errorf("inverse FFT output has %d samples, expected %d", len(output), f.size)
+	}
+
+	scratch := f.pool.Get().(*fftScratch)
+	defer f.pool.Put(scratch)
+
+	C.DSP_RealInverse(f.plan,
+		(*C.DSPComplex)(unsafe.Pointer(&input[0])),
+		(*C.float)(unsafe.Pointer(&output[0])),
+		(*C.DSPComplex)(unsafe.Pointer(&scratch.work[0])))
+	return nil
+}
+
+// frames transforms nframes windowed frames of input in a single cgo call.
+// power may be nil when only spectra are needed.
+func (f *RealFFT) frames(window, input []float32, nframes, hop int, spectra []complex64, power []float32, scratch *fftScratch) {
+	var powerPtr *C.float
+	if power != nil {
+		powerPtr = (*C.float)(unsafe.Pointer(&power[0]))
+	}
+
+	C.DSP_STFTFrames(f.plan,
+		(*C.float)(unsafe.Pointer(&window[0])),
+		(*C.float)(unsafe.Pointer(&input[0])),
+		C.int(nframes), C.int(hop),
+		(*C.DSPComplex)(unsafe.Pointer(&spectra[0])),
+		powerPtr,
+		(*C.float)(unsafe.Pointer(&scratch.frame[0])),
+		(*C.DSPComplex)(unsafe.Pointer(&scratch.work[0])))
+}
@@ -0,0 +1,770 @@
+#ifndef DSP_FFT_IMPL_H
+#define DSP_FFT_IMPL_H
+
+// Mixed-radix FFT, STFT, adaptive filter and downmix kernels for the dsp package.
+// Header-only so cgo compiles it into the package without a separate library;
+// every function is static inline because each Go file including it uses a few.
+//
+// The complex FFT is a Stockham autosort transform (no bit reversal pass).
+// Radix-4 and radix-2 stages run first so the strides seen by the radix-3/5
+// stages are even; every stage processes two complex values per SSE2/NEON
+// register. Twiddles are computed once per plan in double precision.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DSP_SIMD 1
+#define DSP_SIMD_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DSP_SIMD 1
+#define DSP_SIMD_NEON 1
+#endif
+
+#define DSP_MAX_FACTORS 32
+
+typedef struct {
+    float re;
+    float im;
+} DSPComplex;
+
+typedef struct {
+    int n;                                  // Transform length
+    int nfactors;
+    int factors[DSP_MAX_FACTORS];           // Radix of each stage
+    DSPComplex* twiddles[DSP_MAX_FACTORS];  // Stage twiddles, laid out [t-1][q]
+    DSPComplex* roots[DSP_MAX_FACTORS];     // Roots of unity for generic radix stages
+} DSPComplexPlan;
+
+typedef struct {
+    int n;                  // Real transform length (even)
+    DSPComplexPlan* half;   // Complex plan of length n/2
+    DSPComplex* post;       // exp(-2*pi*i*k/n) for the real-input unpacking
+} DSPRealPlan;
+
+// ---------------------------------------------------------------------------
+// Scalar complex helpers
+// ---------------------------------------------------------------------------
+
+static inline DSPComplex dsp_c(float re, float im) { DSPComplex c = { re, im }; return c; }
+static inline DSPComplex dsp_cadd(DSPComplex a, DSPComplex b) { return dsp_c(a.re + b.re, a.im + b.im); }
+static inline DSPComplex dsp_csub(DSPComplex a, DSPComplex b) { return dsp_c(a.re - b.re, a.im - b.im); }
+static inline DSPComplex dsp_cscale(DSPComplex a, float s) { return dsp_c(a.re * s, a.im * s); }
+static inline DSPComplex dsp_cnegj(DSPComplex a) { return dsp_c(a.im, -a.re); } // -j * a
+static inline DSPComplex dsp_cconj(DSPComplex a) { return dsp_c(a.re, -a.im); }
+static inline DSPComplex dsp_cmul(DSPComplex a, DSPComplex w) {
+    return dsp_c(a.re * w.re - a.im * w.im, a.re * w.im + a.im * w.re);
+}
+
+// ---------------------------------------------------------------------------
+// Vector helpers: two interleaved complex values per register
+// ---------------------------------------------------------------------------
+
+#if DSP_SIMD_SSE
+typedef __m128 dsp_v;
+static inline dsp_v dsp_vload(const DSPComplex* p) { return _mm_loadu_ps((const float*)p); }
+static inline void dsp_vstore(DSPComplex* p, dsp_v v) { _mm_storeu_ps((float*)p, v); }
+static inline dsp_v dsp_vdup(DSPComplex c) { return _mm_setr_ps(c.re, c.im, c.re, c.im); }
+static inline dsp_v dsp_vadd(dsp_v a, dsp_v b) { return _mm_add_ps(a, b); }
+static inline dsp_v dsp_vsub(dsp_v a, dsp_v b) { return _mm_sub_ps(a, b); }
+static inline dsp_v dsp_vscale(dsp_v a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+static inline dsp_v dsp_vnegj(dsp_v a) {
+    dsp_v swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_xor_ps(swapped, _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f));
+}
+static inline dsp_v dsp_vmul(dsp_v a, dsp_v w) {
+    dsp_v wr = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+    dsp_v wi = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+    dsp_v swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    dsp_v cross = _mm_xor_ps(_mm_mul_ps(swapped, wi), _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f));
+    return _mm_add_ps(_mm_mul_ps(a, wr), cross);
+}
+static inline dsp_v dsp_vconj(dsp_v a) { return _mm_xor_ps(a, _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f)); }
+static inline dsp_v dsp_vlo(dsp_v a, dsp_v b) { return _mm_movelh_ps(a, b); } // [a0, b0]
+static inline dsp_v dsp_vhi(dsp_v a, dsp_v b) { return _mm_movehl_ps(b, a); } // [a1, b1]
+#elif DSP_SIMD_NEON
+typedef float32x4_t dsp_v;
+static inline dsp_v dsp_vload(const DSPComplex* p) { return vld1q_f32((const float*)p); }
+static inline void dsp_vstore(DSPComplex* p, dsp_v v) { vst1q_f32((float*)p, v); }
+static inline dsp_v dsp_vdup(DSPComplex c) {
+    float32x2_t half = { c.re, c.im };
+    return vcombine_f32(half, half);
+}
+static inline dsp_v dsp_vadd(dsp_v a, dsp_v b) { return vaddq_f32(a, b); }
+static inline dsp_v dsp_vsub(dsp_v a, dsp_v b) { return vsubq_f32(a, b); }
+static inline dsp_v dsp_vscale(dsp_v a, float s) { return vmulq_n_f32(a, s); }
+static inline dsp_v dsp_vnegj(dsp_v a) {
+    const float32x4_t sign = { 1.0f, -1.0f, 1.0f, -1.0f };
+    return vmulq_f32(vrev64q_f32(a), sign);
+}
+static inline dsp_v dsp_vmul(dsp_v a, dsp_v w) {
+    const float32x4_t sign = { -1.0f, 1.0f, -1.0f, 1.0f };
+    dsp_v wr = vtrn1q_f32(w, w);
+    dsp_v wi = vtrn2q_f32(w, w);
+    dsp_v cross = vmulq_f32(vmulq_f32(vrev64q_f32(a), wi), sign);
+    return vfmaq_f32(cross, a, wr);
+}
+static inline dsp_v dsp_vconj(dsp_v a) {
+    const float32x4_t sign = { 1.0f, -1.0f, 1.0f, -1.0f };
+    return vmulq_f32(a, sign);
+}
+static inline dsp_v dsp_vlo(dsp_v a, dsp_v b) { return vcombine_f32(vget_low_f32(a), vget_low_f32(b)); }
+static inline dsp_v dsp_vhi(dsp_v a, dsp_v b) { return vcombine_f32(vget_high_f32(a), vget_high_f32(b)); }
+#endif
+
+// ---------------------------------------------------------------------------
+// Butterfly stages
+//
+// Stage with radix p over sub-transforms of length len = p*m and stride s:
+//   a_j = x[k + s*(q + m*j)]
+//   y[k + s*(p*q + t)] = DFT_p(a)[t] * exp(-2*pi*i*q*t/len)
+// ---------------------------------------------------------------------------
+
+static inline void dsp_radix2(const DSPComplex* x, DSPComplex* y, int m, int s, const DSPComplex* tw) {
+    if (s == 1) {
+        int q = 0;
+#if DSP_SIMD
+        for (; q + 2 <= m; q += 2) {
+            dsp_v a = dsp_vload(x + q);
+            dsp_v b = dsp_vload(x + q + m);
+            dsp_v r0 = dsp_vadd(a, b);
+            dsp_v r1 = dsp_vmul(dsp_vsub(a, b), dsp_vload(tw + q));
+            dsp_vstore(y + 2 * q, dsp_vlo(r0, r1));
+            dsp_vstore(y + 2 * q + 2, dsp_vhi(r0, r1));
+        }
+#endif
+        for (; q < m; q++) {
+            DSPComplex a = x[q], b = x[q + m];
+            y[2 * q] = dsp_cadd(a, b);
+            y[2 * q + 1] = dsp_cmul(dsp_csub(a, b), tw[q]);
+        }
+        return;
+    }
+
+    for (int q = 0; q < m; q++) {
+        const DSPComplex* x0 = x + s * q;
+        const DSPComplex* x1 = x + s * (q + m);
+        DSPComplex* y0 = y + s * (2 * q);
+        DSPComplex* y1 = y + s * (2 * q + 1);
+        int k = 0;
+#if DSP_SIMD
+        dsp_v w1 = dsp_vdup(tw[q]);
+        for (; k + 2 <= s; k += 2) {
+            dsp_v a = dsp_vload(x0 + k), b = dsp_vload(x1 + k);
+            dsp_vstore(y0 + k, dsp_vadd(a, b));
+            dsp_vstore(y1 + k, dsp_vmul(dsp_vsub(a, b), w1));
+        }
+#endif
+        for (; k < s; k++) {
+            DSPComplex a = x0[k], b = x1[k];
+            y0[k] = dsp_cadd(a, b);
+            y1[k] = dsp_cmul(dsp_csub(a, b), tw[q]);
+        }
+    }
+}
+
+static inline void dsp_radix4(const DSPComplex* x, DSPComplex* y, int m, int s, const DSPComplex* tw) {
+    const DSPComplex* tw1 = tw;
+    const DSPComplex* tw2 = tw + m;
+    const DSPComplex* tw3 = tw + 2 * m;
+
+    if (s == 1) {
+        int q = 0;
+#if DSP_SIMD
+        for (; q + 2 <= m; q += 2) {
+            dsp_v a = dsp_vload(x + q), b = dsp_vload(x + q + m);
+            dsp_v c = dsp_vload(x + q + 2 * m), d = dsp_vload(x + q + 3 * m);
+            dsp_v apc = dsp_vadd(a, c), amc = dsp_vsub(a, c);
+            dsp_v bpd = dsp_vadd(b, d), njbmd = dsp_vnegj(dsp_vsub(b, d));
+            dsp_v r0 = dsp_vadd(apc, bpd);
+            dsp_v r1 = dsp_vmul(dsp_vadd(amc, njbmd), dsp_vload(tw1 + q));
+            dsp_v r2 = dsp_vmul(dsp_vsub(apc, bpd), dsp_vload(tw2 + q));
+            dsp_v r3 = dsp_vmul(dsp_vsub(amc, njbmd), dsp_vload(tw3 + q));
+            dsp_vstore(y + 4 * q, dsp_vlo(r0, r1));
+            dsp_vstore(y + 4 * q + 2, dsp_vlo(r2, r3));
+            dsp_vstore(y + 4 * q + 4, dsp_vhi(r0, r1));
+            dsp_vstore(y + 4 * q + 6, dsp_vhi(r2, r3));
+        }
+#endif
+        for (; q < m; q++) {
+            DSPComplex a = x[q], b = x[q + m], c = x[q + 2 * m], d = x[q + 3 * m];
+            DSPComplex apc = dsp_cadd(a, c), amc = dsp_csub(a, c);
+            DSPComplex bpd = dsp_cadd(b, d), njbmd = dsp_cnegj(dsp_csub(b, d));
+            y[4 * q] = dsp_cadd(apc, bpd);
+            y[4 * q + 1] = dsp_cmul(dsp_cadd(amc, njbmd), tw1[q]);
+            y[4 * q + 2] = dsp_cmul(dsp_csub(apc, bpd), tw2[q]);
+            y[4 * q + 3] = dsp_cmul(dsp_csub(amc, njbmd), tw3[q]);
+        }
+        return;
+    }
+
+    for (int q = 0; q < m; q++) {
+        const DSPComplex* x0 = x + s * q;
+        const DSPComplex* x1 = x + s * (q + m);
+        const DSPComplex* x2 = x + s * (q + 2 * m);
+        const DSPComplex* x3 = x + s * (q + 3 * m);
+        DSPComplex* y0 = y + s * (4 * q);
+        int k = 0;
+#if DSP_SIMD
+        dsp_v w1 = dsp_vdup(tw1[q]), w2 = dsp_vdup(tw2[q]), w3 = dsp_vdup(tw3[q]);
+        for (; k + 2 <= s; k += 2) {
+            dsp_v a = dsp_vload(x0 + k), b = dsp_vload(x1 + k);
+            dsp_v c = dsp_vload(x2 + k), d = dsp_vload(x3 + k);
+            dsp_v apc = dsp_vadd(a, c), amc = dsp_vsub(a, c);
+            dsp_v bpd = dsp_vadd(b, d), njbmd = dsp_vnegj(dsp_vsub(b, d));
+            dsp_vstore(y0 + k, dsp_vadd(apc, bpd));
+            dsp_vstore(y0 + s + k, dsp_vmul(dsp_vadd(amc, njbmd), w1));
+            dsp_vstore(y0 + 2 * s + k, dsp_vmul(dsp_vsub(apc, bpd), w2));
+            dsp_vstore(y0 + 3 * s + k, dsp_vmul(dsp_vsub(amc, njbmd), w3));
+        }
+#endif
+        for (; k < s; k++) {
+            DSPComplex a = x0[k], b = x1[k], c = x2[k], d = x3[k];
+            DSPComplex apc = dsp_cadd(a, c), amc = dsp_csub(a, c);
+            DSPComplex bpd = dsp_cadd(b, d), njbmd = dsp_cnegj(dsp_csub(b, d));
+            y0[k] = dsp_cadd(apc, bpd);
+            y0[s + k] = dsp_cmul(dsp_cadd(amc, njbmd), tw1[q]);
+            y0[2 * s + k] = dsp_cmul(dsp_csub(apc, bpd), tw2[q]);
+            y0[3 * s + k] = dsp_cmul(dsp_csub(amc, njbmd), tw3[q]);
+        }
+    }
+}
+
+static inline void dsp_radix3(const DSPComplex* x, DSPComplex* y, int m, int s, const DSPComplex* tw) {
+    const float c1 = -0.5f;
+    const float s1 = 0.86602540378443864676f; // sin(2*pi/3)
+    const DSPComplex* tw1 = tw;
+    const DSPComplex* tw2 = tw + m;
+
+    for (int q = 0; q < m; q++) {
+        const DSPComplex* x0 = x + s * q;
+        const DSPComplex* x1 = x + s * (q + m);
+        const DSPComplex* x2 = x + s * (q + 2 * m);
+        DSPComplex* y0 = y + s * (3 * q);
+        int k = 0;
+#if DSP_SIMD
+        dsp_v w1 = dsp_vdup(tw1[q]), w2 = dsp_vdup(tw2[q]);
+        for (; k + 2 <= s; k += 2) {
+            dsp_v a0 = dsp_vload(x0 + k), a1 = dsp_vload(x1 + k), a2 = dsp_vload(x2 + k);
+            dsp_v t1 = dsp_vadd(a1, a2);
+            dsp_v b = dsp_vadd(a0, dsp_vscale(t1, c1));
+            dsp_v nd = dsp_vnegj(dsp_vscale(dsp_vsub(a1, a2), s1));
+            dsp_vstore(y0 + k, dsp_vadd(a0, t1));
+            dsp_vstore(y0 + s + k, dsp_vmul(dsp_vadd(b, nd), w1));
+            dsp_vstore(y0 + 2 * s + k, dsp_vmul(dsp_vsub(b, nd), w2));
+        }
+#endif
+        for (; k < s; k++) {
+            DSPComplex a0 = x0[k], a1 = x1[k], a2 = x2[k];
+            DSPComplex t1 = dsp_cadd(a1, a2);
+            DSPComplex b = dsp_cadd(a0, dsp_cscale(t1, c1));
+            DSPComplex nd = dsp_cnegj(dsp_cscale(dsp_csub(a1, a2), s1));
+            y0[k] = dsp_cadd(a0, t1);
+            y0[s + k] = dsp_cmul(dsp_cadd(b, nd), tw1[q]);
+            y0[2 * s + k] = dsp_cmul(dsp_csub(b, nd), tw2[q]);
+        }
+    }
+}
+
+static inline void dsp_radix5(const DSPComplex* x, DSPComplex* y, int m, int s, const DSPComplex* tw) {
+    const float c1 = 0.30901699437494742410f;  // cos(2*pi/5)
+    const float c2 = -0.80901699437494742410f; // cos(4*pi/5)
+    const float s1 = 0.95105651629515357212f;  // sin(2*pi/5)
+    const float s2 = 0.58778525229247312917f;  // sin(4*pi/5)
+    const DSPComplex* tw1 = tw;
+    const DSPComplex* tw2 = tw + m;
+    const DSPComplex* tw3 = tw + 2 * m;
+    const DSPComplex* tw4 = tw + 3 * m;
+
+    for (int q = 0; q < m; q++) {
+        const DSPComplex* x0 = x + s * q;
+        DSPComplex* y0 = y + s * (5 * q);
+        int k = 0;
+#if DSP_SIMD
+        dsp_v w1 = dsp_vdup(tw1[q]), w2 = dsp_vdup(tw2[q]);
+        dsp_v w3 = dsp_vdup(tw3[q]), w4 = dsp_vdup(tw4[q]);
+        for (; k + 2 <= s; k += 2) {
+            dsp_v a0 = dsp_vload(x0 + k);
+            dsp_v a1 = dsp_vload(x0 + s * m + k);
+            dsp_v a2 = dsp_vload(x0 + 2 * s * m + k);
+            dsp_v a3 = dsp_vload(x0 + 3 * s * m + k);
+            dsp_v a4 = dsp_vload(x0 + 4 * s * m + k);
+            dsp_v t1 = dsp_vadd(a1, a4), t2 = dsp_vadd(a2, a3);
+            dsp_v t3 = dsp_vsub(a1, a4), t4 = dsp_vsub(a2, a3);
+            dsp_v b1 = dsp_vadd(a0, dsp_vadd(dsp_vscale(t1, c1), dsp_vscale(t2, c2)));
+            dsp_v b2 = dsp_vadd(a0, dsp_vadd(dsp_vscale(t1, c2), dsp_vscale(t2, c1)));
+            dsp_v nd1 = dsp_vnegj(dsp_vadd(dsp_vscale(t3, s1), dsp_vscale(t4, s2)));
+            dsp_v nd2 = dsp_vnegj(dsp_vsub(dsp_vscale(t3, s2), dsp_vscale(t4, s1)));
+            dsp_vstore(y0 + k, dsp_vadd(a0, dsp_vadd(t1, t2)));
+            dsp_vstore(y0 + s + k, dsp_vmul(dsp_vadd(b1, nd1), w1));
+            dsp_vstore(y0 + 2 * s + k, dsp_vmul(dsp_vadd(b2, nd2), w2));
+            dsp_vstore(y0 + 3 * s + k, dsp_vmul(dsp_vsub(b2, nd2), w3));
+            dsp_vstore(y0 + 4 * s + k, dsp_vmul(dsp_vsub(b1, nd1), w4));
+        }
+#endif
+        for (; k < s; k++) {
+            DSPComplex a0 = x0[k];
+            DSPComplex a1 = x0[s * m + k];
+            DSPComplex a2 = x0[2 * s * m + k];
+            DSPComplex a3 = x0[3 * s * m + k];
+            DSPComplex a4 = x0[4 * s * m + k];
+            DSPComplex t1 = dsp_cadd(a1, a4), t2 = dsp_cadd(a2, a3);
+            DSPComplex t3 = dsp_csub(a1, a4), t4 = dsp_csub(a2, a3);
+            DSPComplex b1 = dsp_cadd(a0, dsp_cadd(dsp_cscale(t1, c1), dsp_cscale(t2, c2)));
+            DSPComplex b2 = dsp_cadd(a0, dsp_cadd(dsp_cscale(t1, c2), dsp_cscale(t2, c1)));
+            DSPComplex nd1 = dsp_cnegj(dsp_cadd(dsp_cscale(t3, s1), dsp_cscale(t4, s2)));
+            DSPComplex nd2 = dsp_cnegj(dsp_csub(dsp_cscale(t3, s2), dsp_cscale(t4, s1)));
+            y0[k] = dsp_cadd(a0, dsp_cadd(t1, t2));
+            y0[s + k] = dsp_cmul(dsp_cadd(b1, nd1), tw1[q]);
+            y0[2 * s + k] = dsp_cmul(dsp_cadd(b2, nd2), tw2[q]);
+            y0[3 * s + k] = dsp_cmul(dsp_csub(b2, nd2), tw3[q]);
+            y0[4 * s + k] = dsp_cmul(dsp_csub(b1, nd1), tw4[q]);
+        }
+    }
+}
+
+// dsp_radixg handles any other prime factor with a direct O(p^2) DFT
+static inline void dsp_radixg(const DSPComplex* x, DSPComplex* y, int p, int m, int s,
+                       const DSPComplex* tw, const DSPComplex* roots) {
+    DSPComplex a[64];
+    for (int q = 0; q < m; q++) {
+        for (int k = 0; k < s; k++) {
+            for (int j = 0; j < p; j++) {
+                a[j] = x[k + s * (q + m * j)];
+            }
+            for (int t = 0; t < p; t++) {
+                DSPComplex sum = a[0];
+                for (int j = 1; j < p; j++) {
+                    sum = dsp_cadd(sum, dsp_cmul(a[j], roots[(j * t) % p]));
+                }
+                y[k + s * (p * q + t)] = t == 0 ? sum : dsp_cmul(sum, tw[(t - 1) * m + q]);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Plans
+// ---------------------------------------------------------------------------
+
+static inline void DSP_ComplexPlanDestroy(DSPComplexPlan* plan) {
+    if (!plan) return;
+    for (int i = 0; i < plan->nfactors; i++) {
+        free(plan->twiddles[i]);
+        free(plan->roots[i]);
+    }
+    free(plan);
+}
+
+static inline DSPComplexPlan* DSP_ComplexPlanCreate(int n) {
+    if (n < 1) return NULL;
+
+    DSPComplexPlan* plan = (DSPComplexPlan*)calloc(1, sizeof(DSPComplexPlan));
+    if (!plan) return NULL;
+    plan->n = n;
+
+    // Factor: 4s, then 2s, then odd primes in increasing order
+    int rest = n;
+    while (rest % 4 == 0 && plan->nfactors < DSP_MAX_FACTORS) { plan->factors[plan->nfactors++] = 4; rest /= 4; }
+    while (rest % 2 == 0 && plan->nfactors < DSP_MAX_FACTORS) { plan->factors[plan->nfactors++] = 2; rest /= 2; }
+    for (int p = 3; rest > 1 && plan->nfactors < DSP_MAX_FACTORS; p += 2) {
+        while (rest % p == 0 && plan->nfactors < DSP_MAX_FACTORS) { plan->factors[plan->nfactors++] = p; rest /= p; }
+    }
+    if (rest != 1) {
+        DSP_ComplexPlanDestroy(plan);
+        return NULL;
+    }
+
+    int len = n;
+    for (int st = 0; st < plan->nfactors; st++) {
+        int p = plan->factors[st];
+        int m = len / p;
+        if (p > 64) {
+            DSP_ComplexPlanDestroy(plan);
+            return NULL;
+        }
+
+        plan->twiddles[st] = (DSPComplex*)malloc(sizeof(DSPComplex) * (size_t)(p - 1) * (m > 0 ? m : 1));
+        if (!plan->twiddles[st]) {
+            DSP_ComplexPlanDestroy(plan);
+            return NULL;
+        }
+        for (int t = 1; t < p; t++) {
+            for (int q = 0; q < m; q++) {
+                double angle = -2.0 * M_PI * (double)q * (double)t / (double)len;
+                plan->twiddles[st][(t - 1) * m + q] = dsp_c((float)cos(angle), (float)sin(angle));
+            }
+        }
+
+        if (p != 2 && p != 3 && p != 4 && p != 5) {
+            plan->roots[st] = (DSPComplex*)malloc(sizeof(DSPComplex) * (size_t)p);
+            if (!plan->roots[st]) {
+                DSP_ComplexPlanDestroy(plan);
+                return NULL;
+            }
+            for (int j = 0; j < p; j++) {
+                double angle = -2.0 * M_PI * (double)j / (double)p;
+                plan->roots[st][j] = dsp_c((float)cos(angle), (float)sin(angle));
+            }
+        }
+
+        len = m;
+    }
+
+    return plan;
+}
+
+// DSP_ComplexForward transforms data in place; scratch must hold n values
+static inline void DSP_ComplexForward(const DSPComplexPlan* plan, DSPComplex* data, DSPComplex* scratch) {
+    DSPComplex* src = data;
+    DSPComplex* dst = scratch;
+    int len = plan->n;
+    int s = 1;
+
+    for (int st = 0; st < plan->nfactors; st++) {
+        int p = plan->factors[st];
+        int m = len / p;
+        switch (p) {
+        case 2: dsp_radix2(src, dst, m, s, plan->twiddles[st]); break;
+        case 3: dsp_radix3(src, dst, m, s, plan->twiddles[st]); break;
+        case 4: dsp_radix4(src, dst, m, s, plan->twiddles[st]); break;
+        case 5: dsp_radix5(src, dst, m, s, plan->twiddles[st]); break;
+        default: dsp_radixg(src, dst, p, m, s, plan->twiddles[st], plan->roots[st]); break;
+        }
+        DSPComplex* tmp = src;
+        src = dst;
+        dst = tmp;
+        len = m;
+        s *= p;
+    }
+
+    if (src != data) {
+        memcpy(data, src, sizeof(DSPComplex) * (size_t)plan->n);
+    }
+}
+
+static inline void DSP_RealPlanDestroy(DSPRealPlan* plan) {
+    if (!plan) return;
+    DSP_ComplexPlanDestroy(plan->half);
+    free(plan->post);
+    free(plan);
+}
+
+// DSP_RealPlanCreate returns a plan for real input of even length n
+static inline DSPRealPlan* DSP_RealPlanCreate(int n) {
+    if (n < 2 || n % 2 != 0) return NULL;
+
+    DSPRealPlan* plan = (DSPRealPlan*)calloc(1, sizeof(DSPRealPlan));
+    if (!plan) return NULL;
+    plan->n = n;
+    plan->half = DSP_ComplexPlanCreate(n / 2);
+    plan->post = (DSPComplex*)malloc(sizeof(DSPComplex) * (size_t)(n / 2));
+    if (!plan->half || !plan->post) {
+        DSP_RealPlanDestroy(plan);
+        return NULL;
+    }
+
+    for (int k = 0; k < n / 2; k++) {
+        double angle = -2.0 * M_PI * (double)k / (double)n;
+        plan->post[k] = dsp_c((float)cos(angle), (float)sin(angle));
+    }
+    return plan;
+}
+
+// DSP_RealForward computes the n/2+1 bins of a real transform. The input is
+// read as n/2 complex values and transformed in scratch (n+2 floats), then
+// unpacked into out.
+static inline void DSP_RealForward(const DSPRealPlan* plan, const float* input, DSPComplex* out, DSPComplex* scratch) {
+    int h = plan->n / 2;
+    DSPComplex* z = scratch;
+    DSPComplex* work = scratch + h;
+
+    memcpy(z, input, sizeof(float) * (size_t)plan->n);
+    DSP_ComplexForward(plan->half, z, work);
+
+    out[0] = dsp_c(z[0].re + z[0].im, 0.0f);
+    out[h] = dsp_c(z[0].re - z[0].im, 0.0f);
+    for (int k = 1; k < h; k++) {
+        DSPComplex zk = z[k];
+        DSPComplex zc = dsp_c(z[h - k].re, -z[h - k].im);
+        DSPComplex even = dsp_cscale(dsp_cadd(zk, zc), 0.5f);
+        DSPComplex odd = dsp_cnegj(dsp_cscale(dsp_csub(zk, zc), 0.5f));
+        out[k] = dsp_cadd(even, dsp_cmul(odd, plan->post[k]));
+    }
+}
+
+// DSP_RealInverse is the exact inverse of DSP_RealForward: it packs the n/2+1
+// bins of in back into the n/2-point spectrum of the even/odd samples, runs
+// the complex transform on its conjugate and writes the n real samples to
+// output. Scratch is the same size as for DSP_RealForward.
+static inline void DSP_RealInverse(const DSPRealPlan* plan, const DSPComplex* in, float* output, DSPComplex* scratch) {
+    int h = plan->n / 2;
+    DSPComplex* z = scratch;
+    DSPComplex* work = scratch + h;
+    float scale = 1.0f / (float)h;
+
+    for (int k = 0; k < h; k++) {
+        DSPComplex xk = in[k];
+        DSPComplex xc = dsp_c(in[h - k].re, -in[h - k].im);
+        DSPComplex even = dsp_cscale(dsp_cadd(xk, xc), 0.5f);
+        DSPComplex post = dsp_c(plan->post[k].re, -plan->post[k].im);
+        DSPComplex odd = dsp_cmul(dsp_cscale(dsp_csub(xk, xc), 0.5f), post);
+        // z = even + j*odd, conjugated for the inverse
+        z[k] = dsp_c(even.re - odd.im, -(even.im + odd.re));
+    }
+    DSP_ComplexForward(plan->half, z, work);
+
+    for (int m = 0; m < h; m++) {
+        output[2 * m] = z[m].re * scale;
+        output[2 * m + 1] = -z[m].im * scale;
+    }
+}
+
+// DSP_RealScratchSize is the number of complex values DSP_RealForward needs as scratch
+static inline int DSP_RealScratchSize(const DSPRealPlan* plan) {
+    return plan->n; // n/2 for the packed input plus n/2 for the Stockham buffer
+}
+
+// ---------------------------------------------------------------------------
+// STFT
+// ---------------------------------------------------------------------------
+
+// DSP_STFTFrames transforms nframes windowed frames of input, frame f starting
+// at f*hop. Spectra (n/2+1 bins per frame) go to spectra and, when power is
+// not NULL, squared magnitudes to power. frame holds n floats and scratch
+// DSP_RealScratchSize complex values.
+static inline void DSP_STFTFrames(const DSPRealPlan* plan, const float* window, const float* input,
+                           int nframes, int hop, DSPComplex* spectra, float* power,
+                           float* frame, DSPComplex* scratch) {
+    int n = plan->n;
+    int bins = n / 2 + 1;
+
+    for (int f = 0; f < nframes; f++) {
+        const float* src = input + (size_t)f * hop;
+        for (int i = 0; i < n; i++) {
+            frame[i] = src[i] * window[i];
+        }
+
+        DSPComplex* spectrum = spectra + (size_t)f * bins;
+        DSP_RealForward(plan, frame, spectrum, scratch);
+
+        if (power) {
+            float* out = power + (size_t)f * bins;
+            for (int k = 0; k < bins; k++) {
+                out[k] = spectrum[k].re * spectrum[k].re + spectrum[k].im * spectrum[k].im;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Partitioned frequency-domain adaptive filter
+//
+// The filter has `partitions` blocks of `bins` weights, laid out one after
+// the other. Input spectra live in a ring of the same shape whose newest
+// entry is at `head`; weight block p pairs with input (head + p) % partitions.
+// ---------------------------------------------------------------------------
+
+// DSP_PartitionFilter computes out = sum over p of X[(head+p)%P] * W[p]
+static inline void DSP_PartitionFilter(const DSPComplex* x, const DSPComplex* w, int partitions, int head,
+                                int bins, DSPComplex* out) {
+    memset(out, 0, sizeof(DSPComplex) * (size_t)bins);
+    for (int p = 0; p < partitions; p++) {
+        const DSPComplex* xp = x + (size_t)((head + p) % partitions) * bins;
+        const DSPComplex* wp = w + (size_t)p * bins;
+        int k = 0;
+#if DSP_SIMD
+        for (; k + 2 <= bins; k += 2) {
+            dsp_vstore(out + k, dsp_vadd(dsp_vload(out + k), dsp_vmul(dsp_vload(xp + k), dsp_vload(wp + k))));
+        }
+#endif
+        for (; k < bins; k++) {
+            out[k] = dsp_cadd(out[k], dsp_cmul(xp[k], wp[k]));
+        }
+    }
+}
+
+// DSP_PartitionUpdate adds conj(X[(head+p)%P]) * g to every weight block W[p]
+static inline void DSP_PartitionUpdate(const DSPComplex* x, DSPComplex* w, int partitions, int head,
+                                int bins, const DSPComplex* g) {
+    for (int p = 0; p < partitions; p++) {
+        const DSPComplex* xp = x + (size_t)((head + p) % partitions) * bins;
+        DSPComplex* wp = w + (size_t)p * bins;
+        int k = 0;
+#if DSP_SIMD
+        for (; k + 2 <= bins; k += 2) {
+            dsp_v step = dsp_vmul(dsp_vconj(dsp_vload(xp + k)), dsp_vload(g + k));
+            dsp_vstore(wp + k, dsp_vadd(dsp_vload(wp + k), step));
+        }
+#endif
+        for (; k < bins; k++) {
+            wp[k] = dsp_cadd(wp[k], dsp_cmul(dsp_cconj(xp[k]), g[k]));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Downmix
+//
+// Interleaved integer PCM, one int64 per sample as Go's []int holds it, is
+// converted and mixed to mono in one pass. Channel c of frame f is weighted
+// by (w[c] + f*dw[c]) * scale, so weights can ramp across a call, and the
+// same pass adds each channel's energy and its product with channel `ref`
+// to energy[c] and cross[c] (in scaled units). Mono and stereo, the layouts
+// recordings actually have, are vectorized; other layouts run scalar.
+// ---------------------------------------------------------------------------
+
+#if DSP_SIMD_SSE
+// dsp_pcm4 converts four int64 samples holding 32-bit PCM to float
+static inline __m128 dsp_pcm4(const int64_t* p) {
+    __m128i a = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)p), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i b = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(p + 2)), _MM_SHUFFLE(3, 1, 2, 0));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi64(a, b));
+}
+#elif DSP_SIMD_NEON
+static inline float32x4_t dsp_pcm4(const int64_t* p) {
+    int32x2_t a = vmovn_s64(vld1q_s64(p));
+    int32x2_t b = vmovn_s64(vld1q_s64(p + 2));
+    return vcvtq_f32_s32(vcombine_s32(a, b));
+}
+#endif
+
+// dsp_downmix_mono converts one channel, four samples per step
+static inline void dsp_downmix_mono(const int64_t* in, int frames, float scale, float w, float dw,
+                             float* out, double* energy) {
+    float sum = 0;
+    int f = 0;
+#if DSP_SIMD_SSE
+    __m128 gain = _mm_mul_ps(_mm_setr_ps(w, w + dw, w + 2 * dw, w + 3 * dw), _mm_set1_ps(scale));
+    __m128 step = _mm_set1_ps(4 * dw * scale);
+    __m128 sq = _mm_setzero_ps();
+    for (; f + 4 <= frames; f += 4) {
+        __m128 x = dsp_pcm4(in + f);
+        _mm_storeu_ps(out + f, _mm_mul_ps(x, gain));
+        sq = _mm_add_ps(sq, _mm_mul_ps(x, x));
+        gain = _mm_add_ps(gain, step);
+    }
+    float s[4];
+    _mm_storeu_ps(s, sq);
+    sum = s[0] + s[1] + s[2] + s[3];
+#elif DSP_SIMD_NEON
+    float32x4_t gain = vmulq_n_f32((float32x4_t){ w, w + dw, w + 2 * dw, w + 3 * dw }, scale);
+    float32x4_t step = vdupq_n_f32(4 * dw * scale);
+    float32x4_t sq = vdupq_n_f32(0);
+    for (; f + 4 <= frames; f += 4) {
+        float32x4_t x = dsp_pcm4(in + f);
+        vst1q_f32(out + f, vmulq_f32(x, gain));
+        sq = vmlaq_f32(sq, x, x);
+        gain = vaddq_f32(gain, step);
+    }
+    sum = vaddvq_f32(sq);
+#endif
+    for (; f < frames; f++) {
+        float x = (float)in[f];
+        out[f] = (w + f * dw) * scale * x;
+        sum += x * x;
+    }
+    energy[0] += (double)sum * scale * scale;
+}
+
+// dsp_downmix_stereo mixes two channels, four frames per step
+static inline void dsp_downmix_stereo(const int64_t* in, int frames, float scale, const float* w,
+                               const float* dw, float* out, double* lr) {
+    float ll = 0, rr = 0, xy = 0;
+    int f = 0;
+#if DSP_SIMD_SSE
+    // wa weighs frames f and f+1, wb frames f+2 and f+3
+    __m128 wa = _mm_mul_ps(_mm_setr_ps(w[0], w[1], w[0] + dw[0], w[1] + dw[1]), _mm_set1_ps(scale));
+    __m128 step = _mm_mul_ps(_mm_setr_ps(dw[0], dw[1], dw[0], dw[1]), _mm_set1_ps(2 * scale));
+    __m128 wb = _mm_add_ps(wa, step);
+    step = _mm_add_ps(step, step);
+    __m128 sq = _mm_setzero_ps(), cr = _mm_setzero_ps();
+    for (; f + 4 <= frames; f += 4) {
+        __m128 a = dsp_pcm4(in + 2 * f);     // L0 R0 L1 R1
+        __m128 b = dsp_pcm4(in + 2 * f + 4); // L2 R2 L3 R3
+        __m128 pa = _mm_mul_ps(a, wa), pb = _mm_mul_ps(b, wb);
+        __m128 left = _mm_shuffle_ps(pa, pb, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 right = _mm_shuffle_ps(pa, pb, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + f, _mm_add_ps(left, right));
+        sq = _mm_add_ps(sq, _mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)));
+        __m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 bs = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+        cr = _mm_add_ps(cr, _mm_add_ps(_mm_mul_ps(a, as), _mm_mul_ps(b, bs)));
+        wa = _mm_add_ps(wa, step);
+        wb = _mm_add_ps(wb, step);
+    }
+    float s[4], c[4];
+    _mm_storeu_ps(s, sq);
+    _mm_storeu_ps(c, cr);
+    ll = s[0] + s[2];
+    rr = s[1] + s[3];
+    xy = (c[0] + c[1] + c[2] + c[3]) * 0.5f; // Every product appears twice
+#elif DSP_SIMD_NEON
+    float32x4_t wa = vmulq_n_f32((float32x4_t){ w[0], w[1], w[0] + dw[0], w[1] + dw[1] }, scale);
+    float32x4_t step = vmulq_n_f32((float32x4_t){ dw[0], dw[1], dw[0], dw[1] }, 2 * scale);
+    float32x4_t wb = vaddq_f32(wa, step);
+    step = vaddq_f32(step, step);
+    float32x4_t sq = vdupq_n_f32(0), cr = vdupq_n_f32(0);
+    for (; f + 4 <= frames; f += 4) {
+        float32x4_t a = dsp_pcm4(in + 2 * f);
+        float32x4_t b = dsp_pcm4(in + 2 * f + 4);
+        vst1q_f32(out + f, vpaddq_f32(vmulq_f32(a, wa), vmulq_f32(b, wb)));
+        sq = vmlaq_f32(vmlaq_f32(sq, a, a), b, b);
+        cr = vmlaq_f32(vmlaq_f32(cr, a, vrev64q_f32(a)), b, vrev64q_f32(b));
+        wa = vaddq_f32(wa, step);
+        wb = vaddq_f32(wb, step);
+    }
+    ll = vgetq_lane_f32(sq, 0) + vgetq_lane_f32(sq, 2);
+    rr = vgetq_lane_f32(sq, 1) + vgetq_lane_f32(sq, 3);
+    xy = vaddvq_f32(cr) * 0.5f;
+#endif
+    for (; f < frames; f++) {
+        float l = (float)in[2 * f], r = (float)in[2 * f + 1];
+        out[f] = ((w[0] + f * dw[0]) * l + (w[1] + f * dw[1]) * r) * scale;
+        ll += l * l;
+        rr += r * r;
+        xy += l * r;
+    }
+    double s2 = (double)scale * scale;
+    lr[0] = ll * s2;
+    lr[1] = rr * s2;
+    lr[2] = xy * s2;
+}
+
+// DSP_Downmix converts and mixes frames of interleaved PCM to out
+static inline void DSP_Downmix(const int64_t* in, int frames, int channels, float scale, const float* w,
+                        const float* dw, int ref, float* out, double* energy, double* cross) {
+    if (channels == 1) {
+        double e = 0;
+        dsp_downmix_mono(in, frames, scale, w[0], dw[0], out, &e);
+        energy[0] += e;
+        cross[0] += e;
+        return;
+    }
+    if (channels == 2) {
+        double lr[3];
+        dsp_downmix_stereo(in, frames, scale, w, dw, out, lr);
+        energy[0] += lr[0];
+        energy[1] += lr[1];
+        cross[0] += ref == 0 ? lr[0] : lr[2];
+        cross[1] += ref == 0 ? lr[2] : lr[1];
+        return;
+    }
+    for (int f = 0; f < frames; f++) {
+        const int64_t* frame = in + (size_t)f * channels;
+        float r = (float)frame[ref] * scale, sum = 0;
+        for (int c = 0; c < channels; c++) {
+            float x = (float)frame[c] * scale;
+            sum += (w[c] + f * dw[c]) * x;
+            energy[c] += x * x;
+            cross[c] += r * x;
+        }
+        out[f] = sum;
+    }
+}
+
+#endif // DSP_FFT_IMPL_H
@@ -0,0 +1,231 @@
+package dsp
+
+import (
+	"sort"
+	"sync"
+	"unsafe"
+
+	"github.com/platformlabs-co/personal-assist/services/memory"
+)
+
+const (
+	// poolMinClass is the smallest buffer the pool hands out, in elements
+	poolMinClass = 4096
+
+	// poolMaxClass is the largest pooled buffer, in elements; larger
+	// requests are allocated and dropped as usual
+	poolMaxClass = 1 << 30
+
+	// poolRetained is the default limit on the bytes of idle buffers kept
+	poolRetained = 512 * memory.MB
+)
+
+// poolClasses are the buffer capacities of the pool: each is a quarter
+// larger than the one before, so a buffer wastes at most a fifth of itself
+var poolClasses = func() []int {
+	var classes []int
+	for size := poolMinClass; size <= poolMaxClass; size += size / 4 {
+		size = (size + poolMinClass - 1) / poolMinClass * poolMinClass
+		classes = append(classes, size)
+	}
+	return classes
+}()
+
+// poolClass returns the index of the smallest class holding n elements,
+// or -1 when n is too large to pool
+func poolClass(n int) int {
+	i := sort.SearchInts(poolClasses, n)
+	if i == len(poolClasses) {
+		return -1
+	}
+	return i
+}
+
+// SamplePoolStats counts how often the pool saved an allocation
+type SamplePoolStats struct {
+	Hits     int64 `json:"hits"`
+	Misses   int64 `json:"misses"`
+	Dropped  int64 `json:"dropped"`  // Released buffers not kept, over the retention limit
+	Retained int64 `json:"retained"` // Bytes of idle buffers
+}
+
+// freeLists holds the idle buffers of one element type, per size class
+type freeLists[T float32 | int] struct {
+	classes [][][]T
+}
+
+// SamplePool recycles the recording-sized sample buffers of preprocessing.
+// Each stage takes its output buffer from the pool and releases its input
+// once done, so a transcription job reuses the buffers of the one before
+// rather than leaving several large objects per job to the collector.
+// Buffers are grouped in size classes and the native kernels work on them
+// in place, so they need no buffers of their own.
+//
+// A released buffer must not be used again, and must be released once. A
+// nil pool allocates every buffer and keeps none.
+type SamplePool struct {
+	mutex       sync.Mutex
+	floats      freeLists[float32]
+	ints        freeLists[int]
+	maxRetained int64
+	stats       SamplePoolStats
+	memory      *memory.Consumer // Idle buffers, evicted under memory pressure
+}
+
+var (
+	defaultSamplePool     *SamplePool
+	defaultSamplePoolOnce sync.Once
+)
+
+// DefaultSamplePool returns the pool shared by transcription jobs. Its idle
+// buffers count against the memory budget and are the first thing evicted.
+func DefaultSamplePool() *SamplePool {
+	defaultSamplePoolOnce.Do(func() {
+		defaultSamplePool = NewSamplePool(poolRetained)
+		defaultSamplePool.memory = memory.Default().Register("sample pool", memory.Heap, defaultSamplePool.Trim)
+	})
+	return defaultSamplePool
+}
+
+// NewSamplePool creates a pool keeping at most maxRetained bytes of idle buffers
+func NewSamplePool(maxRetained int64) *SamplePool {
+	return &SamplePool{
+		floats:      freeLists[float32]{classes: make([][][]float32, len(poolClasses))},
+		ints:        freeLists[int]{classes: make([][][]int, len(poolClasses))},
+		maxRetained: maxRetained,
+	}
+}
+
+// Float32 returns a buffer of n samples with undefined contents
+func (p *SamplePool) Float32(n int) []float32 {
+	if p == nil {
+		return make([]float32, n)
+	}
+	return take(p, &p.floats, n)
+}
+
+// ReleaseFloat32 returns a buffer from Float32 to the pool
+func (p *SamplePool) ReleaseFloat32(buffer []float32) {
+	if p != nil {
+		give(p, &p.floats, buffer)
+	}
+}
+
+// Ints returns a buffer of n integer samples with undefined contents
+func (p *SamplePool) Ints(n int) []int {
+	if p == nil {
+		return make([]int, n)
+	}
+	return take(p, &p.ints, n)
+}
+
+// ReleaseInts returns a buffer from Ints to the pool
+func (p *SamplePool) ReleaseInts(buffer []int) {
+	if p != nil {
+		give(p, &p.ints, buffer)
+	}
+}
+
+// Stats returns the pool counters
+func (p *SamplePool) Stats() SamplePoolStats {
+	if p == nil {
+		return SamplePoolStats{}
+	}
+	p.mutex.Lock()
+	defer p.mutex.Unlock()
+	return p.stats
+}
+
+// Trim drops idle buffers, largest first, until need bytes are freed, and
+// returns the bytes dropped
+func (p *SamplePool) Trim(need int64) int64 {
+	p.mutex.Lock()
+	defer p.mutex.Unlock()
+
+	var freed int64
+	for class := len(poolClasses) - 1; class >= 0 && freed < need; class-- {
+		freed += trimClass(p, &p.floats, class, need-freed)
+		if freed < need {
+			freed += trimClass(p, &p.ints, class, need-freed)
+		}
+	}
+	return freed
+}
+
+// take pops an idle buffer of n's class or allocates one
+func take[T float32 | int](p *SamplePool, lists *freeLists[T], n int) []T {
+	class := poolClass(n)
+	if class < 0 {
+		return make([]T, n)
+	}
+
+	p.mutex.Lock()
+	free := lists.classes[class]
+	if last := len(free) - 1; last >= 0 {
+		buffer := free[last]
+		free[last] = nil
+		lists.classes[class] = free[:last]
+		bytes := bufferBytes(buffer)
+		p.stats.Hits++
+		p.stats.Retained -= bytes
+		p.mutex.Unlock()
+		if p.memory != nil {
+			p.memory.Release(bytes)
+		}
+		return buffer[:n]
+	}
+	p.stats.Misses++
+	p.mutex.Unlock()
+
+	return make([]T, n, poolClasses[class])
+}
+
+// give keeps a released buffer for reuse when it is one of the pool's and
+// fits the retention limit
+func give[T float32 | int](p *SamplePool, lists *freeLists[T], buffer []T) {
+	class := poolClass(cap(buffer))
+	if class < 0 || poolClasses[class] != cap(buffer) {
+		return
+	}
+	buffer = buffer[:cap(buffer)]
+	bytes := bufferBytes(buffer)
+
+	p.mutex.Lock()
+	if p.stats.Retained+bytes > p.maxRetained {
+		p.stats.Dropped++
+		p.mutex.Unlock()
+		return
+	}
+	lists.classes[class] = append(lists.classes[class], buffer)
+	p.stats.Retained += bytes
+	p.mutex.Unlock()
+
+	if p.memory != nil {
+		p.memory.Add(bytes)
+	}
+}
+
+// trimClass drops the idle buffers of one class until need bytes are
+// freed. Callers hold the mutex.
+func trimClass[T float32 | int](p *SamplePool, lists *freeLists[T], class int, need int64) int64 {
+	var freed int64
+	free := lists.classes[class]
+	for len(free) > 0 && freed < need {
+		last := len(free) - 1
+		freed += bufferBytes(free[last])
+		free[last] = nil
+		free = free[:last]
+	}
+	lists.classes[class] = free
+	p.stats.Retained -= freed
+	if freed > 0 && p.memory != nil {
+		p.memory.Release(freed)
+	}
+	return freed
+}
+
+// bufferBytes returns the memory of a buffer's capacity
+func bufferBytes[T float32 | int](buffer []T) int64 {
+	var zero T
+	return int64(cap(buffer)) * int64(unsafe.Sizeof(zero))
+}
@@ -0,0 +1,96 @@
+package dsp
+
+import (
+	"fmt"
+	"math"
+)
+
+// Resampler converts interleaved float32 audio between sample rates block
+// by block with linear interpolation, the same quality as the resampling of
+// recordings for Whisper. The last frame of each block carries over to the
+// next, and output positions are computed from frame counts rather than
+// accumulated, so block boundaries add no clicks and the output length
+// tracks the input exactly over a stream of any length.
+//
+// A Resampler is not safe for concurrent use.
+type Resampler struct {
+	channels int
+	step     float64   // Input frames per output frame
+	next     int64     // Output frames produced
+	consumed int64     // Input frames before the current block
+	last     []float32 // Last frame of the previous block
+}
+
+// NewResampler creates a resampler from one rate to another
+func NewResampler(fromRate, toRate float64, channels int) (*Resampler, error) {
+	if fromRate <= 0 || toRate <= 0 {
+		return nil, fmt.Errorf("invalid resampling rates: %g to %g Hz", fromRate, toRate)
+	}
+	if channels <= 0 {
+		return nil, fmt.Errorf("invalid channel count: %d", channels)
+	}
+	return &Resampler{
+		channels: channels,
+		step:     fromRate / toRate,
+		last:     make([]float32, channels),
+	}, nil
+}
+
+// Reset forgets the stream, so the next block starts a new one
+func (r *Resampler) Reset() {
+	r.next = 0
+	r.consumed = 0
+}
+
+// Flush appends the output frames that fall before the end of the input
+// so far, which Process holds back until the next frame arrives, and
+// resets the resampler. It is used when the stream ends or changes rate.
+func (r *Resampler) Flush(output []float32) []float32 {
+	for r.consumed > 0 && r.position() < 0 {
+		output = append(output, r.last...)
+		r.next++
+	}
+	r.Reset()
+	return output
+}
+
+// Process resamples whole interleaved frames and appends them to output,
+// returning the extended slice
+func (r *Resampler) Process(input, output []float32) []float32 {
+	ch := r.channels
+	frames := len(input) / ch
+	if frames == 0 {
+		return output
+	}
+
+	// Frame i of the block, with -1 the last frame of the previous one
+	frame := func(i int) []float32 {
+		if i < 0 {
+			return r.last
+		}
+		return input[i*ch : (i+1)*ch]
+	}
+	for {
+		pos := r.position()
+		if pos >= float64(frames-1) {
+			break
+		}
+		i := int(math.Floor(pos))
+		frac := float32(pos - float64(i))
+		a, b := frame(i), frame(i+1)
+		for c := 0; c < ch; c++ {
+			output = append(output, a[c]+frac*(b[c]-a[c]))
+		}
+		r.next++
+	}
+
+	r.consumed += int64(frames)
+	copy(r.last, input[(frames-1)*ch:frames*ch])
+	return output
+}
+
+// position returns where the next output frame falls in the current block,
+// in input frames; -1 is the last frame of the previous block
+func (r *Resampler) position() float64 {
+	return float64(r.next)*r.step - float64(r.consumed)
+}
@@ -0,0 +1,257 @@
+package dsp
+
+import (
+	"fmt"
+)
+
+// maxBatchFrames bounds how many frames are transformed per cgo call
+const maxBatchFrames = 256
+
+// maxPushSamples bounds the samples Push buffers at once
+const maxPushSamples = 1 << 16
+
+// STFTConfig describes the framing of a short-time Fourier transform
+type STFTConfig struct {
+	FFTSize    int        // Transform length in samples
+	WindowSize int        // Window length, centered and zero-padded to FFTSize
+	HopSize    int        // Samples between frame starts
+	Window     WindowType // Analysis window
+	SampleRate int        // Used for frame timestamps only
+	Center     bool       // Reflect-pad the start so frame i is centered on sample i*HopSize
+}
+
+// WhisperSTFTConfig returns the framing Whisper's log-mel front end expects:
+// 25ms Hann windows every 10ms at 16kHz
+func WhisperSTFTConfig() STFTConfig {
+	return STFTConfig{
+		FFTSize:    400,
+		WindowSize: 400,
+		HopSize:    160,
+		Window:     WindowHann,
+		SampleRate: 16000,
+		Center:     true,
+	}
+}
+
+// Frame is one analysed frame. Spectrum and Power alias buffers owned by the
+// STFT and are only valid for the duration of ConsumeFrame.
+type Frame struct {
+	Index    int64       // Frame number since the start of the stream
+	Time     float64     // Seconds from the start of the stream to the frame center
+	Spectrum []complex64 // FFTSize/2+1 bins
+	Power    []float32   // Squared magnitude of each bin
+}
+
+// FrameConsumer receives every frame an STFT produces
+type FrameConsumer interface {
+	ConsumeFrame(frame *Frame)
+}
+
+// FrameConsumerFunc adapts a function to FrameConsumer
+type FrameConsumerFunc func(frame *Frame)
+
+// ConsumeFrame calls f(frame)
+func (f FrameConsumerFunc) ConsumeFrame(frame *Frame) {
+	f(frame)
+}
+
+// STFT is a streaming short-time Fourier transform. Samples are pushed in
+// arbitrary block sizes; every complete frame is transformed once and handed
+// to all subscribed consumers, so mel extraction, noise estimation and echo
+// cancellation can share a single analysis pass. An STFT is not safe for
+// concurrent use.
+type STFT struct {
+	config    STFTConfig
+	fft       *RealFFT
+	window    []float32
+	consumers []FrameConsumer
+
+	pending    []float32 // Samples not yet consumed by a frame start
+	started    bool      // Start padding has been applied
+	frameIndex int64
+
+	spectra []complex64
+	power   []float32
+	scratch *fftScratch
+	frame   Frame
+}
+
+// NewSTFT creates a streaming STFT feeding the given consumers
+func NewSTFT(config STFTConfig, consumers ...FrameConsumer) (*STFT, error) {
+	if config.WindowSize == 0 {
+		config.WindowSize = config.FFTSize
+	}
+	if config.HopSize < 1 || config.HopSize > config.FFTSize {
+		return nil, fmt.Errorf("hop size %d must be between 1 and the FFT size %d", config.HopSize, config.FFTSize)
+	}
+	if config.SampleRate < 1 {
+		return nil, fmt.Errorf("invalid sample rate: %d", config.SampleRate)
+	}
+
+	fft, err := NewRealFFT(config.FFTSize)
+	if err != nil {
+		return nil, err
+	}
+	window, err := Window(config.Window, config.WindowSize, config.FFTSize)
+	if err != nil {
+		return nil, err
+	}
+
+	return &STFT{
+		config:    config,
+		fft:       fft,
+		window:    window,
+		consumers: consumers,
+		spectra:   make([]complex64, maxBatchFrames*fft.Bins()),
+		power:     make([]float32, maxBatchFrames*fft.Bins()),
+		scratch:   fft.pool.New().(*fftScratch),
+	}, nil
+}
+
+// Config returns the framing of the transform
+func (s *STFT) Config() STFTConfig {
+	return s.config
+}
+
+// Bins returns the number of frequency bins per frame
+func (s *STFT) Bins() int {
+	return s.fft.Bins()
+}
+
+// Subscribe adds a consumer for frames produced from now on
+func (s *STFT) Subscribe(consumer FrameConsumer) {
+	s.consumers = append(s.consumers, consumer)
+}
+
+// FrameCount returns the number of frames produced so far
+func (s *STFT) FrameCount() int64 {
+	return s.frameIndex
+}
+
+// Push appends samples to the stream and emits every frame that is now
+// complete. It returns the number of frames emitted.
+func (s *STFT) Push(samples []float32) int {
+	// Long inputs go through in blocks, so the STFT never buffers a copy
+	// of a whole recording
+	emitted := 0
+	for len(samples) > maxPushSamples {
+		emitted += s.push(samples[:maxPushSamples])
+		samples = samples[maxPushSamples:]
+	}
+	return emitted + s.push(samples)
+}
+
+// push appends one block of samples and emits the complete frames
+func (s *STFT) push(samples []float32) int {
+	s.pending = append(s.pending, samples...)
+
+	if s.config.Center && !s.started {
+		half := s.config.FFTSize / 2
+		if len(s.pending) <= half {
+			return 0 // Reflection needs half+1 samples
+		}
+		padded := make([]float32, half, half+len(s.pending))
+		for i := 0; i < half; i++ {
+			padded[i] = s.pending[half-i]
+		}
+		s.pending = append(padded, s.pending...)
+	}
+	s.started = true
+
+	return s.drain()
+}
+
+// Flush zero-pads the end of the stream, emits the remaining frames and
+// resets the stream. With Center set the end is padded with half a frame of
+// zeros, as whisper.cpp does, giving 1+n/HopSize frames for n samples;
+// otherwise enough zeros are added for every sample to land in a frame.
+func (s *STFT) Flush() int {
+	half := s.config.FFTSize / 2
+	emitted := 0
+
+	if s.config.Center {
+		if !s.started && len(s.pending) > 0 {
+			// Too short to reflect; pad the start with zeros instead
+			s.pending = append(make([]float32, half), s.pending...)
+			s.started = true
+		}
+		if s.started {
+			s.pending = append(s.pending, make([]float32, half)...)
+			emitted = s.drain()
+		}
+		s.Reset()
+		return emitted
+	}
+
+	// Samples at the head of pending were already covered by the previous frame
+	covered := 0
+	if s.frameIndex > 0 {
+		covered = s.config.FFTSize - s.config.HopSize
+	}
+	if len(s.pending) > covered {
+		frames := 1
+		if extra := len(s.pending) - s.config.FFTSize; extra > 0 {
+			frames += (extra + s.config.HopSize - 1) / s.config.HopSize
+		}
+		if total := (frames-1)*s.config.HopSize + s.config.FFTSize; total > len(s.pending) {
+			s.pending = append(s.pending, make([]float32, total-len(s.pending))...)
+		}
+		emitted = s.drain()
+	}
+
+	s.Reset()
+	return emitted
+}
+
+// Reset discards buffered samples and restarts frame numbering
+func (s *STFT) Reset() {
+	s.pending = s.pending[:0]
+	s.started = false
+	s.frameIndex = 0
+}
+
+// drain transforms every complete frame in pending and keeps the remainder
+func (s *STFT) drain() int {
+	fftSize, hop := s.config.FFTSize, s.config.HopSize
+	bins := s.fft.Bins()
+
+	offset := 0
+	emitted := 0
+	for len(s.pending)-offset >= fftSize {
+		frames := (len(s.pending)-offset-fftSize)/hop + 1
+		if frames > maxBatchFrames {
+			frames = maxBatchFrames
+		}
+
+		s.fft.frames(s.window, s.pending[offset:], frames, hop, s.spectra, s.power, s.scratch)
+
+		for f := 0; f < frames; f++ {
+			s.frame = Frame{
+				Index:    s.frameIndex,
+				Time:     s.frameTime(s.frameIndex),
+				Spectrum: s.spectra[f*bins : (f+1)*bins : (f+1)*bins],
+				Power:    s.power[f*bins : (f+1)*bins : (f+1)*bins],
+			}
+			for _, consumer := range s.consumers {
+				consumer.ConsumeFrame(&s.frame)
+			}
+			s.frameIndex++
+		}
+
+		offset += frames * hop
+		emitted += frames
+	}
+
+	remaining := copy(s.pending, s.pending[offset:])
+	s.pending = s.pending[:remaining]
+	return emitted
+}
+
+// frameTime returns the time of a frame's center in seconds
+func (s *STFT) frameTime(index int64) float64 {
+	center := index * int64(s.config.HopSize)
+	if !s.config.Center {
+		center += int64(s.config.FFTSize / 2)
+	}
+	return float64(center) / float64(s.config.SampleRate)
+}
@@ -0,0 +1,63 @@
+package dsp
+
+import (
+	"fmt"
+	"math"
+	"sync"
+)
+
+// WindowType selects the analysis window of an STFT
+type WindowType string
+
+const (
+	WindowHann        WindowType = "hann"
+	WindowHamming     WindowType = "hamming"
+	WindowRectangular WindowType = "rectangular"
+)
+
+type windowKey struct {
+	windowType WindowType
+	length     int
+	fftSize    int
+}
+
+var (
+	windowCache = make(map[windowKey][]float32)
+	windowMutex sync.Mutex
+)
+
+// Window returns a periodic window of the given length, zero-padded on both
+// sides to fftSize the way torch.stft centers a shorter window. The returned
+// slice is cached and shared, so callers must not modify it.
+func Window(windowType WindowType, length, fftSize int) ([]float32, error) {
+	if length < 1 || length > fftSize {
+		return nil, fmt.Errorf("window length %d must be between 1 and the FFT size %d", length, fftSize)
+	}
+
+	key := windowKey{windowType: windowType, length: length, fftSize: fftSize}
+	windowMutex.Lock()
+	defer windowMutex.Unlock()
+
+	if window, ok := windowCache[key]; ok {
+		return window, nil
+	}
+
+	window := make([]float32, fftSize)
+	offset := (fftSize - length) / 2
+	for i := 0; i < length; i++ {
+		phase := 2 * math.Pi * float64(i) / float64(length)
+		switch windowType {
+		case WindowHann:
+			window[offset+i] = float32(0.5 - 0.5*math.Cos(phase))
+		case WindowHamming:
+			window[offset+i] = float32(0.54 - 0.46*math.Cos(phase))
+		case WindowRectangular:
+			window[offset+i] = 1
+		default:
+			return nil, fmt.Errorf("unknown window type: %s", windowType)
+		}
+	}
+
+	windowCache[key] = window
+	return window, nil
+}
@@ -0,0 +1,226 @@
+package services
+
+import (
+	"context"
+	"fmt"
+	"sync"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/logger"
+	"github.com/platformlabs-co/personal-assist/storage"
+)
+
+// GarbageCollectorConfig controls how tombstoned activities are purged
+type GarbageCollectorConfig struct {
+	GracePeriod    time.Duration // How long a deleted activity stays restorable
+	InitialDelay   time.Duration // Delay before the first pass after startup
+	Interval       time.Duration // Time between passes
+	ActivityBatch  int           // Activities purged per pass
+	RowBatch       int           // Transcript chunks deleted per transaction
+	BatchPause     time.Duration // Pause between row batches
+	BytesPerSecond int64         // File deletion budget, 0 disables throttling
+}
+
+// DefaultGarbageCollectorConfig returns the default garbage collector configuration
+func DefaultGarbageCollectorConfig() GarbageCollectorConfig {
+	return GarbageCollectorConfig{
+		GracePeriod:    24 * time.Hour,
+		InitialDelay:   2 * time.Minute,
+		Interval:       15 * time.Minute,
+		ActivityBatch:  10,
+		RowBatch:       500,
+		BatchPause:     50 * time.Millisecond,
+		BytesPerSecond: 32 * 1024 * 1024,
+	}
+}
+
+// GarbageCollectionStats summarizes the work done by the garbage collector
+type GarbageCollectionStats struct {
+	ActivitiesPurged int       `json:"activities_purged"`
+	RowsDeleted      int64     `json:"rows_deleted"`
+	BytesFreed       int64     `json:"bytes_freed"`
+	LastRun          time.Time `json:"last_run"`
+	LastError        string    `json:"last_error,omitempty"`
+}
+
+// GarbageCollector purges soft-deleted activities in the background. Deleting
+// an activity only sets its tombstone, so it returns immediately and can be
+// restored until the grace period ends and the collector claims it.
+type GarbageCollector struct {
+	storage     *storage.SQLiteStorage
+	fileManager *storage.FileManager
+	config      GarbageCollectorConfig
+	throttle    *storage.IOThrottle
+
+	ctx    context.Context
+	cancel context.CancelFunc
+	done   chan struct{}
+
+	statsMutex sync.RWMutex
+	stats      GarbageCollectionStats
+}
+
+// NewGarbageCollector creates a new garbage collector
+func NewGarbageCollector(sqliteStorage *storage.SQLiteStorage, fileManager *storage.FileManager, config GarbageCollectorConfig) *GarbageCollector {
+	return &GarbageCollector{
+		storage:     sqliteStorage,
+		fileManager: fileManager,
+		config:      config,
+		throttle:    storage.NewIOThrottle(config.BytesPerSecond),
+	}
+}
+
+// Start launches the background collection loop
+func (gc *GarbageCollector) Start() {
+	if gc.cancel != nil {
+		return
+	}
+
+	gc.ctx, gc.cancel = context.WithCancel(context.Background())
+	gc.done = make(chan struct{})
+	go gc.run()
+
+	logger.WithFields(map[string]interface{}{
+		"grace_period": gc.config.GracePeriod.String(),
+		"interval":     gc.config.Interval.String(),
+	}).Info("Garbage collector started")
+}
+
+// Stop cancels any pass in progress and waits for the loop to exit. An
+// interrupted purge resumes on the next start because the claim is persisted.
+func (gc *GarbageCollector) Stop() {
+	if gc.cancel == nil {
+		return
+	}
+
+	gc.cancel()
+	<-gc.done
+	gc.cancel = nil
+
+	logger.Info("Garbage collector stopped")
+}
+
+// GetStats returns cumulative statistics
+func (gc *GarbageCollector) GetStats() GarbageCollectionStats {
+	gc.statsMutex.RLock()
+	defer gc.statsMutex.RUnlock()
+	return gc.stats
+}
+
+// run is the background loop
+func (gc *GarbageCollector) run() {
+	defer close(gc.done)
+
+	timer := time.NewTimer(gc.config.InitialDelay)
+	defer timer.Stop()
+
+	for {
+		select {
+		case <-timer.C:
+			if err := gc.RunOnce(gc.ctx); err != nil && gc.ctx.Err() == nil {
+				logger.WithError(err).Warn("Garbage collection pass failed")
+			}
+			timer.Reset(gc.config.Interval)
+		case <-gc.ctx.Done():
+			return
+		}
+	}
+}
+
+// RunOnce purges up to ActivityBatch activities whose grace period has ended
+func (gc *GarbageCollector) RunOnce(ctx context.Context) error {
+	deletedBefore := time.Now().Add(-gc.config.GracePeriod)
+
+	ids, err := gc.storage.GetPurgeableActivityIDs(deletedBefore, gc.config.ActivityBatch)
+	if err != nil {
+		gc.recordError(err)
+		return err
+	}
+
+	for _, id := range ids {
+		if err := gc.purgeActivity(ctx, id, deletedBefore); err != nil {
+			gc.recordError(err)
+			return err
+		}
+	}
+
+	gc.statsMutex.Lock()
+	gc.stats.LastRun = time.Now()
+	gc.stats.LastError = ""
+	gc.statsMutex.Unlock()
+
+	if len(ids) > 0 {
+		logger.WithField("activities", len(ids)).Info("Garbage collection pass completed")
+	}
+
+	return nil
+}
+
+// purgeActivity removes one activity: claim, files, transcript rows, then the
+// activity row itself (recordings go with it through the cascade)
+func (gc *GarbageCollector) purgeActivity(ctx context.Context, activityID string, deletedBefore time.Time) error {
+	claimed, err := gc.storage.ClaimActivityForPurge(activityID, deletedBefore)
+	if err != nil {
+		return err
+	}
+	if !claimed {
+		// Restored between the scan and the claim
+		return nil
+	}
+
+	freed, err := gc.fileManager.DeleteActivityFilesThrottled(ctx, activityID, gc.throttle)
+	gc.addStats(0, 0, freed)
+	if err != nil {
+		return fmt.Errorf("failed to delete files for activity %s: %w", activityID, err)
+	}
+
+	var rowsDeleted int64
+	for {
+		n, err := gc.storage.DeleteActivityTranscriptChunksBatch(activityID, gc.config.RowBatch)
+		if err != nil {
+			return err
+		}
+		rowsDeleted += n
+		gc.addStats(0, n, 0)
+
+		if n < int64(gc.config.RowBatch) {
+			break
+		}
+
+		select {
+		case <-time.After(gc.config.BatchPause):
+		case <-ctx.Done():
+			return ctx.Err()
+		}
+	}
+
+	if err := gc.storage.PurgeActivity(activityID); err != nil {
+		return err
+	}
+	gc.addStats(1, 0, 0)
+
+	logger.WithFields(map[string]interface{}{
+		"activity_id":  activityID,
+		"rows_deleted": rowsDeleted,
+		"bytes_freed":  freed,
+	}).Info("Purged deleted activity")
+
+	return nil
+}
+
+// addStats accumulates purge counters
+func (gc *GarbageCollector) addStats(activities int, rows, bytes int64) {
+	gc.statsMutex.Lock()
+	defer gc.statsMutex.Unlock()
+	gc.stats.ActivitiesPurged += activities
+	gc.stats.RowsDeleted += rows
+	gc.stats.BytesFreed += bytes
+}
+
+// recordError stores the last error for status reporting
+func (gc *GarbageCollector) recordError(err error) {
+	gc.statsMutex.Lock()
+	defer gc.statsMutex.Unlock()
+	gc.stats.LastRun = time.Now()
+	gc.stats.LastError = err.Error()
+}
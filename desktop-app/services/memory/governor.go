@@ -0,0 +1,469 @@
+package memory
+
+import (
+	"context"
+	"fmt"
+	"runtime/debug"
+	"sort"
+	"sync"
+
+	"github.com/platformlabs-co/personal-assist/logger"
+)
+
+const (
+	// MB is a megabyte in bytes
+	MB = int64(1024 * 1024)
+
+	// minRuntimeLimit keeps the Go heap limit above the point where the
+	// collector would run continuously when native memory fills the budget
+	minRuntimeLimit = 256 * MB
+
+	// fallbackPhysical is assumed when the amount of RAM cannot be read
+	fallbackPhysical = 8 * 1024 * MB
+)
+
+// Kind tells whether a consumer's memory is allocated by the Go runtime or
+// outside it, by whisper.cpp and Core Audio
+type Kind int
+
+const (
+	// Heap memory is counted by the Go runtime against its soft limit
+	Heap Kind = iota
+	// Native memory is invisible to the Go runtime, so it lowers the soft limit
+	Native
+)
+
+// Evictor frees at least need bytes if it can and returns the bytes freed.
+// It must release them on its consumer before returning.
+type Evictor func(need int64) int64
+
+// Config sets the memory budget
+type Config struct {
+	Budget         int64   // Bytes for all consumers; 0 uses BudgetFraction of RAM
+	BudgetFraction float64 // Share of physical RAM used when Budget is 0
+	RuntimeLimit   bool    // Set the Go soft memory limit to the budget left to the heap
+}
+
+// DefaultConfig returns a budget of half the physical memory, which leaves
+// the rest of a 16GB laptop to the user's own applications
+func DefaultConfig() Config {
+	return Config{
+		BudgetFraction: 0.5,
+		RuntimeLimit:   true,
+	}
+}
+
+// Stats summarizes the reservations against the budget
+type Stats struct {
+	Budget       int64            `json:"budget"`
+	Reserved     int64            `json:"reserved"`
+	Native       int64            `json:"native"`
+	RuntimeLimit int64            `json:"runtime_limit"`
+	Waiting      int              `json:"waiting"`
+	Evicted      int64            `json:"evicted"`
+	Consumers    map[string]int64 `json:"consumers"`
+}
+
+// Governor holds one memory budget that the memory-hungry subsystems
+// register with. Each consumer reserves memory before it allocates and
+// releases it after freeing. When a reservation does not fit, the governor
+// first asks the consumers holding caches to evict, then makes blocking
+// reservations wait, which is how transcription jobs are held back while
+// others run. Memory that cannot wait, such as audio arriving from a tap,
+// is recorded anyway and eviction runs in the background.
+type Governor struct {
+	mutex     sync.Mutex
+	config    Config
+	budget    int64
+	reserved  int64
+	native    int64
+	blocking  int64         // Bytes held through Reserve
+	changed   chan struct{} // Closed whenever memory is released
+	waiting   int
+	evicted   int64
+	limit     int64
+	consumers []*Consumer
+	reclaims  bool // A background reclaim is running
+}
+
+// Consumer is a subsystem's account with the governor
+type Consumer struct {
+	governor *Governor
+	name     string
+	kind     Kind
+	evict    Evictor
+	held     int64
+	blocking int64
+	closed   bool
+}
+
+var (
+	defaultGovernor *Governor
+	defaultOnce     sync.Once
+)
+
+// Default returns the governor shared by the whole application
+func Default() *Governor {
+	defaultOnce.Do(func() {
+		defaultGovernor = NewGovernor(DefaultConfig())
+	})
+	return defaultGovernor
+}
+
+// NewGovernor creates a governor with the given budget
+func NewGovernor(config Config) *Governor {
+	g := &Governor{changed: make(chan struct{})}
+	g.Configure(config)
+	return g
+}
+
+// Configure changes the budget. Reservations above a lowered budget stay
+// until they are released; new ones wait or evict.
+func (g *Governor) Configure(config Config) {
+	budget := config.Budget
+	if budget <= 0 {
+		physical := PhysicalMemory()
+		if physical <= 0 {
+			physical = fallbackPhysical
+		}
+		fraction := config.BudgetFraction
+		if fraction <= 0 || fraction > 1 {
+			fraction = DefaultConfig().BudgetFraction
+		}
+		budget = int64(float64(physical) * fraction)
+	}
+
+	g.mutex.Lock()
+	g.config = config
+	g.budget = budget
+	g.applyLimit()
+	g.broadcast()
+	limit := g.runtimeLimit()
+	g.mutex.Unlock()
+
+	logger.WithFields(map[string]interface{}{
+		"budget_mb":        budget / MB,
+		"runtime_limit_mb": limit / MB,
+	}).Info("Memory budget configured")
+	g.reclaimAsync()
+}
+
+// Register adds a consumer. evict may be nil for memory that cannot be
+// given back on demand.
+func (g *Governor) Register(name string, kind Kind, evict Evictor) *Consumer {
+	c := &Consumer{governor: g, name: name, kind: kind, evict: evict}
+	g.mutex.Lock()
+	g.consumers = append(g.consumers, c)
+	g.mutex.Unlock()
+	return c
+}
+
+// Budget returns the budget in bytes
+func (g *Governor) Budget() int64 {
+	g.mutex.Lock()
+	defer g.mutex.Unlock()
+	return g.budget
+}
+
+// Stats returns the current reservations
+func (g *Governor) Stats() Stats {
+	g.mutex.Lock()
+	defer g.mutex.Unlock()
+
+	stats := Stats{
+		Budget:       g.budget,
+		Reserved:     g.reserved,
+		Native:       g.native,
+		RuntimeLimit: g.limit,
+		Waiting:      g.waiting,
+		Evicted:      g.evicted,
+		Consumers:    make(map[string]int64),
+	}
+	for _, c := range g.consumers {
+		stats.Consumers[c.name] += c.held
+	}
+	return stats
+}
+
+// Reserve takes bytes from the budget, evicting caches and then waiting for
+// other consumers to release memory when they do not fit. A reservation is
+// admitted over budget when no other blocking reservation is outstanding,
+// so a job larger than the budget still runs, alone. The caller must not
+// hold locks its own evictor takes.
+func (c *Consumer) Reserve(ctx context.Context, bytes int64) error {
+	g := c.governor
+	for {
+		if c.admit(bytes, true, false) {
+			return nil
+		}
+		g.reclaim(bytes, c)
+		if c.admit(bytes, true, true) {
+			return nil
+		}
+
+		g.mutex.Lock()
+		if g.blocking == 0 || g.reserved+bytes <= g.budget {
+			g.mutex.Unlock()
+			continue
+		}
+		changed := g.changed
+		g.waiting++
+		g.mutex.Unlock()
+
+		logger.WithFields(map[string]interface{}{
+			"consumer":    c.name,
+			"bytes_mb":    bytes / MB,
+			"reserved_mb": g.reservedBytes() / MB,
+		}).Debug("Waiting for memory")
+
+		select {
+		case <-changed:
+		case <-ctx.Done():
+		}
+		g.mutex.Lock()
+		g.waiting--
+		g.mutex.Unlock()
+		if err := ctx.Err(); err != nil {
+			return fmt.Errorf("failed to reserve %d MB for %s: %w", bytes/MB, c.name, err)
+		}
+	}
+}
+
+// TryReserve takes bytes from the budget if they fit after evicting caches
+// other than the caller's, and reports whether it did
+func (c *Consumer) TryReserve(bytes int64) bool {
+	if c.admit(bytes, false, false) {
+		return true
+	}
+	c.governor.reclaim(bytes, c)
+	return c.admit(bytes, false, false)
+}
+
+// Add records memory that is already allocated or cannot wait, such as
+// audio arriving on a realtime thread. Over budget, caches are evicted in
+// the background.
+func (c *Consumer) Add(bytes int64) {
+	g := c.governor
+	g.mutex.Lock()
+	g.take(c, bytes, false)
+	over := g.reserved > g.budget
+	g.mutex.Unlock()
+
+	if over {
+		g.reclaimAsync()
+	}
+}
+
+// Release returns bytes to the budget
+func (c *Consumer) Release(bytes int64) {
+	g := c.governor
+	g.mutex.Lock()
+	defer g.mutex.Unlock()
+
+	if bytes > c.held {
+		bytes = c.held
+	}
+	if bytes <= 0 {
+		return
+	}
+
+	// Memory added without waiting is given back before blocking reservations
+	if unblocked := bytes - (c.held - c.blocking); unblocked > 0 {
+		c.blocking -= unblocked
+		g.blocking -= unblocked
+	}
+	c.held -= bytes
+	g.reserved -= bytes
+	if c.kind == Native {
+		g.native -= bytes
+		g.applyLimit()
+	}
+	if c.closed && c.held == 0 {
+		g.unregister(c)
+	}
+	g.broadcast()
+}
+
+// Close removes the consumer from the governor once it holds nothing, for
+// subsystems that live shorter than the application
+func (c *Consumer) Close() {
+	g := c.governor
+	g.mutex.Lock()
+	defer g.mutex.Unlock()
+
+	c.closed = true
+	if c.held == 0 {
+		g.unregister(c)
+	}
+}
+
+// unregister drops a consumer. Callers hold the mutex.
+func (g *Governor) unregister(c *Consumer) {
+	for i, other := range g.consumers {
+		if other == c {
+			g.consumers = append(g.consumers[:i], g.consumers[i+1:]...)
+			return
+		}
+	}
+}
+
+// Move hands bytes of the consumer's holding to another consumer without
+// returning them to the budget, for a reservation admitted as a whole whose
+// parts are allocated by the Go runtime and outside it
+func (c *Consumer) Move(to *Consumer, bytes int64) {
+	g := c.governor
+	g.mutex.Lock()
+	defer g.mutex.Unlock()
+
+	bytes = min(bytes, c.held)
+	if bytes <= 0 {
+		return
+	}
+	moved := min(bytes, c.blocking)
+	c.held -= bytes
+	c.blocking -= moved
+	to.held += bytes
+	to.blocking += moved
+	if c.kind != to.kind {
+		if to.kind == Native {
+			g.native += bytes
+		} else {
+			g.native -= bytes
+		}
+		g.applyLimit()
+	}
+}
+
+// ReleaseAll returns everything the consumer holds
+func (c *Consumer) ReleaseAll() {
+	c.Release(c.Held())
+}
+
+// Held returns the bytes the consumer holds
+func (c *Consumer) Held() int64 {
+	c.governor.mutex.Lock()
+	defer c.governor.mutex.Unlock()
+	return c.held
+}
+
+// Fits reports whether bytes would fit in the budget if the consumer gave
+// up what it holds, which is what replacing a loaded model does
+func (c *Consumer) Fits(bytes int64) bool {
+	g := c.governor
+	g.mutex.Lock()
+	defer g.mutex.Unlock()
+	return g.reserved-c.held+bytes <= g.budget
+}
+
+// admit takes bytes if they fit the budget, or with alone set, when no
+// other blocking reservation is outstanding
+func (c *Consumer) admit(bytes int64, blocking, alone bool) bool {
+	g := c.governor
+	g.mutex.Lock()
+	defer g.mutex.Unlock()
+
+	if g.reserved+bytes > g.budget && !(alone && g.blocking == 0) {
+		return false
+	}
+	g.take(c, bytes, blocking)
+	return true
+}
+
+// take records a reservation. Callers hold the mutex.
+func (g *Governor) take(c *Consumer, bytes int64, blocking bool) {
+	c.held += bytes
+	g.reserved += bytes
+	if blocking {
+		c.blocking += bytes
+		g.blocking += bytes
+	}
+	if c.kind == Native {
+		g.native += bytes
+		g.applyLimit()
+	}
+}
+
+// reclaim asks the consumers with evictors, largest first, to free memory
+// until need bytes fit, skipping the consumer asking. Evictors run without
+// the governor's mutex so they can release.
+func (g *Governor) reclaim(need int64, except *Consumer) int64 {
+	g.mutex.Lock()
+	shortfall := g.reserved + need - g.budget
+	var candidates []*Consumer
+	for _, c := range g.consumers {
+		if c != except && c.evict != nil && c.held > 0 {
+			candidates = append(candidates, c)
+		}
+	}
+	sort.Slice(candidates, func(i, j int) bool { return candidates[i].held > candidates[j].held })
+	g.mutex.Unlock()
+
+	var freed int64
+	for _, c := range candidates {
+		if freed >= shortfall {
+			break
+		}
+		freed += c.evict(shortfall - freed)
+	}
+
+	if freed > 0 {
+		g.mutex.Lock()
+		g.evicted += freed
+		g.mutex.Unlock()
+		logger.WithFields(map[string]interface{}{
+			"freed_mb":     freed / MB,
+			"shortfall_mb": shortfall / MB,
+		}).Debug("Evicted cached memory")
+	}
+	return freed
+}
+
+// reclaimAsync evicts down to the budget in the background, once at a time
+func (g *Governor) reclaimAsync() {
+	g.mutex.Lock()
+	if g.reclaims || g.reserved <= g.budget {
+		g.mutex.Unlock()
+		return
+	}
+	g.reclaims = true
+	g.mutex.Unlock()
+
+	go func() {
+		g.reclaim(0, nil)
+		g.mutex.Lock()
+		g.reclaims = false
+		g.mutex.Unlock()
+	}()
+}
+
+// reservedBytes returns the total reservation
+func (g *Governor) reservedBytes() int64 {
+	g.mutex.Lock()
+	defer g.mutex.Unlock()
+	return g.reserved
+}
+
+// broadcast wakes the waiting reservations. Callers hold the mutex.
+func (g *Governor) broadcast() {
+	close(g.changed)
+	g.changed = make(chan struct{})
+}
+
+// runtimeLimit returns the part of the budget left to the Go heap. Callers
+// hold the mutex.
+func (g *Governor) runtimeLimit() int64 {
+	return max(g.budget-g.native, minRuntimeLimit)
+}
+
+// applyLimit sets the Go soft memory limit so garbage collection tightens
+// as native memory fills the budget. Callers hold the mutex.
+func (g *Governor) applyLimit() {
+	if !g.config.RuntimeLimit {
+		return
+	}
+	limit := g.runtimeLimit()
+	if limit != g.limit {
+		g.limit = limit
+		debug.SetMemoryLimit(limit)
+	}
+}
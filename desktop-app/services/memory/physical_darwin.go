@@ -0,0 +1,18 @@
+package memory
+
+import (
+	"encoding/binary"
+	"syscall"
+)
+
+// PhysicalMemory returns the installed RAM in bytes, or 0 if unknown
+func PhysicalMemory() int64 {
+	value, err := syscall.Sysctl("hw.memsize")
+	if err != nil {
+		return 0
+	}
+	// Sysctl drops trailing zero bytes of the little-endian integer
+	buf := make([]byte, 8)
+	copy(buf, value)
+	return int64(binary.LittleEndian.Uint64(buf))
+}
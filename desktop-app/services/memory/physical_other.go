@@ -0,0 +1,32 @@
+//go:build !darwin
+
+package memory
+
+import (
+	"bufio"
+	"os"
+	"strconv"
+	"strings"
+)
+
+// PhysicalMemory returns the installed RAM in bytes, or 0 if unknown
+func PhysicalMemory() int64 {
+	file, err := os.Open("/proc/meminfo")
+	if err != nil {
+		return 0
+	}
+	defer file.Close()
+
+	scanner := bufio.NewScanner(file)
+	for scanner.Scan() {
+		fields := strings.Fields(scanner.Text())
+		if len(fields) >= 2 && fields[0] == "MemTotal:" {
+			kb, err := strconv.ParseInt(fields[1], 10, 64)
+			if err != nil {
+				return 0
+			}
+			return kb * 1024
+		}
+	}
+	return 0
+}
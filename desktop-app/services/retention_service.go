@@ -0,0 +1,379 @@
+package services
+
+import (
+	"context"
+	"fmt"
+	"sync"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/logger"
+	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/services/transcription"
+	"github.com/platformlabs-co/personal-assist/storage"
+)
+
+// RetentionConfig controls how often and how fast retention passes run
+type RetentionConfig struct {
+	InitialDelay   time.Duration // Delay before the first pass after startup
+	Interval       time.Duration // Time between passes
+	BatchSize      int           // Rows handled per transaction
+	BatchPause     time.Duration // Pause between batches
+	BytesPerSecond int64         // File deletion budget, 0 disables throttling
+	FailureBackoff time.Duration // Wait before retrying a file that failed to delete, doubled per failure
+}
+
+// DefaultRetentionConfig returns the default retention configuration
+func DefaultRetentionConfig() RetentionConfig {
+	return RetentionConfig{
+		InitialDelay:   5 * time.Minute,
+		Interval:       6 * time.Hour,
+		BatchSize:      100,
+		BatchPause:     100 * time.Millisecond,
+		BytesPerSecond: 32 * 1024 * 1024,
+		FailureBackoff: time.Hour,
+	}
+}
+
+// RetentionStats summarizes the work done by the retention engine
+type RetentionStats struct {
+	RecordingsPurged int       `json:"recordings_purged"`
+	BytesFreed       int64     `json:"bytes_freed"`
+	ChunksDeleted    int64     `json:"chunks_deleted"`
+	PurgeFailures    int       `json:"purge_failures"`
+	LastRun          time.Time `json:"last_run"`
+	LastError        string    `json:"last_error,omitempty"`
+}
+
+// RetentionService applies the user's retention policy in the background.
+// Every rule is evaluated with indexed queries over audio_recordings and
+// transcript_chunks, so a pass only touches rows that qualify. Audio removal
+// keeps the recording row (marked with audio_purged_at) so its transcript
+// survives unless a transcript rule removes it too. A pass walks the
+// candidates once in order, skipping recordings being transcribed; files
+// that fail to delete are recorded on their row and retried after a backoff.
+type RetentionService struct {
+	storage     *storage.SQLiteStorage
+	fileManager *storage.FileManager
+	config      RetentionConfig
+	throttle    *storage.IOThrottle
+
+	policyMutex sync.RWMutex
+	policy      models.RetentionPolicy
+
+	claimMutex sync.RWMutex
+	claim      func(recordingID string) (func(), bool)
+
+	ctx    context.Context
+	cancel context.CancelFunc
+	done   chan struct{}
+
+	statsMutex sync.RWMutex
+	stats      RetentionStats
+}
+
+// NewRetentionService creates a new retention service
+func NewRetentionService(sqliteStorage *storage.SQLiteStorage, fileManager *storage.FileManager, config RetentionConfig) *RetentionService {
+	return &RetentionService{
+		storage:     sqliteStorage,
+		fileManager: fileManager,
+		config:      config,
+		throttle:    storage.NewIOThrottle(config.BytesPerSecond),
+	}
+}
+
+// SetPolicy replaces the policy used by subsequent passes
+func (rs *RetentionService) SetPolicy(policy models.RetentionPolicy) {
+	rs.policyMutex.Lock()
+	defer rs.policyMutex.Unlock()
+	rs.policy = policy
+}
+
+// SetClaimFunc sets the function claiming a recording before its audio is
+// deleted, keeping transcription jobs from starting on it until the purge is
+// recorded. A recording it refuses is being transcribed; its audio is kept
+// until the next pass.
+func (rs *RetentionService) SetClaimFunc(claim func(recordingID string) (func(), bool)) {
+	rs.claimMutex.Lock()
+	defer rs.claimMutex.Unlock()
+	rs.claim = claim
+}
+
+// GetPolicy returns the current policy
+func (rs *RetentionService) GetPolicy() models.RetentionPolicy {
+	rs.policyMutex.RLock()
+	defer rs.policyMutex.RUnlock()
+	return rs.policy
+}
+
+// GetStats returns cumulative statistics
+func (rs *RetentionService) GetStats() RetentionStats {
+	rs.statsMutex.RLock()
+	defer rs.statsMutex.RUnlock()
+	return rs.stats
+}
+
+// Start launches the background retention loop
+func (rs *RetentionService) Start() {
+	if rs.cancel != nil {
+		return
+	}
+
+	rs.ctx, rs.cancel = context.WithCancel(context.Background())
+	rs.done = make(chan struct{})
+	go rs.run()
+
+	logger.WithField("interval", rs.config.Interval.String()).Info("Retention service started")
+}
+
+// Stop cancels any pass in progress and waits for the loop to exit
+func (rs *RetentionService) Stop() {
+	if rs.cancel == nil {
+		return
+	}
+
+	rs.cancel()
+	<-rs.done
+	rs.cancel = nil
+
+	logger.Info("Retention service stopped")
+}
+
+// run is the background loop
+func (rs *RetentionService) run() {
+	defer close(rs.done)
+
+	timer := time.NewTimer(rs.config.InitialDelay)
+	defer timer.Stop()
+
+	for {
+		select {
+		case <-timer.C:
+			if err := rs.RunOnce(rs.ctx); err != nil && rs.ctx.Err() == nil {
+				logger.WithError(err).Warn("Retention pass failed")
+			}
+			timer.Reset(rs.config.Interval)
+		case <-rs.ctx.Done():
+			return
+		}
+	}
+}
+
+// RunOnce applies every rule of the current policy
+func (rs *RetentionService) RunOnce(ctx context.Context) error {
+	policy := rs.GetPolicy()
+	if policy.IsEmpty() {
+		return nil
+	}
+
+	err := rs.applyPolicy(ctx, policy)
+
+	rs.statsMutex.Lock()
+	rs.stats.LastRun = time.Now()
+	rs.stats.LastError = ""
+	if err != nil {
+		rs.stats.LastError = err.Error()
+	}
+	rs.statsMutex.Unlock()
+
+	return err
+}
+
+// applyPolicy runs the age rule, then the size cap, then transcript expiry
+func (rs *RetentionService) applyPolicy(ctx context.Context, policy models.RetentionPolicy) error {
+	if maxAge := policy.AudioMaxAge(); maxAge > 0 {
+		if err := rs.purgeAudioOlderThan(ctx, time.Now().Add(-maxAge)); err != nil {
+			return fmt.Errorf("failed to apply audio age rule: %w", err)
+		}
+	}
+
+	if capBytes := policy.AudioStorageCapBytes(); capBytes > 0 {
+		if err := rs.purgeAudioAboveCap(ctx, capBytes); err != nil {
+			return fmt.Errorf("failed to apply audio storage cap: %w", err)
+		}
+	}
+
+	if maxAge := policy.TranscriptMaxAge(); maxAge > 0 {
+		if err := rs.deleteTranscriptsOlderThan(ctx, time.Now().Add(-maxAge)); err != nil {
+			return fmt.Errorf("failed to apply transcript age rule: %w", err)
+		}
+	}
+
+	return nil
+}
+
+// purgeAudioOlderThan removes audio recorded before the cutoff
+func (rs *RetentionService) purgeAudioOlderThan(ctx context.Context, cutoff time.Time) error {
+	var after *storage.AudioRetentionCandidate
+	for {
+		candidates, err := rs.storage.GetAudioRetentionCandidates(cutoff, after, rs.config.FailureBackoff, rs.config.BatchSize)
+		if err != nil {
+			return err
+		}
+		if len(candidates) == 0 {
+			return nil
+		}
+		after = candidates[len(candidates)-1]
+
+		if _, err := rs.purgeAudioBatch(ctx, candidates); err != nil {
+			return err
+		}
+
+		if len(candidates) < rs.config.BatchSize {
+			return nil
+		}
+		if err := rs.pause(ctx); err != nil {
+			return err
+		}
+	}
+}
+
+// purgeAudioAboveCap removes the oldest audio until the total fits in the cap
+func (rs *RetentionService) purgeAudioAboveCap(ctx context.Context, capBytes int64) error {
+	total, err := rs.storage.GetAudioBytesOnDisk()
+	if err != nil {
+		return err
+	}
+
+	var after *storage.AudioRetentionCandidate
+	for total > capBytes {
+		candidates, err := rs.storage.GetAudioRetentionCandidates(time.Now(), after, rs.config.FailureBackoff, rs.config.BatchSize)
+		if err != nil {
+			return err
+		}
+		if len(candidates) == 0 {
+			return nil
+		}
+
+		// Only take as many of the oldest recordings as needed to get under the cap
+		selected := candidates[:0]
+		var planned int64
+		for _, candidate := range candidates {
+			if total-planned <= capBytes {
+				break
+			}
+			selected = append(selected, candidate)
+			planned += candidate.FileSize
+		}
+		after = selected[len(selected)-1]
+
+		freed, err := rs.purgeAudioBatch(ctx, selected)
+		if err != nil {
+			return err
+		}
+		total -= freed
+
+		if err := rs.pause(ctx); err != nil {
+			return err
+		}
+	}
+
+	return nil
+}
+
+// purgeAudioBatch deletes the files of a batch and marks the rows in one
+// transaction, recording the files that failed to delete on their rows. It
+// returns the bytes freed.
+func (rs *RetentionService) purgeAudioBatch(ctx context.Context, candidates []*storage.AudioRetentionCandidate) (int64, error) {
+	purged := make([]string, 0, len(candidates))
+	var failed []string
+	var freed int64
+
+	rs.claimMutex.RLock()
+	claim := rs.claim
+	rs.claimMutex.RUnlock()
+	var claims []func()
+
+	// Jobs may start on the recordings once the purge is recorded
+	defer func() {
+		for _, release := range claims {
+			release()
+		}
+	}()
+
+	// Persist whatever was deleted even if the batch is interrupted
+	defer func() {
+		if err := rs.storage.MarkAudioPurged(purged); err != nil {
+			logger.WithError(err).Error("Failed to record purged audio")
+			return
+		}
+		if err := rs.storage.MarkAudioPurgeFailed(failed); err != nil {
+			logger.WithError(err).Error("Failed to record audio purge failures")
+		}
+		rs.statsMutex.Lock()
+		rs.stats.RecordingsPurged += len(purged)
+		rs.stats.BytesFreed += freed
+		rs.stats.PurgeFailures += len(failed)
+		rs.statsMutex.Unlock()
+	}()
+
+	for _, candidate := range candidates {
+		if claim != nil {
+			release, ok := claim(candidate.ID)
+			if !ok {
+				logger.WithField("recording_id", candidate.ID).Debug("Recording is being transcribed, keeping its audio")
+				continue
+			}
+			claims = append(claims, release)
+		}
+
+		if err := rs.throttle.Wait(ctx, candidate.FileSize); err != nil {
+			return freed, err
+		}
+
+		path := rs.fileManager.GetAbsolutePathFromRelative(candidate.FilePath)
+		if err := rs.fileManager.DeleteFile(path); err != nil {
+			logger.WithError(err).WithField("recording_id", candidate.ID).Warn("Failed to delete audio file")
+			failed = append(failed, candidate.ID)
+			continue
+		}
+
+		// Derived spectrograms go with the audio
+		for _, cachePath := range transcription.MelCachePaths(path) {
+			if err := rs.fileManager.DeleteFile(cachePath); err != nil {
+				logger.WithError(err).WithField("recording_id", candidate.ID).Warn("Failed to delete mel cache")
+			}
+		}
+
+		purged = append(purged, candidate.ID)
+		freed += candidate.FileSize
+	}
+
+	logger.WithFields(map[string]interface{}{
+		"recordings":  len(purged),
+		"failed":      len(failed),
+		"bytes_freed": freed,
+	}).Info("Retention removed audio files")
+
+	return freed, nil
+}
+
+// deleteTranscriptsOlderThan removes transcript chunks created before the cutoff
+func (rs *RetentionService) deleteTranscriptsOlderThan(ctx context.Context, cutoff time.Time) error {
+	for {
+		n, err := rs.storage.DeleteTranscriptChunksBefore(cutoff, rs.config.BatchSize)
+		if err != nil {
+			return err
+		}
+
+		rs.statsMutex.Lock()
+		rs.stats.ChunksDeleted += n
+		rs.statsMutex.Unlock()
+
+		if n < int64(rs.config.BatchSize) {
+			return nil
+		}
+		if err := rs.pause(ctx); err != nil {
+			return err
+		}
+	}
+}
+
+// pause waits between batches so foreground queries get the database
+func (rs *RetentionService) pause(ctx context.Context) error {
+	select {
+	case <-time.After(rs.config.BatchPause):
+		return nil
+	case <-ctx.Done():
+		return ctx.Err()
+	}
+}
@@ -0,0 +1,219 @@
+package services
+
+import (
+	"context"
+	"sync"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/logger"
+	"github.com/platformlabs-co/personal-assist/storage"
+)
+
+// TranscriptRefinerConfig controls the background refinement of draft transcripts
+type TranscriptRefinerConfig struct {
+	InitialDelay time.Duration // Delay before the first pass after startup
+	Interval     time.Duration // Time between passes
+	BatchSize    int           // Drafts fetched per pass
+	MaxAttempts  int           // Failures before a draft is left alone for RetryAfter
+	RetryAfter   time.Duration // Time before a draft left alone is tried again
+}
+
+// DefaultTranscriptRefinerConfig returns the default refiner configuration
+func DefaultTranscriptRefinerConfig() TranscriptRefinerConfig {
+	return TranscriptRefinerConfig{
+		InitialDelay: time.Minute,
+		Interval:     2 * time.Minute,
+		BatchSize:    10,
+		MaxAttempts:  3,
+		RetryAfter:   24 * time.Hour,
+	}
+}
+
+// TranscriptRefinerStats summarizes the work done by the refiner
+type TranscriptRefinerStats struct {
+	Refined   int64     `json:"refined"`
+	Failed    int64     `json:"failed"`
+	Pending   int       `json:"pending"` // Drafts seen by the last pass, at most BatchSize
+	LastRun   time.Time `json:"last_run"`
+	LastError string    `json:"last_error,omitempty"`
+}
+
+// TranscriptRefiner is the second tier of two-tier transcription. While the
+// machine is idle it re-transcribes draft transcripts with the larger
+// refinement model, oldest first, and swaps each one in atomically.
+type TranscriptRefiner struct {
+	transcription *TranscriptionService
+	storage       *storage.SQLiteStorage
+	config        TranscriptRefinerConfig
+	idle          func() bool
+	refined       func(activityID, recordingID string)
+
+	ctx    context.Context
+	cancel context.CancelFunc
+	done   chan struct{}
+
+	statsMutex sync.RWMutex
+	stats      TranscriptRefinerStats
+}
+
+// NewTranscriptRefiner creates a new transcript refiner
+func NewTranscriptRefiner(transcriptionService *TranscriptionService, sqliteStorage *storage.SQLiteStorage, config TranscriptRefinerConfig) *TranscriptRefiner {
+	return &TranscriptRefiner{
+		transcription: transcriptionService,
+		storage:       sqliteStorage,
+		config:        config,
+	}
+}
+
+// SetIdleFunc sets the check that keeps refinement from competing with
+// recording and interactive transcription. It is consulted before every draft.
+func (r *TranscriptRefiner) SetIdleFunc(idle func() bool) {
+	r.idle = idle
+}
+
+// SetRefinedFunc sets a callback run after a draft was replaced
+func (r *TranscriptRefiner) SetRefinedFunc(refined func(activityID, recordingID string)) {
+	r.refined = refined
+}
+
+// Start launches the background refinement loop
+func (r *TranscriptRefiner) Start() {
+	if r.cancel != nil {
+		return
+	}
+
+	r.ctx, r.cancel = context.WithCancel(context.Background())
+	r.done = make(chan struct{})
+	go r.run()
+
+	logger.WithField("interval", r.config.Interval.String()).Info("Transcript refiner started")
+}
+
+// Stop cancels the loop and waits for it to exit. A recording being refined
+// finishes first; its draft is replaced or left for the next start.
+func (r *TranscriptRefiner) Stop() {
+	if r.cancel == nil {
+		return
+	}
+
+	r.cancel()
+	<-r.done
+	r.cancel = nil
+
+	logger.Info("Transcript refiner stopped")
+}
+
+// GetStats returns cumulative statistics
+func (r *TranscriptRefiner) GetStats() TranscriptRefinerStats {
+	r.statsMutex.RLock()
+	defer r.statsMutex.RUnlock()
+	return r.stats
+}
+
+// run is the background loop
+func (r *TranscriptRefiner) run() {
+	defer close(r.done)
+
+	timer := time.NewTimer(r.config.InitialDelay)
+	defer timer.Stop()
+
+	for {
+		select {
+		case <-timer.C:
+			if err := r.RunOnce(r.ctx); err != nil && r.ctx.Err() == nil {
+				logger.WithError(err).Warn("Transcript refinement pass failed")
+			}
+			timer.Reset(r.config.Interval)
+		case <-r.ctx.Done():
+			return
+		}
+	}
+}
+
+// RunOnce refines pending drafts until none is left in the batch or the
+// machine stops being idle
+func (r *TranscriptRefiner) RunOnce(ctx context.Context) error {
+	if !r.isIdle() {
+		return nil
+	}
+
+	pending, err := r.storage.GetDraftTranscripts(r.config.BatchSize, r.config.MaxAttempts, time.Now().Add(-r.config.RetryAfter))
+	if err != nil {
+		r.recordError(err)
+		return err
+	}
+
+	r.statsMutex.Lock()
+	r.stats.Pending = len(pending)
+	r.statsMutex.Unlock()
+
+	if len(pending) == 0 {
+		r.transcription.ReleaseRefinementModel()
+		r.finishRun(nil)
+		return nil
+	}
+	if !r.transcription.RefinementReady() {
+		return nil
+	}
+
+	refined := 0
+	var lastErr error
+	for _, draft := range pending {
+		if ctx.Err() != nil || !r.isIdle() {
+			break
+		}
+
+		replaced, err := r.transcription.RefineDraft(draft)
+		if err != nil {
+			if markErr := r.storage.MarkDraftRefineFailed(draft.RecordingID); markErr != nil {
+				logger.WithError(markErr).WithField("recording_id", draft.RecordingID).Warn("Failed to record draft refinement failure")
+			}
+			lastErr = err
+			r.statsMutex.Lock()
+			r.stats.Failed++
+			r.statsMutex.Unlock()
+			logger.WithError(err).WithField("recording_id", draft.RecordingID).Warn("Failed to refine draft transcript")
+			continue
+		}
+
+		if replaced {
+			refined++
+			r.statsMutex.Lock()
+			r.stats.Refined++
+			r.statsMutex.Unlock()
+			if r.refined != nil {
+				r.refined(draft.ActivityID, draft.RecordingID)
+			}
+		}
+	}
+
+	r.finishRun(lastErr)
+	if refined > 0 {
+		logger.WithField("recordings", refined).Info("Transcript refinement pass completed")
+	}
+
+	return nil
+}
+
+// isIdle reports whether refinement may run now
+func (r *TranscriptRefiner) isIdle() bool {
+	return r.idle == nil || r.idle()
+}
+
+// finishRun records a completed pass and the last refinement error in it
+func (r *TranscriptRefiner) finishRun(err error) {
+	r.statsMutex.Lock()
+	r.stats.LastRun = time.Now()
+	r.stats.LastError = ""
+	if err != nil {
+		r.stats.LastError = err.Error()
+	}
+	r.statsMutex.Unlock()
+}
+
+// recordError stores the error of a pass that could not run
+func (r *TranscriptRefiner) recordError(err error) {
+	r.statsMutex.Lock()
+	r.stats.LastError = err.Error()
+	r.statsMutex.Unlock()
+}
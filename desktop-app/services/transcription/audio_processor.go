@@ -8,6 +8,7 @@ import (
 
 	"github.com/go-audio/audio"
 	"github.com/go-audio/wav"
+	"github.com/platformlabs-co/personal-assist/services/dsp"
 	"github.com/sirupsen/logrus"
 )
 
@@ -19,6 +20,8 @@ type AudioChunk struct {
 	SampleRate      int       `json:"sample_rate"`
 	ChunkIndex      int       `json:"chunk_index"`
 	OriginalPath    string    `json:"original_path"`
+	StartSample     int       `json:"start_sample"`     // Offset of the chunk in the 16kHz recording
+	EndSample       int       `json:"end_sample"`
 	ActivityStartTime time.Time `json:"activity_start_time"` // For timeline correlation
 }
 
@@ -27,6 +30,9 @@ type AudioProcessor struct {
 	sampleRate      int
 	channels        int
 	logger          *logrus.Logger
+	pool            *dsp.SamplePool
+
+	noiseSuppression bool
 }
 
 // NewAudioProcessor creates a new audio processor
@@ -35,10 +41,35 @@ func NewAudioProcessor(logger *logrus.Logger) *AudioProcessor {
 		sampleRate: 16000, // Whisper optimal sample rate
 		channels:   1,     // Mono for Whisper
 		logger:     logger,
+		pool:       dsp.DefaultSamplePool(),
 	}
 }
 
-// PrepareForWhisper converts audio to optimal format for Whisper processing
+// SetSamplePool changes the pool the preprocessing buffers come from; nil
+// allocates every buffer
+func (p *AudioProcessor) SetSamplePool(pool *dsp.SamplePool) {
+	p.pool = pool
+}
+
+// ReleaseSamples returns the samples of PrepareForWhisper to the pool once
+// they, and the chunks ChunkAudio cut from them, are no longer used
+func (p *AudioProcessor) ReleaseSamples(samples []float32) {
+	p.pool.ReleaseFloat32(samples)
+}
+
+// SetNoiseSuppression turns the noise suppression stage of PrepareForWhisper on or off
+func (p *AudioProcessor) SetNoiseSuppression(enabled bool) {
+	p.noiseSuppression = enabled
+}
+
+// NoiseSuppression reports whether PrepareForWhisper suppresses noise
+func (p *AudioProcessor) NoiseSuppression() bool {
+	return p.noiseSuppression
+}
+
+// PrepareForWhisper converts audio to optimal format for Whisper processing.
+// Every stage writes to a buffer from the sample pool and releases its input;
+// the caller releases the result with ReleaseSamples.
 func (p *AudioProcessor) PrepareForWhisper(inputPath string) ([]float32, error) {
 	p.logger.WithField("input_path", inputPath).Info("Preparing audio for Whisper")
 
@@ -63,55 +94,48 @@ func (p *AudioProcessor) PrepareForWhisper(inputPath string) ([]float32, error)
 		"bit_depth":   decoder.BitDepth,
 	}).Debug("Loaded audio file metadata")
 
-	// Read all audio data
-	buf := &audio.IntBuffer{
-		Format: format,
-		Data:   make([]int, 0),
+	// Read all audio data as float32 mono, weighting channels by what they carry
+	downmixer, err := dsp.NewDownmixer(dsp.DefaultDownmixConfig(format.NumChannels, int(decoder.BitDepth), format.SampleRate))
+	if err != nil {
+		return nil, fmt.Errorf("failed to downmix audio: %w", err)
 	}
-
-	// Read the entire file
-	for {
-		// Read in chunks to avoid memory issues with large files
-		chunk := &audio.IntBuffer{
-			Format: format,
-			Data:   make([]int, 4096),
-		}
-
-		n, err := decoder.PCMBuffer(chunk)
-		if err != nil {
-			return nil, fmt.Errorf("failed to read audio data: %w", err)
-		}
-		if n == 0 {
-			break
-		}
-
-		buf.Data = append(buf.Data, chunk.Data[:n]...)
+	samples, err := p.decodeMono(decoder, format.NumChannels, format.SampleRate, downmixer)
+	if err != nil {
+		return nil, err
 	}
 
-	p.logger.WithField("samples", len(buf.Data)).Debug("Read audio samples")
+	p.logger.WithField("samples", len(samples)).Debug("Read audio samples")
 
-	if len(buf.Data) == 0 {
+	if len(samples) == 0 {
+		p.pool.ReleaseFloat32(samples)
 		return nil, fmt.Errorf("no audio data found in file")
 	}
-
-	// Convert to float32 samples
-	samples := p.convertToFloat32(buf.Data, int(decoder.BitDepth))
-
-	// Convert to mono if stereo
 	if format.NumChannels > 1 {
-		samples = p.convertToMono(samples, format.NumChannels)
-		p.logger.Debug("Converted stereo to mono")
+		p.logger.WithField("weights", downmixer.Weights()).Debug("Downmixed channels to mono")
 	}
 
 	// Resample if not 16kHz
 	if format.SampleRate != p.sampleRate {
-		samples = p.resample(samples, format.SampleRate, p.sampleRate)
+		resampled := p.resample(samples, format.SampleRate, p.sampleRate)
+		p.pool.ReleaseFloat32(samples)
+		samples = resampled
 		p.logger.WithFields(logrus.Fields{
 			"from": format.SampleRate,
 			"to":   p.sampleRate,
 		}).Debug("Resampled audio")
 	}
 
+	// Suppress background noise before levels are measured
+	if p.noiseSuppression {
+		denoised, err := dsp.SuppressNoiseTo(samples, p.pool.Float32(len(samples))[:0], dsp.DefaultNoiseSuppressorConfig(p.sampleRate))
+		p.pool.ReleaseFloat32(samples)
+		if err != nil {
+			return nil, fmt.Errorf("failed to suppress noise: %w", err)
+		}
+		samples = denoised
+		p.logger.Debug("Suppressed background noise")
+	}
+
 	// Normalize audio levels
 	samples = p.NormalizeAudio(samples)
 	p.logger.Debug("Normalized audio")
@@ -128,52 +152,52 @@ func (p *AudioProcessor) PrepareForWhisper(inputPath string) ([]float32, error)
 	return samples, nil
 }
 
-// convertToFloat32 converts integer PCM samples to float32 normalized to [-1.0, 1.0]
-func (p *AudioProcessor) convertToFloat32(intSamples []int, bitDepth int) []float32 {
-	samples := make([]float32, len(intSamples))
-
-	// Calculate normalization factor based on bit depth
-	var maxValue float64
-	switch bitDepth {
-	case 8:
-		maxValue = 128.0
-	case 16:
-		maxValue = 32768.0
-	case 24:
-		maxValue = 8388608.0
-	case 32:
-		maxValue = 2147483648.0
-	default:
-		maxValue = 32768.0 // Assume 16-bit if unknown
-	}
-
-	for i, sample := range intSamples {
-		samples[i] = float32(float64(sample) / maxValue)
+// decodeMono reads the PCM data of a WAV file a second at a time and
+// downmixes each block as it arrives, so the integer samples of the whole
+// recording are never held at once. The mono buffer comes from the pool,
+// sized from the data chunk so it does not grow while reading.
+func (p *AudioProcessor) decodeMono(decoder *wav.Decoder, channels, blockFrames int, downmixer *dsp.Downmixer) ([]float32, error) {
+	if err := decoder.FwdToPCM(); err != nil {
+		return nil, fmt.Errorf("failed to read audio data: %w", err)
 	}
-
-	return samples
-}
-
-// convertToMono converts multi-channel audio to mono by averaging channels
-func (p *AudioProcessor) convertToMono(samples []float32, numChannels int) []float32 {
-	if numChannels == 1 {
-		return samples
+	expected := blockFrames
+	if frameBytes := int64(decoder.BitDepth/8) * int64(channels); frameBytes > 0 && decoder.PCMLen() > 0 {
+		expected = int(decoder.PCMLen() / frameBytes)
 	}
 
-	monoSamples := make([]float32, len(samples)/numChannels)
+	samples := p.pool.Float32(expected)[:0]
+	block := p.pool.Ints(blockFrames * channels)
+	defer p.pool.ReleaseInts(block)
 
-	for i := 0; i < len(monoSamples); i++ {
-		var sum float32
-		for ch := 0; ch < numChannels; ch++ {
-			sum += samples[i*numChannels+ch]
+	chunk := &audio.IntBuffer{}
+	have := 0 // Samples of an incomplete frame carried to the next read
+	for {
+		chunk.Data = block[have : blockFrames*channels]
+		n, err := decoder.PCMBuffer(chunk)
+		if err != nil {
+			p.pool.ReleaseFloat32(samples)
+			return nil, fmt.Errorf("failed to read audio data: %w", err)
+		}
+		if n == 0 {
+			return samples, nil
+		}
+		have += n
+		frames := have / channels
+
+		// Files whose header understates the data grow the buffer
+		if cap(samples)-len(samples) < frames {
+			grown := p.pool.Float32(2*cap(samples) + blockFrames)[:len(samples)]
+			copy(grown, samples)
+			p.pool.ReleaseFloat32(samples)
+			samples = grown
 		}
-		monoSamples[i] = sum / float32(numChannels)
+		samples = downmixer.Process(block[:frames*channels], samples)
+		have = copy(block, block[frames*channels:have])
 	}
-
-	return monoSamples
 }
 
-// resample converts audio from one sample rate to another using linear interpolation
+// resample converts audio from one sample rate to another using linear
+// interpolation, into a buffer from the sample pool
 func (p *AudioProcessor) resample(samples []float32, fromRate, toRate int) []float32 {
 	if fromRate == toRate {
 		return samples
@@ -182,7 +206,7 @@ func (p *AudioProcessor) resample(samples []float32, fromRate, toRate int) []flo
 	// Calculate output length
 	ratio := float64(toRate) / float64(fromRate)
 	outputLen := int(float64(len(samples)) * ratio)
-	resampled := make([]float32, outputLen)
+	resampled := p.pool.Float32(outputLen)
 
 	// Simple linear interpolation
 	for i := 0; i < outputLen; i++ {
@@ -206,9 +230,22 @@ func (p *AudioProcessor) resample(samples []float32, fromRate, toRate int) []flo
 	return resampled
 }
 
-// ChunkAudio splits audio into overlapping chunks for better transcription accuracy
+// ChunkAudio splits audio into overlapping chunks for better transcription
+// accuracy. Chunks share the samples rather than copying them, so they are
+// valid until the samples are released.
 func (p *AudioProcessor) ChunkAudio(samples []float32, chunkDuration time.Duration, overlapDuration time.Duration, activityStartTime time.Time, inputPath string) []AudioChunk {
-	if len(samples) == 0 {
+	chunks := p.ChunkBounds(len(samples), chunkDuration, overlapDuration, activityStartTime, inputPath)
+	for i := range chunks {
+		start, end := chunks[i].StartSample, chunks[i].EndSample
+		chunks[i].Samples = samples[start:end:end]
+	}
+	return chunks
+}
+
+// ChunkBounds computes the chunks ChunkAudio would produce for a recording of
+// totalSamples samples without copying any audio
+func (p *AudioProcessor) ChunkBounds(totalSamples int, chunkDuration time.Duration, overlapDuration time.Duration, activityStartTime time.Time, inputPath string) []AudioChunk {
+	if totalSamples == 0 {
 		return []AudioChunk{}
 	}
 	
@@ -218,10 +255,10 @@ func (p *AudioProcessor) ChunkAudio(samples []float32, chunkDuration time.Durati
 	var chunks []AudioChunk
 	chunkIndex := 0
 	
-	for start := 0; start < len(samples); start += (chunkSamples - overlapSamples) {
+	for start := 0; start < totalSamples; start += (chunkSamples - overlapSamples) {
 		end := start + chunkSamples
-		if end > len(samples) {
-			end = len(samples)
+		if end > totalSamples {
+			end = totalSamples
 		}
 		
 		// Skip tiny chunks at the end
@@ -229,20 +266,18 @@ func (p *AudioProcessor) ChunkAudio(samples []float32, chunkDuration time.Durati
 			break
 		}
 		
-		chunkSamples := make([]float32, end-start)
-		copy(chunkSamples, samples[start:end])
-		
 		startTime := float64(start) / float64(p.sampleRate)
 		endTime := float64(end) / float64(p.sampleRate)
 		
 		chunk := AudioChunk{
-			Samples:           chunkSamples,
 			StartTime:         startTime,
 			EndTime:           endTime,
 			SampleRate:        p.sampleRate,
 			ChunkIndex:        chunkIndex,
 			OriginalPath:      inputPath,
 			ActivityStartTime: activityStartTime,
+			StartSample:       start,
+			EndSample:         end,
 		}
 		
 		chunks = append(chunks, chunk)
@@ -259,7 +294,8 @@ func (p *AudioProcessor) ChunkAudio(samples []float32, chunkDuration time.Durati
 	return chunks
 }
 
-// NormalizeAudio applies audio normalization to improve transcription quality
+// NormalizeAudio applies audio normalization to improve transcription
+// quality, scaling the samples in place
 func (p *AudioProcessor) NormalizeAudio(samples []float32) []float32 {
 	if len(samples) == 0 {
 		return samples
@@ -283,15 +319,15 @@ func (p *AudioProcessor) NormalizeAudio(samples []float32) []float32 {
 	targetLevel := float32(0.7)
 	factor := targetLevel / maxAmp
 	
-	normalized := make([]float32, len(samples))
-	for i, sample := range samples {
-		normalized[i] = sample * factor
+	for i := range samples {
+		samples[i] *= factor
 	}
 	
-	return normalized
+	return samples
 }
 
-// RemoveSilence removes silence from beginning and end of audio
+// RemoveSilence removes silence from beginning and end of audio, moving the
+// rest to the start of samples so the buffer can still be released
 func (p *AudioProcessor) RemoveSilence(samples []float32, threshold float32) []float32 {
 	if len(samples) == 0 {
 		return samples
@@ -325,7 +361,24 @@ func (p *AudioProcessor) RemoveSilence(samples []float32, threshold float32) []f
 	start = int(math.Max(0, float64(start-padding)))
 	end = int(math.Min(float64(len(samples)-1), float64(end+padding)))
 	
-	return samples[start:end+1]
+	n := copy(samples, samples[start:end+1])
+	return samples[:n]
+}
+
+// AnalyzeSpectrum runs a single STFT pass over samples with Whisper's framing
+// and hands every frame to all consumers. It returns the number of frames.
+func (p *AudioProcessor) AnalyzeSpectrum(samples []float32, consumers ...dsp.FrameConsumer) (int, error) {
+	config := dsp.WhisperSTFTConfig()
+	config.SampleRate = p.sampleRate
+
+	stft, err := dsp.NewSTFT(config, consumers...)
+	if err != nil {
+		return 0, fmt.Errorf("failed to create STFT: %w", err)
+	}
+
+	frames := stft.Push(samples)
+	frames += stft.Flush()
+	return frames, nil
 }
 
 // GetAudioDuration calculates the duration of audio samples
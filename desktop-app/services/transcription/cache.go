@@ -5,11 +5,13 @@ import (
 	"fmt"
 	"io"
 	"os"
+	"sort"
 	"sync"
 	"time"
 
 	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
 	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/services/memory"
 	"github.com/sirupsen/logrus"
 )
 
@@ -22,6 +24,7 @@ type TranscriptionCache struct {
 	maxCacheSize   int
 	cleanupTicker  *time.Ticker
 	cleanupStop    chan struct{}
+	memory         *memory.Consumer
 }
 
 // CachedTranscription represents a cached transcription result
@@ -33,8 +36,12 @@ type CachedTranscription struct {
 	CachedAt     time.Time                 `json:"cached_at"`
 	LastAccessed time.Time                 `json:"last_accessed"`
 	AccessCount  int                       `json:"access_count"`
+	bytes        int64                     // Reserved with the memory governor
 }
 
+// chunkOverhead approximates the memory of a cached chunk besides its text
+const chunkOverhead = 256
+
 // NewTranscriptionCache creates a new transcription cache
 func NewTranscriptionCache(maxCacheSize int, logger *logrus.Logger) *TranscriptionCache {
 	cache := &TranscriptionCache{
@@ -44,6 +51,7 @@ func NewTranscriptionCache(maxCacheSize int, logger *logrus.Logger) *Transcripti
 		maxCacheSize:  maxCacheSize,
 		cleanupStop:   make(chan struct{}),
 	}
+	cache.memory = memory.Default().Register("transcription cache", memory.Heap, cache.evict)
 
 	// Start cleanup routine
 	cache.cleanupTicker = time.NewTicker(30 * time.Minute)
@@ -54,8 +62,8 @@ func NewTranscriptionCache(maxCacheSize int, logger *logrus.Logger) *Transcripti
 
 // GetCachedTranscription checks if a transcription is cached
 func (tc *TranscriptionCache) GetCachedTranscription(audioPath, modelID string, config models.TranscriptionConfig) ([]*models.TranscriptChunk, bool) {
-	tc.mutex.RLock()
-	defer tc.mutex.RUnlock()
+	tc.mutex.Lock()
+	defer tc.mutex.Unlock()
 
 	// Generate cache key
 	cacheKey, err := tc.generateCacheKey(audioPath, modelID, config)
@@ -72,7 +80,7 @@ func (tc *TranscriptionCache) GetCachedTranscription(audioPath, modelID string,
 	// Check if file hasn't changed
 	if !tc.isFileUnchanged(audioPath, cached.AudioHash) {
 		// File changed, remove from cache
-		delete(tc.audioHashes, cacheKey)
+		tc.removeEntry(cacheKey)
 		tc.logger.WithField("audio_path", audioPath).Debug("Cache invalidated due to file change")
 		return nil, false
 	}
@@ -122,8 +130,13 @@ func (tc *TranscriptionCache) CacheTranscription(audioPath, modelID string, conf
 		LastAccessed: time.Now(),
 		AccessCount:  1,
 	}
+	for _, chunk := range chunks {
+		cached.bytes += int64(len(chunk.Text)) + chunkOverhead
+	}
 
+	tc.removeEntry(cacheKey)
 	tc.audioHashes[cacheKey] = cached
+	tc.memory.Add(cached.bytes)
 
 	tc.logger.WithFields(logrus.Fields{
 		"audio_path": audioPath,
@@ -169,7 +182,7 @@ func (tc *TranscriptionCache) InvalidateAudioCache(audioPath string) {
 		if cached.AudioHash != "" {
 			// We'd need to store the original path to match properly
 			// For now, this is a simplified implementation
-			delete(tc.audioHashes, key)
+			tc.removeEntry(key)
 		}
 	}
 
@@ -298,7 +311,7 @@ func (tc *TranscriptionCache) cleanupOldEntries() {
 	}
 
 	for _, key := range toDelete {
-		delete(tc.audioHashes, key)
+		tc.removeEntry(key)
 	}
 
 	if len(toDelete) > 0 {
@@ -314,32 +327,54 @@ func (tc *TranscriptionCache) cleanupOldestEntries() {
 		entriesToRemove = 1
 	}
 
-	// Sort by last accessed time
-	type cacheEntry struct {
-		key    string
-		cached *CachedTranscription
+	// Remove oldest entries
+	entries := tc.entriesByAccess()
+	for i := 0; i < entriesToRemove && i < len(entries); i++ {
+		tc.removeEntry(entries[i])
 	}
 
-	var entries []cacheEntry
-	for key, cached := range tc.audioHashes {
-		entries = append(entries, cacheEntry{key, cached})
-	}
+	tc.logger.WithField("removed_entries", entriesToRemove).Debug("Removed oldest cache entries")
+}
 
-	// Simple sort by last accessed time (oldest first)
-	for i := 0; i < len(entries)-1; i++ {
-		for j := i + 1; j < len(entries); j++ {
-			if entries[i].cached.LastAccessed.After(entries[j].cached.LastAccessed) {
-				entries[i], entries[j] = entries[j], entries[i]
-			}
-		}
+// entriesByAccess returns the cache keys, least recently accessed first.
+// Callers hold the mutex.
+func (tc *TranscriptionCache) entriesByAccess() []string {
+	keys := make([]string, 0, len(tc.audioHashes))
+	for key := range tc.audioHashes {
+		keys = append(keys, key)
 	}
+	sort.Slice(keys, func(i, j int) bool {
+		return tc.audioHashes[keys[i]].LastAccessed.Before(tc.audioHashes[keys[j]].LastAccessed)
+	})
+	return keys
+}
 
-	// Remove oldest entries
-	for i := 0; i < entriesToRemove && i < len(entries); i++ {
-		delete(tc.audioHashes, entries[i].key)
+// removeEntry drops an entry and its memory reservation. Callers hold the mutex.
+func (tc *TranscriptionCache) removeEntry(key string) {
+	if cached, exists := tc.audioHashes[key]; exists {
+		delete(tc.audioHashes, key)
+		tc.memory.Release(cached.bytes)
 	}
+}
 
-	tc.logger.WithField("removed_entries", entriesToRemove).Debug("Removed oldest cache entries")
+// evict removes the least recently accessed entries until need bytes are
+// freed, for the memory governor
+func (tc *TranscriptionCache) evict(need int64) int64 {
+	tc.mutex.Lock()
+	defer tc.mutex.Unlock()
+
+	var freed int64
+	for _, key := range tc.entriesByAccess() {
+		if freed >= need {
+			break
+		}
+		freed += tc.audioHashes[key].bytes
+		tc.removeEntry(key)
+	}
+	if freed > 0 {
+		tc.logger.WithField("freed_bytes", freed).Debug("Evicted cached transcriptions for memory")
+	}
+	return freed
 }
 
 // Close shuts down the cache and releases resources
@@ -353,6 +388,8 @@ func (tc *TranscriptionCache) Close() error {
 	
 	tc.mutex.Lock()
 	tc.audioHashes = make(map[string]*CachedTranscription)
+	tc.memory.ReleaseAll()
+	tc.memory.Close()
 	tc.mutex.Unlock()
 
 	tc.logger.Info("Transcription cache closed")
@@ -0,0 +1,286 @@
+package transcription
+
+import (
+	"crypto/sha256"
+	"fmt"
+	"sync"
+	"time"
+	"unsafe"
+
+	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
+	"github.com/platformlabs-co/personal-assist/services/memory"
+)
+
+// EncoderCacheConfig sizes the encoder output cache
+type EncoderCacheConfig struct {
+	// MaxStates is the number of whisper states kept alive. Each holds the
+	// encoder output of one 30 s window plus its compute buffers, from tens of
+	// megabytes for tiny models to several hundred for large ones.
+	MaxStates int
+
+	// StateBytes is the memory of one state, reserved with the memory
+	// governor. Past the first state, an idle state is reused instead of
+	// allocating another when the budget is full.
+	StateBytes int64
+}
+
+// DefaultEncoderCacheConfig returns the default cache size
+func DefaultEncoderCacheConfig() EncoderCacheConfig {
+	return EncoderCacheConfig{
+		MaxStates: 2,
+	}
+}
+
+// MelFingerprint identifies the spectrogram a chunk is decoded from
+type MelFingerprint [sha256.Size]byte
+
+// NewMelFingerprint hashes a chunk's mel input
+func NewMelFingerprint(mel []float32) MelFingerprint {
+	if len(mel) == 0 {
+		return sha256.Sum256(nil)
+	}
+	return sha256.Sum256(unsafe.Slice((*byte)(unsafe.Pointer(&mel[0])), len(mel)*4))
+}
+
+// encoderKey identifies the encoder output of one window
+type encoderKey struct {
+	ModelID     string
+	Fingerprint MelFingerprint
+	Offset      int // First mel frame of the window
+}
+
+// encoderEntry is a whisper state holding the encoder output for key
+type encoderEntry struct {
+	key      encoderKey
+	state    *nativeState
+	valid    bool
+	inUse    bool
+	lastUsed time.Time
+}
+
+// EncoderCacheStats reports how often the encoder could be skipped
+type EncoderCacheStats struct {
+	Hits       int64         `json:"hits"`
+	Misses     int64         `json:"misses"`
+	Evictions  int64         `json:"evictions"`
+	EncodeTime time.Duration `json:"encode_time"`
+	States     int           `json:"states"`
+}
+
+// EncoderCache keeps the encoder output of recently decoded windows so the
+// decoder can run again over the same audio, with a different language,
+// temperature or prompt, without re-running the encoder. whisper.cpp does not
+// expose the encoder output outside a whisper_state, so entries are live
+// states and the cache only lives as long as the loaded model.
+type EncoderCache struct {
+	native  *nativeWhisper
+	modelID string
+	config  EncoderCacheConfig
+	memory  *memory.Consumer
+
+	mutex   sync.Mutex
+	entries []*encoderEntry
+	stats   EncoderCacheStats
+	closed  bool
+}
+
+// NewEncoderCache creates an encoder cache for a loaded model
+func NewEncoderCache(model whisper.Model, modelID string, config EncoderCacheConfig) (*EncoderCache, error) {
+	native, err := newNativeWhisper(model)
+	if err != nil {
+		return nil, err
+	}
+	if config.MaxStates < 1 {
+		config.MaxStates = 1
+	}
+
+	c := &EncoderCache{
+		native:  native,
+		modelID: modelID,
+		config:  config,
+	}
+	c.memory = memory.Default().Register("encoder cache", memory.Native, c.evict)
+	return c, nil
+}
+
+// acquire returns a state holding the encoder output of the window starting
+// at offset, encoding it on a miss with the given thread count. The entry
+// must be released after use.
+func (c *EncoderCache) acquire(fingerprint MelFingerprint, mel []float32, nMel, nLen, offset, threads int) (*encoderEntry, error) {
+	key := encoderKey{ModelID: c.modelID, Fingerprint: fingerprint, Offset: offset}
+
+	c.mutex.Lock()
+	if c.closed {
+		c.mutex.Unlock()
+		return nil, fmt.Errorf("encoder cache is closed")
+	}
+	for _, entry := range c.entries {
+		if entry.valid && !entry.inUse && entry.key == key {
+			entry.inUse = true
+			c.stats.Hits++
+			c.mutex.Unlock()
+			return entry, nil
+		}
+	}
+	c.stats.Misses++
+
+	entry := c.victim()
+	if entry == nil {
+		reserved := c.memory.TryReserve(c.config.StateBytes)
+		if !reserved {
+			entry = c.oldestIdle()
+		}
+		if entry == nil {
+			state, err := c.native.NewState()
+			if err != nil {
+				if reserved {
+					c.memory.Release(c.config.StateBytes)
+				}
+				c.mutex.Unlock()
+				return nil, err
+			}
+			if !reserved {
+				c.memory.Add(c.config.StateBytes)
+			}
+			entry = &encoderEntry{state: state}
+			c.entries = append(c.entries, entry)
+		} else if entry.valid {
+			c.stats.Evictions++
+		}
+	}
+	entry.key = key
+	entry.valid = false
+	entry.inUse = true
+	c.mutex.Unlock()
+
+	start := time.Now()
+	err := c.native.Encode(entry.state, mel, nMel, nLen, offset, threads)
+	elapsed := time.Since(start)
+
+	c.mutex.Lock()
+	c.stats.EncodeTime += elapsed
+	entry.valid = err == nil
+	c.mutex.Unlock()
+
+	if err != nil {
+		c.release(entry)
+		return nil, err
+	}
+	return entry, nil
+}
+
+// reserve keeps at least states states alive, one per stream decoding
+// concurrently, so streams do not free and reallocate states between windows
+func (c *EncoderCache) reserve(states int) {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+
+	if states > c.config.MaxStates {
+		c.config.MaxStates = states
+	}
+}
+
+// victim picks the least recently used idle state once the cache is full.
+// Callers hold the mutex.
+func (c *EncoderCache) victim() *encoderEntry {
+	if len(c.entries) < c.config.MaxStates {
+		return nil
+	}
+
+	oldest := c.oldestIdle()
+	if oldest != nil && oldest.valid {
+		c.stats.Evictions++
+	}
+	return oldest
+}
+
+// oldestIdle returns the least recently used state not in use, or nil.
+// Callers hold the mutex.
+func (c *EncoderCache) oldestIdle() *encoderEntry {
+	var oldest *encoderEntry
+	for _, entry := range c.entries {
+		if entry.inUse {
+			continue
+		}
+		if oldest == nil || entry.lastUsed.Before(oldest.lastUsed) {
+			oldest = entry
+		}
+	}
+	return oldest
+}
+
+// evict frees idle states, least recently used first, until need bytes are
+// freed, for the memory governor
+func (c *EncoderCache) evict(need int64) int64 {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+
+	var freed int64
+	for freed < need {
+		entry := c.oldestIdle()
+		if entry == nil {
+			break
+		}
+		if entry.valid {
+			c.stats.Evictions++
+		}
+		c.remove(entry)
+		freed += c.config.StateBytes
+	}
+	return freed
+}
+
+// remove frees a state and drops it from the cache. Callers hold the mutex.
+func (c *EncoderCache) remove(entry *encoderEntry) {
+	for i, other := range c.entries {
+		if other == entry {
+			c.entries = append(c.entries[:i], c.entries[i+1:]...)
+			break
+		}
+	}
+	entry.state.Free()
+	c.memory.Release(c.config.StateBytes)
+}
+
+// release returns a state to the cache, freeing it when the cache grew past
+// its size while every state was busy
+func (c *EncoderCache) release(entry *encoderEntry) {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+
+	entry.inUse = false
+	entry.lastUsed = time.Now()
+	if !c.closed && len(c.entries) <= c.config.MaxStates {
+		return
+	}
+	c.remove(entry)
+}
+
+// Stats returns the cache counters
+func (c *EncoderCache) Stats() EncoderCacheStats {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+
+	stats := c.stats
+	stats.States = len(c.entries)
+	return stats
+}
+
+// Close frees every idle state; states in use are freed when released
+func (c *EncoderCache) Close() {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+
+	c.closed = true
+	remaining := c.entries[:0]
+	for _, entry := range c.entries {
+		if entry.inUse {
+			remaining = append(remaining, entry)
+			continue
+		}
+		entry.state.Free()
+		c.memory.Release(c.config.StateBytes)
+	}
+	c.entries = remaining
+	c.memory.Close()
+}
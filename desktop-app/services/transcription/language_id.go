@@ -0,0 +1,206 @@
+package transcription
+
+import (
+	"math"
+
+	"github.com/sirupsen/logrus"
+)
+
+const (
+	// A chunk decoded with the locked language whose confidence falls below
+	// languageRecheckConfidence has its language detected again, and is
+	// decoded in the detected language when that is at least
+	// languageSwitchProbability likely
+	languageRecheckConfidence = 0.4
+	languageSwitchProbability = 0.5
+)
+
+// LanguageProbs decodes start-of-transcript on a state holding encoder
+// output and fills probs with the probability of each language ID. logits
+// must hold the vocabulary and probs one value per language.
+func (n *nativeWhisper) LanguageProbs(state *nativeState, threads int, logits []float32, probs []float64) error {
+	vocab := n.Vocabulary()
+	if err := n.Decode(state, []int32{vocab.SOT}, 0, threads, logits); err != nil {
+		return err
+	}
+
+	for id, token := range vocab.Languages {
+		probs[id] = float64(logits[token])
+	}
+	logSoftmax(probs)
+	for id := range probs {
+		probs[id] = math.Exp(probs[id])
+	}
+	return nil
+}
+
+// identifyLanguage is the language-ID pre-pass of a recording. It encodes up
+// to config.LanguageWindows windows of speech, the first starting where speech
+// starts and the others spread over the rest, and returns the language with
+// the highest summed probability together with its mean probability.
+// Chunks are then decoded in that language instead of each detecting its own.
+func (wp *WhisperProcessor) identifyLanguage(mel *MelSpectrogram) (string, float64, error) {
+	vocab := wp.native.Vocabulary()
+	if !vocab.Multilingual {
+		return "en", 1, nil
+	}
+
+	starts := languageSampleStarts(mel.Speech, wp.config.LanguageWindows)
+	if len(starts) == 0 {
+		return "", 0, nil
+	}
+
+	threads := streamThreads(1)
+	logits := make([]float32, vocab.Size)
+	probs := make([]float64, len(vocab.Languages))
+	total := make([]float64, len(vocab.Languages))
+	var buffer []float32
+
+	for _, start := range starts {
+		end := start + melChunkSamples
+		if end > mel.Samples {
+			end = mel.Samples
+		}
+		input, nLen, _, err := mel.ChunkMel(start, end, buffer)
+		if err != nil {
+			return "", 0, err
+		}
+		buffer = input
+
+		err = wp.withEncodedState(input, mel.NMel, nLen, threads, func(state *nativeState) error {
+			return wp.native.LanguageProbs(state, threads, logits, probs)
+		})
+		if err != nil {
+			return "", 0, err
+		}
+		for id, p := range probs {
+			total[id] += p
+		}
+	}
+
+	best := 0
+	for id := range total {
+		if total[id] > total[best] {
+			best = id
+		}
+	}
+	return nativeLanguageCode(best), total[best] / float64(len(starts)), nil
+}
+
+// recheckLanguage handles a chunk that decoded poorly in the recording's
+// locked language, which is what a switch of language in a meeting looks
+// like. The chunk's encoder output is normally still cached, so detection
+// costs one decoder step; only a confident detection of another language
+// pays for decoding the chunk again.
+func (wp *WhisperProcessor) recheckLanguage(stream *melStream, chunk AudioChunk, input []float32, nMel, nLen, audioFrames int, result *nativeResult) *nativeResult {
+	stream.report.LanguageChecks++
+
+	vocab := wp.native.Vocabulary()
+	probs := make([]float64, len(vocab.Languages))
+	err := wp.withEncodedState(input, nMel, nLen, stream.decoder.threads, func(state *nativeState) error {
+		return wp.native.LanguageProbs(state, stream.decoder.threads, stream.decoder.logits, probs)
+	})
+	if err != nil {
+		wp.logger.WithError(err).WithField("chunk_index", chunk.ChunkIndex).Warn("Failed to detect chunk language")
+		return result
+	}
+
+	best := 0
+	for id := range probs {
+		if probs[id] > probs[best] {
+			best = id
+		}
+	}
+	language := nativeLanguageCode(best)
+	if language == wp.language || probs[best] < languageSwitchProbability {
+		return result
+	}
+
+	config := wp.config
+	config.Language = language
+	switched, err := wp.decodeChunkMel(stream, chunk, input, nMel, nLen, audioFrames, config)
+	if err != nil || meanConfidence(switched.Segments) <= meanConfidence(result.Segments) {
+		return result
+	}
+
+	stream.report.LanguageSwitches++
+	wp.logger.WithFields(logrus.Fields{
+		"chunk_index": chunk.ChunkIndex,
+		"locked":      wp.language,
+		"detected":    language,
+	}).Debug("Chunk decoded in a different language")
+	return switched
+}
+
+// withEncodedState runs fn on a state holding the encoder output of a mel
+// input's first window, taken from the encoder cache when there is one
+func (wp *WhisperProcessor) withEncodedState(input []float32, nMel, nLen, threads int, fn func(state *nativeState) error) error {
+	if wp.cache != nil {
+		entry, err := wp.cache.acquire(NewMelFingerprint(input), input, nMel, nLen, 0, threads)
+		if err != nil {
+			return err
+		}
+		defer wp.cache.release(entry)
+		return fn(entry.state)
+	}
+
+	state, err := wp.native.NewState()
+	if err != nil {
+		return err
+	}
+	defer state.Free()
+	if err := wp.native.Encode(state, input, nMel, nLen, 0, threads); err != nil {
+		return err
+	}
+	return fn(state)
+}
+
+// languageSampleStarts returns the first samples of up to windows
+// non-overlapping windows of speech, evenly spaced in speech time
+func languageSampleStarts(spans []SpeechSpan, windows int) []int {
+	speech := 0
+	for _, span := range spans {
+		speech += span.End - span.Start
+	}
+	if speech == 0 || windows < 1 {
+		return nil
+	}
+
+	var starts []int
+	last := -windowFrames
+	for k := 0; k < windows; k++ {
+		target := k * speech / windows
+		frame := spans[len(spans)-1].Start
+		for _, span := range spans {
+			if target < span.End-span.Start {
+				frame = span.Start + target
+				break
+			}
+			target -= span.End - span.Start
+		}
+
+		if frame < last+windowFrames {
+			continue
+		}
+		starts = append(starts, frame*melHopLength)
+		last = frame
+	}
+	return starts
+}
+
+// meanConfidence is the duration-weighted confidence of the segments with text
+func meanConfidence(segments []nativeSegment) float64 {
+	var confidence, duration float64
+	for _, segment := range segments {
+		if segment.Text == "" {
+			continue
+		}
+		length := math.Max(segment.End-segment.Start, 0.01)
+		confidence += segment.Confidence * length
+		duration += length
+	}
+	if duration == 0 {
+		return 0
+	}
+	return confidence / duration
+}
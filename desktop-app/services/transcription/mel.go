@@ -0,0 +1,550 @@
+package transcription
+
+import (
+	"bufio"
+	"bytes"
+	"crypto/sha256"
+	"encoding/binary"
+	"fmt"
+	"io"
+	"math"
+	"os"
+	"path/filepath"
+
+	"github.com/platformlabs-co/personal-assist/services/dsp"
+	"github.com/sirupsen/logrus"
+)
+
+const (
+	// Whisper front end constants (whisper.cpp: WHISPER_N_FFT, WHISPER_HOP_LENGTH, WHISPER_CHUNK_SIZE)
+	melSampleRate   = 16000
+	melHopLength    = 160
+	melChunkSamples = 30 * melSampleRate
+
+	// ggmlMagic starts every ggml Whisper model file
+	ggmlMagic = 0x67676d6c
+
+	// melCacheMagic identifies a mel cache file, melCacheVersion its layout
+	melCacheMagic   = "PAMELCH1"
+	melCacheVersion = 3
+
+	// melCacheDenoised flags a cache computed from noise suppressed audio
+	melCacheDenoised = 1
+)
+
+// MelFilters is the mel filter bank embedded in a Whisper model file
+type MelFilters struct {
+	NMel  int
+	NFFT  int       // Frequency bins per filter (n_fft/2+1)
+	Data  []float32 // NMel rows of NFFT weights
+	Hash  [8]byte   // Identifies the bank in cache files
+	spans [][2]int  // Non-zero bin range of each filter
+}
+
+// LoadMelFilters reads the mel filter bank from a ggml Whisper model file,
+// so the front end uses exactly the weights whisper.cpp uses
+func LoadMelFilters(modelPath string) (*MelFilters, error) {
+	file, err := os.Open(modelPath)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open model file: %w", err)
+	}
+	defer file.Close()
+
+	reader := bufio.NewReader(file)
+
+	// magic, then 11 hyperparameters (n_vocab ... n_mels, ftype), then the filters
+	var header [12]int32
+	if err := binary.Read(reader, binary.LittleEndian, &header); err != nil {
+		return nil, fmt.Errorf("failed to read model header: %w", err)
+	}
+	if uint32(header[0]) != ggmlMagic {
+		return nil, fmt.Errorf("not a ggml Whisper model: %s", modelPath)
+	}
+
+	var dims [2]int32
+	if err := binary.Read(reader, binary.LittleEndian, &dims); err != nil {
+		return nil, fmt.Errorf("failed to read mel filter size: %w", err)
+	}
+	nMel, nFFT := int(dims[0]), int(dims[1])
+	if nMel != int(header[10]) || nFFT != dsp.WhisperSTFTConfig().FFTSize/2+1 {
+		return nil, fmt.Errorf("unexpected mel filter bank %dx%d", nMel, nFFT)
+	}
+
+	filters := &MelFilters{
+		NMel: nMel,
+		NFFT: nFFT,
+		Data: make([]float32, nMel*nFFT),
+	}
+	if err := binary.Read(reader, binary.LittleEndian, filters.Data); err != nil {
+		return nil, fmt.Errorf("failed to read mel filters: %w", err)
+	}
+
+	raw := new(bytes.Buffer)
+	binary.Write(raw, binary.LittleEndian, filters.Data)
+	sum := sha256.Sum256(raw.Bytes())
+	copy(filters.Hash[:], sum[:])
+
+	// Each triangular filter covers a handful of bins; skip the zeros
+	filters.spans = make([][2]int, nMel)
+	for j := 0; j < nMel; j++ {
+		row := filters.Data[j*nFFT : (j+1)*nFFT]
+		start, end := 0, nFFT
+		for start < end && row[start] == 0 {
+			start++
+		}
+		for end > start && row[end-1] == 0 {
+			end--
+		}
+		filters.spans[j] = [2]int{start, end}
+	}
+
+	return filters, nil
+}
+
+// MelSpectrogram holds the log10 mel energies of a whole recording, one row
+// of NMel values per 10ms frame. Values are not yet normalized: Whisper
+// clamps and scales relative to the maximum of each 30s window, which
+// ChunkMel applies per chunk.
+type MelSpectrogram struct {
+	NMel    int
+	Frames  int
+	Samples int // 16kHz samples the spectrogram was computed from
+	Data    []float32
+	Edges   map[melEdge][]float32 // Frames at chunk boundaries, see ComputeEdges
+	Speech  []SpeechSpan          // Frames with speech, see DetectSpeech
+
+	Denoised bool // Computed from noise suppressed audio
+}
+
+// melEdge identifies the frames at a chunk boundary. whisper.cpp pads each
+// chunk on its own (reflection before the start, zeros after the end), so
+// the frames whose window crosses a boundary differ from the frames of the
+// continuous recording.
+type melEdge struct {
+	Sample int
+	End    bool
+}
+
+// melEdgeFrames returns the first recording frame and the number of frames
+// whose window crosses a chunk boundary at sample
+func melEdgeFrames(sample int, end bool) (int, int) {
+	half := dsp.WhisperSTFTConfig().FFTSize / 2
+	if !end {
+		return sample / melHopLength, (half + melHopLength - 1) / melHopLength
+	}
+	first := (sample-half)/melHopLength + 1
+	last := (sample + half + melHopLength - 1) / melHopLength
+	return first, last - first
+}
+
+// melAccumulator turns STFT power frames into log10 mel rows
+type melAccumulator struct {
+	filters *MelFilters
+	rows    []float32
+}
+
+// ConsumeFrame appends the log mel energies of one frame
+func (m *melAccumulator) ConsumeFrame(frame *dsp.Frame) {
+	for j := 0; j < m.filters.NMel; j++ {
+		span := m.filters.spans[j]
+		weights := m.filters.Data[j*m.filters.NFFT:]
+
+		// whisper.cpp accumulates in double
+		var sum float64
+		for k := span[0]; k < span[1]; k++ {
+			sum += float64(frame.Power[k]) * float64(weights[k])
+		}
+		m.rows = append(m.rows, float32(math.Log10(math.Max(sum, 1e-10))))
+	}
+}
+
+// MelFrontend computes, caches and slices log-mel spectrograms for Whisper
+type MelFrontend struct {
+	filters *MelFilters
+	logger  *logrus.Logger
+}
+
+// NewMelFrontend creates a front end using the filter bank of a model file
+func NewMelFrontend(modelPath string, logger *logrus.Logger) (*MelFrontend, error) {
+	filters, err := LoadMelFilters(modelPath)
+	if err != nil {
+		return nil, err
+	}
+	return &MelFrontend{filters: filters, logger: logger}, nil
+}
+
+// NMel returns the number of mel bins the model expects (80, or 128 for large-v3)
+func (f *MelFrontend) NMel() int {
+	return f.filters.NMel
+}
+
+// Compute runs one STFT pass over a recording. Frames are centered every
+// 10ms with the start reflect-padded like whisper.cpp, and continue until
+// the last window that still overlaps the audio.
+func (f *MelFrontend) Compute(samples []float32) (*MelSpectrogram, error) {
+	rows, err := f.melRows(dsp.WhisperSTFTConfig(), len(samples)/melHopLength+3, samples, make([]float32, dsp.WhisperSTFTConfig().FFTSize))
+	if err != nil {
+		return nil, err
+	}
+
+	return &MelSpectrogram{
+		NMel:    f.filters.NMel,
+		Frames:  len(rows) / f.filters.NMel,
+		Samples: len(samples),
+		Data:    rows,
+		Edges:   make(map[melEdge][]float32),
+	}, nil
+}
+
+// ComputeEdges stores the boundary frames of each chunk exactly as
+// whisper.cpp computes them from the chunk's own samples, so cached input
+// for those chunks matches whisper_pcm_to_mel within float rounding
+func (f *MelFrontend) ComputeEdges(mel *MelSpectrogram, samples []float32, chunks []AudioChunk) error {
+	config := dsp.WhisperSTFTConfig()
+	half := config.FFTSize / 2
+
+	for _, chunk := range chunks {
+		start, end := chunk.StartSample, chunk.EndSample
+		if start%melHopLength != 0 || end-start < config.FFTSize+half {
+			continue
+		}
+
+		if key := (melEdge{Sample: start}); start > 0 && mel.Edges[key] == nil {
+			// Centered STFT over the chunk start reflects the chunk's own samples
+			_, count := melEdgeFrames(start, false)
+			rows, err := f.melRows(config, count+1, samples[start:start+count*melHopLength+half])
+			if err != nil {
+				return err
+			}
+			mel.Edges[key] = rows[:count*f.filters.NMel]
+		}
+
+		if key := (melEdge{Sample: end, End: true}); end < mel.Samples && mel.Edges[key] == nil {
+			// Uncentered frames from the first crossing window, zeros past the end
+			first, count := melEdgeFrames(end, true)
+			uncentered := config
+			uncentered.Center = false
+			rows, err := f.melRows(uncentered, count+1, samples[first*melHopLength-half:end], make([]float32, config.FFTSize))
+			if err != nil {
+				return err
+			}
+			mel.Edges[key] = rows[:count*f.filters.NMel]
+		}
+	}
+	return nil
+}
+
+// melRows pushes blocks through an STFT and returns the log mel rows of the
+// frames it emits
+func (f *MelFrontend) melRows(config dsp.STFTConfig, expectedFrames int, blocks ...[]float32) ([]float32, error) {
+	accumulator := &melAccumulator{
+		filters: f.filters,
+		rows:    make([]float32, 0, expectedFrames*f.filters.NMel),
+	}
+
+	stft, err := dsp.NewSTFT(config, accumulator)
+	if err != nil {
+		return nil, fmt.Errorf("failed to create STFT: %w", err)
+	}
+
+	// Push in slices so the STFT never buffers a copy of a whole recording
+	for _, block := range blocks {
+		for offset := 0; offset < len(block); offset += melChunkSamples {
+			end := offset + melChunkSamples
+			if end > len(block) {
+				end = len(block)
+			}
+			stft.Push(block[offset:end])
+		}
+	}
+	return accumulator.rows, nil
+}
+
+// ChunkMel returns the normalized mel input whisper_set_mel expects for the
+// samples [start, end) of the recording, laid out bin-major and padded with
+// 30s of silence exactly like whisper_pcm_to_mel. It also returns the frame
+// count of the padded input and the number of frames holding audio, which
+// bounds decoding. start must be a multiple of the 10ms hop so chunk frames
+// line up with recording frames. Boundary frames come from Edges when the
+// chunk was seen by ComputeEdges; otherwise they see the neighbouring audio
+// instead of whisper.cpp's per-chunk padding.
+func (m *MelSpectrogram) ChunkMel(start, end int, buffer []float32) ([]float32, int, int, error) {
+	if start%melHopLength != 0 || start < 0 || end > m.Samples || end <= start {
+		return nil, 0, 0, fmt.Errorf("chunk [%d, %d) is not aligned to the mel frames", start, end)
+	}
+
+	n := end - start
+	half := dsp.WhisperSTFTConfig().FFTSize / 2
+	nLen := (n + melChunkSamples) / melHopLength
+	audioFrames := 1 + (n+half-2*half)/melHopLength
+	if audioFrames < 1 {
+		audioFrames = 1
+	}
+	// Frames whose window still overlaps the chunk audio
+	covered := (n + half + melHopLength - 1) / melHopLength
+	first := start / melHopLength
+
+	startEdge, startFirst, startCount := m.Edges[melEdge{Sample: start}], 0, 0
+	if startEdge != nil {
+		startFirst, startCount = melEdgeFrames(start, false)
+	}
+	endEdge, endFirst, endCount := m.Edges[melEdge{Sample: end, End: true}], 0, 0
+	if endEdge != nil {
+		endFirst, endCount = melEdgeFrames(end, true)
+	}
+
+	size := m.NMel * nLen
+	if cap(buffer) < size {
+		buffer = make([]float32, size)
+	}
+	mel := buffer[:size]
+
+	// Silence pads to log10(1e-10)
+	maxValue := float32(-10)
+	for j := 0; j < m.NMel; j++ {
+		row := mel[j*nLen : (j+1)*nLen]
+		for i := range row {
+			value := float32(-10)
+			frame := first + i
+			switch {
+			case i >= covered:
+			case startEdge != nil && frame >= startFirst && frame < startFirst+startCount:
+				value = startEdge[(frame-startFirst)*m.NMel+j]
+			case endEdge != nil && frame >= endFirst && frame < endFirst+endCount:
+				value = endEdge[(frame-endFirst)*m.NMel+j]
+			case frame < m.Frames:
+				value = m.Data[frame*m.NMel+j]
+			}
+			row[i] = value
+			if value > maxValue {
+				maxValue = value
+			}
+		}
+	}
+
+	floor := maxValue - 8
+	for i, value := range mel {
+		if value < floor {
+			value = floor
+		}
+		mel[i] = (value + 4) / 4
+	}
+
+	return mel, nLen, audioFrames, nil
+}
+
+// MelCachePaths returns the cache files that may exist for an audio file
+func MelCachePaths(audioPath string) []string {
+	return []string{melCachePath(audioPath, 80), melCachePath(audioPath, 128)}
+}
+
+// melCachePath returns the cache file of an audio file for a bin count
+func melCachePath(audioPath string, nMel int) string {
+	return fmt.Sprintf("%s.mel%d", audioPath, nMel)
+}
+
+// melCacheHeader precedes the frames in a cache file, which are followed by
+// the edges and the speech spans. The audio file's size and modification
+// time and the filter bank hash invalidate stale caches.
+type melCacheHeader struct {
+	Magic      [8]byte
+	Version    uint32
+	NMel       uint32
+	Frames     uint32
+	Samples    uint32
+	Edges      uint32
+	Speech     uint32
+	Flags      uint32 // melCacheDenoised
+	AudioSize  int64
+	AudioMtime int64
+	FilterHash [8]byte
+}
+
+// melCacheEdge precedes the frames of one edge in a cache file
+type melCacheEdge struct {
+	Sample uint32
+	End    uint32
+	Frames uint32
+}
+
+// LoadCache returns the cached spectrogram of an audio file, or false when
+// there is no cache or it no longer matches the file or model
+func (f *MelFrontend) LoadCache(audioPath string) (*MelSpectrogram, bool) {
+	info, err := os.Stat(audioPath)
+	if err != nil {
+		return nil, false
+	}
+
+	file, err := os.Open(melCachePath(audioPath, f.filters.NMel))
+	if err != nil {
+		return nil, false
+	}
+	defer file.Close()
+
+	reader := bufio.NewReader(file)
+	var header melCacheHeader
+	if err := binary.Read(reader, binary.LittleEndian, &header); err != nil {
+		return nil, false
+	}
+	if string(header.Magic[:]) != melCacheMagic || header.Version != melCacheVersion ||
+		int(header.NMel) != f.filters.NMel || header.FilterHash != f.filters.Hash ||
+		header.AudioSize != info.Size() || header.AudioMtime != info.ModTime().UnixNano() {
+		return nil, false
+	}
+
+	mel := &MelSpectrogram{
+		NMel:    int(header.NMel),
+		Frames:  int(header.Frames),
+		Samples: int(header.Samples),
+		Data:    make([]float32, int(header.NMel)*int(header.Frames)),
+		Edges:   make(map[melEdge][]float32, header.Edges),
+
+		Denoised: header.Flags&melCacheDenoised != 0,
+	}
+	if err := readMelCache(reader, mel, int(header.Edges), int(header.Speech)); err != nil {
+		f.logger.WithError(err).WithField("audio_path", audioPath).Warn("Discarding truncated mel cache")
+		return nil, false
+	}
+
+	return mel, true
+}
+
+// SaveCache writes the spectrogram next to its audio file
+func (f *MelFrontend) SaveCache(audioPath string, mel *MelSpectrogram) error {
+	info, err := os.Stat(audioPath)
+	if err != nil {
+		return fmt.Errorf("failed to stat audio file: %w", err)
+	}
+
+	header := melCacheHeader{
+		Version:    melCacheVersion,
+		NMel:       uint32(mel.NMel),
+		Frames:     uint32(mel.Frames),
+		Samples:    uint32(mel.Samples),
+		Edges:      uint32(len(mel.Edges)),
+		Speech:     uint32(len(mel.Speech)),
+		AudioSize:  info.Size(),
+		AudioMtime: info.ModTime().UnixNano(),
+		FilterHash: f.filters.Hash,
+	}
+	if mel.Denoised {
+		header.Flags |= melCacheDenoised
+	}
+	copy(header.Magic[:], melCacheMagic)
+
+	path := melCachePath(audioPath, mel.NMel)
+	tempFile, err := os.CreateTemp(filepath.Dir(path), filepath.Base(path)+".*.tmp")
+	if err != nil {
+		return fmt.Errorf("failed to create mel cache: %w", err)
+	}
+	defer os.Remove(tempFile.Name())
+
+	writer := bufio.NewWriter(tempFile)
+	if err := writeMelCache(writer, &header, mel); err != nil {
+		tempFile.Close()
+		return fmt.Errorf("failed to write mel cache: %w", err)
+	}
+	if err := tempFile.Close(); err != nil {
+		return fmt.Errorf("failed to write mel cache: %w", err)
+	}
+
+	if err := os.Rename(tempFile.Name(), path); err != nil {
+		return fmt.Errorf("failed to install mel cache: %w", err)
+	}
+	return nil
+}
+
+// writeMelCache writes the header, frames, edges and speech spans and flushes the writer
+func writeMelCache(writer *bufio.Writer, header *melCacheHeader, mel *MelSpectrogram) error {
+	if err := binary.Write(writer, binary.LittleEndian, header); err != nil {
+		return err
+	}
+	if err := binary.Write(writer, binary.LittleEndian, mel.Data); err != nil {
+		return err
+	}
+	for key, rows := range mel.Edges {
+		edge := melCacheEdge{Sample: uint32(key.Sample), Frames: uint32(len(rows) / mel.NMel)}
+		if key.End {
+			edge.End = 1
+		}
+		if err := binary.Write(writer, binary.LittleEndian, &edge); err != nil {
+			return err
+		}
+		if err := binary.Write(writer, binary.LittleEndian, rows); err != nil {
+			return err
+		}
+	}
+	for _, span := range mel.Speech {
+		if err := binary.Write(writer, binary.LittleEndian, [2]uint32{uint32(span.Start), uint32(span.End)}); err != nil {
+			return err
+		}
+	}
+	return writer.Flush()
+}
+
+// readMelCache reads the frames, edges and speech spans following the header
+func readMelCache(reader io.Reader, mel *MelSpectrogram, edges, speech int) error {
+	if err := binary.Read(reader, binary.LittleEndian, mel.Data); err != nil {
+		return err
+	}
+	for i := 0; i < edges; i++ {
+		var edge melCacheEdge
+		if err := binary.Read(reader, binary.LittleEndian, &edge); err != nil {
+			return err
+		}
+		if edge.Frames > 8 {
+			return fmt.Errorf("invalid mel cache edge of %d frames", edge.Frames)
+		}
+		rows := make([]float32, int(edge.Frames)*mel.NMel)
+		if err := binary.Read(reader, binary.LittleEndian, rows); err != nil {
+			return err
+		}
+		mel.Edges[melEdge{Sample: int(edge.Sample), End: edge.End != 0}] = rows
+	}
+	if speech > mel.Frames {
+		return fmt.Errorf("invalid mel cache with %d speech spans", speech)
+	}
+	for i := 0; i < speech; i++ {
+		var span [2]uint32
+		if err := binary.Read(reader, binary.LittleEndian, &span); err != nil {
+			return err
+		}
+		mel.Speech = append(mel.Speech, SpeechSpan{Start: int(span[0]), End: int(span[1])})
+	}
+	return nil
+}
+
+// melFromRecording returns a recording's spectrogram from its cache, or
+// decodes the audio, computes the spectrogram with the boundary frames of
+// the chunks chunkBounds returns for it and its speech spans, and caches it.
+// Every model with the same filter bank shares the cached result, as long as
+// it was computed with the processor's noise suppression setting.
+func (f *MelFrontend) melFromRecording(audioPath string, processor *AudioProcessor, chunkBounds func(totalSamples int) []AudioChunk) (*MelSpectrogram, bool, error) {
+	if mel, ok := f.LoadCache(audioPath); ok && mel.Denoised == processor.NoiseSuppression() {
+		return mel, true, nil
+	}
+
+	samples, err := processor.PrepareForWhisper(audioPath)
+	if err != nil {
+		return nil, false, fmt.Errorf("failed to prepare audio: %w", err)
+	}
+	defer processor.ReleaseSamples(samples)
+	if isValid, message := processor.ValidateAudioQuality(samples); !isValid {
+		return nil, false, fmt.Errorf("audio quality validation failed: %s", message)
+	}
+
+	mel, err := f.Compute(samples)
+	if err != nil {
+		return nil, false, err
+	}
+	if err := f.ComputeEdges(mel, samples, chunkBounds(len(samples))); err != nil {
+		return nil, false, err
+	}
+	mel.Speech = DetectSpeech(mel)
+	mel.Denoised = processor.NoiseSuppression()
+
+	if err := f.SaveCache(audioPath, mel); err != nil {
+		f.logger.WithError(err).WithField("audio_path", audioPath).Warn("Failed to write mel cache")
+	}
+	return mel, false, nil
+}
@@ -0,0 +1,425 @@
+package transcription
+
+import (
+	"fmt"
+	"math"
+	"math/rand"
+	"strings"
+
+	"github.com/platformlabs-co/personal-assist/models"
+)
+
+const (
+	windowFrames         = 3000 // Mel frames in one 30 s encoder window
+	timestampFrames      = 2    // Mel frames per timestamp token (20 ms)
+	maxInitialTimestamp  = 50   // First timestamp of a window is at most 1 s
+	logProbThreshold     = -1.0
+	entropyThreshold     = 2.4
+	temperatureIncrement = 0.2
+)
+
+// decodedToken is one token picked by the decoder
+type decodedToken struct {
+	ID   int32
+	P    float64
+	LogP float64
+}
+
+// windowResult is the best sequence decoded from one encoder window
+type windowResult struct {
+	Tokens       []decodedToken
+	NoSpeechProb float64
+	AvgLogProb   float64
+	Temperature  float64
+}
+
+// melDecoder runs whisper's decoding loop on top of whisper_decode, so the
+// encoder output of a window can come from the encoder cache. It follows
+// whisper_full: timestamp rules, temperature fallback on repetitive or
+// unlikely output, and no-speech detection.
+//
+// Steps are strictly one token each. Speculative decoding, where a small
+// model drafts several tokens that this model checks in one pass, needs the
+// logits of every position in the pass. whisper_decode only returns those of
+// the last token (whisper_batch_prep_legacy flags no other row), so checking
+// k drafted tokens would still take k passes.
+type melDecoder struct {
+	native  *nativeWhisper
+	vocab   *nativeVocabulary
+	cache   *EncoderCache
+	threads int
+	logits  []float32
+	work    []float64
+}
+
+// newMelDecoder creates a decoder reading encoder output from cache. Each
+// decoder owns its buffers, so decoders on one cache can run concurrently.
+func newMelDecoder(cache *EncoderCache, threads int) *melDecoder {
+	vocab := cache.native.Vocabulary()
+	return &melDecoder{
+		native:  cache.native,
+		vocab:   vocab,
+		cache:   cache,
+		threads: threads,
+		logits:  make([]float32, vocab.Size),
+		work:    make([]float64, vocab.Size),
+	}
+}
+
+// Transcribe decodes a chunk's normalized mel input window by window, reusing
+// cached encoder output when the same input was encoded before
+func (d *melDecoder) Transcribe(mel []float32, nMel, nLen, audioFrames int, config models.TranscriptionConfig) (*nativeResult, error) {
+	fingerprint := NewMelFingerprint(mel)
+	result := &nativeResult{}
+
+	languageID := -1
+	if config.Language != "" && config.Language != "auto" {
+		if languageID = nativeLanguageID(config.Language); languageID < 0 {
+			return nil, fmt.Errorf("unknown language %q", config.Language)
+		}
+	}
+
+	// Stop with less than a second left, as whisper_full does
+	for seek := 0; seek+100 < audioFrames; {
+		entry, err := d.cache.acquire(fingerprint, mel, nMel, nLen, seek, d.threads)
+		if err != nil {
+			return nil, err
+		}
+
+		if languageID < 0 && d.vocab.Multilingual {
+			languageID, err = d.detectLanguage(entry.state)
+			if err != nil {
+				d.cache.release(entry)
+				return nil, err
+			}
+		}
+
+		window, err := d.decodeWindow(entry.state, languageID, config)
+		d.cache.release(entry)
+		if err != nil {
+			return nil, err
+		}
+
+		advance := windowFrames
+		if window.NoSpeechProb <= config.NoSpeechThreshold || window.AvgLogProb >= logProbThreshold {
+			var segments []nativeSegment
+			segments, advance = d.segments(window.Tokens, seek)
+			result.Segments = append(result.Segments, segments...)
+		}
+		seek += advance
+	}
+
+	if languageID >= 0 {
+		result.Language = nativeLanguageCode(languageID)
+	} else if !d.vocab.Multilingual {
+		result.Language = "en"
+	}
+	return result, nil
+}
+
+// detectLanguage picks the most likely language token after start-of-transcript
+func (d *melDecoder) detectLanguage(state *nativeState) (int, error) {
+	if err := d.native.Decode(state, []int32{d.vocab.SOT}, 0, d.threads, d.logits); err != nil {
+		return -1, err
+	}
+
+	best := -1
+	for id, token := range d.vocab.Languages {
+		if best < 0 || d.logits[token] > d.logits[d.vocab.Languages[best]] {
+			best = id
+		}
+	}
+	return best, nil
+}
+
+// decodeWindow decodes one window, raising the temperature while the result
+// looks like a hallucination, and returns the best attempt
+func (d *melDecoder) decodeWindow(state *nativeState, languageID int, config models.TranscriptionConfig) (*windowResult, error) {
+	prompt := []int32{d.vocab.SOT}
+	if d.vocab.Multilingual {
+		prompt = append(prompt, d.vocab.Languages[languageID], d.vocab.Transcribe)
+	}
+
+	var best *windowResult
+	for temperature := config.Temperature; temperature <= 1.0+1e-6; temperature += temperatureIncrement {
+		window, complete, err := d.decodeSequence(state, prompt, temperature)
+		if err != nil {
+			return nil, err
+		}
+		if best == nil || window.AvgLogProb > best.AvgLogProb {
+			best = window
+		}
+
+		failed := !complete || window.AvgLogProb < logProbThreshold
+		if len(window.Tokens) > 32 && tokenEntropy(window.Tokens) < entropyThreshold {
+			failed = true
+		}
+		// Silence is expected to decode badly, retrying will not help
+		if !failed || window.NoSpeechProb > config.NoSpeechThreshold {
+			return window, nil
+		}
+	}
+
+	return best, nil
+}
+
+// decodeSequence samples tokens until end-of-transcript or the context limit.
+// complete is false when the limit was reached.
+func (d *melDecoder) decodeSequence(state *nativeState, prompt []int32, temperature float64) (*windowResult, bool, error) {
+	if err := d.native.Decode(state, prompt, 0, d.threads, d.logits); err != nil {
+		return nil, false, err
+	}
+	nPast := len(prompt)
+
+	window := &windowResult{
+		NoSpeechProb: d.noSpeechProb(),
+		Temperature:  temperature,
+	}
+
+	// Sampling is seeded like whisper.cpp so reruns are reproducible
+	random := rand.New(rand.NewSource(0))
+	maxTokens := d.vocab.TextCtx/2 - 4
+	sumLogProb := 0.0
+	for len(window.Tokens) < maxTokens {
+		logProbs := d.process(window.Tokens, temperature)
+
+		token := d.pick(logProbs, temperature, random)
+		window.Tokens = append(window.Tokens, decodedToken{
+			ID:   token,
+			P:    math.Exp(logProbs[token]),
+			LogP: logProbs[token],
+		})
+		sumLogProb += logProbs[token]
+
+		if token == d.vocab.EOT {
+			window.AvgLogProb = sumLogProb / float64(len(window.Tokens))
+			return window, true, nil
+		}
+
+		if err := d.native.Decode(state, []int32{token}, nPast, d.threads, d.logits); err != nil {
+			return nil, false, err
+		}
+		nPast++
+	}
+
+	window.AvgLogProb = sumLogProb / float64(len(window.Tokens))
+	return window, false, nil
+}
+
+// noSpeechProb returns the probability of the no-speech token in the current logits
+func (d *melDecoder) noSpeechProb() float64 {
+	maxLogit := math.Inf(-1)
+	for _, logit := range d.logits {
+		maxLogit = math.Max(maxLogit, float64(logit))
+	}
+
+	sum := 0.0
+	for _, logit := range d.logits {
+		sum += math.Exp(float64(logit) - maxLogit)
+	}
+	return math.Exp(float64(d.logits[d.vocab.NoSpeech])-maxLogit) / sum
+}
+
+// process applies whisper's token rules to the current logits and returns
+// log-probabilities, with -Inf for tokens that may not come next
+func (d *melDecoder) process(tokens []decodedToken, temperature float64) []float64 {
+	vocab := d.vocab
+	logProbs := d.work
+	for i, logit := range d.logits {
+		logProbs[i] = float64(logit)
+		if temperature > 0 {
+			logProbs[i] /= temperature
+		}
+	}
+
+	suppress := func(from, to int32) {
+		for i := from; i < to && int(i) < len(logProbs); i++ {
+			logProbs[i] = math.Inf(-1)
+		}
+	}
+	for _, token := range []int32{vocab.NoTimestamps, vocab.SOT, vocab.SOLM, vocab.Prev, vocab.NoSpeech, vocab.Translate, vocab.Transcribe} {
+		suppress(token, token+1)
+	}
+	for _, token := range vocab.Languages {
+		suppress(token, token+1)
+	}
+
+	n := len(tokens)
+	if n == 0 {
+		// Start with a timestamp within the first second
+		suppress(0, vocab.Begin)
+		suppress(vocab.Begin+maxInitialTimestamp+1, int32(len(logProbs)))
+	}
+
+	// Timestamps come in pairs, except right before end-of-transcript
+	lastTimestamp := n > 0 && tokens[n-1].ID >= vocab.Begin
+	penultimateTimestamp := n < 2 || tokens[n-2].ID >= vocab.Begin
+	if lastTimestamp {
+		if penultimateTimestamp {
+			suppress(vocab.Begin, int32(len(logProbs)))
+		} else {
+			suppress(0, vocab.EOT)
+		}
+	}
+
+	// Timestamps never go backwards and a segment has a non-zero length
+	for i := n - 1; i >= 0; i-- {
+		if tokens[i].ID >= vocab.Begin {
+			next := tokens[i].ID
+			if lastTimestamp && !penultimateTimestamp {
+				next++
+			}
+			suppress(vocab.Begin, next)
+			break
+		}
+	}
+
+	logSoftmax(logProbs)
+
+	// Sample a timestamp when all timestamps together beat every text token
+	timestampLogProb := logSumExp(logProbs[vocab.Begin:])
+	maxTextLogProb := math.Inf(-1)
+	for _, logProb := range logProbs[:vocab.Begin] {
+		maxTextLogProb = math.Max(maxTextLogProb, logProb)
+	}
+	if timestampLogProb > maxTextLogProb {
+		suppress(0, vocab.Begin)
+	}
+
+	return logProbs
+}
+
+// pick chooses the next token, greedily at temperature zero
+func (d *melDecoder) pick(logProbs []float64, temperature float64, random *rand.Rand) int32 {
+	best := 0
+	for i, logProb := range logProbs {
+		if logProb > logProbs[best] {
+			best = i
+		}
+	}
+	if temperature <= 0 {
+		return int32(best)
+	}
+
+	total := 0.0
+	for _, logProb := range logProbs {
+		total += math.Exp(logProb)
+	}
+	target := random.Float64() * total
+	for i, logProb := range logProbs {
+		target -= math.Exp(logProb)
+		if target <= 0 {
+			return int32(i)
+		}
+	}
+	return int32(best)
+}
+
+// segments splits a decoded window at its timestamp tokens and returns how
+// many frames to advance: to the last timestamp, or past the whole window
+func (d *melDecoder) segments(tokens []decodedToken, seek int) ([]nativeSegment, int) {
+	var segments []nativeSegment
+	var text strings.Builder
+	sumLogProb, textTokens := 0.0, 0
+	start := seek
+	last := 0
+
+	for i := 0; i < len(tokens); i++ {
+		token := tokens[i].ID
+		if token < d.vocab.EOT {
+			text.WriteString(d.native.TokenBytes(token))
+			sumLogProb += tokens[i].LogP
+			textTokens++
+			continue
+		}
+		if token < d.vocab.Begin {
+			continue
+		}
+
+		offset := int(token-d.vocab.Begin) * timestampFrames
+		if offset > last {
+			last = offset
+		}
+		if text.Len() > 0 {
+			segments = append(segments, nativeSegment{
+				Text:       strings.TrimSpace(text.String()),
+				Start:      float64(start) / 100,
+				End:        float64(seek+offset) / 100,
+				Confidence: tokenConfidence(sumLogProb, textTokens),
+			})
+			text.Reset()
+			sumLogProb, textTokens = 0, 0
+		}
+
+		// The next segment starts at the last of consecutive timestamps
+		for i+1 < len(tokens) && tokens[i+1].ID >= d.vocab.Begin {
+			i++
+		}
+		start = seek + int(tokens[i].ID-d.vocab.Begin)*timestampFrames
+	}
+
+	if text.Len() > 0 {
+		segments = append(segments, nativeSegment{
+			Text:       strings.TrimSpace(text.String()),
+			Start:      float64(start) / 100,
+			End:        float64(seek+windowFrames) / 100,
+			Confidence: tokenConfidence(sumLogProb, textTokens),
+		})
+		return segments, windowFrames
+	}
+
+	// A lone closing timestamp means nothing was said after it
+	n := len(tokens)
+	if n > 0 && tokens[n-1].ID == d.vocab.EOT {
+		n--
+	}
+	singleEnding := n > 0 && tokens[n-1].ID >= d.vocab.Begin && (n < 2 || tokens[n-2].ID < d.vocab.Begin)
+	if last == 0 || singleEnding {
+		return segments, windowFrames
+	}
+	return segments, last
+}
+
+// tokenEntropy is the entropy of the last 32 token IDs; repetition loops score low
+func tokenEntropy(tokens []decodedToken) float64 {
+	if len(tokens) > 32 {
+		tokens = tokens[len(tokens)-32:]
+	}
+
+	counts := make(map[int32]int, len(tokens))
+	for _, token := range tokens {
+		counts[token.ID]++
+	}
+
+	entropy := 0.0
+	for _, count := range counts {
+		p := float64(count) / float64(len(tokens))
+		entropy -= p * math.Log(p)
+	}
+	return entropy
+}
+
+// logSoftmax converts logits to log-probabilities in place
+func logSoftmax(values []float64) {
+	norm := logSumExp(values)
+	for i := range values {
+		values[i] -= norm
+	}
+}
+
+// logSumExp returns log(sum(exp(values))) without overflow
+func logSumExp(values []float64) float64 {
+	maxValue := math.Inf(-1)
+	for _, value := range values {
+		maxValue = math.Max(maxValue, value)
+	}
+	if math.IsInf(maxValue, -1) {
+		return maxValue
+	}
+
+	sum := 0.0
+	for _, value := range values {
+		sum += math.Exp(value - maxValue)
+	}
+	return maxValue + math.Log(sum)
+}
@@ -12,6 +12,7 @@ import (
 
 	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
 	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/services/memory"
 	"github.com/sirupsen/logrus"
 )
 
@@ -21,6 +22,11 @@ type ModelManager struct {
 	downloadQueue chan models.ModelDownloadRequest
 	activeModel   *models.WhisperModel
 	loadedModel   whisper.Model
+	loadedPath    string
+	encoderCache  *EncoderCache
+	memory        *memory.Consumer // Weights of the loaded model
+	queued        map[string]bool // Downloads waiting or in progress
+	queueMutex    sync.Mutex
 	mutex         sync.RWMutex
 	logger        *logrus.Logger
 }
@@ -35,6 +41,8 @@ func NewModelManager(modelsPath string, logger *logrus.Logger) *ModelManager {
 	mm := &ModelManager{
 		modelsPath:    modelsPath,
 		downloadQueue: make(chan models.ModelDownloadRequest, 10),
+		queued:        make(map[string]bool),
+		memory:        memory.Default().Register("whisper models", memory.Native, nil),
 		logger:        logger,
 	}
 
@@ -68,21 +76,31 @@ func (mm *ModelManager) DownloadModel(modelID string) error {
 		return fmt.Errorf("model %s is already downloaded", modelID)
 	}
 	
+	// Two downloads of one model would share its temporary file
+	mm.queueMutex.Lock()
+	defer mm.queueMutex.Unlock()
+	if mm.queued[modelID] {
+		return nil
+	}
+
 	mm.logger.WithField("model", modelID).Info("Queuing model for download")
 	
 	select {
 	case mm.downloadQueue <- models.ModelDownloadRequest{ModelID: modelID, Priority: 1}:
+		mm.queued[modelID] = true
 		return nil
 	default:
 		return fmt.Errorf("download queue is full")
 	}
 }
 
-// SetActiveModel sets the active model and loads it
+// SetActiveModel sets the active model and loads it. A quantized copy is
+// loaded instead when the model does not fit the memory budget.
 func (mm *ModelManager) SetActiveModel(modelID string) error {
 	mm.mutex.Lock()
 	defer mm.mutex.Unlock()
 
+	modelID = mm.chooseVariant(modelID)
 	if !mm.isModelDownloaded(modelID) {
 		return fmt.Errorf("model %s is not downloaded", modelID)
 	}
@@ -90,8 +108,7 @@ func (mm *ModelManager) SetActiveModel(modelID string) error {
 	// Unload current model if any
 	if mm.loadedModel != nil {
 		mm.logger.Debug("Unloading existing model")
-		mm.loadedModel.Close()
-		mm.loadedModel = nil
+		mm.unloadModel()
 	}
 
 	// Load new model
@@ -120,9 +137,23 @@ func (mm *ModelManager) SetActiveModel(modelID string) error {
 	}
 
 	mm.loadedModel = model
+	mm.loadedPath = modelPath
 
-	// Update active model
+	// The weights are already in memory; reserving evicts caches to make room
 	modelInfo, _ := models.GetModelByID(modelID)
+	if !mm.memory.TryReserve(modelInfo.Size) {
+		mm.memory.Add(modelInfo.Size)
+	}
+
+	encoderConfig := DefaultEncoderCacheConfig()
+	encoderConfig.StateBytes = modelInfo.StateMemory()
+	encoderCache, err := NewEncoderCache(model, modelID, encoderConfig)
+	if err != nil {
+		mm.logger.WithError(err).Warn("Encoder cache unavailable for this model")
+	}
+	mm.encoderCache = encoderCache
+
+	// Update active model
 	mm.activeModel = modelInfo
 
 	mm.logger.WithField("model", modelID).Info("Successfully loaded model")
@@ -155,6 +186,69 @@ func (mm *ModelManager) GetLoadedModel() whisper.Model {
 	return mm.loadedModel
 }
 
+// GetLoadedModelPath returns the file the loaded model was read from, or ""
+func (mm *ModelManager) GetLoadedModelPath() string {
+	mm.mutex.RLock()
+	defer mm.mutex.RUnlock()
+	return mm.loadedPath
+}
+
+// GetEncoderCache returns the encoder output cache of the loaded model, or nil
+func (mm *ModelManager) GetEncoderCache() *EncoderCache {
+	mm.mutex.RLock()
+	defer mm.mutex.RUnlock()
+	return mm.encoderCache
+}
+
+// chooseVariant returns the quantized copy of a model when the model itself
+// does not fit the memory budget and the copy does. A copy that is not
+// downloaded yet is queued, and the model is used until it arrives.
+// Callers hold the mutex.
+func (mm *ModelManager) chooseVariant(modelID string) string {
+	model, exists := models.GetModelByID(modelID)
+	if !exists || mm.memory.Fits(model.Memory) {
+		return modelID
+	}
+	variant, exists := models.GetQuantizedVariant(modelID)
+	if !exists {
+		return modelID
+	}
+
+	fields := logrus.Fields{
+		"model":     modelID,
+		"variant":   variant.ID,
+		"memory_mb": model.Memory / memory.MB,
+		"budget_mb": memory.Default().Budget() / memory.MB,
+	}
+	if !mm.isModelDownloaded(variant.ID) {
+		if err := mm.DownloadModel(variant.ID); err != nil {
+			mm.logger.WithError(err).WithFields(fields).Warn("Failed to queue quantized model download")
+		}
+		mm.logger.WithFields(fields).Warn("Model exceeds the memory budget, using it until its quantized copy is downloaded")
+		return modelID
+	}
+
+	mm.logger.WithFields(fields).Info("Model exceeds the memory budget, loading its quantized copy")
+	return variant.ID
+}
+
+// unloadModel frees the loaded model and its reservation. Callers hold the mutex.
+func (mm *ModelManager) unloadModel() {
+	mm.closeEncoderCache()
+	mm.loadedModel.Close()
+	mm.loadedModel = nil
+	mm.loadedPath = ""
+	mm.memory.ReleaseAll()
+}
+
+// closeEncoderCache frees the cached encoder states before their model is unloaded
+func (mm *ModelManager) closeEncoderCache() {
+	if mm.encoderCache != nil {
+		mm.encoderCache.Close()
+		mm.encoderCache = nil
+	}
+}
+
 // isModelDownloaded checks if a model file exists
 func (mm *ModelManager) isModelDownloaded(modelID string) bool {
 	modelPath := mm.getModelPath(modelID)
@@ -167,7 +261,7 @@ func (mm *ModelManager) isModelActive(modelID string) bool {
 	mm.mutex.RLock()
 	defer mm.mutex.RUnlock()
 	
-	return mm.activeModel != nil && mm.activeModel.ID == modelID
+	return mm.activeModel != nil && (mm.activeModel.ID == modelID || mm.activeModel.Quantizes == modelID)
 }
 
 // getModelPath returns the file path for a model
@@ -183,6 +277,10 @@ func (mm *ModelManager) downloadWorker() {
 		if err := mm.downloadModelFile(req.ModelID); err != nil {
 			mm.logger.WithError(err).WithField("model", req.ModelID).Error("Failed to download model")
 		}
+
+		mm.queueMutex.Lock()
+		delete(mm.queued, req.ModelID)
+		mm.queueMutex.Unlock()
 	}
 }
 
@@ -238,7 +336,11 @@ func (mm *ModelManager) downloadModelFile(modelID string) error {
 		return fmt.Errorf("failed to stat downloaded file: %w", err)
 	}
 	
+	// Listed sizes are approximate for some models, so the server's length wins
 	expectedSize := model.Size
+	if resp.ContentLength > 0 {
+		expectedSize = resp.ContentLength
+	}
 	if stat.Size() != expectedSize {
 		os.Remove(tempPath)
 		return fmt.Errorf("downloaded file size mismatch: got %d, expected %d", stat.Size(), expectedSize)
@@ -263,6 +365,31 @@ func (mm *ModelManager) getModelDownloadURL(modelID string) string {
 	return fmt.Sprintf("%s/%s", baseURL, filename)
 }
 
+// EnsureModel loads a downloaded model unless it is already loaded
+func (mm *ModelManager) EnsureModel(modelID string) error {
+	if mm.isModelActive(modelID) {
+		return nil
+	}
+	return mm.SetActiveModel(modelID)
+}
+
+// IsModelDownloaded reports whether a model file is on disk
+func (mm *ModelManager) IsModelDownloaded(modelID string) bool {
+	return mm.isModelDownloaded(modelID)
+}
+
+// Unload frees the loaded model until it is needed again
+func (mm *ModelManager) Unload() {
+	mm.mutex.Lock()
+	defer mm.mutex.Unlock()
+
+	if mm.loadedModel != nil {
+		mm.logger.Debug("Unloading model")
+		mm.unloadModel()
+		mm.activeModel = nil
+	}
+}
+
 // EnsureDefaultModel ensures a default model is available and loaded
 // This will block until a model is available (either already downloaded or download completes)
 func (mm *ModelManager) EnsureDefaultModel() error {
@@ -319,8 +446,7 @@ func (mm *ModelManager) Close() error {
 	
 	// Unload model
 	if mm.loadedModel != nil {
-		mm.loadedModel.Close()
-		mm.loadedModel = nil
+		mm.unloadModel()
 	}
 	
 	return nil
@@ -0,0 +1,77 @@
+package transcription
+
+import (
+	"sort"
+)
+
+const (
+	// A frame is speech when its mean log10 mel energy is this far above the
+	// recording's noise floor (8 dB), which is taken at a low percentile
+	vadMargin          = 0.8
+	vadFloorPercentile = 0.1
+
+	// Gaps shorter than vadHangoverFrames join their neighbours, then runs
+	// shorter than vadMinSpeechFrames are dropped as clicks
+	vadHangoverFrames  = 30
+	vadMinSpeechFrames = 20
+)
+
+// SpeechSpan is a run of mel frames that contain speech
+type SpeechSpan struct {
+	Start int // First frame
+	End   int // Frame after the last one
+}
+
+// DetectSpeech finds the frames of a spectrogram whose energy stands out
+// from the recording's noise floor. It is deliberately permissive: it only
+// has to rule out stretches with nothing to transcribe.
+func DetectSpeech(mel *MelSpectrogram) []SpeechSpan {
+	if mel.Frames == 0 {
+		return nil
+	}
+
+	energy := make([]float64, mel.Frames)
+	for frame := range energy {
+		sum := 0.0
+		for _, value := range mel.Data[frame*mel.NMel : (frame+1)*mel.NMel] {
+			sum += float64(value)
+		}
+		energy[frame] = sum / float64(mel.NMel)
+	}
+
+	sorted := append([]float64(nil), energy...)
+	sort.Float64s(sorted)
+	threshold := sorted[int(float64(len(sorted)-1)*vadFloorPercentile)] + vadMargin
+
+	var spans []SpeechSpan
+	for frame := 0; frame < len(energy); frame++ {
+		if energy[frame] <= threshold {
+			continue
+		}
+		if n := len(spans); n > 0 && frame-spans[n-1].End < vadHangoverFrames {
+			spans[n-1].End = frame + 1
+			continue
+		}
+		spans = append(spans, SpeechSpan{Start: frame, End: frame + 1})
+	}
+
+	kept := spans[:0]
+	for _, span := range spans {
+		if span.End-span.Start >= vadMinSpeechFrames {
+			kept = append(kept, span)
+		}
+	}
+	return kept
+}
+
+// HasSpeech reports whether any speech overlaps the samples [start, end)
+func (m *MelSpectrogram) HasSpeech(start, end int) bool {
+	first := start / melHopLength
+	last := (end + melHopLength - 1) / melHopLength
+	for _, span := range m.Speech {
+		if span.Start < last && span.End > first {
+			return true
+		}
+	}
+	return false
+}
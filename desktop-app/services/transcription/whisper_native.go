@@ -0,0 +1,318 @@
+package transcription
+
+/*
+#include <stdlib.h>
+#include <whisper.h>
+*/
+import "C"
+import (
+	"fmt"
+	"math"
+	"reflect"
+	"runtime"
+	"strings"
+	"sync"
+	"unsafe"
+
+	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
+	"github.com/platformlabs-co/personal-assist/models"
+)
+
+// The Go bindings only accept PCM, so the mel path calls whisper.cpp directly
+// on the whisper_context behind a loaded model. whisper_full runs on the
+// context's default state, which is not reentrant. The bindings' Context
+// uses the same state, so both paths take the context's lock in
+// contextLocks; contexts of different models decode in parallel.
+var contextLocks sync.Map // uintptr of the whisper_context to *sync.Mutex
+
+// contextLock returns the lock of a whisper_context's default state
+func contextLock(ctx *C.struct_whisper_context) *sync.Mutex {
+	lock, _ := contextLocks.LoadOrStore(uintptr(unsafe.Pointer(ctx)), &sync.Mutex{})
+	return lock.(*sync.Mutex)
+}
+
+// modelLock returns the lock of the default state of a model's
+// whisper_context. A model that does not expose its context shares one
+// lock with every other such model.
+func modelLock(model whisper.Model) *sync.Mutex {
+	ctx, err := modelContext(model)
+	if err != nil {
+		return contextLock(nil)
+	}
+	return contextLock(ctx)
+}
+
+// nativeWhisper gives direct access to the whisper_context of a loaded model
+type nativeWhisper struct {
+	ctx       *C.struct_whisper_context
+	lock      *sync.Mutex // Held around whisper_full and reading its results
+	vocabOnce sync.Once
+	vocab     *nativeVocabulary
+}
+
+// newNativeWhisper wraps the whisper_context of a model loaded by the Go
+// bindings
+func newNativeWhisper(model whisper.Model) (*nativeWhisper, error) {
+	ctx, err := modelContext(model)
+	if err != nil {
+		return nil, err
+	}
+	return &nativeWhisper{ctx: ctx, lock: contextLock(ctx)}, nil
+}
+
+// modelContext finds the whisper_context a model loaded by the Go bindings
+// wraps. The bindings keep it in an unexported ctx field.
+func modelContext(model whisper.Model) (*C.struct_whisper_context, error) {
+	value := reflect.ValueOf(model)
+	if value.Kind() != reflect.Ptr || value.Elem().Kind() != reflect.Struct {
+		return nil, fmt.Errorf("unsupported whisper model type %T", model)
+	}
+
+	field := value.Elem().FieldByName("ctx")
+	if !field.IsValid() || field.Kind() != reflect.Ptr || field.IsNil() {
+		return nil, fmt.Errorf("whisper model %T does not expose its context", model)
+	}
+
+	return (*C.struct_whisper_context)(unsafe.Pointer(field.Pointer())), nil
+}
+
+// nativeSegment is a segment decoded by whisper_full
+type nativeSegment struct {
+	Text       string
+	Start      float64 // Seconds from the start of the input
+	End        float64
+	Confidence float64 // Geometric mean probability of the text tokens
+}
+
+// tokenConfidence turns the summed log-probability of n text tokens into a
+// confidence in [0, 1]
+func tokenConfidence(sumLogProb float64, n int) float64 {
+	if n == 0 {
+		return 0
+	}
+	return math.Exp(sumLogProb / float64(n))
+}
+
+// nativeResult holds the output of one whisper_full run
+type nativeResult struct {
+	Segments []nativeSegment
+	Language string
+}
+
+// NMel returns the number of mel bins the model was trained on
+func (n *nativeWhisper) NMel() int {
+	return int(C.whisper_model_n_mels(n.ctx))
+}
+
+// TranscribeMel decodes a precomputed, normalized mel spectrogram. mel holds
+// nMel rows of nLen frames; decoding stops after audioFrames frames, as it
+// does when whisper.cpp computes the spectrogram from PCM itself.
+func (n *nativeWhisper) TranscribeMel(mel []float32, nMel, nLen, audioFrames int, config models.TranscriptionConfig) (*nativeResult, error) {
+	if len(mel) != nMel*nLen {
+		return nil, fmt.Errorf("mel input has %d values, expected %d", len(mel), nMel*nLen)
+	}
+
+	// Same settings the Go bindings apply to a new context
+	strategy := C.enum_whisper_sampling_strategy(C.WHISPER_SAMPLING_GREEDY)
+	if config.BeamSize > 1 {
+		strategy = C.WHISPER_SAMPLING_BEAM_SEARCH
+	}
+	params := C.whisper_full_default_params(strategy)
+	if config.BeamSize > 1 {
+		params.beam_search.beam_size = C.int(config.BeamSize)
+	}
+	params.translate = C.bool(false)
+	params.no_context = C.bool(true)
+	params.print_special = C.bool(false)
+	params.print_progress = C.bool(false)
+	params.print_realtime = C.bool(false)
+	params.print_timestamps = C.bool(false)
+	params.token_timestamps = C.bool(config.EnableTimestamps)
+	params.temperature = C.float(config.Temperature)
+	params.offset_ms = 0
+	params.duration_ms = C.int(audioFrames * 10)
+
+	language := config.Language
+	if language == "" {
+		language = "auto"
+	}
+	cLanguage := C.CString(language)
+	defer C.free(unsafe.Pointer(cLanguage))
+	params.language = cLanguage
+
+	ctx := n.ctx
+	n.lock.Lock()
+	defer n.lock.Unlock()
+
+	if C.whisper_set_mel(ctx, (*C.float)(unsafe.Pointer(&mel[0])), C.int(nLen), C.int(nMel)) != 0 {
+		return nil, fmt.Errorf("whisper_set_mel rejected a %dx%d spectrogram", nMel, nLen)
+	}
+
+	// With no samples whisper_full keeps the mel set above
+	if C.whisper_full(ctx, params, nil, 0) != 0 {
+		return nil, fmt.Errorf("whisper_full failed")
+	}
+
+	result := &nativeResult{}
+	if id := C.whisper_full_lang_id(ctx); id >= 0 {
+		result.Language = C.GoString(C.whisper_lang_str(id))
+	}
+
+	eot := C.whisper_token_eot(ctx)
+	count := int(C.whisper_full_n_segments(ctx))
+	for i := 0; i < count; i++ {
+		segment := C.int(i)
+
+		sumLogProb, textTokens := 0.0, 0
+		for j := 0; j < int(C.whisper_full_n_tokens(ctx, segment)); j++ {
+			token := C.whisper_full_get_token_data(ctx, segment, C.int(j))
+			if token.id < eot {
+				sumLogProb += float64(token.plog)
+				textTokens++
+			}
+		}
+
+		result.Segments = append(result.Segments, nativeSegment{
+			Text:       strings.TrimSpace(C.GoString(C.whisper_full_get_segment_text(ctx, segment))),
+			Start:      float64(C.whisper_full_get_segment_t0(ctx, segment)) / 100,
+			End:        float64(C.whisper_full_get_segment_t1(ctx, segment)) / 100,
+			Confidence: tokenConfidence(sumLogProb, textTokens),
+		})
+	}
+
+	return result, nil
+}
+
+// nativeState is a whisper_state: a spectrogram, the encoder output of one
+// window of it and the decoder's self-attention cache. States are independent
+// of each other and of the context's default state used by whisper_full.
+type nativeState struct {
+	ptr *C.struct_whisper_state
+}
+
+// nativeVocabulary holds the special tokens the decoder needs
+type nativeVocabulary struct {
+	Size         int
+	TextCtx      int
+	Multilingual bool
+	EOT          int32
+	SOT          int32
+	SOLM         int32
+	Prev         int32
+	NoSpeech     int32
+	NoTimestamps int32
+	Begin        int32 // First timestamp token
+	Translate    int32
+	Transcribe   int32
+	Languages    []int32 // Token of each language ID
+}
+
+// streamThreads splits the cores between concurrently decoding streams,
+// with at most the 4 threads whisper_full_default_params picks per stream
+func streamThreads(streams int) int {
+	if streams < 1 {
+		streams = 1
+	}
+	n := runtime.NumCPU() / streams
+	if n < 1 {
+		return 1
+	}
+	if n > 4 {
+		return 4
+	}
+	return n
+}
+
+// NewState allocates a whisper_state for the context
+func (n *nativeWhisper) NewState() (*nativeState, error) {
+	state := C.whisper_init_state(n.ctx)
+	if state == nil {
+		return nil, fmt.Errorf("whisper_init_state failed")
+	}
+	return &nativeState{ptr: state}, nil
+}
+
+// Free releases the state's buffers
+func (s *nativeState) Free() {
+	if s.ptr != nil {
+		C.whisper_free_state(s.ptr)
+		s.ptr = nil
+	}
+}
+
+// Encode loads a spectrogram into the state and runs the encoder over the
+// 30 s window starting offset frames into it
+func (n *nativeWhisper) Encode(state *nativeState, mel []float32, nMel, nLen, offset, threads int) error {
+	if len(mel) != nMel*nLen {
+		return fmt.Errorf("mel input has %d values, expected %d", len(mel), nMel*nLen)
+	}
+	if C.whisper_set_mel_with_state(n.ctx, state.ptr, (*C.float)(unsafe.Pointer(&mel[0])), C.int(nLen), C.int(nMel)) != 0 {
+		return fmt.Errorf("whisper_set_mel rejected a %dx%d spectrogram", nMel, nLen)
+	}
+	if C.whisper_encode_with_state(n.ctx, state.ptr, C.int(offset), C.int(threads)) != 0 {
+		return fmt.Errorf("whisper_encode failed at frame %d", offset)
+	}
+	return nil
+}
+
+// Decode feeds tokens to the decoder after nPast earlier ones and copies the
+// logits for the last token into logits, which must hold Size values
+func (n *nativeWhisper) Decode(state *nativeState, tokens []int32, nPast, threads int, logits []float32) error {
+	if len(tokens) == 0 {
+		return fmt.Errorf("no tokens to decode")
+	}
+	if C.whisper_decode_with_state(n.ctx, state.ptr, (*C.whisper_token)(unsafe.Pointer(&tokens[0])), C.int(len(tokens)), C.int(nPast), C.int(threads)) != 0 {
+		return fmt.Errorf("whisper_decode failed after %d tokens", nPast)
+	}
+
+	// Rows hold the logits of each input token, the last one is the prediction
+	all := unsafe.Slice((*float32)(unsafe.Pointer(C.whisper_get_logits_from_state(state.ptr))), len(tokens)*len(logits))
+	copy(logits, all[(len(tokens)-1)*len(logits):])
+	return nil
+}
+
+// TokenBytes returns the bytes a token stands for, which may be part of a UTF-8 sequence
+func (n *nativeWhisper) TokenBytes(token int32) string {
+	return C.GoString(C.whisper_token_to_str(n.ctx, C.whisper_token(token)))
+}
+
+// Vocabulary returns the model's special tokens
+func (n *nativeWhisper) Vocabulary() *nativeVocabulary {
+	n.vocabOnce.Do(func() {
+		ctx := n.ctx
+		vocab := &nativeVocabulary{
+			Size:         int(C.whisper_n_vocab(ctx)),
+			TextCtx:      int(C.whisper_n_text_ctx(ctx)),
+			Multilingual: C.whisper_is_multilingual(ctx) != 0,
+			EOT:          int32(C.whisper_token_eot(ctx)),
+			SOT:          int32(C.whisper_token_sot(ctx)),
+			SOLM:         int32(C.whisper_token_solm(ctx)),
+			Prev:         int32(C.whisper_token_prev(ctx)),
+			NoSpeech:     int32(C.whisper_token_nosp(ctx)),
+			NoTimestamps: int32(C.whisper_token_not(ctx)),
+			Begin:        int32(C.whisper_token_beg(ctx)),
+			Translate:    int32(C.whisper_token_translate(ctx)),
+			Transcribe:   int32(C.whisper_token_transcribe(ctx)),
+		}
+
+		if vocab.Multilingual {
+			for id := 0; id <= int(C.whisper_lang_max_id()); id++ {
+				vocab.Languages = append(vocab.Languages, int32(C.whisper_token_lang(ctx, C.int(id))))
+			}
+		}
+		n.vocab = vocab
+	})
+	return n.vocab
+}
+
+// nativeLanguageID returns whisper's ID for a language code, or -1
+func nativeLanguageID(language string) int {
+	cLanguage := C.CString(language)
+	defer C.free(unsafe.Pointer(cLanguage))
+	return int(C.whisper_lang_id(cLanguage))
+}
+
+// nativeLanguageCode returns the code of a whisper language ID
+func nativeLanguageCode(id int) string {
+	return C.GoString(C.whisper_lang_str(C.int(id)))
+}
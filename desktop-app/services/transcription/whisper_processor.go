@@ -1,9 +1,14 @@
 package transcription
 
 import (
+	"bytes"
+	"crypto/sha256"
 	"fmt"
 	"io"
+	"math"
+	"sort"
 	"strings"
+	"sync"
 	"time"
 
 	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
@@ -13,10 +18,30 @@ import (
 
 // WhisperProcessor handles transcription using Whisper.cpp
 type WhisperProcessor struct {
-	model   whisper.Model
-	context whisper.Context
-	config  models.TranscriptionConfig
-	logger  *logrus.Logger
+	model       whisper.Model
+	context     whisper.Context
+	lock        *sync.Mutex // Lock of the default state context decodes on, see contextLocks
+	config      models.TranscriptionConfig
+	logger      *logrus.Logger
+	native      *nativeWhisper // Set when the mel cache is enabled
+	melFrontend *MelFrontend
+	streams     []*melStream
+	cache       *EncoderCache  // Set when encoder output is cached
+	redecoder   *nativeWhisper // Larger model for low-confidence segments, beam search when nil
+	redecodeID  string
+	modelID     string // Part of region fingerprints, see SetModelID
+	language    string // Language locked for the current recording, empty to use config
+	detected    string // Language whisper detected in the last chunk
+	report      models.TranscriptionReport
+}
+
+// melStream decodes chunks of mel input independently of other streams. It
+// owns its decoder buffers, its chunk input and its share of the report, and
+// takes its own whisper states from the encoder cache.
+type melStream struct {
+	decoder *melDecoder // Nil without encoder cache
+	buffer  []float32   // Reused chunk mel input
+	report  models.TranscriptionReport
 }
 
 // NewWhisperProcessor creates a new Whisper processor
@@ -37,6 +62,7 @@ func NewWhisperProcessor(modelPath string, config models.TranscriptionConfig, lo
 	wp := &WhisperProcessor{
 		model:   model,
 		context: context,
+		lock:    modelLock(model),
 		config:  config,
 		logger:  logger,
 	}
@@ -69,6 +95,7 @@ func NewWhisperProcessorFromModel(model whisper.Model, config models.Transcripti
 	wp := &WhisperProcessor{
 		model:   model,
 		context: context,
+		lock:    modelLock(model),
 		config:  config,
 		logger:  logger,
 	}
@@ -89,24 +116,47 @@ func (wp *WhisperProcessor) TranscribeChunk(chunk AudioChunk, activityStartTime
 		"duration":    chunk.EndTime - chunk.StartTime,
 	}).Debug("Processing audio chunk")
 
-	// Configure context based on our config
-	if wp.config.Language != "auto" {
-		if err := wp.context.SetLanguage(wp.config.Language); err != nil {
+	// Configure context based on our config and the recording's language
+	language := wp.config.Language
+	if wp.language != "" {
+		language = wp.language
+	}
+	// "auto" also undoes the previous recording's locked language
+	if language != "auto" || wp.context.IsMultilingual() {
+		if err := wp.context.SetLanguage(language); err != nil {
 			wp.logger.WithError(err).Warn("Failed to set language, using auto-detect")
 		}
 	}
 	wp.context.SetTemperature(float32(wp.config.Temperature))
 	wp.context.SetTokenTimestamps(wp.config.EnableTimestamps)
 	
-	// Process the audio with whisper
+	// Process the audio with whisper. The results live in the model's
+	// default state until the next run, so they are read under the lock.
+	wp.lock.Lock()
+	start := time.Now()
 	err := wp.context.Process(chunk.Samples, nil, nil, nil)
 	if err != nil {
+		wp.lock.Unlock()
 		return nil, fmt.Errorf("whisper processing failed: %w", err)
 	}
+	wp.report.DecodeTime += time.Since(start)
 
-	// Extract results
+	// Extract results. The bindings only decode greedily and segment by
+	// segment re-decoding needs mel input, so segments are only reported here.
 	segments := wp.extractSegments(chunk, activityStartTime)
-	
+	wp.detected = wp.context.DetectedLanguage()
+	wp.lock.Unlock()
+	for _, segment := range segments {
+		if segment.Confidence < wp.config.RedecodeThreshold {
+			wp.report.LowConfidence++
+		}
+		wp.report.AddSegment(segment.EndTime-segment.StartTime, segment.Confidence, segment.Confidence)
+	}
+	return wp.buildTranscriptChunk(chunk, segments, activityStartTime)
+}
+
+// buildTranscriptChunk combines the segments decoded from a chunk into one transcript chunk
+func (wp *WhisperProcessor) buildTranscriptChunk(chunk AudioChunk, segments []TranscriptSegment, activityStartTime time.Time) (*models.TranscriptChunk, error) {
 	if len(segments) == 0 {
 		// Return empty chunk if no speech detected
 		return models.NewTranscriptChunk(
@@ -121,7 +171,7 @@ func (wp *WhisperProcessor) TranscribeChunk(chunk AudioChunk, activityStartTime
 
 	// Combine all segments into one chunk
 	var combinedText strings.Builder
-	var confidence float64
+	var confidence, duration float64
 	var language string
 	var speaker string
 
@@ -130,14 +180,18 @@ func (wp *WhisperProcessor) TranscribeChunk(chunk AudioChunk, activityStartTime
 			combinedText.WriteString(" ")
 		}
 		combinedText.WriteString(strings.TrimSpace(segment.Text))
-		
-		// Use confidence from first segment
+
+		// Weight each segment's confidence by its length
+		length := math.Max(segment.EndTime-segment.StartTime, 0.01)
+		confidence += segment.Confidence * length
+		duration += length
+
 		if i == 0 {
-			confidence = segment.Confidence
 			language = segment.Language
 			speaker = segment.Speaker
 		}
 	}
+	confidence /= duration
 
 	text := combinedText.String()
 	if text == "" {
@@ -168,20 +222,148 @@ func (wp *WhisperProcessor) TranscribeChunk(chunk AudioChunk, activityStartTime
 	return transcriptChunk, nil
 }
 
+// RecordingTranscript is a recording transcribed against the regions it
+// was last transcribed in
+type RecordingTranscript struct {
+	Regions []models.TranscriptRegion // Every region of the recording, ordered by start
+	Chunks  []*models.TranscriptChunk // Chunks of the regions decoded this time
+	Decoded int                       // Regions decoded
+	Reused  int                       // Regions whose previous transcript still holds
+	Stale   int                       // Previous regions no longer in the recording
+}
+
+// Unchanged reports whether the recording's regions are the previous ones,
+// so there is nothing to store
+func (t *RecordingTranscript) Unchanged() bool {
+	return t.Decoded == 0 && t.Stale == 0 && t.Reused == len(t.Regions)
+}
+
+// regionPlanner matches the chunks of a recording against the regions it
+// was last transcribed in. A region's fingerprint covers the decoder as well
+// as its input, so regions decoded with another model or other settings
+// never match.
+type regionPlanner struct {
+	previous   map[[2]int]models.TranscriptRegion
+	decoder    MelFingerprint
+	transcript *RecordingTranscript
+}
+
+// newRegionPlanner creates a planner for the previous regions of a recording
+// and the fingerprint of the decoder chunks are decoded with
+func newRegionPlanner(previous []models.TranscriptRegion, decoder MelFingerprint) *regionPlanner {
+	planner := &regionPlanner{
+		previous:   make(map[[2]int]models.TranscriptRegion, len(previous)),
+		decoder:    decoder,
+		transcript: &RecordingTranscript{},
+	}
+	for _, region := range previous {
+		planner.previous[[2]int{region.StartSample, region.EndSample}] = region
+	}
+	return planner
+}
+
+// fingerprint returns the fingerprint of a region from that of its decoder input
+func (p *regionPlanner) fingerprint(input MelFingerprint) MelFingerprint {
+	return sha256.Sum256(append(p.decoder[:], input[:]...))
+}
+
+// reuse reports whether a chunk covers a previous region with the same
+// fingerprint, keeping that region's transcript if so
+func (p *regionPlanner) reuse(chunk AudioChunk, fingerprint MelFingerprint) bool {
+	region, ok := p.previous[[2]int{chunk.StartSample, chunk.EndSample}]
+	if !ok || !bytes.Equal(region.Fingerprint, fingerprint[:]) {
+		return false
+	}
+	p.transcript.Regions = append(p.transcript.Regions, region)
+	p.transcript.Reused++
+	return true
+}
+
+// record adds the region of a chunk transcribed this time, with the chunk
+// it produced, nil when none
+func (p *regionPlanner) record(chunk AudioChunk, fingerprint MelFingerprint, transcriptChunk *models.TranscriptChunk) {
+	region := models.TranscriptRegion{
+		StartSample: chunk.StartSample,
+		EndSample:   chunk.EndSample,
+		Fingerprint: append([]byte(nil), fingerprint[:]...),
+	}
+	if transcriptChunk != nil {
+		region.ChunkID = transcriptChunk.ID
+		p.transcript.Chunks = append(p.transcript.Chunks, transcriptChunk)
+	}
+	p.transcript.Regions = append(p.transcript.Regions, region)
+}
+
+// finish returns the transcript with its regions ordered by start
+func (p *regionPlanner) finish(previous int) *RecordingTranscript {
+	t := p.transcript
+	sort.Slice(t.Regions, func(i, j int) bool {
+		return t.Regions[i].StartSample < t.Regions[j].StartSample
+	})
+	t.Stale = previous - t.Reused
+	return t
+}
+
+// SetModelID names the model the processor decodes with. The name is part of
+// each region's fingerprint, so transcribing a recording again with another
+// model decodes every region again.
+func (wp *WhisperProcessor) SetModelID(modelID string) {
+	wp.modelID = modelID
+}
+
+// decoderFingerprint identifies the models and settings chunks are decoded
+// with. Streams only schedule decoding and chunk bounds are matched on their
+// own, so both are left out.
+func (wp *WhisperProcessor) decoderFingerprint() MelFingerprint {
+	c := wp.config
+	h := sha256.New()
+	fmt.Fprintf(h, "model=%q redecode_model=%q language=%q temperature=%g beam_size=%d timestamps=%t speakers=%t",
+		wp.modelID, wp.redecodeID, c.Language, c.Temperature, c.BeamSize, c.EnableTimestamps, c.EnableSpeakers)
+	fmt.Fprintf(h, " no_speech=%g vocabulary=%q language_windows=%d noise_suppression=%t redecode_threshold=%g redecode_beam_size=%d",
+		c.NoSpeechThreshold, c.CustomVocabulary, c.LanguageWindows, c.NoiseSuppression, c.RedecodeThreshold, c.RedecodeBeamSize)
+
+	var fingerprint MelFingerprint
+	h.Sum(fingerprint[:0])
+	return fingerprint
+}
+
 // ProcessRecording processes an entire audio recording through Whisper
 func (wp *WhisperProcessor) ProcessRecording(recording *models.AudioRecording, activity *models.Activity) ([]*models.TranscriptChunk, error) {
+	transcript, err := wp.TranscribeRecording(recording, activity, nil)
+	if err != nil {
+		return nil, err
+	}
+	return transcript.Chunks, nil
+}
+
+// TranscribeRecording transcribes a recording against the regions it was
+// last transcribed in. A chunk whose samples, decoder input, model and
+// settings match a previous region keeps that region's transcript and is not
+// decoded, so transcribing a recording again costs only what changed.
+func (wp *WhisperProcessor) TranscribeRecording(recording *models.AudioRecording, activity *models.Activity, previous []models.TranscriptRegion) (*RecordingTranscript, error) {
 	wp.logger.WithFields(logrus.Fields{
-		"recording_id": recording.ID,
-		"activity_id":  activity.ID,
-		"file_path":    recording.FilePath,
+		"recording_id":     recording.ID,
+		"activity_id":      activity.ID,
+		"file_path":        recording.FilePath,
+		"previous_regions": len(previous),
 	}).Info("Starting recording transcription")
 
-	// Load and preprocess audio file
 	audioProcessor := NewAudioProcessor(wp.logger)
+	audioProcessor.SetNoiseSuppression(wp.config.NoiseSuppression)
+	if wp.melFrontend != nil {
+		transcript, err := wp.processRecordingFromMel(recording, activity, audioProcessor, previous)
+		if err == nil {
+			return transcript, nil
+		}
+		wp.logger.WithError(err).WithField("recording_id", recording.ID).Warn("Mel cache path failed, transcribing from PCM")
+	}
+
+	// Load and preprocess audio file
 	samples, err := audioProcessor.PrepareForWhisper(recording.FilePath)
 	if err != nil {
 		return nil, fmt.Errorf("failed to prepare audio: %w", err)
 	}
+	defer audioProcessor.ReleaseSamples(samples)
 
 	// Validate audio quality
 	if isValid, message := audioProcessor.ValidateAudioQuality(samples); !isValid {
@@ -195,30 +377,413 @@ func (wp *WhisperProcessor) ProcessRecording(recording *models.AudioRecording, a
 
 	wp.logger.WithField("chunk_count", len(chunks)).Info("Audio split into chunks")
 
-	// Process each chunk
-	var allChunks []*models.TranscriptChunk
+	// Without mel input there is no cheap pre-pass: the first chunk detects
+	// the language and the others are decoded in it
+	wp.language = ""
+	lockLanguage := wp.config.Language == "auto" && wp.config.LanguageWindows > 0
+
+	// Process each chunk whose samples changed since the last transcription
+	planner := newRegionPlanner(previous, wp.decoderFingerprint())
 	for i, chunk := range chunks {
+		fingerprint := planner.fingerprint(NewMelFingerprint(chunk.Samples))
+		if planner.reuse(chunk, fingerprint) {
+			continue
+		}
+
+		planner.transcript.Decoded++
 		transcriptChunk, err := wp.TranscribeChunk(chunk, activity.StartTime)
 		if err != nil {
 			wp.logger.WithError(err).WithField("chunk_index", i).Warn("Failed to transcribe chunk, skipping")
 			continue
 		}
+		if lockLanguage && wp.language == "" {
+			wp.language = wp.detected
+		}
 
 		// Set required IDs
 		transcriptChunk.ActivityID = activity.ID
 		transcriptChunk.AudioRecordingID = recording.ID
 		transcriptChunk.UserID = activity.UserID
 
-		allChunks = append(allChunks, transcriptChunk)
+		planner.record(chunk, fingerprint, transcriptChunk)
 	}
+	transcript := planner.finish(len(previous))
+	wp.report.ChunksDecoded += transcript.Decoded
+	wp.report.ChunksReused += transcript.Reused
 
 	wp.logger.WithFields(logrus.Fields{
 		"recording_id":      recording.ID,
 		"chunks_processed":  len(chunks),
-		"chunks_transcribed": len(allChunks),
+		"chunks_transcribed": len(transcript.Chunks),
+		"chunks_reused":     transcript.Reused,
 	}).Info("Recording transcription completed")
 
-	return allChunks, nil
+	return transcript, nil
+}
+
+// EnableMelCache makes the processor compute each recording's log-mel
+// spectrogram once, cache it next to the audio file and feed chunks to
+// whisper.cpp through whisper_set_mel. Overlapping chunks then share frames
+// and re-transcribing a recording skips audio decoding and the front end.
+func (wp *WhisperProcessor) EnableMelCache(modelPath string) error {
+	native, err := newNativeWhisper(wp.model)
+	if err != nil {
+		return err
+	}
+
+	frontend, err := NewMelFrontend(modelPath, wp.logger)
+	if err != nil {
+		return err
+	}
+	if frontend.NMel() != native.NMel() {
+		return fmt.Errorf("model file has %d mel filters but the loaded model expects %d", frontend.NMel(), native.NMel())
+	}
+
+	wp.native = native
+	wp.melFrontend = frontend
+	return nil
+}
+
+// SetEncoderCache makes mel input decode through the processor's own decoding
+// loop, which takes the encoder output of each window from cache. Decoding
+// the same audio again, with other settings or to retry a window, then skips
+// the encoder. Requires EnableMelCache.
+func (wp *WhisperProcessor) SetEncoderCache(cache *EncoderCache) error {
+	if wp.native == nil {
+		return fmt.Errorf("encoder cache requires mel input")
+	}
+	if cache.native.ctx != wp.native.ctx {
+		return fmt.Errorf("encoder cache belongs to another model")
+	}
+
+	wp.cache = cache
+	wp.streams = nil
+	return nil
+}
+
+// melStreams returns the processor's decoding streams. With the encoder
+// cache, config.Streams chunks decode at once on separate whisper states and
+// split the cores between them; whisper_full runs on the context's single
+// default state, so without it there is one stream.
+func (wp *WhisperProcessor) melStreams() []*melStream {
+	if wp.streams != nil {
+		return wp.streams
+	}
+
+	count := 1
+	if wp.cache != nil && wp.config.BeamSize <= 1 && wp.config.Streams > 1 {
+		count = wp.config.Streams
+		wp.cache.reserve(count)
+	}
+
+	for i := 0; i < count; i++ {
+		stream := &melStream{}
+		if wp.cache != nil {
+			stream.decoder = newMelDecoder(wp.cache, streamThreads(count))
+		}
+		wp.streams = append(wp.streams, stream)
+	}
+	return wp.streams
+}
+
+// SetRedecodeModel makes low-confidence segments decode again with a second,
+// usually larger, model instead of beam search on the processor's own model.
+// The model must use the same mel bins. Requires EnableMelCache.
+func (wp *WhisperProcessor) SetRedecodeModel(model whisper.Model, modelID string) error {
+	if wp.native == nil {
+		return fmt.Errorf("re-decoding requires mel input")
+	}
+
+	native, err := newNativeWhisper(model)
+	if err != nil {
+		return err
+	}
+	if native.NMel() != wp.native.NMel() {
+		return fmt.Errorf("re-decoding model %s has %d mel bins, expected %d", modelID, native.NMel(), wp.native.NMel())
+	}
+
+	wp.redecoder = native
+	wp.redecodeID = modelID
+	return nil
+}
+
+// Report returns what the processor decoded and re-decoded so far
+func (wp *WhisperProcessor) Report() models.TranscriptionReport {
+	return wp.report
+}
+
+// processRecordingFromMel transcribes a recording from its cached spectrogram
+func (wp *WhisperProcessor) processRecordingFromMel(recording *models.AudioRecording, activity *models.Activity, audioProcessor *AudioProcessor, previous []models.TranscriptRegion) (*RecordingTranscript, error) {
+	chunkDuration := time.Duration(wp.config.ChunkDuration) * time.Second
+	overlapDuration := time.Duration(wp.config.OverlapDuration) * time.Second
+	chunkBounds := func(totalSamples int) []AudioChunk {
+		return audioProcessor.ChunkBounds(totalSamples, chunkDuration, overlapDuration, activity.StartTime, recording.FilePath)
+	}
+
+	mel, cached, err := wp.melFrontend.melFromRecording(recording.FilePath, audioProcessor, chunkBounds)
+	if err != nil {
+		return nil, err
+	}
+	chunks := chunkBounds(mel.Samples)
+
+	// Chunks are fingerprinted by their mel input and the decoder; those
+	// matching a previous region keep its transcript and those without speech
+	// produce none
+	planner := newRegionPlanner(previous, wp.decoderFingerprint())
+	fingerprints := make([]MelFingerprint, len(chunks))
+	var pending []int
+	var scratch []float32
+	for i, chunk := range chunks {
+		input, _, _, err := mel.ChunkMel(chunk.StartSample, chunk.EndSample, scratch)
+		if err != nil {
+			pending = append(pending, i) // Decoding reports the error
+			continue
+		}
+		scratch = input
+		fingerprints[i] = planner.fingerprint(NewMelFingerprint(input))
+		if planner.reuse(chunk, fingerprints[i]) {
+			continue
+		}
+		if !mel.HasSpeech(chunk.StartSample, chunk.EndSample) {
+			wp.logger.WithField("chunk_index", i).Debug("No speech in chunk, skipping")
+			planner.record(chunk, fingerprints[i], nil)
+			continue
+		}
+		pending = append(pending, i)
+	}
+	planner.transcript.Decoded = len(pending)
+
+	wp.logger.WithFields(logrus.Fields{
+		"chunk_count":   len(chunks),
+		"chunks_reused": planner.transcript.Reused,
+		"mel_cached":    cached,
+		"mel_frames":    mel.Frames,
+	}).Info("Transcribing from log-mel spectrogram")
+
+	wp.language = ""
+	if wp.config.Language == "auto" && wp.config.LanguageWindows > 0 && len(pending) > 0 {
+		language, probability, err := wp.identifyLanguage(mel)
+		if err != nil {
+			wp.logger.WithError(err).Warn("Language identification failed, detecting per chunk")
+		} else {
+			wp.language = language
+			wp.logger.WithFields(logrus.Fields{
+				"language":    language,
+				"probability": probability,
+			}).Info("Recording language identified")
+		}
+	}
+
+	// Streams take chunks in order; results are collected by chunk index
+	streams := wp.melStreams()
+	results := make([]*models.TranscriptChunk, len(chunks))
+	errs := make([]error, len(chunks))
+	next := make(chan int)
+	var wg sync.WaitGroup
+	for _, stream := range streams {
+		wg.Add(1)
+		go func(stream *melStream) {
+			defer wg.Done()
+			for i := range next {
+				results[i], errs[i] = wp.transcribeChunkMel(stream, chunks[i], mel, activity.StartTime)
+			}
+		}(stream)
+	}
+	for _, i := range pending {
+		next <- i
+	}
+	close(next)
+	wg.Wait()
+
+	for _, stream := range streams {
+		wp.report.Merge(stream.report)
+		stream.report = models.TranscriptionReport{}
+	}
+
+	// A chunk that failed keeps no region, so the next run decodes it again
+	for _, i := range pending {
+		if errs[i] != nil {
+			wp.logger.WithError(errs[i]).WithField("chunk_index", i).Warn("Failed to transcribe chunk, skipping")
+			continue
+		}
+		transcriptChunk := results[i]
+		if transcriptChunk != nil {
+			transcriptChunk.ActivityID = activity.ID
+			transcriptChunk.AudioRecordingID = recording.ID
+			transcriptChunk.UserID = activity.UserID
+		}
+		planner.record(chunks[i], fingerprints[i], transcriptChunk)
+	}
+	transcript := planner.finish(len(previous))
+	wp.report.ChunksDecoded += transcript.Decoded
+	wp.report.ChunksReused += transcript.Reused
+
+	fields := logrus.Fields{
+		"recording_id":       recording.ID,
+		"chunks_processed":   len(chunks),
+		"chunks_transcribed": len(transcript.Chunks),
+		"chunks_reused":      transcript.Reused,
+		"streams":            len(streams),
+	}
+	if wp.language != "" {
+		fields["language"] = wp.language
+		fields["language_switches"] = wp.report.LanguageSwitches
+	}
+	if wp.config.RedecodeThreshold > 0 {
+		fields["low_confidence"] = wp.report.LowConfidence
+		fields["redecoded"] = wp.report.Redecoded
+		fields["improved"] = wp.report.Improved
+	}
+	if wp.cache != nil {
+		stats := wp.cache.Stats()
+		fields["encoder_cache_hits"] = stats.Hits
+		fields["encoder_cache_misses"] = stats.Misses
+	}
+	wp.logger.WithFields(fields).Info("Recording transcription completed")
+
+	return transcript, nil
+}
+
+// transcribeChunkMel decodes one chunk from the recording's spectrogram on a stream
+func (wp *WhisperProcessor) transcribeChunkMel(stream *melStream, chunk AudioChunk, mel *MelSpectrogram, activityStartTime time.Time) (*models.TranscriptChunk, error) {
+	input, nLen, audioFrames, err := mel.ChunkMel(chunk.StartSample, chunk.EndSample, stream.buffer)
+	if err != nil {
+		return nil, err
+	}
+	stream.buffer = input
+
+	config := wp.config
+	if wp.language != "" {
+		config.Language = wp.language
+	}
+	result, err := wp.decodeChunkMel(stream, chunk, input, mel.NMel, nLen, audioFrames, config)
+	if err != nil {
+		return nil, err
+	}
+	if wp.language != "" && stream.decoder != nil && meanConfidence(result.Segments) < languageRecheckConfidence {
+		result = wp.recheckLanguage(stream, chunk, input, mel.NMel, nLen, audioFrames, result)
+	}
+
+	language := result.Language
+	if language == "" {
+		language = config.Language
+	}
+
+	segments := make([]TranscriptSegment, 0, len(result.Segments))
+	for i, segment := range result.Segments {
+		if segment.Text == "" {
+			continue
+		}
+
+		firstPass := segment.Confidence
+		if segment.Confidence < wp.config.RedecodeThreshold {
+			stream.report.LowConfidence++
+			segment = wp.redecodeSegment(stream, chunk, mel, segment, language)
+		}
+		stream.report.AddSegment(segment.End-segment.Start, firstPass, segment.Confidence)
+
+		segments = append(segments, TranscriptSegment{
+			Text:       segment.Text,
+			StartTime:  chunk.StartTime + segment.Start,
+			EndTime:    chunk.StartTime + segment.End,
+			Confidence: segment.Confidence,
+			Language:   language,
+			Speaker:    wp.detectSpeaker(i, segment.Text),
+		})
+	}
+
+	return wp.buildTranscriptChunk(chunk, segments, activityStartTime)
+}
+
+// decodeChunkMel decodes a chunk's mel input, through the stream's cached
+// encoder decoder when possible and whisper_full otherwise
+func (wp *WhisperProcessor) decodeChunkMel(stream *melStream, chunk AudioChunk, input []float32, nMel, nLen, audioFrames int, config models.TranscriptionConfig) (*nativeResult, error) {
+	start := time.Now()
+	defer func() {
+		stream.report.DecodeTime += time.Since(start)
+	}()
+
+	// The cached-encoder decoder is greedy only
+	if stream.decoder != nil && config.BeamSize <= 1 {
+		result, err := stream.decoder.Transcribe(input, nMel, nLen, audioFrames, config)
+		if err == nil {
+			return result, nil
+		}
+		wp.logger.WithError(err).WithField("chunk_index", chunk.ChunkIndex).Warn("Cached encoder decode failed, using whisper_full")
+	}
+
+	result, err := wp.native.TranscribeMel(input, nMel, nLen, audioFrames, config)
+	if err != nil {
+		return nil, fmt.Errorf("whisper processing failed: %w", err)
+	}
+	return result, nil
+}
+
+// redecodeSegment decodes a low-confidence segment again, on its own, with
+// the re-decoding model or with beam search, and keeps the new text when its
+// confidence is higher. A little audio either side of the segment gives the
+// decoder the word boundaries back.
+func (wp *WhisperProcessor) redecodeSegment(stream *melStream, chunk AudioChunk, mel *MelSpectrogram, segment nativeSegment, language string) nativeSegment {
+	const padSamples = 3200 // 200ms
+
+	start := chunk.StartSample + int(segment.Start*melSampleRate) - padSamples
+	start -= start % melHopLength
+	if start < chunk.StartSample {
+		start = chunk.StartSample
+	}
+	end := chunk.StartSample + int(segment.End*melSampleRate) + padSamples
+	if end > chunk.EndSample {
+		end = chunk.EndSample
+	}
+	if end <= start {
+		return segment
+	}
+
+	input, nLen, audioFrames, err := mel.ChunkMel(start, end, stream.buffer)
+	if err != nil {
+		return segment
+	}
+	stream.buffer = input
+
+	config := wp.config
+	config.Language = language
+	config.Temperature = 0
+	native, method := wp.redecoder, wp.redecodeID
+	if native == nil {
+		native, method = wp.native, "beam_search"
+		config.BeamSize = wp.config.RedecodeBeamSize
+	}
+
+	begin := time.Now()
+	result, err := native.TranscribeMel(input, mel.NMel, nLen, audioFrames, config)
+	stream.report.RedecodeTime += time.Since(begin)
+	stream.report.RedecodeMethod = method
+	if err != nil {
+		wp.logger.WithError(err).WithField("chunk_index", chunk.ChunkIndex).Warn("Failed to re-decode segment")
+		return segment
+	}
+	stream.report.Redecoded++
+	stream.report.RedecodedSeconds += float64(end-start) / melSampleRate
+
+	var text strings.Builder
+	for _, redecoded := range result.Segments {
+		if redecoded.Text == "" {
+			continue
+		}
+		if text.Len() > 0 {
+			text.WriteString(" ")
+		}
+		text.WriteString(redecoded.Text)
+	}
+	confidence := meanConfidence(result.Segments)
+	if text.Len() == 0 || confidence <= segment.Confidence {
+		return segment
+	}
+
+	stream.report.Improved++
+	segment.Text = text.String()
+	segment.Confidence = confidence
+	return segment
 }
 
 // extractSegments extracts transcript segments from the Whisper context using NextSegment API
@@ -251,7 +816,7 @@ func (wp *WhisperProcessor) extractSegments(chunk AudioChunk, activityStartTime
 			Text:       text,
 			StartTime:  startTime,
 			EndTime:    endTime,
-			Confidence: 0.8, // Default confidence
+			Confidence: wp.segmentConfidence(segment),
 			Language:   wp.detectLanguage(text),
 			Speaker:    wp.detectSpeaker(segment.Num, text),
 		}
@@ -262,6 +827,19 @@ func (wp *WhisperProcessor) extractSegments(chunk AudioChunk, activityStartTime
 	return segments
 }
 
+// segmentConfidence is the geometric mean probability of a segment's text tokens
+func (wp *WhisperProcessor) segmentConfidence(segment whisper.Segment) float64 {
+	sumLogProb, textTokens := 0.0, 0
+	for _, token := range segment.Tokens {
+		if !wp.context.IsText(token) {
+			continue
+		}
+		sumLogProb += math.Log(math.Max(float64(token.P), 1e-10))
+		textTokens++
+	}
+	return tokenConfidence(sumLogProb, textTokens)
+}
+
 // TranscriptSegment represents a segment of transcribed text
 type TranscriptSegment struct {
 	Text       string  `json:"text"`
@@ -281,6 +859,9 @@ func (wp *WhisperProcessor) convertToActivityTime(absoluteTime float64, activity
 
 // detectLanguage attempts to detect the language of transcribed text
 func (wp *WhisperProcessor) detectLanguage(text string) string {
+	if wp.language != "" {
+		return wp.language
+	}
 	if wp.config.Language != "auto" {
 		return wp.config.Language
 	}
@@ -1,11 +1,15 @@
 package services
 
 import (
+	"context"
+	"errors"
 	"fmt"
+	"os"
 	"sync"
 	"time"
 
 	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/services/memory"
 	"github.com/platformlabs-co/personal-assist/services/transcription"
 	"github.com/platformlabs-co/personal-assist/storage"
 	"github.com/sirupsen/logrus"
@@ -18,8 +22,37 @@ type TranscriptionService struct {
 	storage        *storage.SQLiteStorage
 	logger         *logrus.Logger
 	modelManager   *transcription.ModelManager
+	draftModels    *transcription.ModelManager
+	refineModels   *transcription.ModelManager
+	redecodeModels *transcription.ModelManager
+	twoTier        TwoTierConfig
 	processingJobs map[string]*TranscriptionJob
+	transcribing   map[string]int // Jobs per recording, see IsTranscribing
+	purging        map[string]int // Retention claims per recording, see ClaimForPurge
 	jobMutex       sync.RWMutex
+	jobMemory      *memory.Consumer // Decoded audio of running jobs
+	stateMemory    *memory.Consumer // Whisper contexts of running jobs
+}
+
+// jobSampleFactor is the peak memory of preparing a 16-bit WAV file for
+// Whisper per byte of file: the samples as ints, then as float32 mono
+const jobSampleFactor = 6
+
+// TwoTierConfig selects the models of two-tier transcription: a fast model
+// drafts a transcript as soon as a recording stops and a larger one replaces
+// it while the machine is idle
+type TwoTierConfig struct {
+	DraftModel  string
+	RefineModel string
+}
+
+// DefaultTwoTierConfig returns the default draft and refinement models. Both
+// use 80 mel bins, so the refinement pass reuses the draft's mel cache.
+func DefaultTwoTierConfig() TwoTierConfig {
+	return TwoTierConfig{
+		DraftModel:  "tiny",
+		RefineModel: "medium",
+	}
 }
 
 // TranscriptionJob represents an ongoing transcription operation
@@ -30,6 +63,7 @@ type TranscriptionJob struct {
 	CurrentFile   string
 	StartTime     time.Time
 	Error         error
+	Report        *models.TranscriptionReport
 }
 
 // SearchFilter for transcript search (placeholder for future expansion)
@@ -50,8 +84,50 @@ func NewTranscriptionService(storage *storage.SQLiteStorage, dataDir, modelsPath
 		storage:        storage,
 		logger:         logger,
 		modelManager:   modelManager,
+		draftModels:    transcription.NewModelManager(modelsPath, logger),
+		refineModels:   transcription.NewModelManager(modelsPath, logger),
+		redecodeModels: transcription.NewModelManager(modelsPath, logger),
+		twoTier:        DefaultTwoTierConfig(),
 		processingJobs: make(map[string]*TranscriptionJob),
+		transcribing:   make(map[string]int),
+		purging:        make(map[string]int),
+		jobMemory:      memory.Default().Register("transcription jobs", memory.Heap, nil),
+		stateMemory:    memory.Default().Register("whisper contexts", memory.Native, nil),
+	}
+}
+
+// reserveJobMemory waits until a job transcribing the given files with the
+// model loaded by manager fits the memory budget, holding jobs back while
+// others run, and returns the function that ends the reservation. Files are
+// transcribed one at a time, so the largest one counts.
+func (ts *TranscriptionService) reserveJobMemory(manager *transcription.ModelManager, paths ...string) (func(), error) {
+	var samples int64
+	for _, path := range paths {
+		if stat, err := os.Stat(path); err == nil {
+			samples = max(samples, stat.Size()*jobSampleFactor)
+		}
+	}
+	var state int64
+	if active, err := manager.GetActiveModel(); err == nil {
+		state = active.StateMemory()
+	}
+
+	start := time.Now()
+	if err := ts.jobMemory.Reserve(context.Background(), samples+state); err != nil {
+		return nil, err
+	}
+	ts.jobMemory.Move(ts.stateMemory, state)
+	if waited := time.Since(start); waited > time.Second {
+		ts.logger.WithFields(logrus.Fields{
+			"waited":     waited.String(),
+			"reserve_mb": (samples + state) / memory.MB,
+		}).Info("Transcription job waited for memory")
 	}
+
+	return func() {
+		ts.stateMemory.Release(state)
+		ts.jobMemory.Release(samples)
+	}, nil
 }
 
 // ProcessActivity transcribes all audio recordings in an activity
@@ -73,6 +149,12 @@ func (ts *TranscriptionService) ProcessActivity(userID, activityID string, confi
 		return fmt.Errorf("no recordings found for activity %s", activityID)
 	}
 
+	// Keep retention away from the audio, skipping audio it removed
+	recordings, release, err := ts.trackAudio(userID, recordings)
+	if err != nil {
+		return err
+	}
+
 	// Start transcription job
 	job := &TranscriptionJob{
 		ActivityID:  activityID,
@@ -87,7 +169,10 @@ func (ts *TranscriptionService) ProcessActivity(userID, activityID string, confi
 	ts.jobMutex.Unlock()
 
 	// Process each recording (simplified implementation)
-	go ts.processActivityAsync(userID, activityID, recordings, job)
+	go func() {
+		defer release()
+		ts.processActivityAsync(userID, activityID, recordings, job)
+	}()
 
 	return nil
 }
@@ -107,6 +192,12 @@ func (ts *TranscriptionService) ProcessRecording(userID, activityID, recordingID
 		return fmt.Errorf("failed to get audio recording: %w", err)
 	}
 
+	// Keep retention away from the audio
+	recording, release, err := ts.trackRecordingAudio(userID, recording)
+	if err != nil {
+		return err
+	}
+
 	// Start transcription job
 	job := &TranscriptionJob{
 		ActivityID:  activityID,
@@ -121,7 +212,10 @@ func (ts *TranscriptionService) ProcessRecording(userID, activityID, recordingID
 	ts.jobMutex.Unlock()
 
 	// Process the recording (simplified implementation)
-	go ts.processRecordingAsync(userID, activityID, recording, job)
+	go func() {
+		defer release()
+		ts.processRecordingAsync(userID, activityID, recording, job)
+	}()
 
 	return nil
 }
@@ -136,10 +230,10 @@ func (ts *TranscriptionService) GetRecordingTranscript(userID, recordingID strin
 	return ts.storage.GetRecordingTranscripts(userID, recordingID)
 }
 
-// SearchTranscripts searches through transcript content
+// SearchTranscripts searches through transcript content with the full-text
+// index, matching the query's words as a phrase, see
+// storage.SQLiteStorage.SearchTranscripts. The filter is not applied yet.
 func (ts *TranscriptionService) SearchTranscripts(userID string, query string, filter SearchFilter) ([]*models.TranscriptChunk, error) {
-	// For now, implement a simple search
-	// In a production system, you'd use FTS5 or similar
 	return ts.storage.SearchTranscripts(userID, query)
 }
 
@@ -178,10 +272,114 @@ func (ts *TranscriptionService) GetTranscriptionStatus(userID, activityID string
 	if job.Error != nil {
 		status.LastError = job.Error.Error()
 	}
+	if job.Report != nil {
+		report := *job.Report
+		status.Report = &report
+	}
 
 	return status, nil
 }
 
+// HasActiveJobs reports whether any transcription is still processing
+func (ts *TranscriptionService) HasActiveJobs() bool {
+	ts.jobMutex.RLock()
+	defer ts.jobMutex.RUnlock()
+
+	for _, job := range ts.processingJobs {
+		if job.Status == "processing" {
+			return true
+		}
+	}
+	return false
+}
+
+// IsTranscribing reports whether a job is transcribing the recording
+func (ts *TranscriptionService) IsTranscribing(recordingID string) bool {
+	ts.jobMutex.RLock()
+	defer ts.jobMutex.RUnlock()
+	return ts.transcribing[recordingID] > 0
+}
+
+// ClaimForPurge claims a recording for retention to delete its audio until
+// the returned function is called. It returns false, claiming nothing, while
+// a job is transcribing the recording; jobs do not start on a claimed one.
+func (ts *TranscriptionService) ClaimForPurge(recordingID string) (func(), bool) {
+	ts.jobMutex.Lock()
+	defer ts.jobMutex.Unlock()
+	if ts.transcribing[recordingID] > 0 {
+		return nil, false
+	}
+	ts.purging[recordingID]++
+
+	return func() {
+		ts.jobMutex.Lock()
+		defer ts.jobMutex.Unlock()
+		if ts.purging[recordingID]--; ts.purging[recordingID] <= 0 {
+			delete(ts.purging, recordingID)
+		}
+	}, true
+}
+
+// trackAudio marks the recordings retention has not claimed as being
+// transcribed until the returned function is called, and returns those that
+// still have audio as stored once marked. Reading them again after marking
+// leaves out audio purged since they were first read.
+func (ts *TranscriptionService) trackAudio(userID string, recordings []*models.AudioRecording) ([]*models.AudioRecording, func(), error) {
+	ts.jobMutex.Lock()
+	recordingIDs := make([]string, 0, len(recordings))
+	for _, recording := range recordings {
+		if ts.purging[recording.ID] == 0 {
+			recordingIDs = append(recordingIDs, recording.ID)
+		}
+	}
+	release := ts.trackRecordingsLocked(recordingIDs...)
+	ts.jobMutex.Unlock()
+
+	tracked := make([]*models.AudioRecording, 0, len(recordingIDs))
+	for _, id := range recordingIDs {
+		recording, err := ts.storage.GetAudioRecording(userID, id)
+		if err != nil {
+			release()
+			return nil, nil, fmt.Errorf("failed to get audio recording: %w", err)
+		}
+		if recording.HasAudio() {
+			tracked = append(tracked, recording)
+		}
+	}
+	return tracked, release, nil
+}
+
+// trackRecordingAudio is trackAudio for a single recording, failing when
+// retention removed or is removing its audio
+func (ts *TranscriptionService) trackRecordingAudio(userID string, recording *models.AudioRecording) (*models.AudioRecording, func(), error) {
+	tracked, release, err := ts.trackAudio(userID, []*models.AudioRecording{recording})
+	if err != nil {
+		return nil, nil, err
+	}
+	if len(tracked) == 0 {
+		release()
+		return nil, nil, fmt.Errorf("audio for recording %s was removed by the retention policy", recording.ID)
+	}
+	return tracked[0], release, nil
+}
+
+// trackRecordingsLocked is trackRecordings with jobMutex held
+func (ts *TranscriptionService) trackRecordingsLocked(recordingIDs ...string) func() {
+	for _, id := range recordingIDs {
+		ts.transcribing[id]++
+	}
+
+	return func() {
+		ts.jobMutex.Lock()
+		defer ts.jobMutex.Unlock()
+		for _, id := range recordingIDs {
+			if ts.transcribing[id]--; ts.transcribing[id] <= 0 {
+				delete(ts.transcribing, id)
+			}
+		}
+	}
+}
+
 // GetAvailableModels returns available Whisper models (placeholder)
 func (ts *TranscriptionService) GetAvailableModels() ([]models.WhisperModel, error) {
 	// Placeholder implementation
@@ -283,6 +481,22 @@ func (ts *TranscriptionService) processActivityAsync(userID, activityID string,
 		return
 	}
 
+	// Wait for memory while other jobs run
+	var paths []string
+	for _, recording := range recordings {
+		if recording.HasAudio() {
+			paths = append(paths, ts.dataDir+"/"+recording.FilePath)
+		}
+	}
+	release, err := ts.reserveJobMemory(ts.modelManager, paths...)
+	if err != nil {
+		ts.jobMutex.Lock()
+		job.Error = err
+		ts.jobMutex.Unlock()
+		return
+	}
+	defer release()
+
 	ts.logger.Info("Creating Whisper processor with loaded model")
 
 	// Create Whisper processor using the loaded model
@@ -295,9 +509,24 @@ func (ts *TranscriptionService) processActivityAsync(userID, activityID string,
 		return
 	}
 	defer processor.Close()
+	ts.enableMelCache(ts.modelManager, processor)
+	ts.enableRedecoding(ts.modelManager, processor, config)
+	model, err := ts.modelManager.GetActiveModel()
+	if err != nil {
+		ts.jobMutex.Lock()
+		job.Error = fmt.Errorf("failed to load whisper model: %w", err)
+		ts.jobMutex.Unlock()
+		return
+	}
+	processor.SetModelID(model.ID)
 
 	// Process each recording
 	for i, recording := range recordings {
+		// Audio removed by retention, keep its existing transcript as is
+		if !recording.HasAudio() {
+			continue
+		}
+
 		// Construct full file path
 		fullPath := ts.dataDir + "/" + recording.FilePath
 
@@ -313,39 +542,122 @@ func (ts *TranscriptionService) processActivityAsync(userID, activityID string,
 		job.CurrentFile = fullPath
 		ts.jobMutex.Unlock()
 
-		// Update recording with full path for processing
-		recordingWithFullPath := *recording
-		recordingWithFullPath.FilePath = fullPath
-
-		// Process the recording with Whisper
-		chunks, err := processor.ProcessRecording(&recordingWithFullPath, activity)
+		// Process the recording with Whisper, decoding only what changed
+		transcript, err := ts.transcribeIncrementally(processor, model, recording, fullPath, activity)
 		if err != nil {
-			ts.logger.WithError(err).Error("Failed to process recording with Whisper")
+			ts.logger.WithError(err).Error("Failed to transcribe recording")
 			ts.jobMutex.Lock()
-			job.Error = fmt.Errorf("failed to process recording: %w", err)
+			job.Error = err
 			ts.jobMutex.Unlock()
 			return
 		}
 
-		// Store transcript chunks
-		for _, chunk := range chunks {
-			err := ts.storage.SaveTranscriptChunk(chunk)
-			if err != nil {
-				ts.logger.WithError(err).Error("Failed to save transcript chunk")
-				ts.jobMutex.Lock()
-				job.Error = fmt.Errorf("failed to save transcript chunk: %w", err)
-				ts.jobMutex.Unlock()
-				return
-			}
-		}
+		ts.setJobReport(job, processor)
 
 		ts.logger.WithFields(logrus.Fields{
-			"recording_id": recording.ID,
-			"chunk_count":  len(chunks),
+			"recording_id":   recording.ID,
+			"chunk_count":    len(transcript.Chunks),
+			"chunks_decoded": transcript.Decoded,
+			"chunks_reused":  transcript.Reused,
 		}).Info("Recording transcribed successfully")
 	}
 }
 
+// transcribeIncrementally transcribes a recording against the regions it
+// was last transcribed in and replaces the chunks of the regions that
+// changed, labelling the transcript with the model's tier. Regions only
+// match when decoded with the same model and settings, so the transcript
+// never mixes models. Nothing is written when nothing changed. A recording
+// without regions is decoded in full and its transcript replaced, dropping
+// chunks an earlier run appended.
+func (ts *TranscriptionService) transcribeIncrementally(processor *transcription.WhisperProcessor, model *models.WhisperModel, recording *models.AudioRecording, fullPath string, activity *models.Activity) (*transcription.RecordingTranscript, error) {
+	previous, err := ts.storage.GetTranscriptRegions(recording.ID)
+	if err != nil {
+		return nil, fmt.Errorf("failed to get transcript regions: %w", err)
+	}
+
+	recordingWithFullPath := *recording
+	recordingWithFullPath.FilePath = fullPath
+	transcript, err := processor.TranscribeRecording(&recordingWithFullPath, activity, previous)
+	if err != nil {
+		return nil, fmt.Errorf("failed to process recording: %w", err)
+	}
+	if transcript.Unchanged() {
+		return transcript, nil
+	}
+
+	if _, err := ts.storage.ReplaceRecordingTranscript(recording.ID, transcript.Chunks, transcript.Regions, ts.transcriptTier(model), model.ID, ""); err != nil {
+		return nil, fmt.Errorf("failed to save transcript chunks: %w", err)
+	}
+	return transcript, nil
+}
+
+// transcriptTier returns the tier of a transcript decoded outside the draft
+// and refinement passes: draft for the draft model, final for any other
+func (ts *TranscriptionService) transcriptTier(model *models.WhisperModel) string {
+	isModel := func(modelID string) bool {
+		return model.ID == modelID || model.Quantizes == modelID
+	}
+	if isModel(ts.twoTier.DraftModel) && !isModel(ts.twoTier.RefineModel) {
+		return models.TranscriptTierDraft
+	}
+	return models.TranscriptTierFinal
+}
+
+// enableMelCache switches a processor to cached log-mel input and cached
+// encoder output, falling back to PCM input when the loaded model does not allow it
+func (ts *TranscriptionService) enableMelCache(manager *transcription.ModelManager, processor *transcription.WhisperProcessor) {
+	modelPath := manager.GetLoadedModelPath()
+	if modelPath == "" {
+		return
+	}
+	if err := processor.EnableMelCache(modelPath); err != nil {
+		ts.logger.WithError(err).Warn("Mel cache unavailable, transcribing from PCM")
+		return
+	}
+
+	if cache := manager.GetEncoderCache(); cache != nil {
+		if err := processor.SetEncoderCache(cache); err != nil {
+			ts.logger.WithError(err).Warn("Encoder cache unavailable, decoding with whisper_full")
+		}
+	}
+}
+
+// enableRedecoding loads the model that re-decodes low-confidence segments
+// when the config names one. Until it is downloaded, and when no model is
+// named, the processor re-decodes with beam search instead.
+func (ts *TranscriptionService) enableRedecoding(manager *transcription.ModelManager, processor *transcription.WhisperProcessor, config models.TranscriptionConfig) {
+	modelID := config.RedecodeModel
+	if config.RedecodeThreshold <= 0 || modelID == "" {
+		return
+	}
+	if active, err := manager.GetActiveModel(); err == nil && (active.ID == modelID || active.Quantizes == modelID) {
+		return
+	}
+
+	if !ts.redecodeModels.IsModelDownloaded(modelID) {
+		if err := ts.redecodeModels.DownloadModel(modelID); err != nil {
+			ts.logger.WithError(err).WithField("model", modelID).Warn("Failed to queue re-decoding model download")
+		}
+		return
+	}
+	if err := ts.redecodeModels.EnsureModel(modelID); err != nil {
+		ts.logger.WithError(err).WithField("model", modelID).Warn("Failed to load re-decoding model, using beam search")
+		return
+	}
+	if err := processor.SetRedecodeModel(ts.redecodeModels.GetLoadedModel(), modelID); err != nil {
+		ts.logger.WithError(err).WithField("model", modelID).Warn("Re-decoding model unavailable, using beam search")
+	}
+}
+
+// setJobReport publishes the processor's re-decoding report on a job
+func (ts *TranscriptionService) setJobReport(job *TranscriptionJob, processor *transcription.WhisperProcessor) {
+	report := processor.Report()
+	ts.jobMutex.Lock()
+	job.Report = &report
+	ts.jobMutex.Unlock()
+}
+
 // processRecordingAsync processes a single recording asynchronously using Whisper
 func (ts *TranscriptionService) processRecordingAsync(userID, activityID string, recording *models.AudioRecording, job *TranscriptionJob) {
 	defer func() {
@@ -367,10 +679,6 @@ func (ts *TranscriptionService) processRecordingAsync(userID, activityID string,
 		"file_path":    fullPath,
 	}).Info("Processing single recording with Whisper")
 
-	// Update recording with full path for processing
-	recordingWithFullPath := *recording
-	recordingWithFullPath.FilePath = fullPath
-
 	// Get activity details
 	activity, err := ts.storage.GetActivity(userID, activityID)
 	if err != nil {
@@ -405,6 +713,16 @@ func (ts *TranscriptionService) processRecordingAsync(userID, activityID string,
 		return
 	}
 
+	// Wait for memory while other jobs run
+	release, err := ts.reserveJobMemory(ts.modelManager, fullPath)
+	if err != nil {
+		ts.jobMutex.Lock()
+		job.Error = err
+		ts.jobMutex.Unlock()
+		return
+	}
+	defer release()
+
 	ts.logger.Info("Creating Whisper processor with loaded model")
 
 	// Create Whisper processor using the loaded model
@@ -417,41 +735,264 @@ func (ts *TranscriptionService) processRecordingAsync(userID, activityID string,
 		return
 	}
 	defer processor.Close()
+	ts.enableMelCache(ts.modelManager, processor)
+	ts.enableRedecoding(ts.modelManager, processor, config)
+	model, err := ts.modelManager.GetActiveModel()
+	if err != nil {
+		ts.jobMutex.Lock()
+		job.Error = fmt.Errorf("failed to load whisper model: %w", err)
+		ts.jobMutex.Unlock()
+		return
+	}
+	processor.SetModelID(model.ID)
 
-	// Process the recording
-	chunks, err := processor.ProcessRecording(&recordingWithFullPath, activity)
+	// Process the recording, decoding only what changed
+	transcript, err := ts.transcribeIncrementally(processor, model, recording, fullPath, activity)
 	if err != nil {
-		ts.logger.WithError(err).Error("Failed to process recording with Whisper")
+		ts.logger.WithError(err).Error("Failed to transcribe recording")
 		ts.jobMutex.Lock()
-		job.Error = fmt.Errorf("failed to process recording: %w", err)
+		job.Error = err
 		ts.jobMutex.Unlock()
 		return
 	}
 
-	ts.logger.WithField("chunk_count", len(chunks)).Info("Transcription completed, saving chunks")
+	ts.setJobReport(job, processor)
+
+	ts.logger.WithFields(logrus.Fields{
+		"activity_id":    activityID,
+		"recording_id":   recording.ID,
+		"chunk_count":    len(transcript.Chunks),
+		"chunks_decoded": transcript.Decoded,
+		"chunks_reused":  transcript.Reused,
+	}).Info("Transcription saved successfully")
+}
+
+// ErrAlreadyTranscribing is returned by DraftRecording when another job is
+// transcribing the recording; its transcript would race the draft's
+var ErrAlreadyTranscribing = errors.New("recording is already being transcribed")
 
-	// Store transcript chunks
-	for _, chunk := range chunks {
-		err := ts.storage.SaveTranscriptChunk(chunk)
+// DraftRecording transcribes a recording that just stopped with the fast
+// draft model and returns the activity it belongs to. The draft is replaced
+// later by the refinement pass, see RefineDraft. It returns
+// ErrAlreadyTranscribing, and drafts nothing, if a job for the recording is
+// already running.
+func (ts *TranscriptionService) DraftRecording(userID, recordingID string) (string, error) {
+	recording, err := ts.storage.GetAudioRecording(userID, recordingID)
+	if err != nil {
+		return "", fmt.Errorf("failed to get audio recording: %w", err)
+	}
+	if !recording.HasAudio() {
+		return "", fmt.Errorf("audio for recording %s was removed by the retention policy", recordingID)
+	}
+
+	ts.jobMutex.Lock()
+	if ts.transcribing[recording.ID] > 0 {
+		ts.jobMutex.Unlock()
+		return recording.ActivityID, ErrAlreadyTranscribing
+	}
+	if ts.purging[recording.ID] > 0 {
+		ts.jobMutex.Unlock()
+		return "", fmt.Errorf("audio for recording %s was removed by the retention policy", recordingID)
+	}
+	release := ts.trackRecordingsLocked(recording.ID)
+	ts.jobMutex.Unlock()
+
+	// Audio purged since the recording was read
+	recording, err = ts.storage.GetAudioRecording(userID, recordingID)
+	if err != nil {
+		release()
+		return "", fmt.Errorf("failed to get audio recording: %w", err)
+	}
+	if !recording.HasAudio() {
+		release()
+		return "", fmt.Errorf("audio for recording %s was removed by the retention policy", recordingID)
+	}
+
+	job := &TranscriptionJob{
+		ActivityID:  recording.ActivityID,
+		Status:      "processing",
+		Progress:    0.0,
+		CurrentFile: recording.FilePath,
+		StartTime:   time.Now(),
+	}
+
+	ts.jobMutex.Lock()
+	ts.processingJobs[recording.ActivityID] = job
+	ts.jobMutex.Unlock()
+
+	go func() {
+		defer release()
+		ts.draftRecordingAsync(userID, recording, job)
+	}()
+
+	return recording.ActivityID, nil
+}
+
+// draftRecordingAsync produces the draft transcript of a recording
+func (ts *TranscriptionService) draftRecordingAsync(userID string, recording *models.AudioRecording, job *TranscriptionJob) {
+	defer func() {
+		ts.jobMutex.Lock()
+		if job.Error == nil {
+			job.Status = "completed"
+			job.Progress = 1.0
+		} else {
+			job.Status = "failed"
+		}
+		ts.jobMutex.Unlock()
+	}()
+
+	fail := func(err error) {
+		ts.logger.WithError(err).WithField("recording_id", recording.ID).Error("Draft transcription failed")
+		ts.jobMutex.Lock()
+		job.Error = err
+		ts.jobMutex.Unlock()
+	}
+
+	activity, err := ts.storage.GetActivity(userID, recording.ActivityID)
+	if err != nil {
+		fail(fmt.Errorf("failed to get activity: %w", err))
+		return
+	}
+
+	// Draft with the default model while the draft model downloads
+	manager, modelID := ts.draftModels, ts.twoTier.DraftModel
+	if !manager.IsModelDownloaded(modelID) {
+		if err := manager.DownloadModel(modelID); err != nil {
+			ts.logger.WithError(err).WithField("model", modelID).Warn("Failed to queue draft model download")
+		}
+		if err := ts.modelManager.EnsureDefaultModel(); err != nil {
+			fail(fmt.Errorf("failed to load whisper model: %w", err))
+			return
+		}
+		active, err := ts.modelManager.GetActiveModel()
 		if err != nil {
-			ts.logger.WithError(err).Error("Failed to save transcript chunk")
-			ts.jobMutex.Lock()
-			job.Error = fmt.Errorf("failed to save transcript chunk: %w", err)
-			ts.jobMutex.Unlock()
+			fail(fmt.Errorf("failed to load whisper model: %w", err))
 			return
 		}
+		manager, modelID = ts.modelManager, active.ID
+	}
+
+	tier := models.TranscriptTierDraft
+	if modelID == ts.twoTier.RefineModel {
+		tier = models.TranscriptTierFinal
+	}
+
+	if _, err := ts.transcribeWithModel(manager, modelID, recording, activity, tier, "", job); err != nil {
+		fail(err)
+	}
+}
+
+// RefinementReady reports whether the refinement model is on disk, queuing
+// its download when it is not
+func (ts *TranscriptionService) RefinementReady() bool {
+	modelID := ts.twoTier.RefineModel
+	if ts.refineModels.IsModelDownloaded(modelID) {
+		return true
+	}
+	if err := ts.refineModels.DownloadModel(modelID); err != nil {
+		ts.logger.WithError(err).WithField("model", modelID).Warn("Failed to queue refinement model download")
+	}
+	return false
+}
+
+// RefineDraft replaces a draft transcript with one from the refinement
+// model. It returns false when the transcript stopped being a draft, for
+// example because the recording was transcribed again meanwhile.
+func (ts *TranscriptionService) RefineDraft(draft *storage.DraftTranscript) (bool, error) {
+	recording, err := ts.storage.GetAudioRecording(draft.UserID, draft.RecordingID)
+	if err != nil {
+		return false, fmt.Errorf("failed to get audio recording: %w", err)
+	}
+	activity, err := ts.storage.GetActivity(draft.UserID, draft.ActivityID)
+	if err != nil {
+		return false, fmt.Errorf("failed to get activity: %w", err)
+	}
+
+	recording, release, err := ts.trackRecordingAudio(draft.UserID, recording)
+	if err != nil {
+		return false, err
+	}
+	defer release()
+
+	return ts.transcribeWithModel(ts.refineModels, ts.twoTier.RefineModel, recording, activity, models.TranscriptTierFinal, models.TranscriptTierDraft, nil)
+}
+
+// ReleaseRefinementModel unloads the refinement model while no draft needs it
+func (ts *TranscriptionService) ReleaseRefinementModel() {
+	ts.refineModels.Unload()
+}
+
+// transcribeWithModel transcribes a recording with one model and replaces
+// the recording's transcript with the result, see ReplaceRecordingTranscript.
+// Preprocessing and speech detection come from the recording's mel cache, so
+// a second model reuses the work of the first. job, when set, receives the
+// re-decoding report.
+func (ts *TranscriptionService) transcribeWithModel(manager *transcription.ModelManager, modelID string, recording *models.AudioRecording, activity *models.Activity, tier, onlyIfTier string, job *TranscriptionJob) (bool, error) {
+	if err := manager.EnsureModel(modelID); err != nil {
+		return false, fmt.Errorf("failed to load whisper model: %w", err)
+	}
+	loadedModel := manager.GetLoadedModel()
+	if loadedModel == nil {
+		return false, fmt.Errorf("failed to load whisper model")
+	}
+
+	recordingWithFullPath := *recording
+	recordingWithFullPath.FilePath = ts.dataDir + "/" + recording.FilePath
+
+	release, err := ts.reserveJobMemory(manager, recordingWithFullPath.FilePath)
+	if err != nil {
+		return false, err
+	}
+	defer release()
+
+	config := models.DefaultTranscriptionConfig()
+	processor, err := transcription.NewWhisperProcessorFromModel(loadedModel, config, ts.logger)
+	if err != nil {
+		return false, fmt.Errorf("failed to load whisper model: %w", err)
+	}
+	defer processor.Close()
+	ts.enableMelCache(manager, processor)
+	ts.enableRedecoding(manager, processor, config)
+	if active, err := manager.GetActiveModel(); err == nil {
+		processor.SetModelID(active.ID)
+	}
+
+	start := time.Now()
+	transcript, err := processor.TranscribeRecording(&recordingWithFullPath, activity, nil)
+	if err != nil {
+		return false, fmt.Errorf("failed to process recording: %w", err)
+	}
+	if job != nil {
+		ts.setJobReport(job, processor)
+	}
+	report := processor.Report()
+
+	chunks := transcript.Chunks
+	replaced, err := ts.storage.ReplaceRecordingTranscript(recording.ID, chunks, transcript.Regions, tier, modelID, onlyIfTier)
+	if err != nil {
+		return false, err
 	}
 
 	ts.logger.WithFields(logrus.Fields{
-		"activity_id":  activityID,
 		"recording_id": recording.ID,
+		"model":        modelID,
+		"tier":         tier,
 		"chunk_count":  len(chunks),
-	}).Info("Transcription saved successfully")
+		"replaced":     replaced,
+		"duration":     time.Since(start).String(),
+		"confidence":   report.Confidence,
+		"redecoded":    report.Redecoded,
+	}).Info("Recording transcript stored")
+
+	return replaced, nil
 }
 
 // Close cleans up the transcription service
 func (ts *TranscriptionService) Close() error {
 	ts.logger.Info("Closing transcription service")
+	ts.draftModels.Close()
+	ts.refineModels.Close()
+	ts.redecodeModels.Close()
 	if ts.modelManager != nil {
 		return ts.modelManager.Close()
 	}
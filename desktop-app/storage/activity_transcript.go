@@ -0,0 +1,347 @@
+package storage
+
+import (
+	"encoding/binary"
+	"errors"
+	"math"
+	"math/bits"
+	"sort"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/database"
+	"github.com/platformlabs-co/personal-assist/models"
+)
+
+// An activity's transcript is materialized as one blob, so reading the whole
+// transcript is a single row instead of one per chunk. Integers are uvarints
+// unless noted:
+//
+//	version byte
+//	ID of the transcript dictionary the rest is compressed with, 0 for none
+//
+// and compressed by the database's TranscriptCodec:
+//
+//	string count, then each string as its length and bytes
+//	segment count n
+//	n offsets of the segments from the first, uint32 little endian
+//	n segments, ordered by start time
+//
+// A segment is one chunk: start and end time, ID, user and recording as
+// string indexes, text, a flags byte, then the speaker, confidence and
+// language the flags mark present, and the creation time in Unix seconds as
+// a varint. Times are float64 bits byte-reversed before varint encoding, as
+// gob does, so whole and half seconds take two or three bytes. The offset
+// index lets a chunk be placed by start time without decoding the others.
+// Compressing the whole blob rather than each text lets the IDs and the
+// phrases chunks repeat match across segments; the chunk rows keep their
+// own text_z for the full-text index.
+
+// activityTranscriptVersion is the version byte of the blob layout. Blobs
+// of earlier versions do not decode and are rebuilt from the chunk rows.
+const activityTranscriptVersion = 2
+
+// Flags of a segment's optional fields
+const (
+	segmentSpeaker = 1 << iota
+	segmentConfidence
+	segmentLanguage
+)
+
+// errCorruptTranscript is returned for a blob that does not decode
+var errCorruptTranscript = errors.New("corrupt activity transcript")
+
+// activityTranscript is a materialized transcript with its segments left
+// encoded
+type activityTranscript struct {
+	strings  []string
+	lookup   map[string]uint64
+	offsets  []uint32
+	segments []byte
+}
+
+// newActivityTranscript encodes chunks ordered by start time
+func newActivityTranscript(chunks []*models.TranscriptChunk) *activityTranscript {
+	t := &activityTranscript{lookup: make(map[string]uint64)}
+	for _, chunk := range chunks {
+		t.offsets = append(t.offsets, uint32(len(t.segments)))
+		t.segments = t.appendSegment(t.segments, chunk)
+	}
+	return t
+}
+
+// parseActivityTranscript decompresses a blob and decodes its header
+func parseActivityTranscript(codec *database.TranscriptCodec, data []byte) (*activityTranscript, error) {
+	r := &blobReader{data: data}
+	if r.byte() != activityTranscriptVersion {
+		return nil, errCorruptTranscript
+	}
+	dictionaryID := r.uvarint()
+	if r.err != nil || dictionaryID > math.MaxInt64 {
+		return nil, errCorruptTranscript
+	}
+	body, err := codec.DecompressBlob(r.data, int64(dictionaryID))
+	if err != nil {
+		return nil, err
+	}
+
+	r = &blobReader{data: body}
+	count := r.uvarint()
+	if count > uint64(len(r.data)) {
+		return nil, errCorruptTranscript
+	}
+	t := &activityTranscript{
+		strings: make([]string, 0, count),
+		lookup:  make(map[string]uint64, count),
+	}
+	for i := uint64(0); i < count && r.err == nil; i++ {
+		s := r.string()
+		t.lookup[s] = i
+		t.strings = append(t.strings, s)
+	}
+
+	n := r.uvarint()
+	if n > uint64(len(r.data))/4 {
+		return nil, errCorruptTranscript
+	}
+	index := r.bytes(n * 4)
+	t.offsets = make([]uint32, n)
+	for i := range t.offsets {
+		t.offsets[i] = binary.LittleEndian.Uint32(index[i*4:])
+	}
+	t.segments = r.data
+	if r.err != nil {
+		return nil, r.err
+	}
+	for _, offset := range t.offsets {
+		if int(offset) >= len(t.segments) {
+			return nil, errCorruptTranscript
+		}
+	}
+	return t, nil
+}
+
+// Len returns the number of chunks
+func (t *activityTranscript) Len() int {
+	return len(t.offsets)
+}
+
+// Encode returns the blob, compressed with the codec
+func (t *activityTranscript) Encode(codec *database.TranscriptCodec) ([]byte, error) {
+	size := 2*binary.MaxVarintLen64 + 4*len(t.offsets) + len(t.segments)
+	for _, s := range t.strings {
+		size += binary.MaxVarintLen64 + len(s)
+	}
+	body := make([]byte, 0, size)
+	body = binary.AppendUvarint(body, uint64(len(t.strings)))
+	for _, s := range t.strings {
+		body = binary.AppendUvarint(body, uint64(len(s)))
+		body = append(body, s...)
+	}
+	body = binary.AppendUvarint(body, uint64(len(t.offsets)))
+	for _, offset := range t.offsets {
+		body = binary.LittleEndian.AppendUint32(body, offset)
+	}
+	body = append(body, t.segments...)
+
+	compressed, dictionaryID, err := codec.CompressBlob(body)
+	if err != nil {
+		return nil, err
+	}
+	data := make([]byte, 0, 1+binary.MaxVarintLen64+len(compressed))
+	data = append(data, activityTranscriptVersion)
+	data = binary.AppendUvarint(data, uint64(dictionaryID))
+	return append(data, compressed...), nil
+}
+
+// Chunks decodes every chunk, in start time order
+func (t *activityTranscript) Chunks(activityID string) ([]*models.TranscriptChunk, error) {
+	chunks := make([]*models.TranscriptChunk, 0, len(t.offsets))
+	for i := range t.offsets {
+		chunk, err := t.Chunk(i, activityID)
+		if err != nil {
+			return nil, err
+		}
+		chunks = append(chunks, chunk)
+	}
+	return chunks, nil
+}
+
+// Chunk decodes the i-th chunk
+func (t *activityTranscript) Chunk(i int, activityID string) (*models.TranscriptChunk, error) {
+	r := &blobReader{data: t.segments[t.offsets[i]:]}
+	chunk := &models.TranscriptChunk{ActivityID: activityID}
+	chunk.StartTime = r.float()
+	chunk.EndTime = r.float()
+	chunk.ID = r.string()
+	chunk.UserID = t.stringAt(r)
+	chunk.AudioRecordingID = t.stringAt(r)
+	chunk.Text = r.string()
+	flags := r.byte()
+	if flags&segmentSpeaker != 0 {
+		speaker := t.stringAt(r)
+		chunk.Speaker = &speaker
+	}
+	if flags&segmentConfidence != 0 {
+		confidence := r.float()
+		chunk.Confidence = &confidence
+	}
+	if flags&segmentLanguage != 0 {
+		language := t.stringAt(r)
+		chunk.Language = &language
+	}
+	chunk.CreatedAt = time.Unix(r.varint(), 0)
+	if r.err != nil {
+		return nil, r.err
+	}
+	return chunk, nil
+}
+
+// Insert adds a chunk after those starting no later than it, splicing its
+// segment in without re-encoding the others
+func (t *activityTranscript) Insert(chunk *models.TranscriptChunk) {
+	at := sort.Search(len(t.offsets), func(i int) bool {
+		r := &blobReader{data: t.segments[t.offsets[i]:]}
+		return r.float() > chunk.StartTime
+	})
+	position := len(t.segments)
+	if at < len(t.offsets) {
+		position = int(t.offsets[at])
+	}
+
+	segment := t.appendSegment(nil, chunk)
+	segments := make([]byte, 0, len(t.segments)+len(segment))
+	segments = append(segments, t.segments[:position]...)
+	segments = append(segments, segment...)
+	t.segments = append(segments, t.segments[position:]...)
+
+	t.offsets = append(t.offsets, 0)
+	copy(t.offsets[at+1:], t.offsets[at:])
+	t.offsets[at] = uint32(position)
+	for i := at + 1; i < len(t.offsets); i++ {
+		t.offsets[i] += uint32(len(segment))
+	}
+}
+
+// appendSegment appends the segment of a chunk, adding its strings to the
+// table
+func (t *activityTranscript) appendSegment(data []byte, chunk *models.TranscriptChunk) []byte {
+	data = appendFloat(data, chunk.StartTime)
+	data = appendFloat(data, chunk.EndTime)
+	data = appendString(data, chunk.ID)
+	data = binary.AppendUvarint(data, t.intern(chunk.UserID))
+	data = binary.AppendUvarint(data, t.intern(chunk.AudioRecordingID))
+	data = appendString(data, chunk.Text)
+
+	var flags byte
+	if chunk.Speaker != nil {
+		flags |= segmentSpeaker
+	}
+	if chunk.Confidence != nil {
+		flags |= segmentConfidence
+	}
+	if chunk.Language != nil {
+		flags |= segmentLanguage
+	}
+	data = append(data, flags)
+	if chunk.Speaker != nil {
+		data = binary.AppendUvarint(data, t.intern(*chunk.Speaker))
+	}
+	if chunk.Confidence != nil {
+		data = appendFloat(data, *chunk.Confidence)
+	}
+	if chunk.Language != nil {
+		data = binary.AppendUvarint(data, t.intern(*chunk.Language))
+	}
+	return binary.AppendVarint(data, chunk.CreatedAt.Unix())
+}
+
+// intern returns the index of a string in the table, adding it if new
+func (t *activityTranscript) intern(s string) uint64 {
+	if i, ok := t.lookup[s]; ok {
+		return i
+	}
+	i := uint64(len(t.strings))
+	t.strings = append(t.strings, s)
+	t.lookup[s] = i
+	return i
+}
+
+// stringAt reads a string index and returns the string
+func (t *activityTranscript) stringAt(r *blobReader) string {
+	i := r.uvarint()
+	if i >= uint64(len(t.strings)) {
+		r.fail()
+		return ""
+	}
+	return t.strings[i]
+}
+
+// appendFloat appends a float64 as a uvarint of its byte-reversed bits
+func appendFloat(data []byte, v float64) []byte {
+	return binary.AppendUvarint(data, bits.ReverseBytes64(math.Float64bits(v)))
+}
+
+// appendString appends a string as its length and bytes
+func appendString(data []byte, s string) []byte {
+	data = binary.AppendUvarint(data, uint64(len(s)))
+	return append(data, s...)
+}
+
+// blobReader reads the fields of a blob, keeping the first error
+type blobReader struct {
+	data []byte
+	err  error
+}
+
+func (r *blobReader) fail() {
+	r.err = errCorruptTranscript
+	r.data = nil
+}
+
+func (r *blobReader) byte() byte {
+	if len(r.data) == 0 {
+		r.fail()
+		return 0
+	}
+	b := r.data[0]
+	r.data = r.data[1:]
+	return b
+}
+
+func (r *blobReader) uvarint() uint64 {
+	v, n := binary.Uvarint(r.data)
+	if n <= 0 {
+		r.fail()
+		return 0
+	}
+	r.data = r.data[n:]
+	return v
+}
+
+func (r *blobReader) varint() int64 {
+	v, n := binary.Varint(r.data)
+	if n <= 0 {
+		r.fail()
+		return 0
+	}
+	r.data = r.data[n:]
+	return v
+}
+
+func (r *blobReader) float() float64 {
+	return math.Float64frombits(bits.ReverseBytes64(r.uvarint()))
+}
+
+func (r *blobReader) bytes(n uint64) []byte {
+	if n > uint64(len(r.data)) {
+		r.fail()
+		return nil
+	}
+	b := r.data[:n]
+	r.data = r.data[n:]
+	return b
+}
+
+func (r *blobReader) string() string {
+	return string(r.bytes(r.uvarint()))
+}
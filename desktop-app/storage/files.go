@@ -1,8 +1,10 @@
 package storage
 
 import (
+	"context"
 	"fmt"
 	"io"
+	"io/fs"
 	"os"
 	"path/filepath"
 	"time"
@@ -193,6 +195,61 @@ func (fm *FileManager) DeleteActivityFiles(activityID string) error {
 	return nil
 }
 
+// minDeleteCost is the throttle charge for unlinking a file regardless of its
+// size, so directories full of tiny files are still paced
+const minDeleteCost = 64 * 1024
+
+// DeleteActivityFilesThrottled deletes an activity's files one at a time,
+// pacing the deletes through the throttle, then removes the emptied
+// directories. It returns the number of bytes freed.
+func (fm *FileManager) DeleteActivityFilesThrottled(ctx context.Context, activityID string, throttle *IOThrottle) (int64, error) {
+	activityDir := fm.GetActivityDir(activityID)
+	if !fm.FileExists(activityDir) {
+		return 0, nil // Directory doesn't exist, nothing to delete
+	}
+
+	var files []string
+	err := filepath.WalkDir(activityDir, func(path string, d fs.DirEntry, err error) error {
+		if err != nil {
+			return nil // Skip entries with errors, RemoveAll below retries them
+		}
+		if !d.IsDir() {
+			files = append(files, path)
+		}
+		return nil
+	})
+	if err != nil {
+		return 0, fmt.Errorf("failed to list activity files: %w", err)
+	}
+
+	var freed int64
+	for _, path := range files {
+		info, err := os.Lstat(path)
+		if err != nil {
+			continue
+		}
+
+		cost := info.Size()
+		if cost < minDeleteCost {
+			cost = minDeleteCost
+		}
+		if err := throttle.Wait(ctx, cost); err != nil {
+			return freed, err
+		}
+
+		if err := fm.DeleteFile(path); err != nil {
+			return freed, err
+		}
+		freed += info.Size()
+	}
+
+	if err := os.RemoveAll(activityDir); err != nil {
+		return freed, fmt.Errorf("failed to delete activity directory: %w", err)
+	}
+
+	return freed, nil
+}
+
 // ListAudioFiles lists all audio files for an activity
 func (fm *FileManager) ListAudioFiles(activityID string) ([]string, error) {
 	audioDir := fm.GetActivityAudioDir(activityID)
@@ -256,29 +313,3 @@ func (fm *FileManager) GetDiskUsage() (int64, error) {
 
 	return totalSize, nil
 }
-
-// CleanupOldFiles removes files older than the specified duration
-func (fm *FileManager) CleanupOldFiles(maxAge time.Duration) error {
-	cutoff := time.Now().Add(-maxAge)
-	
-	err := filepath.Walk(fm.GetActivitiesDir(), func(path string, info os.FileInfo, err error) error {
-		if err != nil {
-			return nil // Skip files with errors
-		}
-		
-		if !info.IsDir() && info.ModTime().Before(cutoff) {
-			if err := os.Remove(path); err != nil {
-				// Log error but continue with cleanup
-				fmt.Printf("Warning: failed to remove old file %s: %v\n", path, err)
-			}
-		}
-		
-		return nil
-	})
-
-	if err != nil {
-		return fmt.Errorf("failed to cleanup old files: %w", err)
-	}
-
-	return nil
-}
\ No newline at end of file
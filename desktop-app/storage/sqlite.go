@@ -3,6 +3,9 @@ package storage
 import (
 	"database/sql"
 	"fmt"
+	"math"
+	"sort"
+	"strings"
 	"time"
 
 	"github.com/platformlabs-co/personal-assist/database"
@@ -372,26 +375,28 @@ func (s *SQLiteStorage) GetActivitiesByUser(userID string, limit, offset int) ([
 	return activities, nil
 }
 
-// SearchTranscripts performs text search on transcript content using LIKE
+// SearchTranscripts performs full-text search on transcript content
 func (s *SQLiteStorage) SearchTranscripts(userID, query string) ([]*models.TranscriptChunk, error) {
 	return s.SearchTranscriptsWithLimit(userID, query, 100, 0)
 }
 
 // SearchTranscriptsWithLimit performs text search with pagination
 func (s *SQLiteStorage) SearchTranscriptsWithLimit(userID, query string, limit, offset int) ([]*models.TranscriptChunk, error) {
-	// Simple LIKE search since FTS5 is not available
+	// The text is stored compressed, so search goes through the FTS4 index
+	match := transcriptMatchQuery(query)
+	if match == "" {
+		return nil, nil
+	}
 	searchQuery := `
-		SELECT id, user_id, activity_id, audio_recording_id, text, 
-		       start_time, end_time, speaker, confidence, language, created_at
-		FROM transcript_chunks 
-		WHERE user_id = ? AND text LIKE ?
-		ORDER BY start_time
+		SELECT c.id, c.user_id, c.activity_id, c.audio_recording_id, c.text,
+		       c.start_time, c.end_time, c.speaker, c.confidence, c.language, c.created_at, c.text_z, c.text_dict
+		FROM transcript_fts f
+		JOIN transcript_chunks c ON c.rowid = f.docid
+		WHERE transcript_fts MATCH ? AND c.user_id = ?
+		ORDER BY c.start_time
 		LIMIT ? OFFSET ?`
 
-	// Add wildcards for LIKE search
-	likeQuery := "%" + query + "%"
-
-	rows, err := s.db.Query(searchQuery, userID, likeQuery, limit, offset)
+	rows, err := s.db.Query(searchQuery, match, userID, limit, offset)
 	if err != nil {
 		return nil, fmt.Errorf("failed to search transcripts: %w", err)
 	}
@@ -400,7 +405,42 @@ func (s *SQLiteStorage) SearchTranscriptsWithLimit(userID, query string, limit,
 	return s.scanTranscriptChunks(rows)
 }
 
-// scanTranscriptChunks scans transcript chunks from SQL rows
+// transcriptMatchQuery turns a search into an FTS4 phrase query: the words
+// in order, the last one possibly incomplete. It is empty when the search
+// has no words.
+//
+// Search matches tokens, where the LIKE search it replaced matched any
+// substring of the text:
+//   - Words match from their start only: "port" finds "portal" but not
+//     "report", and only the last word may be incomplete, so "hel world"
+//     does not find "hello world".
+//   - Punctuation only separates words. "roadmap next" finds "roadmap.
+//     Next", "c++" finds any word starting with "c", and a search of
+//     punctuation alone finds nothing.
+//   - Case and diacritics are folded: "cafe" finds "Café".
+func transcriptMatchQuery(query string) string {
+	words := strings.Fields(strings.ReplaceAll(query, `"`, " "))
+	if len(words) == 0 {
+		return ""
+	}
+	return `"` + strings.Join(words, " ") + `*"`
+}
+
+// storedTranscriptText returns the text, compressed text and dictionary
+// columns a chunk's text is stored in
+func (s *SQLiteStorage) storedTranscriptText(text string) (string, []byte, sql.NullInt64, error) {
+	compressed, dictionaryID, err := s.db.TranscriptCodec().Compress(text)
+	if err != nil {
+		return "", nil, sql.NullInt64{}, err
+	}
+	if compressed != nil {
+		text = ""
+	}
+	return text, compressed, sql.NullInt64{Int64: dictionaryID, Valid: dictionaryID != 0}, nil
+}
+
+// scanTranscriptChunks scans transcript chunks from SQL rows, decompressing
+// their text
 func (s *SQLiteStorage) scanTranscriptChunks(rows *sql.Rows) ([]*models.TranscriptChunk, error) {
 	var chunks []*models.TranscriptChunk
 	for rows.Next() {
@@ -408,6 +448,8 @@ func (s *SQLiteStorage) scanTranscriptChunks(rows *sql.Rows) ([]*models.Transcri
 		var createdAt int64
 		var speaker, language sql.NullString
 		var confidence sql.NullFloat64
+		var compressed []byte
+		var dictionaryID sql.NullInt64
 
 		err := rows.Scan(
 			&chunk.ID,
@@ -421,10 +463,17 @@ func (s *SQLiteStorage) scanTranscriptChunks(rows *sql.Rows) ([]*models.Transcri
 			&confidence,
 			&language,
 			&createdAt,
+			&compressed,
+			&dictionaryID,
 		)
 		if err != nil {
 			return nil, fmt.Errorf("failed to scan transcript chunk: %w", err)
 		}
+		if compressed != nil {
+			if chunk.Text, err = s.db.TranscriptCodec().Decompress(compressed, dictionaryID.Int64); err != nil {
+				return nil, err
+			}
+		}
 
 		// Handle nullable fields
 		if speaker.Valid {
@@ -489,14 +538,14 @@ func (s *SQLiteStorage) CreateAudioRecording(recording *models.AudioRecording) e
 // GetAudioRecording retrieves an audio recording by ID
 func (s *SQLiteStorage) GetAudioRecording(userID, id string) (*models.AudioRecording, error) {
 	query := `
-		SELECT id, user_id, activity_id, file_path, device_info, status, duration, file_size, config, created_at, updated_at
+		SELECT id, user_id, activity_id, file_path, device_info, status, duration, file_size, config, created_at, updated_at, audio_purged_at
 		FROM audio_recordings WHERE user_id = ? AND id = ?`
 
 	var recording models.AudioRecording
 	var deviceInfoJSON, configJSON string
 	var createdAt, updatedAt int64
 	var duration sql.NullFloat64
-	var fileSize sql.NullInt64
+	var fileSize, audioPurgedAt sql.NullInt64
 
 	err := s.db.QueryRow(query, userID, id).Scan(
 		&recording.ID,
@@ -510,6 +559,7 @@ func (s *SQLiteStorage) GetAudioRecording(userID, id string) (*models.AudioRecor
 		&configJSON,
 		&createdAt,
 		&updatedAt,
+		&audioPurgedAt,
 	)
 	if err != nil {
 		if err == sql.ErrNoRows {
@@ -533,6 +583,10 @@ func (s *SQLiteStorage) GetAudioRecording(userID, id string) (*models.AudioRecor
 	if fileSize.Valid {
 		recording.FileSize = &fileSize.Int64
 	}
+	if audioPurgedAt.Valid {
+		t := time.Unix(audioPurgedAt.Int64, 0)
+		recording.AudioPurgedAt = &t
+	}
 
 	recording.CreatedAt = time.Unix(createdAt, 0)
 	recording.UpdatedAt = time.Unix(updatedAt, 0)
@@ -584,7 +638,7 @@ func (s *SQLiteStorage) UpdateAudioRecording(recording *models.AudioRecording) e
 // GetActivityRecordings retrieves all audio recordings for an activity
 func (s *SQLiteStorage) GetActivityRecordings(userID, activityID string) ([]*models.AudioRecording, error) {
 	query := `
-		SELECT id, user_id, activity_id, file_path, device_info, status, duration, file_size, config, created_at, updated_at
+		SELECT id, user_id, activity_id, file_path, device_info, status, duration, file_size, config, created_at, updated_at, audio_purged_at
 		FROM audio_recordings 
 		WHERE user_id = ? AND activity_id = ?
 		ORDER BY created_at ASC`
@@ -601,7 +655,7 @@ func (s *SQLiteStorage) GetActivityRecordings(userID, activityID string) ([]*mod
 		var deviceInfoJSON, configJSON string
 		var createdAt, updatedAt int64
 		var duration sql.NullFloat64
-		var fileSize sql.NullInt64
+		var fileSize, audioPurgedAt sql.NullInt64
 
 		err := rows.Scan(
 			&recording.ID,
@@ -615,6 +669,7 @@ func (s *SQLiteStorage) GetActivityRecordings(userID, activityID string) ([]*mod
 			&configJSON,
 			&createdAt,
 			&updatedAt,
+			&audioPurgedAt,
 		)
 		if err != nil {
 			return nil, fmt.Errorf("failed to scan audio recording: %w", err)
@@ -635,6 +690,10 @@ func (s *SQLiteStorage) GetActivityRecordings(userID, activityID string) ([]*mod
 		if fileSize.Valid {
 			recording.FileSize = &fileSize.Int64
 		}
+		if audioPurgedAt.Valid {
+			t := time.Unix(audioPurgedAt.Int64, 0)
+			recording.AudioPurgedAt = &t
+		}
 
 		recording.CreatedAt = time.Unix(createdAt, 0)
 		recording.UpdatedAt = time.Unix(updatedAt, 0)
@@ -658,68 +717,191 @@ func (s *SQLiteStorage) SaveTranscriptChunk(chunk *models.TranscriptChunk) error
 
 // CreateTranscriptChunk creates a new transcript chunk in the database
 func (s *SQLiteStorage) CreateTranscriptChunk(chunk *models.TranscriptChunk) error {
-	query := `
-		INSERT INTO transcript_chunks (id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at)
-		VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`
+	return s.CreateTranscriptChunks([]*models.TranscriptChunk{chunk})
+}
+
+// CreateTranscriptChunks creates transcript chunks in one transaction,
+// adding them to the materialized transcripts of their activities
+func (s *SQLiteStorage) CreateTranscriptChunks(chunks []*models.TranscriptChunk) error {
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("failed to begin transaction: %w", err)
+	}
+	defer tx.Rollback()
 
-	_, err := s.db.Exec(query,
+	transcripts := make(map[string]*activityTranscript)
+	for _, chunk := range chunks {
+		if _, taken := transcripts[chunk.ActivityID]; taken {
+			continue
+		}
+		if transcripts[chunk.ActivityID], err = s.takeActivityTranscript(tx, chunk.ActivityID); err != nil {
+			return err
+		}
+	}
+
+	stmt, err := tx.Prepare(`
+		INSERT INTO transcript_chunks (id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at, text_z, text_dict)
+		VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`)
+	if err != nil {
+		return fmt.Errorf("failed to prepare transcript insert: %w", err)
+	}
+	defer stmt.Close()
+
+	for _, chunk := range chunks {
+		if err := s.insertTranscriptChunk(stmt, chunk); err != nil {
+			return err
+		}
+		if transcript := transcripts[chunk.ActivityID]; transcript != nil {
+			transcript.Insert(chunk)
+		}
+	}
+
+	for activityID, transcript := range transcripts {
+		if transcript != nil {
+			if err := s.storeActivityTranscript(tx, activityID, transcript); err != nil {
+				return err
+			}
+		}
+	}
+
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("failed to commit transcript chunks: %w", err)
+	}
+	return nil
+}
+
+// insertTranscriptChunk inserts a chunk with a statement prepared from the
+// transcript_chunks insert, compressing its text
+func (s *SQLiteStorage) insertTranscriptChunk(stmt *sql.Stmt, chunk *models.TranscriptChunk) error {
+	text, compressed, dictionaryID, err := s.storedTranscriptText(chunk.Text)
+	if err != nil {
+		return fmt.Errorf("failed to create transcript chunk: %w", err)
+	}
+	_, err = stmt.Exec(
 		chunk.ID,
 		chunk.UserID,
 		chunk.ActivityID,
 		chunk.AudioRecordingID,
-		chunk.Text,
+		text,
 		chunk.StartTime,
 		chunk.EndTime,
 		chunk.Speaker,
 		chunk.Confidence,
 		chunk.Language,
 		chunk.CreatedAt.Unix(),
+		compressed,
+		dictionaryID,
 	)
 	if err != nil {
 		return fmt.Errorf("failed to create transcript chunk: %w", err)
 	}
-
 	return nil
 }
 
-// GetActivityTranscripts retrieves all transcript chunks for an activity
-func (s *SQLiteStorage) GetActivityTranscripts(userID, activityID string) ([]*models.TranscriptChunk, error) {
-	query := `
-		SELECT id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at
-		FROM transcript_chunks 
-		WHERE user_id = ? AND activity_id = ?
-		ORDER BY start_time ASC`
-
-	rows, err := s.db.Query(query, userID, activityID)
+// takeActivityTranscript removes the materialized transcript of an activity
+// for the transaction to change and store again, and returns it, nil when
+// there is none or it does not decode. Taking it is a write, so a
+// transaction starting with it holds the write lock before reading.
+func (s *SQLiteStorage) takeActivityTranscript(tx *sql.Tx, activityID string) (*activityTranscript, error) {
+	var data []byte
+	err := tx.QueryRow(`DELETE FROM activity_transcripts WHERE activity_id = ? RETURNING data`, activityID).Scan(&data)
+	if err == sql.ErrNoRows {
+		return nil, nil
+	}
 	if err != nil {
-		return nil, fmt.Errorf("failed to query transcript chunks: %w", err)
+		return nil, fmt.Errorf("failed to get activity transcript: %w", err)
 	}
-	defer rows.Close()
+	transcript, err := parseActivityTranscript(s.db.TranscriptCodec(), data)
+	if err != nil {
+		return nil, nil // Rebuilt from the chunks on the next read
+	}
+	return transcript, nil
+}
 
-	return s.scanTranscriptChunks(rows)
+// storeActivityTranscript writes the materialized transcript of an activity
+func (s *SQLiteStorage) storeActivityTranscript(tx *sql.Tx, activityID string, transcript *activityTranscript) error {
+	data, err := transcript.Encode(s.db.TranscriptCodec())
+	if err != nil {
+		return fmt.Errorf("failed to encode activity transcript: %w", err)
+	}
+	_, err = tx.Exec(`INSERT OR REPLACE INTO activity_transcripts (activity_id, data, updated_at) VALUES (?, ?, ?)`,
+		activityID, data, time.Now().Unix())
+	if err != nil {
+		return fmt.Errorf("failed to store activity transcript: %w", err)
+	}
+	return nil
 }
 
-// GetTranscriptChunksByActivity retrieves all transcript chunks for an activity
-func (s *SQLiteStorage) GetTranscriptChunksByActivity(activityID string) ([]*models.TranscriptChunk, error) {
-	query := `
-		SELECT id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at
+// activityTranscriptChunks returns every chunk of an activity from its
+// materialized transcript, materializing it from the chunk rows first when
+// there is none
+func (s *SQLiteStorage) activityTranscriptChunks(activityID string) ([]*models.TranscriptChunk, error) {
+	var data []byte
+	err := s.db.QueryRow(`SELECT data FROM activity_transcripts WHERE activity_id = ?`, activityID).Scan(&data)
+	if err != nil && err != sql.ErrNoRows {
+		return nil, fmt.Errorf("failed to get activity transcript: %w", err)
+	}
+	if err == nil {
+		if transcript, err := parseActivityTranscript(s.db.TranscriptCodec(), data); err == nil {
+			if chunks, err := transcript.Chunks(activityID); err == nil {
+				return chunks, nil
+			}
+		}
+	}
+
+	tx, err := s.db.Begin()
+	if err != nil {
+		return nil, fmt.Errorf("failed to begin transaction: %w", err)
+	}
+	defer tx.Rollback()
+
+	rows, err := tx.Query(`
+		SELECT id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at, text_z, text_dict
 		FROM transcript_chunks 
 		WHERE activity_id = ?
-		ORDER BY start_time ASC`
-
-	rows, err := s.db.Query(query, activityID)
+		ORDER BY start_time ASC`, activityID)
 	if err != nil {
 		return nil, fmt.Errorf("failed to query transcript chunks: %w", err)
 	}
-	defer rows.Close()
+	chunks, err := s.scanTranscriptChunks(rows)
+	rows.Close()
+	if err != nil || len(chunks) == 0 {
+		return chunks, err
+	}
 
-	return s.scanTranscriptChunks(rows)
+	// Storing fails when another connection wrote since the rows were read,
+	// which leaves the transcript to be materialized by a later read
+	if s.storeActivityTranscript(tx, activityID, newActivityTranscript(chunks)) == nil {
+		tx.Commit()
+	}
+	return chunks, nil
+}
+
+// GetActivityTranscripts retrieves all transcript chunks for an activity
+func (s *SQLiteStorage) GetActivityTranscripts(userID, activityID string) ([]*models.TranscriptChunk, error) {
+	chunks, err := s.activityTranscriptChunks(activityID)
+	if err != nil {
+		return nil, err
+	}
+
+	var owned []*models.TranscriptChunk
+	for _, chunk := range chunks {
+		if chunk.UserID == userID {
+			owned = append(owned, chunk)
+		}
+	}
+	return owned, nil
+}
+
+// GetTranscriptChunksByActivity retrieves all transcript chunks for an activity
+func (s *SQLiteStorage) GetTranscriptChunksByActivity(activityID string) ([]*models.TranscriptChunk, error) {
+	return s.activityTranscriptChunks(activityID)
 }
 
 // GetRecordingTranscripts retrieves transcript chunks for a specific recording
 func (s *SQLiteStorage) GetRecordingTranscripts(userID, recordingID string) ([]*models.TranscriptChunk, error) {
 	query := `
-		SELECT id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at
+		SELECT id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at, text_z, text_dict
 		FROM transcript_chunks 
 		WHERE user_id = ? AND audio_recording_id = ?
 		ORDER BY start_time ASC`
@@ -736,7 +918,7 @@ func (s *SQLiteStorage) GetRecordingTranscripts(userID, recordingID string) ([]*
 // GetTranscriptChunksByAudioRecording retrieves transcript chunks for a specific recording
 func (s *SQLiteStorage) GetTranscriptChunksByAudioRecording(audioRecordingID string) ([]*models.TranscriptChunk, error) {
 	query := `
-		SELECT id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at
+		SELECT id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at, text_z, text_dict
 		FROM transcript_chunks 
 		WHERE audio_recording_id = ?
 		ORDER BY start_time ASC`
@@ -790,3 +972,510 @@ func (s *SQLiteStorage) DeleteAudioRecording(recordingID string) error {
 
 	return nil
 }
+
+// Garbage collection operations
+
+// GetPurgeableActivityIDs returns soft-deleted activities whose grace period
+// ended before deletedBefore, oldest deletion first
+func (s *SQLiteStorage) GetPurgeableActivityIDs(deletedBefore time.Time, limit int) ([]string, error) {
+	query := `
+		SELECT id FROM activities
+		WHERE deleted_at IS NOT NULL AND deleted_at < ? AND status != 'recording'
+		ORDER BY deleted_at ASC
+		LIMIT ?`
+
+	rows, err := s.db.Query(query, deletedBefore.Unix(), limit)
+	if err != nil {
+		return nil, fmt.Errorf("failed to query purgeable activities: %w", err)
+	}
+	defer rows.Close()
+
+	var ids []string
+	for rows.Next() {
+		var id string
+		if err := rows.Scan(&id); err != nil {
+			return nil, fmt.Errorf("failed to scan activity id: %w", err)
+		}
+		ids = append(ids, id)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("error iterating purgeable activities: %w", err)
+	}
+
+	return ids, nil
+}
+
+// ClaimActivityForPurge marks a tombstoned activity as being purged so it can
+// no longer be restored. Returns false if the activity was restored or is not
+// eligible anymore. Claiming an already claimed activity succeeds, which lets
+// an interrupted purge resume.
+func (s *SQLiteStorage) ClaimActivityForPurge(activityID string, deletedBefore time.Time) (bool, error) {
+	query := `
+		UPDATE activities
+		SET purge_started_at = COALESCE(purge_started_at, ?)
+		WHERE id = ? AND deleted_at IS NOT NULL AND deleted_at < ? AND status != 'recording'`
+
+	result, err := s.db.Exec(query, time.Now().Unix(), activityID, deletedBefore.Unix())
+	if err != nil {
+		return false, fmt.Errorf("failed to claim activity for purge: %w", err)
+	}
+
+	rowsAffected, err := result.RowsAffected()
+	if err != nil {
+		return false, fmt.Errorf("failed to get rows affected: %w", err)
+	}
+
+	return rowsAffected > 0, nil
+}
+
+// DeleteActivityTranscriptChunksBatch deletes up to limit transcript chunks of
+// an activity in a single statement and returns how many were removed
+func (s *SQLiteStorage) DeleteActivityTranscriptChunksBatch(activityID string, limit int) (int64, error) {
+	query := `
+		DELETE FROM transcript_chunks
+		WHERE rowid IN (SELECT rowid FROM transcript_chunks WHERE activity_id = ? LIMIT ?)`
+
+	result, err := s.db.Exec(query, activityID, limit)
+	if err != nil {
+		return 0, fmt.Errorf("failed to delete transcript chunks: %w", err)
+	}
+
+	rowsAffected, err := result.RowsAffected()
+	if err != nil {
+		return 0, fmt.Errorf("failed to get rows affected: %w", err)
+	}
+
+	return rowsAffected, nil
+}
+
+// PurgeActivity permanently removes a claimed activity. Remaining recordings
+// and transcript chunks are removed by the foreign key cascade.
+func (s *SQLiteStorage) PurgeActivity(activityID string) error {
+	query := `DELETE FROM activities WHERE id = ? AND purge_started_at IS NOT NULL`
+
+	result, err := s.db.Exec(query, activityID)
+	if err != nil {
+		return fmt.Errorf("failed to purge activity: %w", err)
+	}
+
+	rowsAffected, err := result.RowsAffected()
+	if err != nil {
+		return fmt.Errorf("failed to get rows affected: %w", err)
+	}
+	if rowsAffected == 0 {
+		return fmt.Errorf("activity not claimed for purge: %s", activityID)
+	}
+
+	return nil
+}
+
+// RestoreActivity clears the tombstone of a soft-deleted activity unless the
+// garbage collector has already started purging it
+func (s *SQLiteStorage) RestoreActivity(userID, id string) error {
+	query := `
+		UPDATE activities
+		SET deleted_at = NULL, updated_at = ?
+		WHERE user_id = ? AND id = ? AND deleted_at IS NOT NULL AND purge_started_at IS NULL`
+
+	result, err := s.db.Exec(query, time.Now().Unix(), userID, id)
+	if err != nil {
+		return fmt.Errorf("failed to restore activity: %w", err)
+	}
+
+	rowsAffected, err := result.RowsAffected()
+	if err != nil {
+		return fmt.Errorf("failed to get rows affected: %w", err)
+	}
+	if rowsAffected == 0 {
+		return fmt.Errorf("activity can no longer be restored: %s", id)
+	}
+
+	return nil
+}
+
+// Retention operations
+
+// AudioRetentionCandidate is a recording whose audio file may be removed
+type AudioRetentionCandidate struct {
+	ID         string
+	ActivityID string
+	FilePath   string
+	FileSize   int64
+	CreatedAt  int64
+}
+
+// maxPurgeBackoffDoublings caps the retry delay of a file that keeps failing
+// to delete at 64 times the base backoff
+const maxPurgeBackoffDoublings = 6
+
+// GetAudioBytesOnDisk returns the total size of recordings whose audio has not been purged
+func (s *SQLiteStorage) GetAudioBytesOnDisk() (int64, error) {
+	query := `SELECT COALESCE(SUM(file_size), 0) FROM audio_recordings WHERE audio_purged_at IS NULL`
+
+	var total int64
+	if err := s.db.QueryRow(query).Scan(&total); err != nil {
+		return 0, fmt.Errorf("failed to sum audio file sizes: %w", err)
+	}
+	return total, nil
+}
+
+// GetAudioRetentionCandidates returns finished recordings created before the
+// cutoff whose audio is still on disk, oldest first, starting after the given
+// candidate when it is set. A recording whose file failed to delete is left
+// out for the backoff, doubled with each further failure.
+func (s *SQLiteStorage) GetAudioRetentionCandidates(createdBefore time.Time, after *AudioRetentionCandidate, backoff time.Duration, limit int) ([]*AudioRetentionCandidate, error) {
+	query := `
+		SELECT id, activity_id, file_path, COALESCE(file_size, 0), created_at
+		FROM audio_recordings
+		WHERE audio_purged_at IS NULL AND status != 'recording' AND created_at < ?
+			AND (created_at, id) > (?, ?)
+			AND (purge_failed_at IS NULL OR purge_failed_at + (? << MIN(purge_attempts - 1, ?)) <= ?)
+		ORDER BY created_at ASC, id ASC
+		LIMIT ?`
+
+	afterCreatedAt, afterID := int64(math.MinInt64), ""
+	if after != nil {
+		afterCreatedAt, afterID = after.CreatedAt, after.ID
+	}
+
+	rows, err := s.db.Query(query, createdBefore.Unix(), afterCreatedAt, afterID,
+		int64(backoff.Seconds()), maxPurgeBackoffDoublings, time.Now().Unix(), limit)
+	if err != nil {
+		return nil, fmt.Errorf("failed to query retention candidates: %w", err)
+	}
+	defer rows.Close()
+
+	var candidates []*AudioRetentionCandidate
+	for rows.Next() {
+		candidate := &AudioRetentionCandidate{}
+		if err := rows.Scan(&candidate.ID, &candidate.ActivityID, &candidate.FilePath, &candidate.FileSize, &candidate.CreatedAt); err != nil {
+			return nil, fmt.Errorf("failed to scan retention candidate: %w", err)
+		}
+		candidates = append(candidates, candidate)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("error iterating retention candidates: %w", err)
+	}
+
+	return candidates, nil
+}
+
+// MarkAudioPurged records in a single transaction that the audio files of the
+// given recordings were removed
+func (s *SQLiteStorage) MarkAudioPurged(recordingIDs []string) error {
+	if len(recordingIDs) == 0 {
+		return nil
+	}
+
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("failed to begin transaction: %w", err)
+	}
+	defer tx.Rollback()
+
+	stmt, err := tx.Prepare(`UPDATE audio_recordings SET audio_purged_at = ?, updated_at = ? WHERE id = ?`)
+	if err != nil {
+		return fmt.Errorf("failed to prepare purge update: %w", err)
+	}
+	defer stmt.Close()
+
+	now := time.Now().Unix()
+	for _, id := range recordingIDs {
+		if _, err := stmt.Exec(now, now, id); err != nil {
+			return fmt.Errorf("failed to mark audio purged for %s: %w", id, err)
+		}
+	}
+
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("failed to commit purge transaction: %w", err)
+	}
+
+	return nil
+}
+
+// MarkAudioPurgeFailed records in a single transaction that the audio files
+// of the given recordings could not be removed
+func (s *SQLiteStorage) MarkAudioPurgeFailed(recordingIDs []string) error {
+	if len(recordingIDs) == 0 {
+		return nil
+	}
+
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("failed to begin transaction: %w", err)
+	}
+	defer tx.Rollback()
+
+	stmt, err := tx.Prepare(`UPDATE audio_recordings SET purge_attempts = purge_attempts + 1, purge_failed_at = ? WHERE id = ?`)
+	if err != nil {
+		return fmt.Errorf("failed to prepare purge failure update: %w", err)
+	}
+	defer stmt.Close()
+
+	now := time.Now().Unix()
+	for _, id := range recordingIDs {
+		if _, err := stmt.Exec(now, id); err != nil {
+			return fmt.Errorf("failed to record purge failure for %s: %w", id, err)
+		}
+	}
+
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("failed to commit purge failure transaction: %w", err)
+	}
+
+	return nil
+}
+
+// MarkDraftRefineFailed records that the draft transcript of a recording
+// could not be refined
+func (s *SQLiteStorage) MarkDraftRefineFailed(recordingID string) error {
+	_, err := s.db.Exec(`UPDATE audio_recordings SET refine_attempts = refine_attempts + 1, refine_failed_at = ? WHERE id = ?`,
+		time.Now().Unix(), recordingID)
+	if err != nil {
+		return fmt.Errorf("failed to record refinement failure: %w", err)
+	}
+	return nil
+}
+
+// DraftTranscript identifies a recording whose transcript is still a draft
+type DraftTranscript struct {
+	RecordingID string
+	UserID      string
+	ActivityID  string
+}
+
+// GetDraftTranscripts returns up to limit recordings with a draft transcript,
+// oldest first, skipping deleted activities and recordings without audio.
+// Drafts that failed to refine maxAttempts times are skipped unless their
+// last failure was before retryBefore.
+func (s *SQLiteStorage) GetDraftTranscripts(limit, maxAttempts int, retryBefore time.Time) ([]*DraftTranscript, error) {
+	query := `
+		SELECT r.id, r.user_id, r.activity_id
+		FROM audio_recordings r
+		JOIN activities a ON a.id = r.activity_id
+		WHERE r.transcript_tier = 'draft' AND r.audio_purged_at IS NULL AND a.deleted_at IS NULL
+		  AND (r.refine_attempts < ? OR r.refine_failed_at <= ?)
+		ORDER BY r.created_at ASC
+		LIMIT ?`
+
+	rows, err := s.db.Query(query, maxAttempts, retryBefore.Unix(), limit)
+	if err != nil {
+		return nil, fmt.Errorf("failed to query draft transcripts: %w", err)
+	}
+	defer rows.Close()
+
+	var drafts []*DraftTranscript
+	for rows.Next() {
+		draft := &DraftTranscript{}
+		if err := rows.Scan(&draft.RecordingID, &draft.UserID, &draft.ActivityID); err != nil {
+			return nil, fmt.Errorf("failed to scan draft transcript: %w", err)
+		}
+		drafts = append(drafts, draft)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("error iterating draft transcripts: %w", err)
+	}
+
+	return drafts, nil
+}
+
+// GetTranscriptRegions returns the regions a recording was last transcribed
+// in, ordered by start, leaving out those whose chunk has since been deleted
+func (s *SQLiteStorage) GetTranscriptRegions(recordingID string) ([]models.TranscriptRegion, error) {
+	query := `
+		SELECT r.start_sample, r.end_sample, r.fingerprint, r.chunk_id
+		FROM transcript_regions r
+		WHERE r.audio_recording_id = ?
+		  AND (r.chunk_id IS NULL OR EXISTS (SELECT 1 FROM transcript_chunks c WHERE c.id = r.chunk_id))
+		ORDER BY r.start_sample`
+
+	rows, err := s.db.Query(query, recordingID)
+	if err != nil {
+		return nil, fmt.Errorf("failed to query transcript regions: %w", err)
+	}
+	defer rows.Close()
+
+	var regions []models.TranscriptRegion
+	for rows.Next() {
+		var region models.TranscriptRegion
+		var chunkID sql.NullString
+		if err := rows.Scan(&region.StartSample, &region.EndSample, &region.Fingerprint, &chunkID); err != nil {
+			return nil, fmt.Errorf("failed to scan transcript region: %w", err)
+		}
+		region.ChunkID = chunkID.String
+		regions = append(regions, region)
+	}
+
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("error iterating transcript regions: %w", err)
+	}
+
+	return regions, nil
+}
+
+// ReplaceRecordingTranscript replaces the transcript chunks of a recording
+// and records the regions they were transcribed in, in one transaction so
+// readers see either the old or the new transcript. Chunks the regions refer
+// to are kept and every other chunk of the recording is deleted, so nil
+// regions replace the whole transcript. A tier records the tier and model
+// that produced the transcript; an empty one leaves them unchanged. When
+// onlyIfTier is set nothing changes unless the current transcript has that
+// tier, and false is returned.
+func (s *SQLiteStorage) ReplaceRecordingTranscript(recordingID string, chunks []*models.TranscriptChunk, regions []models.TranscriptRegion, tier, modelID, onlyIfTier string) (bool, error) {
+	tx, err := s.db.Begin()
+	if err != nil {
+		return false, fmt.Errorf("failed to begin transaction: %w", err)
+	}
+	defer tx.Rollback()
+
+	if onlyIfTier != "" {
+		var current sql.NullString
+		err := tx.QueryRow(`SELECT transcript_tier FROM audio_recordings WHERE id = ?`, recordingID).Scan(&current)
+		if err == sql.ErrNoRows {
+			return false, nil
+		}
+		if err != nil {
+			return false, fmt.Errorf("failed to get transcript tier: %w", err)
+		}
+		if current.String != onlyIfTier {
+			return false, nil
+		}
+	}
+
+	var activityID string
+	err = tx.QueryRow(`SELECT activity_id FROM audio_recordings WHERE id = ?`, recordingID).Scan(&activityID)
+	if err != nil && err != sql.ErrNoRows {
+		return false, fmt.Errorf("failed to get recording activity: %w", err)
+	}
+	transcript, err := s.takeActivityTranscript(tx, activityID)
+	if err != nil {
+		return false, err
+	}
+
+	if err := replaceTranscriptRegions(tx, recordingID, regions); err != nil {
+		return false, err
+	}
+	_, err = tx.Exec(`
+		DELETE FROM transcript_chunks
+		WHERE audio_recording_id = ?
+		  AND id NOT IN (SELECT chunk_id FROM transcript_regions WHERE audio_recording_id = ? AND chunk_id IS NOT NULL)`,
+		recordingID, recordingID)
+	if err != nil {
+		return false, fmt.Errorf("failed to delete transcript chunks: %w", err)
+	}
+
+	stmt, err := tx.Prepare(`
+		INSERT INTO transcript_chunks (id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at, text_z, text_dict)
+		VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`)
+	if err != nil {
+		return false, fmt.Errorf("failed to prepare transcript insert: %w", err)
+	}
+	defer stmt.Close()
+
+	for _, chunk := range chunks {
+		if err := s.insertTranscriptChunk(stmt, chunk); err != nil {
+			return false, err
+		}
+	}
+
+	if transcript != nil {
+		if transcript, err = replaceRecordingSegments(transcript, activityID, recordingID, regions, chunks); err != nil {
+			return false, err
+		}
+		if err := s.storeActivityTranscript(tx, activityID, transcript); err != nil {
+			return false, err
+		}
+	}
+
+	if tier != "" {
+		_, err = tx.Exec(`UPDATE audio_recordings SET transcript_tier = ?, transcript_model = ?, updated_at = ? WHERE id = ?`,
+			tier, modelID, time.Now().Unix(), recordingID)
+		if err != nil {
+			return false, fmt.Errorf("failed to update transcript tier: %w", err)
+		}
+	}
+
+	if err := tx.Commit(); err != nil {
+		return false, fmt.Errorf("failed to commit transcript replacement: %w", err)
+	}
+
+	return true, nil
+}
+
+// replaceTranscriptRegions replaces the transcript regions of a recording
+func replaceTranscriptRegions(tx *sql.Tx, recordingID string, regions []models.TranscriptRegion) error {
+	if _, err := tx.Exec(`DELETE FROM transcript_regions WHERE audio_recording_id = ?`, recordingID); err != nil {
+		return fmt.Errorf("failed to delete transcript regions: %w", err)
+	}
+	if len(regions) == 0 {
+		return nil
+	}
+
+	stmt, err := tx.Prepare(`
+		INSERT INTO transcript_regions (audio_recording_id, start_sample, end_sample, fingerprint, chunk_id)
+		VALUES (?, ?, ?, ?, ?)`)
+	if err != nil {
+		return fmt.Errorf("failed to prepare transcript region insert: %w", err)
+	}
+	defer stmt.Close()
+
+	for _, region := range regions {
+		chunkID := sql.NullString{String: region.ChunkID, Valid: region.ChunkID != ""}
+		if _, err := stmt.Exec(recordingID, region.StartSample, region.EndSample, region.Fingerprint, chunkID); err != nil {
+			return fmt.Errorf("failed to create transcript region: %w", err)
+		}
+	}
+	return nil
+}
+
+// replaceRecordingSegments returns a materialized transcript with the chunks
+// of a recording replaced, keeping those the regions refer to
+func replaceRecordingSegments(transcript *activityTranscript, activityID, recordingID string, regions []models.TranscriptRegion, chunks []*models.TranscriptChunk) (*activityTranscript, error) {
+	existing, err := transcript.Chunks(activityID)
+	if err != nil {
+		return nil, err
+	}
+	kept := make(map[string]bool, len(regions))
+	for _, region := range regions {
+		if region.ChunkID != "" {
+			kept[region.ChunkID] = true
+		}
+	}
+	for _, chunk := range chunks {
+		delete(kept, chunk.ID)
+	}
+	merged := make([]*models.TranscriptChunk, 0, len(existing)+len(chunks))
+	for _, chunk := range existing {
+		if chunk.AudioRecordingID != recordingID || kept[chunk.ID] {
+			merged = append(merged, chunk)
+		}
+	}
+	merged = append(merged, chunks...)
+	sort.SliceStable(merged, func(i, j int) bool {
+		return merged[i].StartTime < merged[j].StartTime
+	})
+	return newActivityTranscript(merged), nil
+}
+
+// DeleteTranscriptChunksBefore deletes up to limit transcript chunks created
+// before the cutoff and returns how many were removed
+func (s *SQLiteStorage) DeleteTranscriptChunksBefore(createdBefore time.Time, limit int) (int64, error) {
+	query := `
+		DELETE FROM transcript_chunks
+		WHERE rowid IN (SELECT rowid FROM transcript_chunks WHERE created_at < ? LIMIT ?)`
+
+	result, err := s.db.Exec(query, createdBefore.Unix(), limit)
+	if err != nil {
+		return 0, fmt.Errorf("failed to delete transcript chunks: %w", err)
+	}
+
+	rowsAffected, err := result.RowsAffected()
+	if err != nil {
+		return 0, fmt.Errorf("failed to get rows affected: %w", err)
+	}
+
+	return rowsAffected, nil
+}
@@ -0,0 +1,55 @@
+package storage
+
+import (
+	"context"
+	"sync"
+	"time"
+)
+
+// IOThrottle paces background I/O to a byte budget per second so that
+// maintenance work does not compete with recording and transcription
+type IOThrottle struct {
+	bytesPerSecond int64
+	mutex          sync.Mutex
+	next           time.Time
+}
+
+// NewIOThrottle creates a throttle with the given budget. A zero or negative
+// budget disables throttling.
+func NewIOThrottle(bytesPerSecond int64) *IOThrottle {
+	return &IOThrottle{bytesPerSecond: bytesPerSecond}
+}
+
+// Wait blocks until an operation costing n bytes may start, or until ctx is
+// cancelled. Operations are scheduled back to back on a virtual clock, so idle
+// time does not build up credit for a later burst.
+func (t *IOThrottle) Wait(ctx context.Context, n int64) error {
+	if t == nil || t.bytesPerSecond <= 0 {
+		return ctx.Err()
+	}
+
+	t.mutex.Lock()
+	now := time.Now()
+	start := t.next
+	if start.Before(now) {
+		start = now
+	}
+	cost := time.Duration(float64(n) / float64(t.bytesPerSecond) * float64(time.Second))
+	t.next = start.Add(cost)
+	t.mutex.Unlock()
+
+	delay := start.Sub(now)
+	if delay <= 0 {
+		return ctx.Err()
+	}
+
+	timer := time.NewTimer(delay)
+	defer timer.Stop()
+
+	select {
+	case <-timer.C:
+		return nil
+	case <-ctx.Done():
+		return ctx.Err()
+	}
+}
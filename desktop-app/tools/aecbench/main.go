@@ -0,0 +1,384 @@
+// Command aecbench runs the echo canceller over synthetic echo paths and
+// reports echo return loss enhancement (ERLE), how well near-end speech
+// survives, and how many times faster than realtime it runs on one core.
+//
+//	go run ./tools/aecbench
+//	go run ./tools/aecbench -rate 44100 -files
+//
+// Each scenario plays far-end speech through a simulated room into the
+// microphone: far end alone, both sides at once (double talk), near end
+// alone, and a change of echo path halfway through (someone moves the
+// laptop). With -files the mixed-recording path is exercised end to end:
+// a system track and a microphone track are written with a start offset
+// and clock drift between them, and coreaudio.CancelEcho must find both.
+package main
+
+import (
+	"flag"
+	"fmt"
+	"math"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"testing"
+	"time"
+
+	"github.com/go-audio/audio"
+	"github.com/go-audio/wav"
+	"github.com/platformlabs-co/personal-assist/services/coreaudio"
+	"github.com/platformlabs-co/personal-assist/services/dsp"
+)
+
+// echoPath is a synthetic speaker to microphone impulse response
+type echoPath struct {
+	Name  string
+	Delay time.Duration // Direct path
+	Decay time.Duration // Time for the tail to fall by 60dB
+	Gain  float64       // Energy of the response relative to the far end
+}
+
+var echoPaths = []echoPath{
+	{Name: "laptop", Delay: 2 * time.Millisecond, Decay: 60 * time.Millisecond, Gain: 0.8},
+	{Name: "desk", Delay: 5 * time.Millisecond, Decay: 120 * time.Millisecond, Gain: 0.3},
+	{Name: "room", Delay: 15 * time.Millisecond, Decay: 200 * time.Millisecond, Gain: 0.5},
+}
+
+// Scenario timeline in seconds
+const (
+	doubleTalkStart = 10
+	nearOnlyStart   = 15
+	pathChangeStart = 20
+	scenarioEnd     = 30
+	convergence     = 2 // Seconds after the start and the path change not scored
+)
+
+func main() {
+	testing.Init()
+
+	rate := flag.Int("rate", 16000, "sample rate of the synthetic streams")
+	files := flag.Bool("files", false, "also run the WAV file path with a start offset and clock drift")
+	benchTime := flag.Duration("benchtime", time.Second, "run time of the speed measurement")
+	flag.Parse()
+
+	if err := flag.Set("test.benchtime", benchTime.String()); err != nil {
+		fatal(err)
+	}
+
+	for i, path := range echoPaths {
+		next := echoPaths[(i+1)%len(echoPaths)]
+		scenario := newScenario(*rate, path, next, int64(i+1))
+
+		cleaned, err := cancel(scenario.mic, scenario.far, *rate)
+		if err != nil {
+			fatal(err)
+		}
+		fmt.Printf("%-7s ERLE %5.1f dB  after path change %5.1f dB  near end: alone %5.1f dB, double talk %5.1f dB\n",
+			path.Name,
+			scenario.erle(cleaned, convergence, doubleTalkStart),
+			scenario.erle(cleaned, pathChangeStart+convergence, scenarioEnd),
+			scenario.nearSNR(cleaned, nearOnlyStart, pathChangeStart),
+			scenario.nearSNR(cleaned, doubleTalkStart, nearOnlyStart))
+	}
+
+	scenario := newScenario(*rate, echoPaths[0], echoPaths[1], 9)
+	result := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			if _, err := cancel(scenario.mic, scenario.far, *rate); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	if result.N == 0 {
+		fatal(fmt.Errorf("speed benchmark did not run"))
+	}
+	realtime := float64(scenarioEnd) / (float64(result.NsPerOp()) / float64(time.Second))
+	fmt.Printf("speed   %d ns per %ds of audio, %.0fx realtime on one core\n", result.NsPerOp(), scenarioEnd, realtime)
+
+	if *files {
+		if err := runFiles(*rate); err != nil {
+			fatal(err)
+		}
+	}
+}
+
+// scenario holds the streams of one synthetic call
+type scenario struct {
+	rate int
+	far  []float32 // What the speakers play
+	near []float32 // The local speaker
+	echo []float32 // far through the echo paths
+	mic  []float32 // echo + near + noise
+}
+
+// newScenario builds a call whose echo path switches from first to second
+// at pathChangeStart
+func newScenario(rate int, first, second echoPath, seed int64) *scenario {
+	rng := rand.New(rand.NewSource(seed))
+	n := scenarioEnd * rate
+	s := &scenario{
+		rate: rate,
+		far:  speech(n, rate, 130, rng),
+		near: speech(n, rate, 210, rng),
+		echo: make([]float32, n),
+		mic:  make([]float32, n),
+	}
+	for i := 0; i < n; i++ {
+		t := float64(i) / float64(rate)
+		if t >= nearOnlyStart && t < pathChangeStart {
+			s.far[i] = 0
+		}
+		if t < doubleTalkStart || t >= nearOnlyStart+5 {
+			s.near[i] = 0
+		}
+	}
+
+	// The room changes at once, so after the change the new path applies to
+	// everything still ringing as well
+	change := pathChangeStart * rate
+	before := convolve(s.far, impulseResponse(first, rate, rng))
+	after := convolve(s.far, impulseResponse(second, rate, rng))
+	copy(s.echo, before[:change])
+	copy(s.echo[change:], after[change:])
+
+	for i := range s.mic {
+		s.mic[i] = s.echo[i] + s.near[i] + 0.0005*float32(rng.NormFloat64())
+	}
+	return s
+}
+
+// erle returns how far the echo was reduced between two times, in dB. The
+// residual is the output minus the near end and the microphone noise.
+func (s *scenario) erle(cleaned []float32, from, to float64) float64 {
+	var echo, residual float64
+	for i := int(from * float64(s.rate)); i < int(to*float64(s.rate)); i++ {
+		noise := s.mic[i] - s.echo[i] - s.near[i]
+		r := float64(cleaned[i] - s.near[i] - noise)
+		echo += float64(s.echo[i]) * float64(s.echo[i])
+		residual += r * r
+	}
+	return 10 * math.Log10(echo/residual)
+}
+
+// nearSNR returns the near end's energy over the distortion the canceller
+// added to it, in dB: what is left of the echo plus what it removed of the
+// near end
+func (s *scenario) nearSNR(cleaned []float32, from, to float64) float64 {
+	var near, distortion float64
+	for i := int(from * float64(s.rate)); i < int(to*float64(s.rate)); i++ {
+		d := float64(cleaned[i] - s.near[i])
+		near += float64(s.near[i]) * float64(s.near[i])
+		distortion += d * d
+	}
+	return 10 * math.Log10(near/distortion)
+}
+
+// cancel runs the canceller over a capture in 10ms blocks, the way the tap
+// delivers audio
+func cancel(mic, far []float32, rate int) ([]float32, error) {
+	canceller, err := dsp.NewEchoCanceller(dsp.DefaultEchoCancellerConfig(rate))
+	if err != nil {
+		return nil, err
+	}
+	block := rate / 100
+	output := make([]float32, 0, len(mic))
+	for start := 0; start < len(mic); start += block {
+		end := min(start+block, len(mic))
+		output = canceller.Process(mic[start:end], far[start:end], output)
+	}
+	return canceller.Flush(output), nil
+}
+
+// speech returns voiced, syllable-paced noise with a gliding pitch around f0
+func speech(n, rate int, f0 float64, rng *rand.Rand) []float32 {
+	out := make([]float32, n)
+	var breath, phase float64
+	for i := range out {
+		t := float64(i) / float64(rate)
+		syllables := math.Max(0, math.Sin(2*math.Pi*3.1*t+rng.Float64()*0.01))
+		words := 0.5 + 0.5*math.Sin(2*math.Pi*0.4*t)
+		breath = 0.95*breath + 0.05*rng.NormFloat64()
+		phase += 2 * math.Pi * f0 * (1 + 0.1*math.Sin(2*math.Pi*0.7*t)) / float64(rate)
+		voiced := math.Sin(phase) + 0.5*math.Sin(2*phase) + 0.25*math.Sin(3*phase)
+		out[i] = float32(0.15 * syllables * words * (voiced + 3*breath))
+	}
+	return out
+}
+
+// impulseResponse returns a direct path followed by an exponentially
+// decaying random tail, scaled to the path's gain
+func impulseResponse(path echoPath, rate int, rng *rand.Rand) []float64 {
+	delay := int(path.Delay.Seconds() * float64(rate))
+	length := delay + int(path.Decay.Seconds()*float64(rate))
+	response := make([]float64, length)
+	response[delay] = 1
+	tau := path.Decay.Seconds() * float64(rate) / math.Log(1000) // 60dB over Decay
+	var energy float64
+	for i := delay + 1; i < length; i++ {
+		response[i] = 0.5 * rng.NormFloat64() * math.Exp(-float64(i-delay)/tau)
+	}
+	for _, h := range response {
+		energy += h * h
+	}
+	scale := math.Sqrt(path.Gain / energy)
+	for i := range response {
+		response[i] *= scale
+	}
+	return response
+}
+
+// convolve returns the first len(input) samples of the convolution of
+// input with response, computed in the frequency domain
+func convolve(input []float32, response []float64) []float32 {
+	size := 2
+	for size < len(input)+len(response) {
+		size *= 2
+	}
+	fft, err := dsp.NewRealFFT(size)
+	if err != nil {
+		fatal(err)
+	}
+
+	frame := make([]float32, size)
+	copy(frame, input)
+	signal := make([]complex64, fft.Bins())
+	if err := fft.Forward(frame, signal); err != nil {
+		fatal(err)
+	}
+	for i := range frame {
+		frame[i] = 0
+	}
+	for i, h := range response {
+		frame[i] = float32(h)
+	}
+	filter := make([]complex64, fft.Bins())
+	if err := fft.Forward(frame, filter); err != nil {
+		fatal(err)
+	}
+	for k := range signal {
+		signal[k] *= filter[k]
+	}
+	if err := fft.Inverse(signal, frame); err != nil {
+		fatal(err)
+	}
+	return frame[:len(input)]
+}
+
+// runFiles writes a mixed recording's two tracks the way the recorder does,
+// 48kHz stereo from the system tap and stereo at rate from the microphone,
+// starting 350ms apart with 40ppm of clock drift, and checks CancelEcho
+func runFiles(rate int) error {
+	const (
+		systemRate = 48000
+		offset     = 0.35 // Microphone starts this much after the system track
+		drift      = 40e-6
+	)
+
+	dir, err := os.MkdirTemp("", "aecbench")
+	if err != nil {
+		return fmt.Errorf("failed to create fixture directory: %w", err)
+	}
+	defer os.RemoveAll(dir)
+
+	rng := rand.New(rand.NewSource(42))
+	seconds := 90
+	far := speech(seconds*systemRate, systemRate, 130, rng)
+	response := impulseResponse(echoPaths[1], systemRate, rng)
+	echo := convolve(far, response)
+
+	// Microphone frame n hears the echo at system time offset + n/rate*(1+drift)
+	mic := make([]float32, (seconds-1)*rate)
+	micEcho := make([]float32, len(mic))
+	for n := range mic {
+		position := (offset + float64(n)/float64(rate)*(1+drift)) * systemRate
+		index := int(position)
+		if index+1 >= len(echo) {
+			break
+		}
+		frac := float32(position - float64(index))
+		micEcho[n] = echo[index]*(1-frac) + echo[index+1]*frac
+		mic[n] = micEcho[n] + 0.0005*float32(rng.NormFloat64())
+	}
+
+	systemPath := filepath.Join(dir, "system.wav")
+	micPath := filepath.Join(dir, "mic.wav")
+	outputPath := filepath.Join(dir, "mic.aec.wav")
+	if err := writeStereo(systemPath, far, systemRate); err != nil {
+		return err
+	}
+	if err := writeStereo(micPath, mic, rate); err != nil {
+		return err
+	}
+
+	start := time.Now()
+	report, err := coreaudio.CancelEcho(micPath, systemPath, outputPath)
+	if err != nil {
+		return err
+	}
+	elapsed := time.Since(start)
+
+	cleaned, err := readMono(outputPath)
+	if err != nil {
+		return err
+	}
+	var echoEnergy, residual float64
+	for n := convergence * rate; n < len(mic) && n < len(cleaned); n++ {
+		noise := mic[n] - micEcho[n]
+		r := float64(cleaned[n] - noise)
+		echoEnergy += float64(micEcho[n]) * float64(micEcho[n])
+		residual += r * r
+	}
+
+	// The echo's direct path sits echoPaths[1].Delay after the system audio
+	fmt.Printf("files   delay %v (expected %v)  drift %.1f ppm (expected %.1f)  windows %d  ERLE %.1f dB  in %v\n",
+		report.Delay.Round(time.Millisecond),
+		(echoPaths[1].Delay - time.Duration(offset*float64(time.Second))).Round(time.Millisecond),
+		report.DriftPPM, -drift*1e6, report.Windows, 10*math.Log10(echoEnergy/residual), elapsed.Round(time.Millisecond))
+	return nil
+}
+
+// writeStereo writes mono samples to both channels of a 16-bit WAV file
+func writeStereo(path string, samples []float32, rate int) error {
+	file, err := os.Create(path)
+	if err != nil {
+		return fmt.Errorf("failed to create %s: %w", path, err)
+	}
+	defer file.Close()
+
+	data := make([]int, 2*len(samples))
+	for i, sample := range samples {
+		value := int(math.Max(-32768, math.Min(32767, math.Round(float64(sample)*32768))))
+		data[2*i], data[2*i+1] = value, value
+	}
+	encoder := wav.NewEncoder(file, rate, 16, 2, 1)
+	buffer := &audio.IntBuffer{Format: &audio.Format{NumChannels: 2, SampleRate: rate}, Data: data, SourceBitDepth: 16}
+	if err := encoder.Write(buffer); err != nil {
+		return fmt.Errorf("failed to write %s: %w", path, err)
+	}
+	return encoder.Close()
+}
+
+// readMono reads a mono 16-bit WAV file
+func readMono(path string) ([]float32, error) {
+	file, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer file.Close()
+
+	buffer, err := wav.NewDecoder(file).FullPCMBuffer()
+	if err != nil {
+		return nil, fmt.Errorf("failed to read %s: %w", path, err)
+	}
+	samples := make([]float32, len(buffer.Data))
+	for i, value := range buffer.Data {
+		samples[i] = float32(value) / 32768
+	}
+	return samples, nil
+}
+
+// fatal prints an error and exits
+func fatal(err error) {
+	fmt.Fprintln(os.Stderr, "aecbench:", err)
+	os.Exit(1)
+}
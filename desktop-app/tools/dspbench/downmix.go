@@ -0,0 +1,145 @@
+package main
+
+import (
+	"fmt"
+	"math"
+	"math/rand"
+	"testing"
+
+	"github.com/platformlabs-co/personal-assist/services/dsp"
+)
+
+// downmixLayout is a stereo capture whose right channel is derived from the
+// left one
+type downmixLayout struct {
+	Name  string
+	Right func(left int, rng *rand.Rand) int
+}
+
+var downmixLayouts = []downmixLayout{
+	{Name: "identical", Right: func(left int, rng *rand.Rand) int { return left }},
+	{Name: "dead right", Right: func(left int, rng *rand.Rand) int { return 0 }},
+	{Name: "inverted right", Right: func(left int, rng *rand.Rand) int { return -left }},
+	{Name: "noisy right", Right: func(left int, rng *rand.Rand) int { return int(rng.NormFloat64() * 30) }},
+}
+
+// downmixAccuracy returns the largest error of the native pass with fixed
+// weights against a float64 average, over an odd number of frames so the
+// scalar tail runs too
+func downmixAccuracy(channels int) (float64, error) {
+	frames := 4099
+	rng := rand.New(rand.NewSource(5))
+	samples := make([]int, frames*channels)
+	for i := range samples {
+		samples[i] = rng.Intn(65536) - 32768
+	}
+
+	config := dsp.DefaultDownmixConfig(channels, 16, 16000)
+	config.Window = 0
+	mono, err := dsp.Downmix(samples, config)
+	if err != nil {
+		return 0, err
+	}
+	if len(mono) != frames {
+		return 0, fmt.Errorf("downmix returned %d frames for %d", len(mono), frames)
+	}
+
+	maxErr := 0.0
+	for f := range mono {
+		var sum float64
+		for c := 0; c < channels; c++ {
+			sum += float64(samples[f*channels+c]) / 32768
+		}
+		maxErr = math.Max(maxErr, math.Abs(float64(mono[f])-sum/float64(channels)))
+	}
+	return maxErr, nil
+}
+
+// downmixLevels returns, for a stereo layout, the level of the mono mix
+// relative to the left channel in dB, for averaging and for the adaptive
+// downmix
+func downmixLevels(layout downmixLayout) (float64, float64, error) {
+	rate := 16000
+	rng := rand.New(rand.NewSource(6))
+	speech := randomSignal(5*rate, 7)
+	samples := make([]int, 2*len(speech))
+	var reference float64
+	for i, v := range speech {
+		left := int(v * 16384)
+		samples[2*i], samples[2*i+1] = left, layout.Right(left, rng)
+		reference += float64(left) * float64(left) / (32768 * 32768)
+	}
+
+	level := func(window float64) (float64, error) {
+		config := dsp.DefaultDownmixConfig(2, 16, rate)
+		config.Window = window
+		mono, err := dsp.Downmix(samples, config)
+		if err != nil {
+			return 0, err
+		}
+		var energy float64
+		for _, v := range mono {
+			energy += float64(v) * float64(v)
+		}
+		return 10 * math.Log10(energy/reference+1e-12), nil
+	}
+
+	averaged, err := level(0)
+	if err != nil {
+		return 0, 0, err
+	}
+	adaptive, err := level(dsp.DefaultDownmixConfig(2, 16, rate).Window)
+	if err != nil {
+		return 0, 0, err
+	}
+	return averaged, adaptive, nil
+}
+
+// downmixBenchmarks returns thirty seconds of 44.1kHz stereo through the
+// adaptive downmix and through the separate conversion and averaging passes
+// it replaced
+func downmixBenchmarks() []benchmark {
+	rate, seconds := 44100, 30
+	rng := rand.New(rand.NewSource(8))
+	samples := make([]int, 2*rate*seconds)
+	for i := range samples {
+		samples[i] = rng.Intn(65536) - 32768
+	}
+	audio := float64(seconds)
+
+	return []benchmark{
+		{
+			Name:  "Downmix/stereo-44k-30s",
+			Audio: audio,
+			Run: func(b *testing.B) {
+				downmixer, err := dsp.NewDownmixer(dsp.DefaultDownmixConfig(2, 16, rate))
+				if err != nil {
+					b.Fatal(err)
+				}
+				output := make([]float32, 0, len(samples)/2)
+				b.ReportAllocs()
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					output = downmixer.Process(samples, output[:0])
+				}
+			},
+		},
+		{
+			Name:  "ConvertAverage/stereo-44k-30s",
+			Audio: audio,
+			Run: func(b *testing.B) {
+				b.ReportAllocs()
+				for i := 0; i < b.N; i++ {
+					converted := make([]float32, len(samples))
+					for j, v := range samples {
+						converted[j] = float32(float64(v) / 32768)
+					}
+					mono := make([]float32, len(converted)/2)
+					for j := range mono {
+						mono[j] = (converted[2*j] + converted[2*j+1]) / 2
+					}
+				}
+			},
+		},
+	}
+}
@@ -0,0 +1,327 @@
+// Command dspbench checks the dsp package's FFT against scipy.fft and a
+// naive DFT, measures it and the STFT next to the naive DFT and a textbook
+// radix-2 FFT, and measures how many times faster than realtime the noise
+// suppressor and the downmix run on one core. It also shows what the
+// downmix does with stereo layouts that averaging gets wrong.
+//
+//	go run ./tools/dspbench
+//	go run ./tools/dspbench -bench STFT -benchtime 3s
+//
+// The reference transforms are computed in float64, so the reported error
+// is the single-precision error of the dsp kernels. The scipy transforms
+// are recorded in testdata by reference.py, which also times scipy.fft.rfft
+// for an outside point of comparison on the same machine:
+//
+//	python3 tools/dspbench/reference.py
+//
+// The naive DFT and radix-2 FFT only bound the dsp kernels from below; they
+// say nothing about how the kernels compare with an optimized library.
+package main
+
+import (
+	"flag"
+	"fmt"
+	"math"
+	"math/cmplx"
+	"math/rand"
+	"os"
+	"regexp"
+	"testing"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/services/dsp"
+)
+
+// benchmark is one named measurement
+type benchmark struct {
+	Name  string
+	Run   func(b *testing.B)
+	Audio float64 // Seconds of audio processed per op, for a realtime factor
+}
+
+func main() {
+	testing.Init()
+
+	benchPattern := flag.String("bench", ".", "regular expression selecting benchmarks")
+	benchTime := flag.Duration("benchtime", time.Second, "run time per benchmark")
+	flag.Parse()
+
+	if err := flag.Set("test.benchtime", benchTime.String()); err != nil {
+		fatal(err)
+	}
+	pattern, err := regexp.Compile(*benchPattern)
+	if err != nil {
+		fatal(fmt.Errorf("invalid -bench pattern: %w", err))
+	}
+
+	for _, size := range []int{400, 512, 1024, 4096} {
+		maxErr, err := accuracy(size)
+		if err != nil {
+			fatal(err)
+		}
+		scipyErr, err := referenceAccuracy(size)
+		if err != nil {
+			fatal(err)
+		}
+		roundTrip, err := inverseAccuracy(size)
+		if err != nil {
+			fatal(err)
+		}
+		fmt.Printf("accuracy n=%-5d max relative error %.2e (scipy %.2e), inverse round trip %.2e\n", size, maxErr, scipyErr, roundTrip)
+	}
+
+	for _, channels := range []int{1, 2, 3} {
+		maxErr, err := downmixAccuracy(channels)
+		if err != nil {
+			fatal(err)
+		}
+		fmt.Printf("downmix channels=%d max error %.2e\n", channels, maxErr)
+	}
+	for _, layout := range downmixLayouts {
+		averaged, adaptive, err := downmixLevels(layout)
+		if err != nil {
+			fatal(err)
+		}
+		fmt.Printf("downmix %-15s level averaged %6.1f dB, adaptive %6.1f dB\n", layout.Name, averaged, adaptive)
+	}
+
+	for _, bench := range append(benchmarks(), downmixBenchmarks()...) {
+		if !pattern.MatchString(bench.Name) {
+			continue
+		}
+		result := testing.Benchmark(bench.Run)
+		if result.N == 0 {
+			fatal(fmt.Errorf("%s: benchmark did not run", bench.Name))
+		}
+		fmt.Printf("%-30s %10d %12d ns/op %6d allocs/op", bench.Name, result.N, result.NsPerOp(), result.AllocsPerOp())
+		if bench.Audio > 0 && result.NsPerOp() > 0 {
+			fmt.Printf(" %8.0fx realtime", bench.Audio/(float64(result.NsPerOp())/float64(time.Second)))
+		}
+		fmt.Println()
+	}
+}
+
+// benchmarks returns the transforms to measure
+func benchmarks() []benchmark {
+	var list []benchmark
+	for _, size := range []int{400, 512, 1024, 4096} {
+		size := size
+		input := randomSignal(size, 1)
+
+		list = append(list, benchmark{
+			Name: fmt.Sprintf("RealFFT/%d", size),
+			Run: func(b *testing.B) {
+				fft, err := dsp.NewRealFFT(size)
+				if err != nil {
+					b.Fatal(err)
+				}
+				output := make([]complex64, fft.Bins())
+				b.ReportAllocs()
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					fft.Forward(input, output)
+				}
+			},
+		})
+
+		if size&(size-1) == 0 {
+			list = append(list, benchmark{
+				Name: fmt.Sprintf("Radix2FFT/%d", size),
+				Run: func(b *testing.B) {
+					data := make([]complex128, size)
+					b.ReportAllocs()
+					for i := 0; i < b.N; i++ {
+						for j, v := range input {
+							data[j] = complex(float64(v), 0)
+						}
+						radix2FFT(data)
+					}
+				},
+			})
+		}
+
+		if size <= 1024 {
+			list = append(list, benchmark{
+				Name: fmt.Sprintf("NaiveDFT/%d", size),
+				Run: func(b *testing.B) {
+					table := dftTable(size)
+					output := make([]complex128, size/2+1)
+					b.ReportAllocs()
+					b.ResetTimer()
+					for i := 0; i < b.N; i++ {
+						naiveDFT(input, table, output)
+					}
+				},
+			})
+		}
+	}
+
+	// Thirty seconds of 16kHz audio through the Whisper framing, pushed in
+	// 10ms blocks the way a live recording arrives
+	signal := randomSignal(30*16000, 2)
+	list = append(list, benchmark{
+		Name: "STFT/whisper-30s",
+		Run: func(b *testing.B) {
+			frames := 0
+			stft, err := dsp.NewSTFT(dsp.WhisperSTFTConfig(), dsp.FrameConsumerFunc(func(frame *dsp.Frame) {
+				frames++
+			}))
+			if err != nil {
+				b.Fatal(err)
+			}
+			b.ReportAllocs()
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				for start := 0; start < len(signal); start += 160 {
+					stft.Push(signal[start : start+160])
+				}
+				stft.Flush()
+			}
+			if frames != b.N*(1+len(signal)/160) {
+				b.Fatalf("unexpected frame count %d", frames)
+			}
+		},
+	})
+
+	// The same audio through the noise suppressor, one core
+	list = append(list, benchmark{
+		Name:  "NoiseSuppressor/16k-30s",
+		Audio: float64(len(signal)) / 16000,
+		Run: func(b *testing.B) {
+			suppressor, err := dsp.NewNoiseSuppressor(dsp.DefaultNoiseSuppressorConfig(16000))
+			if err != nil {
+				b.Fatal(err)
+			}
+			output := make([]float32, 0, len(signal))
+			b.ReportAllocs()
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				output = output[:0]
+				for start := 0; start < len(signal); start += 160 {
+					output = suppressor.Process(signal[start:start+160], output)
+				}
+				output = suppressor.Flush(output)
+			}
+			if len(output) != len(signal) {
+				b.Fatalf("suppressor returned %d samples for %d", len(output), len(signal))
+			}
+		},
+	})
+
+	return list
+}
+
+// inverseAccuracy returns the largest error of a forward and inverse round
+// trip relative to the signal's peak
+func inverseAccuracy(size int) (float64, error) {
+	fft, err := dsp.NewRealFFT(size)
+	if err != nil {
+		return 0, err
+	}
+
+	input := randomSignal(size, 4)
+	spectrum := make([]complex64, fft.Bins())
+	output := make([]float32, size)
+	if err := fft.Forward(input, spectrum); err != nil {
+		return 0, err
+	}
+	if err := fft.Inverse(spectrum, output); err != nil {
+		return 0, err
+	}
+
+	peak, maxErr := 0.0, 0.0
+	for i := range input {
+		peak = math.Max(peak, math.Abs(float64(input[i])))
+		maxErr = math.Max(maxErr, math.Abs(float64(output[i]-input[i])))
+	}
+	return maxErr / peak, nil
+}
+
+// accuracy returns the largest error of the dsp transform relative to the
+// spectrum's peak magnitude
+func accuracy(size int) (float64, error) {
+	fft, err := dsp.NewRealFFT(size)
+	if err != nil {
+		return 0, err
+	}
+
+	input := randomSignal(size, 3)
+	output := make([]complex64, fft.Bins())
+	if err := fft.Forward(input, output); err != nil {
+		return 0, err
+	}
+
+	reference := make([]complex128, fft.Bins())
+	naiveDFT(input, dftTable(size), reference)
+
+	peak, maxErr := 0.0, 0.0
+	for k := range reference {
+		peak = math.Max(peak, cmplx.Abs(reference[k]))
+		maxErr = math.Max(maxErr, cmplx.Abs(complex128(output[k])-reference[k]))
+	}
+	return maxErr / peak, nil
+}
+
+// randomSignal returns deterministic white noise in [-0.5, 0.5)
+func randomSignal(n int, seed int64) []float32 {
+	rng := rand.New(rand.NewSource(seed))
+	signal := make([]float32, n)
+	for i := range signal {
+		signal[i] = rng.Float32() - 0.5
+	}
+	return signal
+}
+
+// dftTable returns exp(-2*pi*i*k/n) for k in [0, n)
+func dftTable(n int) []complex128 {
+	table := make([]complex128, n)
+	for k := range table {
+		table[k] = cmplx.Exp(complex(0, -2*math.Pi*float64(k)/float64(n)))
+	}
+	return table
+}
+
+// naiveDFT computes the first len(output) bins directly in O(n^2)
+func naiveDFT(input []float32, table []complex128, output []complex128) {
+	n := len(input)
+	for k := range output {
+		var sum complex128
+		for j, v := range input {
+			sum += complex(float64(v), 0) * table[(j*k)%n]
+		}
+		output[k] = sum
+	}
+}
+
+// radix2FFT is an in-place iterative Cooley-Tukey FFT for power of two sizes
+func radix2FFT(data []complex128) {
+	n := len(data)
+	for i, j := 1, 0; i < n; i++ {
+		bit := n >> 1
+		for ; j&bit != 0; bit >>= 1 {
+			j ^= bit
+		}
+		j ^= bit
+		if i < j {
+			data[i], data[j] = data[j], data[i]
+		}
+	}
+
+	for length := 2; length <= n; length <<= 1 {
+		step := cmplx.Exp(complex(0, -2*math.Pi/float64(length)))
+		for start := 0; start < n; start += length {
+			w := complex(1, 0)
+			for k := 0; k < length/2; k++ {
+				a, b := data[start+k], data[start+k+length/2]*w
+				data[start+k], data[start+k+length/2] = a+b, a-b
+				w *= step
+			}
+		}
+	}
+}
+
+// fatal prints an error and exits
+func fatal(err error) {
+	fmt.Fprintln(os.Stderr, "dspbench:", err)
+	os.Exit(1)
+}
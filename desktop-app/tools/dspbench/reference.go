@@ -0,0 +1,58 @@
+package main
+
+import (
+	"embed"
+	"encoding/binary"
+	"fmt"
+	"math"
+	"math/cmplx"
+
+	"github.com/platformlabs-co/personal-assist/services/dsp"
+)
+
+// referenceData holds real FFTs computed by scipy.fft, written by reference.py
+//
+//go:embed testdata/rfft-*.bin
+var referenceData embed.FS
+
+// referenceAccuracy returns the largest error of the dsp transform against
+// scipy.fft.rfft, relative to the spectrum's peak magnitude, for a size
+// reference.py recorded
+func referenceAccuracy(size int) (float64, error) {
+	data, err := referenceData.ReadFile(fmt.Sprintf("testdata/rfft-%d.bin", size))
+	if err != nil {
+		return 0, fmt.Errorf("no scipy reference for n=%d, run reference.py: %w", size, err)
+	}
+	bins := size/2 + 1
+	if len(data) != 4+4*size+16*bins || int(binary.LittleEndian.Uint32(data)) != size {
+		return 0, fmt.Errorf("invalid scipy reference for n=%d", size)
+	}
+
+	input := make([]float32, size)
+	for i := range input {
+		input[i] = math.Float32frombits(binary.LittleEndian.Uint32(data[4+4*i:]))
+	}
+	reference := make([]complex128, bins)
+	offset := 4 + 4*size
+	for k := range reference {
+		re := math.Float64frombits(binary.LittleEndian.Uint64(data[offset+16*k:]))
+		im := math.Float64frombits(binary.LittleEndian.Uint64(data[offset+16*k+8:]))
+		reference[k] = complex(re, im)
+	}
+
+	fft, err := dsp.NewRealFFT(size)
+	if err != nil {
+		return 0, err
+	}
+	output := make([]complex64, fft.Bins())
+	if err := fft.Forward(input, output); err != nil {
+		return 0, err
+	}
+
+	peak, maxErr := 0.0, 0.0
+	for k := range reference {
+		peak = math.Max(peak, cmplx.Abs(reference[k]))
+		maxErr = math.Max(maxErr, cmplx.Abs(complex128(output[k])-reference[k]))
+	}
+	return maxErr / peak, nil
+}
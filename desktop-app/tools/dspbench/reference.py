@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""Reference transforms for dspbench, from scipy.fft (pocketfft).
+
+Writes testdata/rfft-<n>.bin for each size dspbench measures: a fixed
+white-noise input and its real FFT computed in float64, which dspbench
+compares the dsp kernels against. Then times scipy.fft.rfft on the same
+float32 input, for comparison with `make dsp-bench ARGS="-bench RealFFT"`
+on the same machine.
+The timing includes Python's call overhead of a few microseconds, so it
+overstates scipy's cost at small sizes.
+
+    python3 tools/dspbench/reference.py [-no-write]
+
+File layout, little-endian: uint32 n, n float32 input samples, then
+n/2+1 bins as float64 real and imaginary pairs.
+"""
+
+import os
+import struct
+import sys
+import timeit
+
+import numpy as np
+import scipy
+import scipy.fft
+
+SIZES = [400, 512, 1024, 4096]
+SEED = 81
+
+
+def main():
+    write = "-no-write" not in sys.argv[1:]
+    testdata = os.path.join(os.path.dirname(os.path.abspath(__file__)), "testdata")
+    print(f"numpy {np.__version__}, scipy {scipy.__version__}")
+
+    rng = np.random.default_rng(SEED)
+    for n in SIZES:
+        signal = (rng.random(n) - 0.5).astype(np.float32)
+        spectrum = scipy.fft.rfft(signal.astype(np.float64))
+
+        if write:
+            with open(os.path.join(testdata, f"rfft-{n}.bin"), "wb") as f:
+                f.write(struct.pack("<I", n))
+                f.write(signal.astype("<f4").tobytes())
+                f.write(spectrum.astype("<c16").tobytes())
+
+        # Single precision, like the dsp kernels; the output is allocated per call
+        timer = timeit.Timer(lambda: scipy.fft.rfft(signal))
+        number, _ = timer.autorange()
+        best = min(timer.repeat(repeat=5, number=number)) / number
+        print(f"scipy.fft.rfft/{n:<5d} {best * 1e9:12.0f} ns/op")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,539 @@
+// Command loadtest records several meetings at once, the way a user with
+// overlapping calls does, while their recordings are transcribed and other
+// clients use the database, and checks the recordings kept up.
+//
+//	go run ./tools/loadtest
+//	go run ./tools/loadtest -recordings 8 -jobs 2 -seconds 60 -rounds 3
+//	go run ./tools/loadtest -model ~/models/ggml-base.bin -audio meeting.wav
+//
+// Recordings go through AudioRecorder and ffmpeg with a replay of -audio
+// (a synthetic recording when omitted) in place of the capture devices, so
+// the harness runs on Linux without audio hardware. Each stream records for
+// -seconds, stops and queues the file for one of -jobs transcription
+// workers, which store its transcript, for -rounds rounds; -db-clients
+// clients read and write the database meanwhile. Without -model a job
+// prepares the audio for Whisper and stores a chunk per window, all the
+// work of a transcription short of decoding.
+//
+// Per stream it reports the audio lost against wall time, the CPU of its
+// ffmpeg processes and the latency from stop to stored transcript, and it
+// exits non-zero when a stream or the database exceeds a threshold.
+package main
+
+import (
+	"flag"
+	"fmt"
+	"math"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"sort"
+	"sync"
+	"syscall"
+	"time"
+
+	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
+	"github.com/go-audio/audio"
+	"github.com/go-audio/wav"
+	"github.com/platformlabs-co/personal-assist/database"
+	"github.com/platformlabs-co/personal-assist/logger"
+	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/services"
+	"github.com/platformlabs-co/personal-assist/services/transcription"
+	"github.com/platformlabs-co/personal-assist/storage"
+	"github.com/sirupsen/logrus"
+)
+
+// chunkDuration and overlapDuration match the default transcription config
+const (
+	chunkDuration   = 30 * time.Second
+	overlapDuration = 2 * time.Second
+)
+
+// thresholds fail the run when exceeded; zero disables a check
+type thresholds struct {
+	Drop      float64       // Fraction of wall time missing from a recording
+	CPU       float64       // Cores used by the ffmpeg process of a stream
+	Latency   time.Duration // 95th percentile from stop to stored transcript
+	DBLatency time.Duration // 99th percentile of a database operation
+}
+
+// streamResult is what the recordings of one stream captured and cost
+type streamResult struct {
+	Recorded time.Duration // Wall time between start and stop
+	Captured time.Duration // Audio in the files
+	CPU      time.Duration
+	Starts   []time.Duration
+	Stops    []time.Duration
+	Latency  []time.Duration
+	Errors   []error
+}
+
+// job is a stopped recording waiting for transcription
+type job struct {
+	Stream    int
+	Recording *models.AudioRecording
+	Activity  *models.Activity
+	Stopped   time.Time
+}
+
+// harness holds what streams, workers and database clients share
+type harness struct {
+	recorder *services.AudioRecorder
+	storage  *storage.SQLiteStorage
+	user     *models.User
+	config   models.RecordingConfig
+	dir      string
+
+	mutex   sync.Mutex
+	streams []streamResult
+	dbOps   []time.Duration
+	dbErrs  int
+}
+
+func main() {
+	recordings := flag.Int("recordings", 4, "simultaneous recordings")
+	jobs := flag.Int("jobs", 2, "concurrent transcription jobs")
+	dbClients := flag.Int("db-clients", 2, "clients issuing database reads and writes")
+	dbInterval := flag.Duration("db-interval", 20*time.Millisecond, "pause between operations of a database client")
+	seconds := flag.Float64("seconds", 30, "length of each recording")
+	rounds := flag.Int("rounds", 2, "recordings per stream, one after another")
+	mode := flag.String("mode", "mixed", "recording mode: microphone, system or mixed")
+	audioPath := flag.String("audio", "", "recording replayed as the capture input instead of a synthetic one")
+	modelPath := flag.String("model", "", "ggml Whisper model; without it jobs stop short of decoding")
+	maxDrop := flag.Float64("max-drop", 0.02, "allowed fraction of wall time missing from a recording")
+	maxCPU := flag.Float64("max-cpu", 0.25, "allowed cores used by the ffmpeg process of a stream")
+	maxLatency := flag.Duration("max-latency", time.Minute, "allowed 95th percentile from stop to stored transcript")
+	maxDBLatency := flag.Duration("max-db-p99", 250*time.Millisecond, "allowed 99th percentile of a database operation")
+	flag.Parse()
+
+	if *recordings < 1 || *jobs < 1 || *rounds < 1 || *seconds <= 0 {
+		fatal(fmt.Errorf("-recordings, -jobs, -rounds and -seconds must be positive"))
+	}
+	logger.GetLogger().SetLevel(logrus.WarnLevel)
+
+	dir, err := os.MkdirTemp("", "loadtest")
+	if err != nil {
+		fatal(err)
+	}
+	defer os.RemoveAll(dir)
+
+	source := *audioPath
+	if source == "" {
+		source = filepath.Join(dir, "source.wav")
+		if err := writeRecording(source, 60, 48000, 2); err != nil {
+			fatal(err)
+		}
+	}
+
+	db, err := openDatabase(dir)
+	if err != nil {
+		fatal(err)
+	}
+	defer db.Close()
+
+	h := &harness{
+		recorder: services.NewAudioRecorder(),
+		storage:  storage.NewSQLiteStorage(db),
+		user:     models.NewUser("loadtest"),
+		config:   models.DefaultRecordingConfig(),
+		dir:      dir,
+		streams:  make([]streamResult, *recordings),
+	}
+	h.config.RecordingMode = *mode
+	h.recorder.SetReplaySource(source)
+	if err := h.storage.CreateUser(h.user); err != nil {
+		fatal(err)
+	}
+
+	var usage syscall.Rusage
+	if err := syscall.Getrusage(syscall.RUSAGE_SELF, &usage); err != nil {
+		fatal(err)
+	}
+	cpuBefore := cpuTime(usage)
+	start := time.Now()
+
+	queue := make(chan job, *recordings**rounds)
+	var workers sync.WaitGroup
+	for i := 0; i < *jobs; i++ {
+		transcribe, closeJob, err := newTranscriber(*modelPath)
+		if err != nil {
+			fatal(err)
+		}
+		defer closeJob()
+		workers.Add(1)
+		go func() {
+			defer workers.Done()
+			for j := range queue {
+				h.runJob(j, transcribe)
+			}
+		}()
+	}
+
+	stopDB := make(chan struct{})
+	var clients sync.WaitGroup
+	for i := 0; i < *dbClients; i++ {
+		clients.Add(1)
+		go func(seed int64) {
+			defer clients.Done()
+			h.runDBClient(rand.New(rand.NewSource(seed)), *dbInterval, stopDB)
+		}(int64(i))
+	}
+
+	duration := time.Duration(*seconds * float64(time.Second))
+	var streams sync.WaitGroup
+	for i := 0; i < *recordings; i++ {
+		streams.Add(1)
+		go func(stream int) {
+			defer streams.Done()
+			for round := 0; round < *rounds; round++ {
+				h.record(stream, round, duration, queue)
+			}
+		}(i)
+	}
+	streams.Wait()
+	close(queue)
+	workers.Wait()
+	close(stopDB)
+	clients.Wait()
+
+	elapsed := time.Since(start)
+	if err := syscall.Getrusage(syscall.RUSAGE_SELF, &usage); err != nil {
+		fatal(err)
+	}
+	harnessCPU := cpuTime(usage) - cpuBefore
+
+	failures := h.report(elapsed, harnessCPU, thresholds{
+		Drop:      *maxDrop,
+		CPU:       *maxCPU,
+		Latency:   *maxLatency,
+		DBLatency: *maxDBLatency,
+	})
+	for _, failure := range failures {
+		fmt.Println("FAIL:", failure)
+	}
+	if len(failures) > 0 {
+		os.Exit(1)
+	}
+}
+
+// record makes one recording of a stream and queues it for transcription
+func (h *harness) record(stream, round int, duration time.Duration, queue chan<- job) {
+	activity := models.NewActivity(h.user.ID, models.ActivityTypeMeeting, fmt.Sprintf("Load test %d.%d", stream, round))
+	path := filepath.Join(h.dir, fmt.Sprintf("stream-%d-%d.wav", stream, round))
+	recording := models.NewAudioRecording(h.user.ID, activity.ID, path, models.AudioDeviceInfo{Name: "replay"}, h.config)
+
+	fail := func(err error) {
+		h.mutex.Lock()
+		h.streams[stream].Errors = append(h.streams[stream].Errors, err)
+		h.mutex.Unlock()
+	}
+	if err := h.storage.CreateActivity(activity); err != nil {
+		fail(err)
+		return
+	}
+	if err := h.storage.CreateAudioRecording(recording); err != nil {
+		fail(err)
+		return
+	}
+
+	began := time.Now()
+	if err := h.recorder.StartRecording(recording.ID, path, models.AudioDeviceInfo{Name: "replay"}, h.config); err != nil {
+		fail(err)
+		return
+	}
+	started := time.Since(began)
+
+	time.Sleep(duration)
+	stopping := time.Now()
+	stats, err := h.recorder.StopRecordingWithStats(recording.ID)
+	if err != nil {
+		fail(err)
+		return
+	}
+	stopped := time.Since(stopping)
+
+	captured, err := audioDuration(path)
+	if err != nil {
+		fail(err)
+		return
+	}
+	recording.Complete(captured.Seconds(), stats.FileSize)
+	if err := h.storage.UpdateAudioRecording(recording); err != nil {
+		fail(err)
+		return
+	}
+
+	h.mutex.Lock()
+	result := &h.streams[stream]
+	result.Recorded += stats.Duration
+	result.Captured += captured
+	result.CPU += stats.CPUTime
+	result.Starts = append(result.Starts, started)
+	result.Stops = append(result.Stops, stopped)
+	h.mutex.Unlock()
+
+	queue <- job{Stream: stream, Recording: recording, Activity: activity, Stopped: stopping}
+}
+
+// runJob transcribes a recording and stores its transcript
+func (h *harness) runJob(j job, transcribe transcribeFunc) {
+	chunks, err := transcribe(j.Recording, j.Activity)
+	for _, chunk := range chunks {
+		if err != nil {
+			break
+		}
+		chunk.UserID = h.user.ID
+		err = h.storage.CreateTranscriptChunk(chunk)
+	}
+
+	h.mutex.Lock()
+	defer h.mutex.Unlock()
+	result := &h.streams[j.Stream]
+	if err != nil {
+		result.Errors = append(result.Errors, err)
+		return
+	}
+	result.Latency = append(result.Latency, time.Since(j.Stopped))
+}
+
+// runDBClient issues a mix of transcript writes and the reads of the
+// activity list, an activity's transcript and search until stop is closed
+func (h *harness) runDBClient(rng *rand.Rand, interval time.Duration, stop <-chan struct{}) {
+	activity := models.NewActivity(h.user.ID, models.ActivityTypeWorkSession, "Load test client")
+	recording := models.NewAudioRecording(h.user.ID, activity.ID, filepath.Join(h.dir, "client.wav"), models.AudioDeviceInfo{}, h.config)
+	if err := h.storage.CreateActivity(activity); err != nil {
+		h.countDB(0, err)
+		return
+	}
+	if err := h.storage.CreateAudioRecording(recording); err != nil {
+		h.countDB(0, err)
+		return
+	}
+
+	words := []string{"budget", "roadmap", "release", "hiring", "customer", "design"}
+	for at := 0.0; ; at += 5 {
+		select {
+		case <-stop:
+			return
+		case <-time.After(interval):
+		}
+
+		start := time.Now()
+		var err error
+		switch op := rng.Intn(4); op {
+		case 0:
+			text := fmt.Sprintf("we discussed the %s and the %s", words[rng.Intn(len(words))], words[rng.Intn(len(words))])
+			err = h.storage.CreateTranscriptChunk(models.NewTranscriptChunk(h.user.ID, activity.ID, recording.ID, text, at, at+5))
+		case 1:
+			_, err = h.storage.GetActivitiesByUser(h.user.ID, 50, 0)
+		case 2:
+			_, err = h.storage.GetActivityTranscripts(h.user.ID, activity.ID)
+		default:
+			_, err = h.storage.SearchTranscriptsWithLimit(h.user.ID, words[rng.Intn(len(words))], 20, 0)
+		}
+		h.countDB(time.Since(start), err)
+	}
+}
+
+// countDB records the latency or failure of a database operation
+func (h *harness) countDB(latency time.Duration, err error) {
+	h.mutex.Lock()
+	defer h.mutex.Unlock()
+	if err != nil {
+		h.dbErrs++
+		return
+	}
+	h.dbOps = append(h.dbOps, latency)
+}
+
+// report prints the results and returns the thresholds they exceed
+func (h *harness) report(elapsed, harnessCPU time.Duration, limits thresholds) []string {
+	var failures []string
+	fmt.Printf("%-7s %9s %9s %7s %9s %10s %10s %10s %10s %7s\n",
+		"stream", "recorded", "captured", "drop", "cpu", "start max", "stop max", "e2e p50", "e2e p95", "errors")
+	var latencies []time.Duration
+	for i, result := range h.streams {
+		drop := 0.0
+		cpu := 0.0
+		if result.Recorded > 0 {
+			drop = math.Max(0, 1-result.Captured.Seconds()/result.Recorded.Seconds())
+			cpu = result.CPU.Seconds() / result.Recorded.Seconds()
+		}
+		p95 := percentile(result.Latency, 0.95)
+		fmt.Printf("%-7d %9s %9s %6.2f%% %8.1f%% %10s %10s %10s %10s %7d\n",
+			i, result.Recorded.Round(time.Millisecond), result.Captured.Round(time.Millisecond), drop*100, cpu*100,
+			maxDuration(result.Starts).Round(time.Millisecond), maxDuration(result.Stops).Round(time.Millisecond),
+			percentile(result.Latency, 0.5).Round(time.Millisecond), p95.Round(time.Millisecond), len(result.Errors))
+		latencies = append(latencies, result.Latency...)
+
+		for _, err := range result.Errors {
+			failures = append(failures, fmt.Sprintf("stream %d: %v", i, err))
+		}
+		if limits.Drop > 0 && drop > limits.Drop {
+			failures = append(failures, fmt.Sprintf("stream %d lost %.2f%% of its audio, over %.2f%%", i, drop*100, limits.Drop*100))
+		}
+		if limits.CPU > 0 && cpu > limits.CPU {
+			failures = append(failures, fmt.Sprintf("stream %d used %.1f%% of a core, over %.1f%%", i, cpu*100, limits.CPU*100))
+		}
+		if limits.Latency > 0 && p95 > limits.Latency {
+			failures = append(failures, fmt.Sprintf("stream %d p95 latency %s, over %s", i, p95.Round(time.Millisecond), limits.Latency))
+		}
+	}
+
+	dbP99 := percentile(h.dbOps, 0.99)
+	fmt.Printf("\nall streams: e2e p50 %s, p95 %s, max %s\n",
+		percentile(latencies, 0.5).Round(time.Millisecond), percentile(latencies, 0.95).Round(time.Millisecond),
+		maxDuration(latencies).Round(time.Millisecond))
+	fmt.Printf("database: %d ops, p50 %s, p99 %s, %d errors\n",
+		len(h.dbOps), percentile(h.dbOps, 0.5).Round(time.Microsecond), dbP99.Round(time.Microsecond), h.dbErrs)
+	fmt.Printf("harness (transcription and database): %.2f cores over %s\n",
+		harnessCPU.Seconds()/elapsed.Seconds(), elapsed.Round(time.Second))
+
+	if limits.DBLatency > 0 && dbP99 > limits.DBLatency {
+		failures = append(failures, fmt.Sprintf("database p99 latency %s, over %s", dbP99.Round(time.Microsecond), limits.DBLatency))
+	}
+	if h.dbErrs > 0 {
+		failures = append(failures, fmt.Sprintf("%d database operations failed", h.dbErrs))
+	}
+	return failures
+}
+
+// transcribeFunc turns a recording into transcript chunks
+type transcribeFunc func(recording *models.AudioRecording, activity *models.Activity) ([]*models.TranscriptChunk, error)
+
+// newTranscriber returns the transcription of one worker, with its own
+// model when modelPath is set, and a function releasing it
+func newTranscriber(modelPath string) (transcribeFunc, func(), error) {
+	log := logrus.New()
+	log.SetLevel(logrus.WarnLevel)
+
+	if modelPath == "" {
+		processor := transcription.NewAudioProcessor(log)
+		return func(recording *models.AudioRecording, activity *models.Activity) ([]*models.TranscriptChunk, error) {
+			samples, err := processor.PrepareForWhisper(recording.FilePath)
+			if err != nil {
+				return nil, err
+			}
+			defer processor.ReleaseSamples(samples)
+			audioChunks := processor.ChunkAudio(samples, chunkDuration, overlapDuration, activity.StartTime, recording.FilePath)
+			chunks := make([]*models.TranscriptChunk, 0, len(audioChunks))
+			for i := range audioChunks {
+				chunk := audioChunks[i]
+				chunks = append(chunks, models.NewTranscriptChunk(recording.UserID, activity.ID, recording.ID, "load test chunk", chunk.StartTime, chunk.EndTime))
+			}
+			return chunks, nil
+		}, func() {}, nil
+	}
+
+	// whisper.cpp contexts of one model are not safe to use concurrently
+	model, err := whisper.New(modelPath)
+	if err != nil {
+		return nil, nil, fmt.Errorf("failed to load whisper model: %w", err)
+	}
+	config := models.DefaultTranscriptionConfig()
+	return func(recording *models.AudioRecording, activity *models.Activity) ([]*models.TranscriptChunk, error) {
+		processor, err := transcription.NewWhisperProcessorFromModel(model, config, log)
+		if err != nil {
+			return nil, err
+		}
+		defer processor.Close()
+		return processor.ProcessRecording(recording, activity)
+	}, func() { model.Close() }, nil
+}
+
+// openDatabase creates the schema in a new database under dir
+func openDatabase(dir string) (*database.DB, error) {
+	db, err := database.NewDB(database.Config{DataDir: dir, DBName: "loadtest.db"})
+	if err != nil {
+		return nil, err
+	}
+	migrator := database.NewMigrator(db)
+	if err := migrator.InitializeSchema(); err != nil {
+		db.Close()
+		return nil, err
+	}
+	if err := migrator.RunMigrations(database.SchemaMigrations()); err != nil {
+		db.Close()
+		return nil, err
+	}
+	return db, nil
+}
+
+// audioDuration returns the length of the audio in a WAV file
+func audioDuration(path string) (time.Duration, error) {
+	file, err := os.Open(path)
+	if err != nil {
+		return 0, err
+	}
+	defer file.Close()
+	decoder := wav.NewDecoder(file)
+	if !decoder.IsValidFile() {
+		return 0, fmt.Errorf("invalid WAV file: %s", path)
+	}
+	return decoder.Duration()
+}
+
+// writeRecording writes a 16-bit WAV file of tones with pauses and noise
+func writeRecording(path string, seconds float64, rate, channels int) error {
+	file, err := os.Create(path)
+	if err != nil {
+		return err
+	}
+	defer file.Close()
+
+	frames := int(seconds * float64(rate))
+	rng := rand.New(rand.NewSource(1))
+	encoder := wav.NewEncoder(file, rate, 16, channels, 1)
+	buffer := &audio.IntBuffer{
+		Format: &audio.Format{NumChannels: channels, SampleRate: rate},
+		Data:   make([]int, 0, rate*channels),
+	}
+	for start := 0; start < frames; start += rate {
+		buffer.Data = buffer.Data[:0]
+		for f := start; f < min(start+rate, frames); f++ {
+			t := float64(f) / float64(rate)
+			speech := math.Sin(2*math.Pi*220*t)*0.3 + rng.NormFloat64()*0.05
+			if int(t)%4 == 3 {
+				speech *= 0.05 // Pauses
+			}
+			for c := 0; c < channels; c++ {
+				buffer.Data = append(buffer.Data, int(speech*16384/float64(c+1)))
+			}
+		}
+		if err := encoder.Write(buffer); err != nil {
+			return err
+		}
+	}
+	return encoder.Close()
+}
+
+// cpuTime returns the user and system time in a resource usage
+func cpuTime(usage syscall.Rusage) time.Duration {
+	return time.Duration(usage.Utime.Nano() + usage.Stime.Nano())
+}
+
+// percentile returns the value below which a fraction of durations fall
+func percentile(durations []time.Duration, fraction float64) time.Duration {
+	if len(durations) == 0 {
+		return 0
+	}
+	sorted := append([]time.Duration(nil), durations...)
+	sort.Slice(sorted, func(i, j int) bool { return sorted[i] < sorted[j] })
+	return sorted[min(len(sorted)-1, int(fraction*float64(len(sorted))))]
+}
+
+// maxDuration returns the longest of durations
+func maxDuration(durations []time.Duration) time.Duration {
+	var longest time.Duration
+	for _, d := range durations {
+		longest = max(longest, d)
+	}
+	return longest
+}
+
+// fatal prints an error and exits
+func fatal(err error) {
+	fmt.Fprintln(os.Stderr, "loadtest:", err)
+	os.Exit(1)
+}
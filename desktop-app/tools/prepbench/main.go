@@ -0,0 +1,265 @@
+// Command prepbench measures the memory cost of preparing a recording for
+// Whisper: bytes allocated, garbage collections and GC pause time per job,
+// for the allocating pipeline it replaced, the current pipeline without a
+// sample pool, and the current pipeline with one.
+//
+//	go run ./tools/prepbench
+//	go run ./tools/prepbench -minutes 30 -rate 48000 -channels 2 -jobs 8
+//	go run ./tools/prepbench -audio meeting.wav -denoise
+//
+// Without -audio a synthetic recording of the given length and layout is
+// written to a temporary file. Each job decodes, downmixes, resamples,
+// normalizes, trims and chunks the whole recording, as a transcription does
+// before the first chunk is decoded.
+package main
+
+import (
+	"flag"
+	"fmt"
+	"math"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"runtime"
+	"time"
+
+	"github.com/go-audio/audio"
+	"github.com/go-audio/wav"
+	"github.com/platformlabs-co/personal-assist/services/dsp"
+	"github.com/platformlabs-co/personal-assist/services/transcription"
+	"github.com/sirupsen/logrus"
+)
+
+// chunkDuration and overlapDuration match the default transcription config
+const (
+	chunkDuration   = 30 * time.Second
+	overlapDuration = 2 * time.Second
+)
+
+// jobCost is what a batch of jobs cost the runtime, per job
+type jobCost struct {
+	Bytes  uint64
+	Allocs uint64
+	GCs    float64
+	Pause  time.Duration
+	Time   time.Duration
+}
+
+func main() {
+	minutes := flag.Float64("minutes", 10, "length of the synthetic recording")
+	rate := flag.Int("rate", 48000, "sample rate of the synthetic recording")
+	channels := flag.Int("channels", 2, "channels of the synthetic recording")
+	audioPath := flag.String("audio", "", "recording to prepare instead of a synthetic one")
+	jobs := flag.Int("jobs", 5, "jobs per pipeline")
+	denoise := flag.Bool("denoise", false, "include noise suppression")
+	flag.Parse()
+
+	path := *audioPath
+	if path == "" {
+		dir, err := os.MkdirTemp("", "prepbench")
+		if err != nil {
+			fatal(err)
+		}
+		defer os.RemoveAll(dir)
+		path = filepath.Join(dir, "recording.wav")
+		if err := writeRecording(path, *minutes, *rate, *channels); err != nil {
+			fatal(err)
+		}
+	}
+	stat, err := os.Stat(path)
+	if err != nil {
+		fatal(err)
+	}
+
+	logger := logrus.New()
+	logger.SetLevel(logrus.WarnLevel)
+	processor := transcription.NewAudioProcessor(logger)
+	processor.SetNoiseSuppression(*denoise)
+	pool := dsp.NewSamplePool(1 << 31)
+
+	pipelines := []struct {
+		Name string
+		Run  func() error
+	}{
+		{Name: "allocating (before)", Run: func() error { return legacyPrepare(path, processor) }},
+		{Name: "unpooled", Run: func() error {
+			processor.SetSamplePool(nil)
+			return prepare(path, processor)
+		}},
+		{Name: "pooled (after)", Run: func() error {
+			processor.SetSamplePool(pool)
+			return prepare(path, processor)
+		}},
+	}
+
+	fmt.Printf("%s: %.1f MB, %d jobs per pipeline\n\n", path, float64(stat.Size())/(1<<20), *jobs)
+	fmt.Printf("%-22s %12s %10s %8s %12s %10s\n", "pipeline", "MB/job", "allocs/job", "GCs/job", "pause/job", "time/job")
+	for _, pipeline := range pipelines {
+		cost, err := measure(*jobs, pipeline.Run)
+		if err != nil {
+			fatal(fmt.Errorf("%s: %w", pipeline.Name, err))
+		}
+		fmt.Printf("%-22s %12.1f %10d %8.2f %12s %10s\n",
+			pipeline.Name, float64(cost.Bytes)/(1<<20), cost.Allocs, cost.GCs,
+			cost.Pause.Round(time.Microsecond), cost.Time.Round(time.Millisecond))
+	}
+	stats := pool.Stats()
+	fmt.Printf("\npool: %d hits, %d misses, %.1f MB retained\n", stats.Hits, stats.Misses, float64(stats.Retained)/(1<<20))
+}
+
+// measure runs jobs one after another and returns their cost per job. The
+// first job warms up, so a pool starts filled as it is in a running app.
+func measure(jobs int, run func() error) (jobCost, error) {
+	if err := run(); err != nil {
+		return jobCost{}, err
+	}
+	runtime.GC()
+
+	var before, after runtime.MemStats
+	runtime.ReadMemStats(&before)
+	start := time.Now()
+	for i := 0; i < jobs; i++ {
+		if err := run(); err != nil {
+			return jobCost{}, err
+		}
+	}
+	elapsed := time.Since(start)
+	runtime.ReadMemStats(&after)
+
+	n := uint64(jobs)
+	return jobCost{
+		Bytes:  (after.TotalAlloc - before.TotalAlloc) / n,
+		Allocs: (after.Mallocs - before.Mallocs) / n,
+		GCs:    float64(after.NumGC-before.NumGC) / float64(jobs),
+		Pause:  time.Duration((after.PauseTotalNs - before.PauseTotalNs) / n),
+		Time:   elapsed / time.Duration(jobs),
+	}, nil
+}
+
+// prepare runs the current pipeline and releases its buffers
+func prepare(path string, processor *transcription.AudioProcessor) error {
+	samples, err := processor.PrepareForWhisper(path)
+	if err != nil {
+		return err
+	}
+	chunks := processor.ChunkAudio(samples, chunkDuration, overlapDuration, time.Now(), path)
+	if len(chunks) == 0 {
+		return fmt.Errorf("no chunks")
+	}
+	processor.ReleaseSamples(samples)
+	return nil
+}
+
+// legacyPrepare is the pipeline before the sample pool: every stage
+// allocates its output and the chunks are copies
+func legacyPrepare(path string, processor *transcription.AudioProcessor) error {
+	file, err := os.Open(path)
+	if err != nil {
+		return err
+	}
+	defer file.Close()
+
+	decoder := wav.NewDecoder(file)
+	if !decoder.IsValidFile() {
+		return fmt.Errorf("invalid WAV file: %s", path)
+	}
+	format := decoder.Format()
+	data := make([]int, 0)
+	for {
+		chunk := &audio.IntBuffer{Format: format, Data: make([]int, 4096)}
+		n, err := decoder.PCMBuffer(chunk)
+		if err != nil {
+			return err
+		}
+		if n == 0 {
+			break
+		}
+		data = append(data, chunk.Data[:n]...)
+	}
+
+	config := dsp.DefaultDownmixConfig(format.NumChannels, int(decoder.BitDepth), format.SampleRate)
+	samples, err := dsp.Downmix(data, config)
+	if err != nil {
+		return err
+	}
+	if format.SampleRate != 16000 {
+		ratio := 16000 / float64(format.SampleRate)
+		resampled := make([]float32, int(float64(len(samples))*ratio))
+		for i := range resampled {
+			pos := float64(i) / ratio
+			j := int(pos)
+			if j >= len(samples)-1 {
+				resampled[i] = samples[len(samples)-1]
+				continue
+			}
+			resampled[i] = samples[j] + float32(pos-float64(j))*(samples[j+1]-samples[j])
+		}
+		samples = resampled
+	}
+	if processor.NoiseSuppression() {
+		if samples, err = dsp.SuppressNoise(samples, dsp.DefaultNoiseSuppressorConfig(16000)); err != nil {
+			return err
+		}
+	}
+
+	var peak float32
+	for _, v := range samples {
+		peak = max(peak, float32(math.Abs(float64(v))))
+	}
+	normalized := make([]float32, len(samples))
+	for i, v := range samples {
+		normalized[i] = v * 0.7 / peak
+	}
+
+	chunks := processor.ChunkBounds(len(normalized), chunkDuration, overlapDuration, time.Now(), path)
+	for i := range chunks {
+		copied := make([]float32, chunks[i].EndSample-chunks[i].StartSample)
+		copy(copied, normalized[chunks[i].StartSample:chunks[i].EndSample])
+		chunks[i].Samples = copied
+	}
+	if len(chunks) == 0 {
+		return fmt.Errorf("no chunks")
+	}
+	return nil
+}
+
+// writeRecording writes a 16-bit WAV file of noise bursts and tones with
+// different levels per channel
+func writeRecording(path string, minutes float64, rate, channels int) error {
+	file, err := os.Create(path)
+	if err != nil {
+		return err
+	}
+	defer file.Close()
+
+	frames := int(minutes * 60 * float64(rate))
+	rng := rand.New(rand.NewSource(1))
+	encoder := wav.NewEncoder(file, rate, 16, channels, 1)
+	buffer := &audio.IntBuffer{
+		Format: &audio.Format{NumChannels: channels, SampleRate: rate},
+		Data:   make([]int, 0, rate*channels),
+	}
+	for start := 0; start < frames; start += rate {
+		buffer.Data = buffer.Data[:0]
+		for f := start; f < min(start+rate, frames); f++ {
+			t := float64(f) / float64(rate)
+			speech := math.Sin(2*math.Pi*220*t)*0.3 + rng.NormFloat64()*0.05
+			if int(t)%4 == 3 {
+				speech *= 0.05 // Pauses
+			}
+			for c := 0; c < channels; c++ {
+				buffer.Data = append(buffer.Data, int(speech*16384/float64(c+1)))
+			}
+		}
+		if err := encoder.Write(buffer); err != nil {
+			return err
+		}
+	}
+	return encoder.Close()
+}
+
+// fatal prints an error and exits
+func fatal(err error) {
+	fmt.Fprintln(os.Stderr, "prepbench:", err)
+	os.Exit(1)
+}
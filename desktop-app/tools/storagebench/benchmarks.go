@@ -0,0 +1,312 @@
+package main
+
+import (
+	"fmt"
+	"math/rand"
+	"testing"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/storage"
+)
+
+// storageBenchmark measures one SQLiteStorage method against the dataset
+type storageBenchmark struct {
+	Name string
+	Run  func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset)
+}
+
+// storageBenchmarks covers every SQLiteStorage method. Read benchmarks use
+// the generated rows; write and delete benchmarks create their own rows so
+// the dataset keeps its size between runs.
+var storageBenchmarks = []storageBenchmark{
+	// Users
+	{"GetUser", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetUser(ds.UserID)))
+		}
+	}},
+	{"GetFirstUser", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetFirstUser()))
+		}
+	}},
+	{"UpdateUser", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		user, err := s.GetUser(ds.UserID)
+		must(b, err)
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			must(b, s.UpdateUser(user))
+		}
+	}},
+
+	// Activities
+	{"CreateActivity", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, s.CreateActivity(models.NewActivity(ds.UserID, models.ActivityTypeMeeting, "Benchmark")))
+		}
+	}},
+	{"GetActivity", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		rng := rand.New(rand.NewSource(1))
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetActivity(ds.UserID, pick(rng, ds.ActivityIDs))))
+		}
+	}},
+	{"UpdateActivity", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		activity, err := s.GetActivity(ds.UserID, ds.ActivityIDs[0])
+		must(b, err)
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			must(b, s.UpdateActivity(activity))
+		}
+	}},
+	{"GetActivitiesByUser/FirstPage", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetActivitiesByUser(ds.UserID, 50, 0)))
+		}
+	}},
+	{"GetActivitiesByUser/DeepPage", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		offset := len(ds.ActivityIDs) / 2
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetActivitiesByUser(ds.UserID, 50, offset)))
+		}
+	}},
+	{"DeleteActivity", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			activityID, _ := seedActivity(b, s, ds.UserID, 100)
+			b.StartTimer()
+			must(b, s.DeleteActivity(activityID))
+		}
+	}},
+
+	// Search
+	searchBenchmark(searchTerms[0]),
+	searchBenchmark(searchTerms[1]),
+	searchBenchmark(searchTerms[2]),
+	searchBenchmark(searchTerms[3]),
+	searchBenchmark(searchTerms[4]),
+	{"SearchTranscriptsWithLimit/DeepPage", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.SearchTranscriptsWithLimit(ds.UserID, searchTerms[0], 100, 5000)))
+		}
+	}},
+
+	// Audio recordings
+	{"CreateAudioRecording", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, s.CreateAudioRecording(newRecording(ds.UserID, ds.ActivityIDs[0])))
+		}
+	}},
+	{"GetAudioRecording", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		rng := rand.New(rand.NewSource(1))
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetAudioRecording(ds.UserID, pick(rng, ds.RecordingIDs))))
+		}
+	}},
+	{"UpdateAudioRecording", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		recording, err := s.GetAudioRecording(ds.UserID, ds.RecordingIDs[0])
+		must(b, err)
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			must(b, s.UpdateAudioRecording(recording))
+		}
+	}},
+	{"GetActivityRecordings", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		rng := rand.New(rand.NewSource(1))
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetActivityRecordings(ds.UserID, pick(rng, ds.ActivityIDs))))
+		}
+	}},
+	{"DeleteAudioRecording", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			recording := newRecording(ds.UserID, ds.ActivityIDs[0])
+			must(b, s.CreateAudioRecording(recording))
+			b.StartTimer()
+			must(b, s.DeleteAudioRecording(recording.ID))
+		}
+	}},
+
+	// Transcript chunks
+	{"CreateTranscriptChunk", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			chunk := models.NewTranscriptChunk(ds.UserID, ds.ActivityIDs[0], ds.RecordingIDs[0], "benchmark chunk text", float64(i), float64(i+1))
+			must(b, s.CreateTranscriptChunk(chunk))
+		}
+	}},
+	{"GetActivityTranscripts", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		rng := rand.New(rand.NewSource(1))
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetActivityTranscripts(ds.UserID, pick(rng, ds.ActivityIDs))))
+		}
+	}},
+	{"GetTranscriptChunksByActivity", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		rng := rand.New(rand.NewSource(1))
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetTranscriptChunksByActivity(pick(rng, ds.ActivityIDs))))
+		}
+	}},
+	{"GetRecordingTranscripts", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		rng := rand.New(rand.NewSource(1))
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetRecordingTranscripts(ds.UserID, pick(rng, ds.RecordingIDs))))
+		}
+	}},
+	{"GetTranscriptChunksByAudioRecording", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		rng := rand.New(rand.NewSource(1))
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetTranscriptChunksByAudioRecording(pick(rng, ds.RecordingIDs))))
+		}
+	}},
+
+	// Garbage collection
+	{"GetPurgeableActivityIDs", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetPurgeableActivityIDs(time.Now().Add(-24*time.Hour), 10)))
+		}
+	}},
+	{"ClaimActivityForPurge", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			activityID := seedDeletedActivity(b, s, ds.UserID, 0)
+			b.StartTimer()
+			must(b, ignore(s.ClaimActivityForPurge(activityID, time.Now().Add(time.Hour))))
+		}
+	}},
+	{"DeleteActivityTranscriptChunksBatch", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			activityID, _ := seedActivity(b, s, ds.UserID, 500)
+			b.StartTimer()
+			must(b, ignore(s.DeleteActivityTranscriptChunksBatch(activityID, 500)))
+		}
+	}},
+	{"PurgeActivity", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			activityID := seedDeletedActivity(b, s, ds.UserID, 0)
+			must(b, ignore(s.ClaimActivityForPurge(activityID, time.Now().Add(time.Hour))))
+			b.StartTimer()
+			must(b, s.PurgeActivity(activityID))
+		}
+	}},
+	{"RestoreActivity", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			activityID := seedDeletedActivity(b, s, ds.UserID, 0)
+			b.StartTimer()
+			must(b, s.RestoreActivity(ds.UserID, activityID))
+		}
+	}},
+
+	// Retention
+	{"GetAudioBytesOnDisk", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetAudioBytesOnDisk()))
+		}
+	}},
+	{"GetAudioRetentionCandidates", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetAudioRetentionCandidates(time.Now(), nil, time.Hour, 100)))
+		}
+	}},
+	{"MarkAudioPurged", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			recording := newRecording(ds.UserID, ds.ActivityIDs[0])
+			must(b, s.CreateAudioRecording(recording))
+			b.StartTimer()
+			must(b, s.MarkAudioPurged([]string{recording.ID}))
+		}
+	}},
+	{"DeleteTranscriptChunksBefore", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		// A cutoff older than all data measures the lookup without deleting rows
+		cutoff := time.Unix(0, 0)
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.DeleteTranscriptChunksBefore(cutoff, 500)))
+		}
+	}},
+
+	// Two-tier transcription
+	{"GetDraftTranscripts", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		retryBefore := time.Now().Add(-24 * time.Hour)
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.GetDraftTranscripts(10, 3, retryBefore)))
+		}
+	}},
+	{"ReplaceRecordingTranscript", func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		activityID, recordingID := seedActivity(b, s, ds.UserID, 0)
+		chunks := make([]*models.TranscriptChunk, 20)
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			for j := range chunks {
+				chunks[j] = models.NewTranscriptChunk(ds.UserID, activityID, recordingID, "benchmark chunk text", float64(j*30), float64(j*30+30))
+			}
+			must(b, ignore(s.ReplaceRecordingTranscript(recordingID, chunks, nil, models.TranscriptTierFinal, "benchmark", "")))
+		}
+	}},
+}
+
+// searchBenchmark measures SearchTranscripts for one term
+func searchBenchmark(term string) storageBenchmark {
+	return storageBenchmark{"SearchTranscripts/" + term, func(b *testing.B, s *storage.SQLiteStorage, ds *Dataset) {
+		for i := 0; i < b.N; i++ {
+			must(b, ignore(s.SearchTranscripts(ds.UserID, term)))
+		}
+	}}
+}
+
+// seedActivity creates an activity with one recording and the given number of chunks
+func seedActivity(b *testing.B, s *storage.SQLiteStorage, userID string, chunks int) (string, string) {
+	activity := models.NewActivity(userID, models.ActivityTypeMeeting, "Benchmark")
+	must(b, s.CreateActivity(activity))
+
+	recording := newRecording(userID, activity.ID)
+	must(b, s.CreateAudioRecording(recording))
+
+	for i := 0; i < chunks; i++ {
+		chunk := models.NewTranscriptChunk(userID, activity.ID, recording.ID, "benchmark chunk text", float64(i), float64(i+1))
+		must(b, s.CreateTranscriptChunk(chunk))
+	}
+
+	return activity.ID, recording.ID
+}
+
+// seedDeletedActivity creates a soft-deleted activity
+func seedDeletedActivity(b *testing.B, s *storage.SQLiteStorage, userID string, chunks int) string {
+	activityID, _ := seedActivity(b, s, userID, chunks)
+
+	activity, err := s.GetActivity(userID, activityID)
+	must(b, err)
+	deletedAt := time.Now().Add(-time.Minute)
+	activity.DeletedAt = &deletedAt
+	must(b, s.UpdateActivity(activity))
+
+	return activityID
+}
+
+// newRecording returns a completed recording for an activity
+func newRecording(userID, activityID string) *models.AudioRecording {
+	recording := models.NewAudioRecording(userID, activityID, fmt.Sprintf("activities/%s/audio/benchmark.wav", activityID),
+		models.AudioDeviceInfo{}, models.RecordingConfig{})
+	recording.Status = models.AudioRecordingStatusCompleted
+	return recording
+}
+
+// pick returns a random element
+func pick(rng *rand.Rand, ids []string) string {
+	return ids[rng.Intn(len(ids))]
+}
+
+// ignore drops a result so only the error is checked
+func ignore[T any](_ T, err error) error {
+	return err
+}
+
+// must fails the benchmark on error
+func must(b *testing.B, err error) {
+	if err != nil {
+		b.Fatal(err)
+	}
+}
@@ -0,0 +1,259 @@
+package main
+
+import (
+	"database/sql"
+	"fmt"
+	"math/rand"
+	"strings"
+	"time"
+
+	"github.com/google/uuid"
+	"github.com/platformlabs-co/personal-assist/database"
+	"github.com/platformlabs-co/personal-assist/logger"
+	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/storage"
+)
+
+// DatasetConfig describes the volume of synthetic data to generate
+type DatasetConfig struct {
+	Activities     int     // Activities to create
+	Recordings     int     // Audio recordings spread across the activities
+	Chunks         int     // Transcript chunks spread across the recordings
+	DeletedPercent float64 // Share of activities that are soft-deleted
+	History        time.Duration
+	Seed           int64
+	BatchSize      int // Rows inserted per transaction
+}
+
+// DefaultDatasetConfig returns the volumes of a heavy long-time user
+func DefaultDatasetConfig() DatasetConfig {
+	return DatasetConfig{
+		Activities:     20000,
+		Recordings:     50000,
+		Chunks:         20000000,
+		DeletedPercent: 2,
+		History:        2 * 365 * 24 * time.Hour,
+		Seed:           1,
+		BatchSize:      50000,
+	}
+}
+
+// Scale returns the config with every volume multiplied by factor
+func (c DatasetConfig) Scale(factor float64) DatasetConfig {
+	scale := func(n int) int {
+		if scaled := int(float64(n) * factor); scaled > 0 {
+			return scaled
+		}
+		return 1
+	}
+	c.Activities = scale(c.Activities)
+	c.Recordings = scale(c.Recordings)
+	c.Chunks = scale(c.Chunks)
+	return c
+}
+
+// Dataset holds identifiers sampled by the benchmarks
+type Dataset struct {
+	UserID       string
+	ActivityIDs  []string
+	RecordingIDs []string
+}
+
+// vocabulary is the word list transcript text is drawn from. The first words
+// are frequent, the last ones rare, so searches cover both cases.
+var vocabulary = strings.Fields(`
+	the we to and that is it for on this so I you of in be have will
+	meeting project team update customer release review plan budget design
+	schedule feedback roadmap deadline migration database latency dashboard
+	onboarding hiring quarterly retrospective incident postmortem escalation
+	kubernetes terraform observability compliance procurement localization
+	anthropomorphic quinoa zeppelin xylophone`)
+
+// searchTerms are queried by the search benchmarks, from frequent to rare
+var searchTerms = []string{"meeting", "roadmap", "postmortem", "zeppelin", "no-such-word"}
+
+var activityTypes = []models.ActivityType{
+	models.ActivityTypeMeeting,
+	models.ActivityTypeWorkSession,
+	models.ActivityTypeCall,
+	models.ActivityTypeOther,
+}
+
+// GenerateDataset fills an empty database with synthetic activities,
+// recordings and transcript chunks. Rows are written with batched prepared
+// inserts rather than through SQLiteStorage, which commits every row.
+func GenerateDataset(db *database.DB, config DatasetConfig) (*Dataset, error) {
+	rng := rand.New(rand.NewSource(config.Seed))
+	sqliteStorage := storage.NewSQLiteStorage(db)
+
+	user := models.NewUser("benchmark")
+	if err := sqliteStorage.CreateUser(user); err != nil {
+		return nil, err
+	}
+
+	dataset := &Dataset{UserID: user.ID}
+	now := time.Now()
+	start := now.Add(-config.History)
+	spacing := config.History / time.Duration(config.Activities)
+
+	// Activities, evenly spread over the history
+	activityStarts := make([]time.Time, config.Activities)
+	err := insertBatches(db, config.Activities, config.BatchSize, `
+		INSERT INTO activities (id, user_id, type, title, start_time, end_time, status, tags, metadata, created_at, updated_at, deleted_at)
+		VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`,
+		func(stmt *sql.Stmt, i int) error {
+			id := uuid.NewString()
+			dataset.ActivityIDs = append(dataset.ActivityIDs, id)
+
+			startTime := start.Add(time.Duration(i) * spacing)
+			activityStarts[i] = startTime
+			endTime := startTime.Add(time.Duration(15+rng.Intn(90)) * time.Minute)
+
+			var deletedAt *int64
+			if rng.Float64()*100 < config.DeletedPercent {
+				t := endTime.Add(time.Duration(rng.Intn(72)) * time.Hour).Unix()
+				deletedAt = &t
+			}
+
+			_, err := stmt.Exec(id, user.ID, string(activityTypes[rng.Intn(len(activityTypes))]),
+				fmt.Sprintf("Activity %d", i), startTime.Unix(), endTime.Unix(), string(models.ActivityStatusCompleted),
+				`["synthetic"]`, `{}`, startTime.Unix(), endTime.Unix(), deletedAt)
+			return err
+		})
+	if err != nil {
+		return nil, fmt.Errorf("failed to generate activities: %w", err)
+	}
+	logger.WithField("rows", config.Activities).Info("Generated activities")
+
+	// Recordings, round-robin over the activities
+	recordingActivity := make([]int, config.Recordings)
+	err = insertBatches(db, config.Recordings, config.BatchSize, `
+		INSERT INTO audio_recordings (id, user_id, activity_id, file_path, device_info, status, duration, file_size, config, created_at, updated_at)
+		VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`,
+		func(stmt *sql.Stmt, i int) error {
+			id := uuid.NewString()
+			dataset.RecordingIDs = append(dataset.RecordingIDs, id)
+
+			activity := i % config.Activities
+			recordingActivity[i] = activity
+			activityID := dataset.ActivityIDs[activity]
+			createdAt := activityStarts[activity].Add(time.Duration(i/config.Activities) * 10 * time.Minute)
+			duration := float64(300 + rng.Intn(3300))
+
+			_, err := stmt.Exec(id, user.ID, activityID,
+				fmt.Sprintf("activities/%s/audio/%s.wav", activityID, id), `{}`, "completed",
+				duration, int64(duration*32000), `{}`, createdAt.Unix(), createdAt.Unix())
+			return err
+		})
+	if err != nil {
+		return nil, fmt.Errorf("failed to generate recordings: %w", err)
+	}
+	logger.WithField("rows", config.Recordings).Info("Generated audio recordings")
+
+	// Transcript chunks, consecutive per recording like real transcription output
+	chunksPerRecording := config.Chunks / config.Recordings
+	if chunksPerRecording == 0 {
+		chunksPerRecording = 1
+	}
+	words := make([]string, 0, 24)
+	err = insertBatches(db, config.Chunks, config.BatchSize, `
+		INSERT INTO transcript_chunks (id, user_id, activity_id, audio_recording_id, text, start_time, end_time, speaker, confidence, language, created_at)
+		VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`,
+		func(stmt *sql.Stmt, i int) error {
+			recording := (i / chunksPerRecording) % config.Recordings
+			activity := recordingActivity[recording]
+			segment := float64(i % chunksPerRecording)
+
+			words = words[:0]
+			for n := 8 + rng.Intn(16); n > 0; n-- {
+				// Squaring skews the draw towards the frequent words
+				r := rng.Float64()
+				words = append(words, vocabulary[int(r*r*float64(len(vocabulary)))])
+			}
+
+			_, err := stmt.Exec(uuid.NewString(), user.ID, dataset.ActivityIDs[activity], dataset.RecordingIDs[recording],
+				strings.Join(words, " "), segment*5, segment*5+5, nil, 0.6+rng.Float64()*0.4, "en",
+				activityStarts[activity].Unix())
+			return err
+		})
+	if err != nil {
+		return nil, fmt.Errorf("failed to generate transcript chunks: %w", err)
+	}
+	logger.WithField("rows", config.Chunks).Info("Generated transcript chunks")
+
+	if _, err := db.Exec("ANALYZE"); err != nil {
+		return nil, fmt.Errorf("failed to analyze database: %w", err)
+	}
+
+	return dataset, nil
+}
+
+// LoadDataset reads the identifiers of a previously generated database
+func LoadDataset(db *database.DB) (*Dataset, error) {
+	user, err := storage.NewSQLiteStorage(db).GetFirstUser()
+	if err != nil {
+		return nil, err
+	}
+
+	dataset := &Dataset{UserID: user.ID}
+	if dataset.ActivityIDs, err = queryIDs(db, "SELECT id FROM activities"); err != nil {
+		return nil, err
+	}
+	if dataset.RecordingIDs, err = queryIDs(db, "SELECT id FROM audio_recordings"); err != nil {
+		return nil, err
+	}
+	if len(dataset.ActivityIDs) == 0 || len(dataset.RecordingIDs) == 0 {
+		return nil, fmt.Errorf("database has no generated data")
+	}
+
+	return dataset, nil
+}
+
+// insertBatches runs insert for rows 0..count-1, committing every batchSize rows
+func insertBatches(db *database.DB, count, batchSize int, query string, insert func(stmt *sql.Stmt, i int) error) error {
+	for begin := 0; begin < count; begin += batchSize {
+		tx, err := db.Begin()
+		if err != nil {
+			return err
+		}
+
+		stmt, err := tx.Prepare(query)
+		if err != nil {
+			tx.Rollback()
+			return err
+		}
+
+		for i := begin; i < count && i < begin+batchSize; i++ {
+			if err := insert(stmt, i); err != nil {
+				stmt.Close()
+				tx.Rollback()
+				return err
+			}
+		}
+
+		stmt.Close()
+		if err := tx.Commit(); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// queryIDs returns the first column of every row
+func queryIDs(db *database.DB, query string) ([]string, error) {
+	rows, err := db.Query(query)
+	if err != nil {
+		return nil, err
+	}
+	defer rows.Close()
+
+	var ids []string
+	for rows.Next() {
+		var id string
+		if err := rows.Scan(&id); err != nil {
+			return nil, err
+		}
+		ids = append(ids, id)
+	}
+	return ids, rows.Err()
+}
@@ -0,0 +1,312 @@
+// Command storagebench generates a synthetic database at realistic scale and
+// benchmarks every SQLiteStorage method against it, printing the query plan
+// of each statement and flagging full table scans and temporary sorts.
+//
+//	go run ./tools/storagebench -scale 0.05 -bench 'Transcript'
+//	go run ./tools/storagebench -out results.json
+//	go run ./tools/storagebench -baseline results.json
+//
+// The database is generated once and reused by later runs; pass -generate to
+// rebuild it. With -baseline the command exits non-zero when a benchmark got
+// slower than allowed or a statement started scanning a whole table.
+package main
+
+import (
+	"context"
+	"database/sql"
+	"encoding/json"
+	"flag"
+	"fmt"
+	"os"
+	"path/filepath"
+	"regexp"
+	"strings"
+	"testing"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/database"
+	"github.com/platformlabs-co/personal-assist/storage"
+)
+
+// BenchmarkResult is the outcome of one benchmark
+type BenchmarkResult struct {
+	Name        string      `json:"name"`
+	Iterations  int         `json:"iterations"`
+	NsPerOp     int64       `json:"ns_per_op"`
+	AllocsPerOp int64       `json:"allocs_per_op"`
+	BytesPerOp  int64       `json:"bytes_per_op"`
+	Plans       []QueryPlan `json:"plans"`
+}
+
+// QueryPlan is the EXPLAIN QUERY PLAN output of one statement
+type QueryPlan struct {
+	SQL      string   `json:"sql"`
+	Steps    []string `json:"steps"`
+	FullScan bool     `json:"full_scan"`
+	TempSort bool     `json:"temp_sort"`
+}
+
+func main() {
+	testing.Init()
+
+	dataDir := flag.String("dir", filepath.Join(os.TempDir(), "personal-assist-storagebench"), "directory holding the benchmark database")
+	scale := flag.Float64("scale", 1, "fraction of the default dataset (20k activities, 50k recordings, 20M chunks)")
+	generate := flag.Bool("generate", false, "regenerate the dataset even if the database exists")
+	benchPattern := flag.String("bench", ".", "regular expression selecting benchmarks")
+	benchTime := flag.Duration("benchtime", time.Second, "run time per benchmark")
+	outPath := flag.String("out", "", "write results as JSON to this file")
+	baselinePath := flag.String("baseline", "", "compare against results previously written with -out")
+	maxRegression := flag.Float64("max-regression", 0.2, "allowed ns/op increase over the baseline")
+	flag.Parse()
+
+	if err := flag.Set("test.benchtime", benchTime.String()); err != nil {
+		fatal(err)
+	}
+
+	pattern, err := regexp.Compile(*benchPattern)
+	if err != nil {
+		fatal(fmt.Errorf("invalid -bench pattern: %w", err))
+	}
+
+	db, dataset, err := openDataset(*dataDir, *scale, *generate)
+	if err != nil {
+		fatal(err)
+	}
+	defer db.Close()
+
+	sqliteStorage := storage.NewSQLiteStorage(db)
+	var results []BenchmarkResult
+	for _, bench := range storageBenchmarks {
+		if !pattern.MatchString(bench.Name) {
+			continue
+		}
+
+		result, err := runBenchmark(db, sqliteStorage, dataset, bench)
+		if err != nil {
+			fatal(fmt.Errorf("%s: %w", bench.Name, err))
+		}
+		printResult(result)
+		results = append(results, result)
+	}
+
+	if *outPath != "" {
+		if err := writeResults(*outPath, results); err != nil {
+			fatal(err)
+		}
+	}
+
+	if *baselinePath != "" {
+		failures, err := compareBaseline(*baselinePath, results, *maxRegression)
+		if err != nil {
+			fatal(err)
+		}
+		for _, failure := range failures {
+			fmt.Println("REGRESSION:", failure)
+		}
+		if len(failures) > 0 {
+			os.Exit(1)
+		}
+	}
+}
+
+// openDataset opens the benchmark database, generating it when needed
+func openDataset(dataDir string, scale float64, regenerate bool) (*database.DB, *Dataset, error) {
+	config := database.Config{
+		DataDir:    dataDir,
+		DBName:     "storagebench.db",
+		DriverName: observedDriverName,
+	}
+	dbPath := filepath.Join(dataDir, config.DBName)
+
+	if regenerate {
+		for _, suffix := range []string{"", "-wal", "-shm"} {
+			if err := os.Remove(dbPath + suffix); err != nil && !os.IsNotExist(err) {
+				return nil, nil, err
+			}
+		}
+	}
+	_, statErr := os.Stat(dbPath)
+	exists := statErr == nil
+
+	sql.Register(observedDriverName, &observedDriver{driver: database.NewSQLiteDriver()})
+	db, err := database.NewDB(config)
+	if err != nil {
+		return nil, nil, err
+	}
+
+	migrator := database.NewMigrator(db)
+	if err := migrator.InitializeSchema(); err != nil {
+		db.Close()
+		return nil, nil, err
+	}
+	if err := migrator.RunMigrations(database.SchemaMigrations()); err != nil {
+		db.Close()
+		return nil, nil, err
+	}
+
+	var dataset *Dataset
+	if exists {
+		dataset, err = LoadDataset(db)
+	} else {
+		start := time.Now()
+		dataset, err = GenerateDataset(db, DefaultDatasetConfig().Scale(scale))
+		fmt.Printf("generated dataset in %s\n", time.Since(start).Round(time.Second))
+	}
+	if err != nil {
+		db.Close()
+		return nil, nil, err
+	}
+
+	return db, dataset, nil
+}
+
+// runBenchmark runs one benchmark and explains the statements it issued
+func runBenchmark(db *database.DB, s *storage.SQLiteStorage, dataset *Dataset, bench storageBenchmark) (BenchmarkResult, error) {
+	var failure error
+	observer.Begin()
+	result := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		bench.Run(b, s, dataset)
+		if b.Failed() {
+			failure = fmt.Errorf("benchmark failed")
+		}
+	})
+	queries := observer.End()
+	if failure != nil {
+		return BenchmarkResult{}, failure
+	}
+	if result.N == 0 {
+		return BenchmarkResult{}, fmt.Errorf("benchmark did not run")
+	}
+
+	plans := make([]QueryPlan, 0, len(queries))
+	for _, query := range queries {
+		plan, err := explain(db, query)
+		if err != nil {
+			return BenchmarkResult{}, err
+		}
+		plans = append(plans, plan)
+	}
+
+	return BenchmarkResult{
+		Name:        bench.Name,
+		Iterations:  result.N,
+		NsPerOp:     result.NsPerOp(),
+		AllocsPerOp: result.AllocsPerOp(),
+		BytesPerOp:  result.AllocedBytesPerOp(),
+		Plans:       plans,
+	}, nil
+}
+
+// explain runs EXPLAIN QUERY PLAN for a statement with the arguments it was executed with
+func explain(db *database.DB, query observedQuery) (QueryPlan, error) {
+	args := make([]interface{}, len(query.Args))
+	for i, arg := range query.Args {
+		args[i] = arg.Value
+	}
+
+	rows, err := db.QueryContext(context.Background(), "EXPLAIN QUERY PLAN "+query.SQL, args...)
+	if err != nil {
+		return QueryPlan{}, fmt.Errorf("failed to explain %q: %w", query.SQL, err)
+	}
+	defer rows.Close()
+
+	plan := QueryPlan{SQL: strings.Join(strings.Fields(query.SQL), " ")}
+	for rows.Next() {
+		var id, parent, unused int
+		var detail string
+		if err := rows.Scan(&id, &parent, &unused, &detail); err != nil {
+			return QueryPlan{}, err
+		}
+		plan.Steps = append(plan.Steps, detail)
+
+		// "SCAN t" reads every row; "SCAN t USING COVERING INDEX" still reads every index entry.
+		// "SCAN t VIRTUAL TABLE INDEX" is a full-text lookup, which reads only what matches.
+		if strings.HasPrefix(detail, "SCAN ") && !strings.HasPrefix(detail, "SCAN CONSTANT ROW") &&
+			!strings.Contains(detail, " VIRTUAL TABLE INDEX ") {
+			plan.FullScan = true
+		}
+		if strings.HasPrefix(detail, "USE TEMP B-TREE") {
+			plan.TempSort = true
+		}
+	}
+
+	return plan, rows.Err()
+}
+
+// printResult prints a benchmark line followed by its query plans
+func printResult(result BenchmarkResult) {
+	fmt.Printf("%-45s %10d %14d ns/op %8d allocs/op %10d B/op\n",
+		result.Name, result.Iterations, result.NsPerOp, result.AllocsPerOp, result.BytesPerOp)
+
+	for _, plan := range result.Plans {
+		flags := ""
+		if plan.FullScan {
+			flags += " [FULL SCAN]"
+		}
+		if plan.TempSort {
+			flags += " [TEMP SORT]"
+		}
+		fmt.Printf("    %s%s\n", plan.SQL, flags)
+		for _, step := range plan.Steps {
+			fmt.Printf("        %s\n", step)
+		}
+	}
+}
+
+// writeResults stores results for later comparison
+func writeResults(path string, results []BenchmarkResult) error {
+	data, err := json.MarshalIndent(results, "", "  ")
+	if err != nil {
+		return err
+	}
+	return os.WriteFile(path, data, 0644)
+}
+
+// compareBaseline returns a description of every regression against the baseline
+func compareBaseline(path string, results []BenchmarkResult, maxRegression float64) ([]string, error) {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return nil, fmt.Errorf("failed to read baseline: %w", err)
+	}
+
+	var baseline []BenchmarkResult
+	if err := json.Unmarshal(data, &baseline); err != nil {
+		return nil, fmt.Errorf("failed to parse baseline: %w", err)
+	}
+
+	previous := make(map[string]BenchmarkResult, len(baseline))
+	for _, result := range baseline {
+		previous[result.Name] = result
+	}
+
+	var failures []string
+	for _, result := range results {
+		old, ok := previous[result.Name]
+		if !ok {
+			continue
+		}
+
+		if limit := float64(old.NsPerOp) * (1 + maxRegression); float64(result.NsPerOp) > limit {
+			failures = append(failures, fmt.Sprintf("%s: %d ns/op, baseline %d ns/op", result.Name, result.NsPerOp, old.NsPerOp))
+		}
+
+		scanned := make(map[string]bool)
+		for _, plan := range old.Plans {
+			scanned[plan.SQL] = plan.FullScan
+		}
+		for _, plan := range result.Plans {
+			if wasScan, seen := scanned[plan.SQL]; plan.FullScan && (!seen || !wasScan) {
+				failures = append(failures, fmt.Sprintf("%s: new full scan in %s", result.Name, plan.SQL))
+			}
+		}
+	}
+
+	return failures, nil
+}
+
+// fatal prints an error and exits
+func fatal(err error) {
+	fmt.Fprintln(os.Stderr, "storagebench:", err)
+	os.Exit(1)
+}
@@ -0,0 +1,156 @@
+package main
+
+import (
+	"context"
+	"database/sql/driver"
+	"strings"
+	"sync"
+
+	"github.com/mattn/go-sqlite3"
+)
+
+// observedDriverName is the driver the benchmark database is opened with
+const observedDriverName = "sqlite3_observed"
+
+// observedQuery is a statement seen by the driver with the arguments of its
+// first execution, which is enough to ask SQLite for its query plan
+type observedQuery struct {
+	SQL  string
+	Args []driver.NamedValue
+}
+
+// queryObserver records the distinct statements executed while it is enabled
+type queryObserver struct {
+	mutex   sync.Mutex
+	enabled bool
+	seen    map[string]bool
+	queries []observedQuery
+}
+
+var observer = &queryObserver{seen: make(map[string]bool)}
+
+// Begin starts recording statements, discarding any previous ones
+func (o *queryObserver) Begin() {
+	o.mutex.Lock()
+	defer o.mutex.Unlock()
+	o.enabled = true
+	o.seen = make(map[string]bool)
+	o.queries = nil
+}
+
+// End stops recording and returns the statements seen since Begin
+func (o *queryObserver) End() []observedQuery {
+	o.mutex.Lock()
+	defer o.mutex.Unlock()
+	o.enabled = false
+	return o.queries
+}
+
+// record stores a statement the first time it is executed
+func (o *queryObserver) record(query string, args []driver.NamedValue) {
+	o.mutex.Lock()
+	defer o.mutex.Unlock()
+
+	query = strings.TrimSpace(query)
+	if !o.enabled || o.seen[query] {
+		return
+	}
+	o.seen[query] = true
+	o.queries = append(o.queries, observedQuery{SQL: query, Args: append([]driver.NamedValue(nil), args...)})
+}
+
+// observedDriver wraps the SQLite driver so the statements issued by
+// SQLiteStorage can be captured without changing the storage layer
+type observedDriver struct {
+	driver *sqlite3.SQLiteDriver
+}
+
+// Open opens a connection through the wrapped driver
+func (d *observedDriver) Open(dsn string) (driver.Conn, error) {
+	conn, err := d.driver.Open(dsn)
+	if err != nil {
+		return nil, err
+	}
+	return &observedConn{Conn: conn}, nil
+}
+
+// observedConn records statements before passing them to the SQLite connection
+type observedConn struct {
+	driver.Conn
+}
+
+// PrepareContext prepares a statement that records its executions
+func (c *observedConn) PrepareContext(ctx context.Context, query string) (driver.Stmt, error) {
+	var stmt driver.Stmt
+	var err error
+	if preparer, ok := c.Conn.(driver.ConnPrepareContext); ok {
+		stmt, err = preparer.PrepareContext(ctx, query)
+	} else {
+		stmt, err = c.Conn.Prepare(query)
+	}
+	if err != nil {
+		return nil, err
+	}
+	return &observedStmt{Stmt: stmt, query: query}, nil
+}
+
+// BeginTx starts a transaction on the SQLite connection
+func (c *observedConn) BeginTx(ctx context.Context, opts driver.TxOptions) (driver.Tx, error) {
+	if beginner, ok := c.Conn.(driver.ConnBeginTx); ok {
+		return beginner.BeginTx(ctx, opts)
+	}
+	return c.Conn.Begin()
+}
+
+// ExecContext executes a statement without preparing it
+func (c *observedConn) ExecContext(ctx context.Context, query string, args []driver.NamedValue) (driver.Result, error) {
+	execer, ok := c.Conn.(driver.ExecerContext)
+	if !ok {
+		return nil, driver.ErrSkip
+	}
+	observer.record(query, args)
+	return execer.ExecContext(ctx, query, args)
+}
+
+// QueryContext runs a query without preparing it
+func (c *observedConn) QueryContext(ctx context.Context, query string, args []driver.NamedValue) (driver.Rows, error) {
+	queryer, ok := c.Conn.(driver.QueryerContext)
+	if !ok {
+		return nil, driver.ErrSkip
+	}
+	observer.record(query, args)
+	return queryer.QueryContext(ctx, query, args)
+}
+
+// observedStmt records the executions of a prepared statement
+type observedStmt struct {
+	driver.Stmt
+	query string
+}
+
+// ExecContext executes the prepared statement
+func (s *observedStmt) ExecContext(ctx context.Context, args []driver.NamedValue) (driver.Result, error) {
+	observer.record(s.query, args)
+	if execer, ok := s.Stmt.(driver.StmtExecContext); ok {
+		return execer.ExecContext(ctx, args)
+	}
+	return s.Stmt.Exec(namedValuesToValues(args))
+}
+
+// QueryContext runs the prepared statement
+func (s *observedStmt) QueryContext(ctx context.Context, args []driver.NamedValue) (driver.Rows, error) {
+	observer.record(s.query, args)
+	if queryer, ok := s.Stmt.(driver.StmtQueryContext); ok {
+		return queryer.QueryContext(ctx, args)
+	}
+	return s.Stmt.Query(namedValuesToValues(args))
+}
+
+// namedValuesToValues converts arguments for drivers without context support
+func namedValuesToValues(args []driver.NamedValue) []driver.Value {
+	values := make([]driver.Value, len(args))
+	for i, arg := range args {
+		values[i] = arg.Value
+	}
+	return values
+}
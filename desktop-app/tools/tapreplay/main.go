@@ -0,0 +1,287 @@
+// Command tapreplay replays synthetic audio through the native delivery
+// path of the system audio tap, laid out as interleaved and as planar
+// (one buffer per channel) devices deliver it, and checks that Go receives
+// the original interleaved frames either way. It also reports the cost of
+// delivery and the allocations per IO cycle, which should be zero.
+//
+//	go run ./tools/tapreplay
+//	go run ./tools/tapreplay -channels 6 -cycle 441 -seconds 120
+//
+// Each layout runs with the given IO cycle and with one longer than the
+// native interleave buffer, for float32 and 16-bit samples. A last replay
+// switches output devices twice mid-stream, to another rate, sample format
+// and layout and back, with a gap each time, and checks that the stream
+// keeps its format and stays aligned with the host clock.
+package main
+
+import (
+	"bytes"
+	"encoding/binary"
+	"flag"
+	"fmt"
+	"math"
+	"math/rand"
+	"os"
+	"runtime"
+	"time"
+
+	"github.com/platformlabs-co/personal-assist/services/coreaudio"
+)
+
+// longCycle is an IO cycle longer than the native interleave buffer, so
+// planar cycles are delivered in several blocks
+const longCycle = 6000
+
+// replayCase is one layout, sample format and IO cycle to replay
+type replayCase struct {
+	Layout coreaudio.AudioLayout
+	Cycle  int
+}
+
+// replayResult is what a replay delivered and cost
+type replayResult struct {
+	Match       bool
+	PerFrame    time.Duration
+	AllocsCycle float64
+	PoolFrames  int64
+}
+
+func main() {
+	seconds := flag.Float64("seconds", 60, "length of the replayed audio")
+	rate := flag.Int("rate", 48000, "sample rate")
+	channels := flag.Int("channels", 2, "channels")
+	cycle := flag.Int("cycle", 512, "frames per IO cycle")
+	flag.Parse()
+
+	frames := int(*seconds * float64(*rate))
+	var cases []replayCase
+	for _, planar := range []bool{false, true} {
+		for _, size := range []int{4, 2} {
+			for _, frames := range []int{*cycle, longCycle} {
+				cases = append(cases, replayCase{
+					Layout: coreaudio.AudioLayout{
+						Channels:       *channels,
+						SampleRate:     float64(*rate),
+						BytesPerSample: size,
+						Float:          size == 4,
+						Planar:         planar,
+					},
+					Cycle: frames,
+				})
+			}
+		}
+	}
+
+	fmt.Printf("%.0fs of %d channel audio at %d Hz\n\n", *seconds, *channels, *rate)
+	fmt.Printf("%-12s %-8s %8s %6s %12s %12s %11s\n", "layout", "format", "cycle", "match", "ns/frame", "allocs/cycle", "pool frames")
+	failed := false
+	for _, c := range cases {
+		source := synthesize(frames, c.Layout)
+		result, err := replay(source, c)
+		if err != nil {
+			fatal(err)
+		}
+		layout, format := "interleaved", "int16"
+		if c.Layout.Planar {
+			layout = "planar"
+		}
+		if c.Layout.Float {
+			format = "float32"
+		}
+		fmt.Printf("%-12s %-8s %8d %6t %12.2f %12.2f %11d\n",
+			layout, format, c.Cycle, result.Match, float64(result.PerFrame.Nanoseconds())/float64(frames),
+			result.AllocsCycle, result.PoolFrames)
+		failed = failed || !result.Match
+	}
+
+	switched, err := replaySwitch(*rate, *channels, *cycle)
+	if err != nil {
+		fatal(err)
+	}
+	fmt.Printf("\ndevice switch: %d frames for %d expected, max error %.4f, layout kept %t\n",
+		switched.Frames, switched.Expected, switched.MaxError, switched.LayoutKept)
+	failed = failed || !switched.LayoutKept || abs(switched.Frames-switched.Expected) > 2 || switched.MaxError > switchTolerance
+
+	if failed {
+		fatal(fmt.Errorf("delivered audio differs from the source"))
+	}
+}
+
+// switchTolerance is the largest error allowed against the ideal tone after
+// device switches. Interpolating to another rate and 16-bit samples cost a
+// few ten-thousandths; a segment misplaced by one frame costs about 0.03.
+const switchTolerance = 0.01
+
+// switchSegment is audio played on one output device after a gap
+type switchSegment struct {
+	Layout  coreaudio.AudioLayout
+	Seconds float64
+	Gap     time.Duration
+}
+
+// switchResult is what a replay across device switches delivered
+type switchResult struct {
+	Frames     int
+	Expected   int
+	MaxError   float64
+	LayoutKept bool
+}
+
+// replaySwitch replays a tone through three devices in turn and compares
+// the stream with the tone at the first device's rate, silent in the gaps
+func replaySwitch(rate, channels, cycle int) (switchResult, error) {
+	first := coreaudio.AudioLayout{Channels: channels, SampleRate: float64(rate), BytesPerSample: 4, Float: true}
+	other := coreaudio.AudioLayout{Channels: 2, SampleRate: 44100, BytesPerSample: 2, Planar: true}
+	if rate == 44100 {
+		other.SampleRate = 48000
+	}
+	segments := []switchSegment{
+		{Layout: first, Seconds: 5},
+		{Layout: other, Seconds: 5, Gap: 250 * time.Millisecond},
+		{Layout: first, Seconds: 5, Gap: 120 * time.Millisecond},
+	}
+
+	var received []byte
+	result := switchResult{LayoutKept: true}
+	tap, err := coreaudio.NewReplayTap(func(frame *coreaudio.AudioFrame) {
+		result.LayoutKept = result.LayoutKept && frame.Layout == first
+		received = append(received, frame.Data...)
+		frame.Release()
+	}, first, cycle)
+	if err != nil {
+		return result, err
+	}
+	defer tap.Close()
+
+	// Spans of the stream timeline with audio, in seconds
+	var spans [][2]float64
+	at := 0.0
+	for i, segment := range segments {
+		if i > 0 {
+			if err := tap.SwitchDevice(segment.Layout, segment.Gap); err != nil {
+				return result, err
+			}
+			at += segment.Gap.Seconds()
+		}
+		frames := int(segment.Seconds * segment.Layout.SampleRate)
+		if err := tap.Write(tone(frames, segment.Layout, at)); err != nil {
+			return result, err
+		}
+		spans = append(spans, [2]float64{at, at + segment.Seconds})
+		at += segment.Seconds
+	}
+
+	frameBytes := first.FrameBytes()
+	result.Frames = len(received) / frameBytes
+	result.Expected = int(at*float64(rate) + 0.5)
+	for j := 0; j < result.Frames; j++ {
+		t := float64(j) / float64(rate)
+		want, edge := 0.0, false
+		for _, span := range spans {
+			if t >= span[0] && t < span[1] {
+				want = toneAt(t)
+			}
+			// A frame either side of a boundary may fall on the other side
+			edge = edge || math.Abs(t-span[0])*float64(rate) < 2 || math.Abs(t-span[1])*float64(rate) < 2
+		}
+		if edge {
+			continue
+		}
+		got := float64(math.Float32frombits(binary.LittleEndian.Uint32(received[j*frameBytes:])))
+		result.MaxError = math.Max(result.MaxError, math.Abs(got-want))
+	}
+	return result, nil
+}
+
+// toneAt is the tone of the switch replay at a time on the stream timeline
+func toneAt(t float64) float64 {
+	return 0.5 * math.Sin(2*math.Pi*440*t)
+}
+
+// tone returns frames of the tone starting at a time on the stream
+// timeline, the same on every channel
+func tone(frames int, layout coreaudio.AudioLayout, start float64) []byte {
+	data := make([]byte, 0, frames*layout.FrameBytes())
+	for f := 0; f < frames; f++ {
+		v := toneAt(start + float64(f)/layout.SampleRate)
+		for c := 0; c < layout.Channels; c++ {
+			if layout.Float {
+				data = binary.LittleEndian.AppendUint32(data, math.Float32bits(float32(v)))
+			} else {
+				data = binary.LittleEndian.AppendUint16(data, uint16(int16(math.Round(v*32767))))
+			}
+		}
+	}
+	return data
+}
+
+// abs returns the magnitude of an integer
+func abs(v int) int {
+	return max(v, -v)
+}
+
+// replay runs the source through a replay tap twice, the first time to warm
+// up the frame pool, and compares what the second delivered with the source
+func replay(source []byte, c replayCase) (replayResult, error) {
+	received := make([]byte, 0, len(source))
+	layoutOK := true
+	tap, err := coreaudio.NewReplayTap(func(frame *coreaudio.AudioFrame) {
+		layoutOK = layoutOK && frame.Layout == c.Layout && len(frame.Data)%c.Layout.FrameBytes() == 0
+		received = append(received, frame.Data...)
+		frame.Release()
+	}, c.Layout, c.Cycle)
+	if err != nil {
+		return replayResult{}, err
+	}
+	defer tap.Close()
+
+	if err := tap.Write(source); err != nil {
+		return replayResult{}, err
+	}
+	received = received[:0]
+	runtime.GC()
+
+	var before, after runtime.MemStats
+	runtime.ReadMemStats(&before)
+	start := time.Now()
+	if err := tap.Write(source); err != nil {
+		return replayResult{}, err
+	}
+	elapsed := time.Since(start)
+	runtime.ReadMemStats(&after)
+
+	cycles := (len(source)/c.Layout.FrameBytes() + c.Cycle - 1) / c.Cycle
+	return replayResult{
+		Match:       layoutOK && bytes.Equal(received, source),
+		PerFrame:    elapsed,
+		AllocsCycle: float64(after.Mallocs-before.Mallocs) / float64(cycles),
+		PoolFrames:  tap.Frames().Allocated(),
+	}, nil
+}
+
+// synthesize returns interleaved frames of a tone with a different level
+// and some noise per channel, in the layout's sample format
+func synthesize(frames int, layout coreaudio.AudioLayout) []byte {
+	rng := rand.New(rand.NewSource(1))
+	data := make([]byte, frames*layout.FrameBytes())
+	at := 0
+	for f := 0; f < frames; f++ {
+		t := float64(f) / layout.SampleRate
+		for c := 0; c < layout.Channels; c++ {
+			v := math.Sin(2*math.Pi*440*t)*0.5/float64(c+1) + rng.NormFloat64()*0.01
+			if layout.Float {
+				binary.LittleEndian.PutUint32(data[at:], math.Float32bits(float32(v)))
+			} else {
+				binary.LittleEndian.PutUint16(data[at:], uint16(int16(v*32767)))
+			}
+			at += layout.BytesPerSample
+		}
+	}
+	return data
+}
+
+// fatal prints an error and exits
+func fatal(err error) {
+	fmt.Fprintln(os.Stderr, "tapreplay:", err)
+	os.Exit(1)
+}
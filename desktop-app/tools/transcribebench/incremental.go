@@ -0,0 +1,91 @@
+package main
+
+import (
+	"fmt"
+	"path/filepath"
+
+	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
+	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/services/transcription"
+	"github.com/sirupsen/logrus"
+)
+
+// incrementalRun is one transcription of the recording against the regions
+// of the first and how many regions it should decode again
+type incrementalRun struct {
+	Name       string
+	Model      whisper.Model
+	ModelPath  string
+	Config     models.TranscriptionConfig
+	DecodesAll bool
+}
+
+// runIncremental transcribes a recording once as a draft would, then again
+// against the draft's regions: with the same model and settings nothing is
+// decoded, and with another language or model every region is. It returns
+// an error when a run decodes other than expected.
+func runIncremental(model whisper.Model, modelPath, otherModelPath string, recording *models.AudioRecording, activity *models.Activity, logger *logrus.Logger) error {
+	config := models.DefaultTranscriptionConfig()
+	config.RedecodeThreshold = 0
+
+	draft, err := transcribeAgainst(model, modelPath, config, recording, activity, nil, logger)
+	if err != nil {
+		return err
+	}
+	fmt.Printf("%-16s %8s %8s %8s\n", "run", "regions", "decoded", "reused")
+	fmt.Printf("%-16s %8d %8d %8d\n", "draft", len(draft.Regions), draft.Decoded, draft.Reused)
+
+	language := config
+	language.Language = "de"
+	if config.Language == "de" {
+		language.Language = "en"
+	}
+	runs := []incrementalRun{
+		{Name: "same", Model: model, ModelPath: modelPath, Config: config},
+		{Name: "language=" + language.Language, Model: model, ModelPath: modelPath, Config: language, DecodesAll: true},
+	}
+	if otherModelPath != "" {
+		other, err := whisper.New(otherModelPath)
+		if err != nil {
+			return fmt.Errorf("failed to load whisper model: %w", err)
+		}
+		defer other.Close()
+		runs = append(runs, incrementalRun{Name: "model=" + filepath.Base(otherModelPath), Model: other, ModelPath: otherModelPath, Config: config, DecodesAll: true})
+	}
+
+	var failed []string
+	for _, run := range runs {
+		transcript, err := transcribeAgainst(run.Model, run.ModelPath, run.Config, recording, activity, draft.Regions, logger)
+		if err != nil {
+			return err
+		}
+		fmt.Printf("%-16s %8d %8d %8d\n", run.Name, len(transcript.Regions), transcript.Decoded, transcript.Reused)
+
+		if run.DecodesAll && transcript.Reused != 0 {
+			failed = append(failed, fmt.Sprintf("%s reused %d regions decoded with other settings", run.Name, transcript.Reused))
+		}
+		if !run.DecodesAll && !transcript.Unchanged() {
+			failed = append(failed, fmt.Sprintf("%s decoded %d regions of unchanged audio", run.Name, transcript.Decoded))
+		}
+	}
+	if len(failed) > 0 {
+		return fmt.Errorf("incremental transcription: %v", failed)
+	}
+	return nil
+}
+
+// transcribeAgainst transcribes the recording against previous regions with
+// a processor named after its model file
+func transcribeAgainst(model whisper.Model, modelPath string, config models.TranscriptionConfig, recording *models.AudioRecording, activity *models.Activity, previous []models.TranscriptRegion, logger *logrus.Logger) (*transcription.RecordingTranscript, error) {
+	processor, err := transcription.NewWhisperProcessorFromModel(model, config, logger)
+	if err != nil {
+		return nil, err
+	}
+	defer processor.Close()
+	if err := processor.EnableMelCache(modelPath); err != nil {
+		return nil, err
+	}
+	processor.SetModelID(filepath.Base(modelPath))
+
+	return processor.TranscribeRecording(recording, activity, previous)
+}
@@ -0,0 +1,184 @@
+// Command transcribebench measures how fast a recording transcribes from its
+// mel cache with chunks decoded one at a time and with several concurrent
+// decoding streams, and checks every stream count produces the same text.
+//
+//	go run ./tools/transcribebench -model ~/models/ggml-base.bin -audio meeting.wav
+//	go run ./tools/transcribebench -model ggml-small.bin -audio meeting.wav -streams 1,2,4 -runs 3
+//
+// The first pass computes the recording's mel cache, so every measured run
+// starts from the same cached spectrogram. Each run gets a fresh encoder
+// cache: nothing is reused between runs.
+//
+// With -noise-ab it instead compares transcription with and without noise
+// suppression on a noisy fixture, reporting word error rate and decode time:
+//
+//	go run ./tools/transcribebench -model ggml-base.bin -audio meeting.wav -noise-ab -noise-snr 5
+//
+// With -incremental it checks that transcribing a recording again decodes
+// only what changed: nothing against the regions of an earlier run with the
+// same model and settings, every region with another language or with the
+// model given by -other-model. It exits non-zero when a run reuses or
+// decodes other than expected.
+//
+//	go run ./tools/transcribebench -model ggml-tiny.bin -audio meeting.wav -incremental -other-model ggml-base.bin
+package main
+
+import (
+	"flag"
+	"fmt"
+	"os"
+	"strconv"
+	"strings"
+	"testing"
+	"time"
+
+	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
+	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/platformlabs-co/personal-assist/services/transcription"
+	"github.com/sirupsen/logrus"
+)
+
+func main() {
+	testing.Init()
+
+	modelPath := flag.String("model", "", "ggml Whisper model file")
+	audioPath := flag.String("audio", "", "recording to transcribe")
+	streamList := flag.String("streams", "1,2,4", "comma separated stream counts to compare")
+	runs := flag.Int("runs", 1, "transcriptions per stream count")
+	noiseAB := flag.Bool("noise-ab", false, "compare transcription with and without noise suppression")
+	noiseSNR := flag.Float64("noise-snr", 10, "SNR in dB of the office noise mixed into -audio for -noise-ab; 0 uses -audio as recorded")
+	referencePath := flag.String("reference", "", "reference transcript for -noise-ab; defaults to the transcript of -audio without suppression")
+	incremental := flag.Bool("incremental", false, "check that transcribing again decodes only regions whose audio, model or settings changed")
+	otherModelPath := flag.String("other-model", "", "second ggml model for -incremental")
+	flag.Parse()
+
+	if *modelPath == "" || *audioPath == "" {
+		fatal(fmt.Errorf("-model and -audio are required"))
+	}
+	if err := flag.Set("test.benchtime", fmt.Sprintf("%dx", *runs)); err != nil {
+		fatal(err)
+	}
+
+	var counts []int
+	for _, field := range strings.Split(*streamList, ",") {
+		count, err := strconv.Atoi(strings.TrimSpace(field))
+		if err != nil || count < 1 {
+			fatal(fmt.Errorf("invalid stream count %q", field))
+		}
+		counts = append(counts, count)
+	}
+
+	logger := logrus.New()
+	logger.SetLevel(logrus.WarnLevel)
+
+	model, err := whisper.New(*modelPath)
+	if err != nil {
+		fatal(fmt.Errorf("failed to load whisper model: %w", err))
+	}
+	defer model.Close()
+
+	activity := &models.Activity{ID: "bench", StartTime: time.Now()}
+	if *noiseAB {
+		if err := runNoiseAB(model, *modelPath, *audioPath, *referencePath, *noiseSNR, activity, logger); err != nil {
+			fatal(err)
+		}
+		return
+	}
+
+	recording := &models.AudioRecording{ID: "bench", FilePath: *audioPath}
+	if *incremental {
+		if err := runIncremental(model, *modelPath, *otherModelPath, recording, activity, logger); err != nil {
+			fatal(err)
+		}
+		return
+	}
+
+	config := models.DefaultTranscriptionConfig()
+	config.RedecodeThreshold = 0
+
+	// Warm the mel cache and establish the reference transcript
+	config.Streams = 1
+	reference, _, err := transcribe(model, *modelPath, config, recording, activity, logger)
+	if err != nil {
+		fatal(err)
+	}
+	audioSeconds := 0.0
+	if n := len(reference); n > 0 {
+		audioSeconds = reference[n-1].EndTime
+	}
+
+	var baseline int64
+	for _, count := range counts {
+		config.Streams = count
+		var transcript []*models.TranscriptChunk
+		result := testing.Benchmark(func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				chunks, _, err := transcribe(model, *modelPath, config, recording, activity, logger)
+				if err != nil {
+					b.Fatal(err)
+				}
+				transcript = chunks
+			}
+		})
+		if result.N == 0 {
+			fatal(fmt.Errorf("streams=%d: benchmark did not run", count))
+		}
+
+		if baseline == 0 {
+			baseline = result.NsPerOp()
+		}
+		realtime := 0.0
+		if result.NsPerOp() > 0 {
+			realtime = audioSeconds / (float64(result.NsPerOp()) / float64(time.Second))
+		}
+		fmt.Printf("streams=%-3d %14d ns/op %8.2fx realtime %6.2fx speedup  %s\n",
+			count, result.NsPerOp(), realtime, float64(baseline)/float64(result.NsPerOp()), compare(reference, transcript))
+	}
+}
+
+// transcribe runs one transcription of the recording with a fresh encoder
+// cache and returns the transcript with the processor's report
+func transcribe(model whisper.Model, modelPath string, config models.TranscriptionConfig, recording *models.AudioRecording, activity *models.Activity, logger *logrus.Logger) ([]*models.TranscriptChunk, models.TranscriptionReport, error) {
+	var report models.TranscriptionReport
+	processor, err := transcription.NewWhisperProcessorFromModel(model, config, logger)
+	if err != nil {
+		return nil, report, err
+	}
+	defer processor.Close()
+	if err := processor.EnableMelCache(modelPath); err != nil {
+		return nil, report, err
+	}
+
+	cacheConfig := transcription.DefaultEncoderCacheConfig()
+	cacheConfig.MaxStates = config.Streams
+	cache, err := transcription.NewEncoderCache(model, modelPath, cacheConfig)
+	if err != nil {
+		return nil, report, err
+	}
+	defer cache.Close()
+	if err := processor.SetEncoderCache(cache); err != nil {
+		return nil, report, err
+	}
+
+	chunks, err := processor.ProcessRecording(recording, activity)
+	return chunks, processor.Report(), err
+}
+
+// compare reports whether a transcript matches the reference chunk for chunk
+func compare(reference, transcript []*models.TranscriptChunk) string {
+	if len(reference) != len(transcript) {
+		return fmt.Sprintf("MISMATCH: %d chunks, expected %d", len(transcript), len(reference))
+	}
+	for i := range reference {
+		if reference[i].Text != transcript[i].Text {
+			return fmt.Sprintf("MISMATCH: chunk %d differs", i)
+		}
+	}
+	return "identical"
+}
+
+// fatal prints an error and exits
+func fatal(err error) {
+	fmt.Fprintln(os.Stderr, "transcribebench:", err)
+	os.Exit(1)
+}
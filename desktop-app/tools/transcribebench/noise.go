@@ -0,0 +1,213 @@
+package main
+
+import (
+	"fmt"
+	"math"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+	"time"
+	"unicode"
+
+	"github.com/ggerganov/whisper.cpp/bindings/go/pkg/whisper"
+	"github.com/go-audio/audio"
+	"github.com/go-audio/wav"
+	"github.com/platformlabs-co/personal-assist/models"
+	"github.com/sirupsen/logrus"
+)
+
+// runNoiseAB transcribes a noisy fixture with noise suppression off and on
+// and prints the word error rate and decode time of each. The fixture is
+// audioPath with office noise mixed in at snr dB, or audioPath itself when
+// snr is 0. Chunks do not overlap so the joined text can be compared with a
+// plain reference transcript.
+func runNoiseAB(model whisper.Model, modelPath, audioPath, referencePath string, snr float64, activity *models.Activity, logger *logrus.Logger) error {
+	config := models.DefaultTranscriptionConfig()
+	config.RedecodeThreshold = 0
+	config.OverlapDuration = 0
+
+	var reference string
+	if referencePath != "" {
+		data, err := os.ReadFile(referencePath)
+		if err != nil {
+			return fmt.Errorf("failed to read reference transcript: %w", err)
+		}
+		reference = string(data)
+	} else {
+		clean := &models.AudioRecording{ID: "clean", FilePath: audioPath}
+		config.NoiseSuppression = false
+		chunks, _, err := transcribe(model, modelPath, config, clean, activity, logger)
+		if err != nil {
+			return err
+		}
+		reference = transcriptText(chunks)
+	}
+
+	fixture := audioPath
+	if snr != 0 {
+		dir, err := os.MkdirTemp("", "transcribebench")
+		if err != nil {
+			return fmt.Errorf("failed to create fixture directory: %w", err)
+		}
+		defer os.RemoveAll(dir)
+
+		fixture = filepath.Join(dir, "noisy.wav")
+		if err := mixOfficeNoise(audioPath, fixture, snr); err != nil {
+			return err
+		}
+		fmt.Printf("fixture: %s with office noise at %.1f dB SNR\n", filepath.Base(audioPath), snr)
+	}
+	recording := &models.AudioRecording{ID: "noisy", FilePath: fixture}
+
+	for _, denoise := range []bool{false, true} {
+		config.NoiseSuppression = denoise
+
+		// The first pass computes the mel cache for this setting
+		transcript, report, err := transcribe(model, modelPath, config, recording, activity, logger)
+		if err != nil {
+			return err
+		}
+		result := testing.Benchmark(func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				if _, _, err := transcribe(model, modelPath, config, recording, activity, logger); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+		if result.N == 0 {
+			return fmt.Errorf("noise_suppression=%t: benchmark did not run", denoise)
+		}
+
+		fmt.Printf("noise_suppression=%-5t WER %6.2f%%  decode %10v  %14d ns/op  confidence %.3f\n",
+			denoise, 100*wordErrorRate(reference, transcriptText(transcript)),
+			report.DecodeTime.Round(time.Millisecond), result.NsPerOp(), report.Confidence)
+	}
+	return nil
+}
+
+// mixOfficeNoise writes a copy of a WAV file with stationary office noise
+// added at the given signal-to-noise ratio: pink noise for air handling and
+// a fan hum with harmonics that drifts slowly in level
+func mixOfficeNoise(inputPath, outputPath string, snr float64) error {
+	input, err := os.Open(inputPath)
+	if err != nil {
+		return fmt.Errorf("failed to open audio file: %w", err)
+	}
+	defer input.Close()
+
+	decoder := wav.NewDecoder(input)
+	if !decoder.IsValidFile() {
+		return fmt.Errorf("invalid WAV file: %s", inputPath)
+	}
+	buf, err := decoder.FullPCMBuffer()
+	if err != nil {
+		return fmt.Errorf("failed to read audio data: %w", err)
+	}
+	channels := buf.Format.NumChannels
+	if channels < 1 || len(buf.Data) == 0 {
+		return fmt.Errorf("no audio data found in %s", inputPath)
+	}
+
+	full := math.Exp2(float64(decoder.BitDepth)-1) - 1
+	var signal float64
+	for _, sample := range buf.Data {
+		signal += float64(sample) * float64(sample)
+	}
+	signal = math.Sqrt(signal/float64(len(buf.Data))) / full
+
+	noise := officeNoise(len(buf.Data)/channels, buf.Format.SampleRate, rand.New(rand.NewSource(1)))
+	var power float64
+	for _, n := range noise {
+		power += n * n
+	}
+	gain := signal / math.Sqrt(power/float64(len(noise))) / math.Pow(10, snr/20)
+
+	for i := range buf.Data {
+		mixed := float64(buf.Data[i]) + noise[i/channels]*gain*full
+		buf.Data[i] = int(math.Max(-full, math.Min(full, mixed)))
+	}
+
+	output, err := os.Create(outputPath)
+	if err != nil {
+		return fmt.Errorf("failed to create fixture: %w", err)
+	}
+	defer output.Close()
+
+	encoder := wav.NewEncoder(output, buf.Format.SampleRate, int(decoder.BitDepth), channels, 1)
+	if err := encoder.Write(&audio.IntBuffer{Format: buf.Format, Data: buf.Data, SourceBitDepth: int(decoder.BitDepth)}); err != nil {
+		return fmt.Errorf("failed to write fixture: %w", err)
+	}
+	if err := encoder.Close(); err != nil {
+		return fmt.Errorf("failed to write fixture: %w", err)
+	}
+	return nil
+}
+
+// officeNoise returns n samples of unscaled pink noise plus a fan hum at
+// 100Hz and its harmonics
+func officeNoise(n, sampleRate int, rng *rand.Rand) []float64 {
+	noise := make([]float64, n)
+	var b0, b1, b2 float64
+	for i := range noise {
+		// Paul Kellet's economy pink noise filter
+		white := rng.NormFloat64()
+		b0 = 0.99765*b0 + white*0.0990460
+		b1 = 0.96300*b1 + white*0.2965164
+		b2 = 0.57000*b2 + white*1.0526913
+		pink := b0 + b1 + b2 + white*0.1848
+
+		t := float64(i) / float64(sampleRate)
+		level := 1 + 0.2*math.Sin(2*math.Pi*0.1*t)
+		hum := math.Sin(2*math.Pi*100*t) + 0.5*math.Sin(2*math.Pi*200*t) + 0.25*math.Sin(2*math.Pi*300*t)
+		noise[i] = pink + level*hum
+	}
+	return noise
+}
+
+// transcriptText joins the text of a transcript's chunks
+func transcriptText(chunks []*models.TranscriptChunk) string {
+	texts := make([]string, len(chunks))
+	for i, chunk := range chunks {
+		texts[i] = chunk.Text
+	}
+	return strings.Join(texts, " ")
+}
+
+// wordErrorRate returns the word-level edit distance between a hypothesis
+// and a reference, ignoring case and punctuation, per reference word
+func wordErrorRate(reference, hypothesis string) float64 {
+	ref, hyp := words(reference), words(hypothesis)
+	if len(ref) == 0 {
+		if len(hyp) == 0 {
+			return 0
+		}
+		return 1
+	}
+
+	previous := make([]int, len(hyp)+1)
+	current := make([]int, len(hyp)+1)
+	for j := range previous {
+		previous[j] = j
+	}
+	for i := 1; i <= len(ref); i++ {
+		current[0] = i
+		for j := 1; j <= len(hyp); j++ {
+			cost := 1
+			if ref[i-1] == hyp[j-1] {
+				cost = 0
+			}
+			current[j] = min(previous[j-1]+cost, previous[j]+1, current[j-1]+1)
+		}
+		previous, current = current, previous
+	}
+	return float64(previous[len(hyp)]) / float64(len(ref))
+}
+
+// words splits text into lower-case words without punctuation
+func words(text string) []string {
+	return strings.FieldsFunc(strings.ToLower(text), func(r rune) bool {
+		return !unicode.IsLetter(r) && !unicode.IsDigit(r) && r != '\''
+	})
+}